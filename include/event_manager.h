@@ -54,6 +54,20 @@ extern "C" {
 #define SUBS_PRIO_COUNT (SUBS_PRIO_MAX - SUBS_PRIO_MIN + 1)
 
 
+/** @def EVENT_DISPATCH_CLASS_HIGHEST
+ *
+ * @brief Index of the highest event dispatch class.
+ */
+#define EVENT_DISPATCH_CLASS_HIGHEST 0
+
+
+/** @def EVENT_DISPATCH_CLASS_LOWEST
+ *
+ * @brief Index of the lowest event dispatch class.
+ */
+#define EVENT_DISPATCH_CLASS_LOWEST (_EVENT_DISPATCH_CLASS_COUNT - 1)
+
+
 /** @brief Event header.
  *
  * When defining an event structure, the event header
@@ -65,6 +79,36 @@ struct event_header {
 
 	/** Pointer to the event type object. */
 	const struct event_type *type_id;
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_STATS
+	/** Cycle counter value at event submission. */
+	u32_t timestamp;
+#endif
+};
+
+
+/** @brief Event processing statistics.
+ */
+struct event_stats {
+	/** Number of measurements. */
+	u32_t cnt;
+
+	/** Maximum measured number of cycles. */
+	u32_t max_cycles;
+
+	/** Cumulative number of cycles. */
+	u64_t total_cycles;
+};
+
+
+/** @brief Event type statistics.
+ */
+struct event_type_stats {
+	/** Time between event submission and start of its processing. */
+	struct event_stats latency;
+
+	/** Time spent on processing the event. */
+	struct event_stats processing;
 };
 
 
@@ -87,6 +131,11 @@ struct event_listener {
 struct event_subscriber {
 	/** Pointer to the listener. */
 	const struct event_listener *listener;
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_STATS
+	/** Time spent by the listener to process events of a given type. */
+	struct event_stats *stats;
+#endif
 };
 
 
@@ -108,6 +157,36 @@ struct event_info {
 };
 
 
+/** @brief Event memory pool.
+ *
+ * Used when events are allocated from per event type memory pools.
+ */
+struct event_pool {
+	/** Memory slab used to allocate events. */
+	struct k_mem_slab *slab;
+
+	/** Maximum number of slab blocks that were in use at the same time. */
+	atomic_t max_used;
+
+	/** Number of allocations that fell back to the heap. */
+	atomic_t heap_alloc_cnt;
+};
+
+
+/** @brief Event coalescing descriptor.
+ *
+ * Used by event types defined with @ref EVENT_TYPE_COALESCE.
+ */
+struct event_coalesce {
+	/** Function merging a newly submitted event into the queued one. */
+	void (*merge)(struct event_header *queued,
+		      const struct event_header *eh);
+
+	/** Queued event of this type that was not yet dispatched. */
+	struct event_header *pending;
+};
+
+
 /** @brief Event type.
  */
 struct event_type {
@@ -130,6 +209,26 @@ struct event_type {
 
 	/** Logging and formatting information. */
 	const struct event_info *ev_info;
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOLS
+	/** Memory pool used to allocate events of this type. */
+	struct event_pool *pool;
+#endif
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_CLASSES
+	/** Pointer to the dispatch class or NULL for the lowest class. */
+	const u8_t *dispatch_class;
+#endif
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_STATS
+	/** Processing statistics of this event type. */
+	struct event_type_stats *stats;
+#endif
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_COALESCING
+	/** Coalescing descriptor or NULL if events are not coalesced. */
+	struct event_coalesce *coalesce;
+#endif
 };
 
 
@@ -226,14 +325,58 @@ extern const struct event_type __stop_event_types[];
  * - cast_<i>%event_type</i> - Casts the event header that is provided
  *                            as argument to an event of the given type.
  *
+ * If CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOLS is enabled, a memory
+ * pool is also defined for the event type. The number of events in the pool
+ * can be passed as an optional last argument. If it is omitted,
+ * CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOL_SIZE is used.
+ *
  * @param ename     	   Name of the event.
  * @param init_log_en	   Bool indicating if the event is logged
  *                         by default.
  * @param log_fn  	   Function to stringify an event of this type.
  * @param ev_info_struct   Data structure describing the event type.
+ * @param ...		   Optional number of events in the event type pool.
  */
-#define EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct) \
-	_EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct)
+#define EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct, ...) \
+	_EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct,    \
+			   _EVENT_POOL_SIZE(__VA_ARGS__))
+
+
+/** Assign an event type to a dispatch class.
+ *
+ * Every dispatch class has its own event queue and is processed by its own
+ * workqueue, so events of a higher class do not wait for events of lower
+ * classes. Events of the lowest class are processed by the system
+ * workqueue. The order of events is preserved only within a class.
+ *
+ * Event types that are not assigned to a class are dispatched in
+ * @ref EVENT_DISPATCH_CLASS_LOWEST. The macro has no effect if
+ * CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_CLASSES is disabled.
+ *
+ * @param ename   Name of the event.
+ * @param dclass  Dispatch class, from @ref EVENT_DISPATCH_CLASS_HIGHEST
+ *                to @ref EVENT_DISPATCH_CLASS_LOWEST.
+ */
+#define EVENT_TYPE_DISPATCH_CLASS(ename, dclass) \
+	_EVENT_DISPATCH_CLASS_DEFINE(ename, dclass)
+
+
+/** Make an event type coalescing.
+ *
+ * While an event of a coalescing type is queued, newly submitted events
+ * of this type are not queued. Instead, they are merged into the queued
+ * event with the provided function and freed. Use it for high-rate
+ * producers whose events can be accumulated, for example motion deltas.
+ *
+ * The merge function is called with the event queue lock held, so it
+ * must be short and must not block. The macro has no effect if
+ * CONFIG_DESKTOP_EVENT_MANAGER_COALESCING is disabled.
+ *
+ * @param ename     Name of the event.
+ * @param merge_fn  Function merging a new event into the queued one.
+ */
+#define EVENT_TYPE_COALESCE(ename, merge_fn) \
+	_EVENT_COALESCE_DEFINE(ename, merge_fn)
 
 
 /** Verify if an event ID is valid.
@@ -248,6 +391,18 @@ extern const struct event_type __stop_event_types[];
 	__ASSERT_NO_MSG((id >= __start_event_types) && (id < __stop_event_types))
 
 
+/** Allocate an event from the memory pool of the event type.
+ *
+ * If the pool is exhausted, the event is allocated from the heap.
+ *
+ * @param et    Pointer to the event type.
+ * @param size  Size of the event.
+ *
+ * @return Pointer to the allocated memory or NULL if allocation failed.
+ */
+void *_event_pool_alloc(const struct event_type *et, size_t size);
+
+
 /** Submit an event to the Event Manager.
  *
  * @param eh  Pointer to the event header element in the event object.
@@ -70,11 +70,36 @@ extern "C" {
 	_EVENT_SUBSCRIBERS_EMPTY(ename, _SUBS_PRIO_ID(_SUBS_PRIO_FINAL))
 
 
+/* Event processing statistics. */
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_STATS
+#define _EVENT_SUBSCRIBER_STATS_DEFINE(lname, ename) \
+	static struct event_stats _CONCAT(_CONCAT(__event_subscriber_stats_, ename), lname)
+
+#define _EVENT_SUBSCRIBER_STATS_INIT(lname, ename) \
+	.stats = &_CONCAT(_CONCAT(__event_subscriber_stats_, ename), lname),
+
+#define _EVENT_TYPE_STATS_DEFINE(ename) \
+	static struct event_type_stats _CONCAT(__event_type_stats_, ename)
+
+#define _EVENT_TYPE_STATS_INIT(ename) \
+	.stats = &_CONCAT(__event_type_stats_, ename),
+
+#else
+#define _EVENT_SUBSCRIBER_STATS_DEFINE(lname, ename)
+#define _EVENT_SUBSCRIBER_STATS_INIT(lname, ename)
+#define _EVENT_TYPE_STATS_DEFINE(ename)
+#define _EVENT_TYPE_STATS_INIT(ename)
+
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_STATS */
+
+
 /* Subscribe a listener to an event. */
 #define _EVENT_SUBSCRIBE(lname, ename, prio)								\
+	_EVENT_SUBSCRIBER_STATS_DEFINE(lname, ename);							\
 	const struct event_subscriber _CONCAT(_CONCAT(__event_subscriber_, ename), lname) __used	\
 	__attribute__((__section__(_EVENT_SUBSCRIBERS_SECTION_NAME(ename, prio)))) = {			\
 		.listener = &_CONCAT(__event_listener_, lname),						\
+		_EVENT_SUBSCRIBER_STATS_INIT(lname, ename)						\
 	}
 
 
@@ -82,6 +107,99 @@ extern "C" {
 #define _EVENT_ID(ename) (&_CONCAT(__event_type_, ename))
 
 
+/* Event memory pools.
+ *
+ * When event pools are enabled, every event type owns a memory slab with
+ * a compile-time number of blocks. Events are allocated from the slab and
+ * the heap is used only when the slab is exhausted.
+ */
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOLS
+#define _EVENT_POOL_DEFAULT_SIZE CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOL_SIZE
+
+/* Indirection is needed to expand the slab name before it is pasted. */
+#define _EVENT_SLAB_DEFINE(slab, block_size, block_cnt, align)		\
+	K_MEM_SLAB_DEFINE(slab, block_size, block_cnt, align)
+
+#define _EVENT_POOL_DEFINE(ename, pool_size)					\
+	_EVENT_SLAB_DEFINE(_CONCAT(__event_slab_, ename),			\
+			   sizeof(struct ename), pool_size,			\
+			   __alignof__(struct ename));				\
+	static struct event_pool _CONCAT(__event_pool_, ename) = {		\
+		.slab = &_CONCAT(__event_slab_, ename),				\
+	}
+
+#define _EVENT_POOL_INIT(ename) .pool = &_CONCAT(__event_pool_, ename),
+
+#define _EVENT_MEM_ALLOC(ename, size) _event_pool_alloc(_EVENT_ID(ename), size)
+
+#else
+#define _EVENT_POOL_DEFAULT_SIZE 0
+
+#define _EVENT_POOL_DEFINE(ename, pool_size)
+#define _EVENT_POOL_INIT(ename)
+#define _EVENT_MEM_ALLOC(ename, size) k_malloc(size)
+
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOLS */
+
+
+/* Event dispatch classes.
+ *
+ * The dispatch class of an event type is defined with a separate macro.
+ * If it is not defined, the weak reference resolves to NULL and events of
+ * the given type are dispatched in the lowest class.
+ */
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_CLASSES
+#define _EVENT_DISPATCH_CLASS_COUNT CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_CLASS_COUNT
+
+#define _EVENT_DISPATCH_CLASS_INIT(ename) \
+	.dispatch_class = &_CONCAT(__event_dispatch_class_, ename),
+
+#else
+#define _EVENT_DISPATCH_CLASS_COUNT 1
+
+#define _EVENT_DISPATCH_CLASS_INIT(ename)
+
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_CLASSES */
+
+#define _EVENT_DISPATCH_CLASS_DECLARE(ename) \
+	extern const u8_t _CONCAT(__event_dispatch_class_, ename) __weak
+
+#define _EVENT_DISPATCH_CLASS_DEFINE(ename, dclass)				\
+	BUILD_ASSERT_MSG((dclass) < _EVENT_DISPATCH_CLASS_COUNT,		\
+			 "Invalid dispatch class");				\
+	const u8_t _CONCAT(__event_dispatch_class_, ename) = (dclass)
+
+
+/* Event coalescing.
+ *
+ * Similarly to dispatch classes, the coalescing descriptor is defined with
+ * a separate macro and referenced weakly from the event type.
+ */
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_COALESCING
+#define _EVENT_COALESCE_INIT(ename) \
+	.coalesce = &_CONCAT(__event_coalesce_, ename),
+
+#else
+#define _EVENT_COALESCE_INIT(ename)
+
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_COALESCING */
+
+#define _EVENT_COALESCE_DECLARE(ename) \
+	extern struct event_coalesce _CONCAT(__event_coalesce_, ename) __weak
+
+#define _EVENT_COALESCE_DEFINE(ename, merge_fn)			\
+	struct event_coalesce _CONCAT(__event_coalesce_, ename) = {	\
+		.merge = merge_fn,					\
+	}
+
+
+/* Select the pool size passed as an optional argument or use the default. */
+#define _EVENT_POOL_SIZE_SELECT(dflt, size, ...) size
+
+#define _EVENT_POOL_SIZE(...) \
+	_EVENT_POOL_SIZE_SELECT(_EVENT_POOL_DEFAULT_SIZE, ##__VA_ARGS__, _EVENT_POOL_DEFAULT_SIZE)
+
+
 /* Macro generates a function of name new_ename where ename is provided as
  * an argument. Allocator function is used to create an event of the given
  * ename type.
@@ -89,7 +207,7 @@ extern "C" {
 #define _EVENT_ALLOCATOR_FN(ename)					\
 	static inline struct ename *_CONCAT(new_, ename)(void)		\
 	{								\
-		struct ename *event = k_malloc(sizeof(*event));		\
+		struct ename *event = _EVENT_MEM_ALLOC(ename, sizeof(*event));	\
 		if (unlikely(!event)) {					\
 			printk("Event Manager OOM error\n");		\
 			LOG_PANIC();					\
@@ -178,13 +296,17 @@ extern "C" {
 #define _EVENT_TYPE_DECLARE(ename)					\
 	extern const struct event_type _CONCAT(__event_type_, ename);	\
 	_EVENT_SUBSCRIBERS_DECLARE(ename);				\
+	_EVENT_DISPATCH_CLASS_DECLARE(ename);				\
+	_EVENT_COALESCE_DECLARE(ename);					\
 	_EVENT_ALLOCATOR_FN(ename);					\
 	_EVENT_CASTER_FN(ename);					\
 	_EVENT_TYPECHECK_FN(ename)
 
 
-#define _EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct)							\
+#define _EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct, pool_size)						\
 	_EVENT_SUBSCRIBERS_DEFINE(ename);										\
+	_EVENT_POOL_DEFINE(ename, pool_size);										\
+	_EVENT_TYPE_STATS_DEFINE(ename);										\
 	const struct event_type _CONCAT(__event_type_, ename) __used							\
 	__attribute__((__section__("event_types"))) = {									\
 		.name				= STRINGIFY(ename),							\
@@ -201,6 +323,10 @@ extern "C" {
 		.init_log_enable		= init_log_en,								\
 		.log_event			= log_fn,								\
 		.ev_info			= ev_info_struct,							\
+		_EVENT_POOL_INIT(ename)											\
+		_EVENT_DISPATCH_CLASS_INIT(ename)									\
+		_EVENT_TYPE_STATS_INIT(ename)										\
+		_EVENT_COALESCE_INIT(ename)										\
 	}
 
 
@@ -29,6 +29,7 @@ extern "C" {
 #define COAP_ENABLE_OBSERVE_SERVER CONFIG_NRF_COAP_ENABLE_OBSERVE_SERVER
 #define COAP_ENABLE_OBSERVE_CLIENT CONFIG_NRF_COAP_ENABLE_OBSERVE_CLIENT
 #define COAP_OBSERVE_MAX_NUM_OBSERVERS CONFIG_NRF_COAP_OBSERVE_MAX_NUM_OBSERVERS
+#define COAP_OBSERVE_CON_INTERVAL CONFIG_NRF_COAP_OBSERVE_CON_INTERVAL
 #define COAP_OBSERVE_MAX_NUM_OBSERVABLES \
 				CONFIG_NRF_COAP_OBSERVE_MAX_NUM_OBSERVABLES
 #define COAP_MAX_NUMBER_OF_OPTIONS CONFIG_NRF_COAP_MAX_NUMBER_OF_OPTIONS
@@ -36,12 +37,24 @@ extern "C" {
 #define COAP_MESSAGE_DATA_MAX_SIZE CONFIG_NRF_COAP_MESSAGE_DATA_MAX_SIZE
 #define COAP_MESSAGE_QUEUE_SIZE CONFIG_NRF_COAP_MESSAGE_QUEUE_SIZE
 #define COAP_RESOURCE_MAX_DEPTH CONFIG_NRF_COAP_RESOURCE_MAX_DEPTH
+#define COAP_RESOURCE_INDEX_SIZE CONFIG_NRF_COAP_RESOURCE_INDEX_SIZE
+#define COAP_WELL_KNOWN_CACHE_SIZE CONFIG_NRF_COAP_WELL_KNOWN_CACHE_SIZE
 #define COAP_SESSION_COUNT CONFIG_NRF_COAP_SESSION_COUNT
+#define COAP_SESSION_CACHE_TIMEOUT CONFIG_NRF_COAP_SESSION_CACHE_TIMEOUT
 #define COAP_PORT_COUNT CONFIG_NRF_COAP_PORT_COUNT
 #define COAP_ACK_TIMEOUT CONFIG_NRF_COAP_ACK_TIMEOUT
 #define COAP_ACK_RANDOM_FACTOR CONFIG_NRF_COAP_ACK_RANDOM_FACTOR
 #define COAP_MAX_TRANSMISSION_SPAN CONFIG_NRF_COAP_MAX_TRANSMISSION_SPAN
 #define COAP_MAX_RETRANSMIT_COUNT CONFIG_NRF_COAP_MAX_RETRANSMIT_COUNT
+#define COAP_INPUT_BUDGET CONFIG_NRF_COAP_INPUT_BUDGET
+#define COAP_TICK_INTERVAL_MS CONFIG_NRF_COAP_TICK_INTERVAL_MS
+
+#if defined(CONFIG_NRF_COAP_MEM_POOL)
+#define COAP_MEM_MESSAGE_COUNT CONFIG_NRF_COAP_MEM_MESSAGE_COUNT
+#define COAP_MEM_BUFFER_COUNT CONFIG_NRF_COAP_MEM_BUFFER_COUNT
+#define COAP_MEM_SMALL_BUFFER_COUNT CONFIG_NRF_COAP_MEM_SMALL_BUFFER_COUNT
+#define COAP_MEM_SMALL_BUFFER_SIZE CONFIG_NRF_COAP_MEM_SMALL_BUFFER_SIZE
+#endif /* CONFIG_NRF_COAP_MEM_POOL */
 
 /**@defgroup COAP_CONTENT_TYPE_MASK Resource content type bitmask values
  * @{
@@ -132,6 +145,42 @@ typedef void * (*coap_alloc_t) (size_t size);
  */
 typedef void (*coap_free_t)(void *memory);
 
+/**@brief Pools of the built-in allocator, see \ref coap_mem_alloc. */
+typedef enum {
+	/** Small encoded messages. */
+	COAP_MEM_POOL_SMALL,
+
+	/** Message structures. */
+	COAP_MEM_POOL_MESSAGE,
+
+	/** Message data buffers and encoded messages. */
+	COAP_MEM_POOL_BUFFER,
+
+	/** Number of pools. */
+	COAP_MEM_POOL_COUNT
+} coap_mem_pool_t;
+
+/**@brief Usage statistics of a pool of the built-in allocator. */
+typedef struct {
+	/** Size of each block in the pool. */
+	u16_t block_size;
+
+	/** Number of blocks in the pool. */
+	u16_t block_count;
+
+	/** Number of blocks currently in use. */
+	u16_t used;
+
+	/** Highest number of blocks in use at the same time. */
+	u16_t max_used;
+
+	/** Number of requests the pool was the best fit for, but had no free
+	 *  block. The request was served by a pool with larger blocks, or
+	 *  failed.
+	 */
+	u32_t failures;
+} coap_mem_stats_t;
+
 /**@brief Callback function to call upon undefined behavior.
  *
  * @param[in] error_code Error code from CoAP module.
@@ -491,6 +540,43 @@ struct coap_resource_t {
 u32_t coap_init(u32_t token_rand_seed, coap_transport_init_t *transport_params,
 		coap_alloc_t alloc_fn, coap_free_t free_fn);
 
+/**@brief Allocate memory from the built-in pool allocator.
+ *
+ * @details Available with CONFIG_NRF_COAP_MEM_POOL. Register it together
+ *          with \ref coap_mem_free in \ref coap_init to serve all memory of
+ *          the module from fixed-size block pools instead of a heap. The
+ *          request is served by the pool with the smallest blocks that fit,
+ *          or by a pool with larger blocks when that pool is empty.
+ *
+ * @note To size the pools, start from the worst case given in the help of
+ *       CONFIG_NRF_COAP_MEM_BUFFER_COUNT, run the busiest scenario of the
+ *       application and read the pools with \ref coap_mem_stats_get. A
+ *       non-zero failure count means the pool is too small, and a high-water
+ *       mark below the block count means it can be reduced.
+ *
+ * @param[in] size Size of memory to be used.
+ *
+ * @retval A valid memory address on success, else, NULL.
+ */
+void *coap_mem_alloc(size_t size);
+
+/**@brief Free memory allocated with \ref coap_mem_alloc.
+ *
+ * @param[in] memory Address of memory to be freed. May be NULL.
+ */
+void coap_mem_free(void *memory);
+
+/**@brief Get the usage statistics of a pool of the built-in allocator.
+ *
+ * @param[in]  pool  Pool to read.
+ * @param[out] stats Pointer to where the statistics are written. A pool
+ *                   with no blocks reads as all zeros.
+ *
+ * @retval 0      If the statistics were read.
+ * @retval EINVAL If the pool is unknown or stats is NULL.
+ */
+u32_t coap_mem_stats_get(coap_mem_pool_t pool, coap_mem_stats_t *stats);
+
 /**@brief Register error handler callback to the CoAP module.
  *
  * @param[in] callback Function to be called upon unknown messages and
@@ -731,6 +817,11 @@ u32_t coap_resource_child_add(coap_resource_t *parent, coap_resource_t *child);
  *          link-format. This function can be called when all resources have
  *          been added by the application.
  *
+ *          The string is cached in CONFIG_NRF_COAP_WELL_KNOWN_CACHE_SIZE bytes
+ *          and only generated again after a resource is created or added.
+ *          Permission changes to resources already in the tree are not
+ *          detected.
+ *
  * @param[inout] string Buffer to use for the .well-known/core string.
  *                      Should not be NULL.
  * @param[inout] length Length of the string buffer. Returns the used number
@@ -804,10 +895,31 @@ u32_t coap_message_ct_match_select(coap_content_type_t *ct,
 /**@brief CoAP time tick used for retransmitting any message in the queue
  *        if needed.
  *
+ * @details Only the messages whose retransmission timeout has expired are
+ *          processed, see \ref coap_next_deadline.
+ *
  * @retval 0 If time tick update was successfully handled.
  */
 u32_t coap_time_tick(void);
 
+/**@brief Get the number of time ticks until the next retransmission or
+ *        transmission timeout of a message in the queue.
+ *
+ * @details Calls to \ref coap_time_tick before that only process the
+ *          transport. An application which does not need the transport
+ *          processing can sleep for the given number of tick intervals, and
+ *          then call \ref coap_time_tick once for every elapsed interval.
+ *
+ * @param[out] ticks Number of \ref coap_time_tick calls until the next
+ *                   retransmission or timeout is handled. 0 if one is
+ *                   already due.
+ *
+ * @retval 0      If a message is waiting for retransmission or timeout.
+ * @retval EINVAL If ticks pointer is NULL.
+ * @retval ENOENT If no message is waiting for retransmission or timeout.
+ */
+u32_t coap_next_deadline(u32_t *ticks);
+
 /**@brief Setup secure DTLS session.
  *
  * @details For the client role, this API triggers a DTLS handshake. Until the
@@ -821,10 +933,15 @@ u32_t coap_time_tick(void);
  *
  * @note Only one DTLS session is permitted between a local and remote endpoint.
  *       Therefore, in case a DTLS session was established between the local
- *       and remote endpoint, the existing DTLS session will be reused
- *       irrespective of the role and number of times this API was called. In
- *       case the application desires a fresh security setup, it must first
- *       call the \ref coap_security_destroy to tear down the existing setup.
+ *       and remote endpoint with the same role, peer verification, security
+ *       tags and hostname, the existing DTLS session will be reused. A
+ *       released session set up with other settings is closed and a new one
+ *       is set up. In case the application desires a fresh security setup, it
+ *       must first call the \ref coap_security_destroy to tear down the
+ *       existing setup.
+ *
+ * @note If all sessions are in use, the least recently released session, see
+ *       \ref coap_security_release, is closed to make room for the new one.
  *
  * @param[inout] local  Identifies the local IP address and port on which the
  *                      setup is requested. Also indicates the security
@@ -841,14 +958,37 @@ u32_t coap_time_tick(void);
  *                      settings shall be setup irrespective of the remote
  *                      client.
  *
- * @retval 0 If setup of the secure DTLS session was successful.
+ * @retval 0     If setup of the secure DTLS session was successful.
+ * @retval EBUSY If a session in use between the endpoints was set up with
+ *               other security settings.
  */
 u32_t coap_security_setup(coap_local_t *local, struct sockaddr const *remote);
 
+/**@brief Release a secure DTLS session for later reuse.
+ *
+ * @details The session is kept open instead of being torn down. A later call
+ *          to \ref coap_security_setup with the same local and remote endpoint
+ *          and security settings reuses it without a new DTLS handshake,
+ *          unless it has been released for longer than
+ *          CONFIG_NRF_COAP_SESSION_CACHE_TIMEOUT seconds. A released session
+ *          may be closed at any time to make room for a new session.
+ *          Confirmable messages still waiting for a response on it are then
+ *          failed with ECONNABORTED.
+ *
+ * @param[in] handle Transport handle of the session, as returned by
+ *                   \ref coap_security_setup.
+ *
+ * @retval 0      If the session was released.
+ * @retval EBADF  If the handle is not a known transport.
+ * @retval ENOENT If the handle does not belong to a DTLS session.
+ */
+u32_t coap_security_release(coap_transport_handle_t handle);
+
 /**@brief Destroy a secure DTLS session.
  *
  * @details Terminate and clean up any session associated with the local port
- *          and the remote.
+ *          and the remote. Confirmable messages waiting for a response on the
+ *          session are failed with ECONNABORTED.
  *
  * @param[in] local_port Local port to unbind the session from.
  * @param[in] remote     Pointer to a structure holding the address information
@@ -871,6 +1011,36 @@ u32_t coap_security_destroy(coap_transport_handle_t handle);
  **/
 void coap_input(void);
 
+/**@brief Event-driven process loop.
+ *
+ * @details Blocks until data is received on any of the CoAP ports or secure
+ *          sessions, a message in the queue is due for retransmission or
+ *          timeout, or the timeout expires. Received data is then handled, and
+ *          \ref coap_time_tick is called every CONFIG_NRF_COAP_TICK_INTERVAL_MS
+ *          milliseconds for as long as the message queue is not empty.
+ *
+ *          This replaces calling \ref coap_input and \ref coap_time_tick
+ *          from the application's main loop, which should not be mixed with
+ *          it. While the queue is empty the library does not wake up at all.
+ *
+ *          A port or session whose socket reports an error is closed, its
+ *          queued messages fail with the error, and the error is reported
+ *          to the handler registered with \ref coap_error_handler_register.
+ *
+ * @note The wait is not interrupted when another thread sends a confirmable
+ *       message, so its retransmissions are only sent once this call returns.
+ *       If messages are sent from other threads, use a timeout no longer than
+ *       CONFIG_NRF_COAP_TICK_INTERVAL_MS instead of K_FOREVER.
+ *
+ * @param[in] timeout Maximum time to block in milliseconds. 0 to return
+ *                    immediately, or K_FOREVER to wait until there is work.
+ *
+ * @retval 0        If the processing succeeded.
+ * @retval ENOTCONN If there is no socket to wait on.
+ * @retval EIO      If waiting on the sockets failed.
+ */
+u32_t coap_process(s32_t timeout);
+
 #ifdef __cplusplus
 }
 #endif
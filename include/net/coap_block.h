@@ -17,6 +17,9 @@
 #define COAP_BLOCK_H__
 
 #include <stdint.h>
+#include <stdbool.h>
+
+#include <net/coap_api.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -90,6 +93,203 @@ u32_t coap_block_opt_block2_encode(u32_t *encoded,
  */
 u32_t coap_block_opt_block2_decode(coap_block_opt_block2_t *opt, u32_t encoded);
 
+/**@cond */
+typedef struct coap_block_xfer_t coap_block_xfer_t;
+/**@endcond */
+
+/**@brief Callback function to add options to a message of a block transfer.
+ *
+ * @details Called for every request sent by a client transfer and for every
+ *          response sent by a server transfer. Only options with numbers lower
+ *          than \ref COAP_OPT_BLOCK2 can be added, for example URI-Path or
+ *          Content-Format.
+ *
+ * @param[in] xfer    Block transfer the message belongs to.
+ * @param[in] message Message to add the options to.
+ *
+ * @retval 0 If the options were added successfully.
+ */
+typedef u32_t (*coap_block_options_add_t)(coap_block_xfer_t *xfer,
+					  coap_message_t *message);
+
+/**@brief Callback function to provide the data of the next block.
+ *
+ * @param[in]    xfer   Block transfer the data is sent by.
+ * @param[in]    offset Offset of the block in the whole body.
+ * @param[out]   data   Buffer to fill the block data into.
+ * @param[inout] len    Size of the block. Shall be set to the number of bytes
+ *                      provided, which can be lower only for the last block.
+ * @param[out]   last   Shall be set to true if this is the last block.
+ *
+ * @retval 0 If the data was provided successfully.
+ */
+typedef u32_t (*coap_block_read_t)(coap_block_xfer_t *xfer, u32_t offset,
+				   u8_t *data, u16_t *len, bool *last);
+
+/**@brief Callback function to consume the data of a received block.
+ *
+ * @param[in] xfer   Block transfer the data is received by.
+ * @param[in] offset Offset of the block in the whole body.
+ * @param[in] data   Block data.
+ * @param[in] len    Length of the block data.
+ * @param[in] last   True if this is the last block.
+ *
+ * @retval 0     If the data was consumed successfully.
+ * @retval EFBIG If the body is too large for the application. A server
+ *               responds with 4.13 Request Entity Too Large. Other errors are
+ *               responded with 5.00 Internal Server Error.
+ */
+typedef u32_t (*coap_block_write_t)(coap_block_xfer_t *xfer, u32_t offset,
+				    const u8_t *data, u16_t len, bool last);
+
+/**@brief Callback function called when a client block transfer has ended.
+ *
+ * @param[in] xfer     Block transfer which ended.
+ * @param[in] status   0 if the last response was received, the status of the
+ *                     \ref coap_response_callback_t if the transmission
+ *                     failed, or EPROTO if the server did not follow the
+ *                     block sequence.
+ * @param[in] response Last response received, NULL if none. Only valid in
+ *                     the callback.
+ */
+typedef void (*coap_block_done_t)(coap_block_xfer_t *xfer, u32_t status,
+				  coap_message_t *response);
+
+/**@brief Structure to hold a block-wise transfer.
+ *
+ * @details The structure is allocated by the application, which sets the
+ *          public members before the transfer is started. The body of the
+ *          transfer is streamed through the read and write callbacks one block
+ *          at a time, so it never needs to be buffered as a whole.
+ *
+ *          A client transfer sends Block1 requests with the body provided by
+ *          the read callback if it is set, and fetches the Block2 responses
+ *          into the write callback.
+ *
+ *          A server transfer handles requests of one resource, see
+ *          \ref coap_block_server_get_handle and
+ *          \ref coap_block_server_put_handle.
+ */
+struct coap_block_xfer_t {
+	/** Public. Preferred block size in bytes: 16, 32, 64, 128, 256, 512 or
+	 *  1024. Smaller size proposed by the peer is used instead. A block
+	 *  and the options of its message shall fit in
+	 *  CONFIG_NRF_COAP_MESSAGE_DATA_MAX_SIZE.
+	 */
+	u16_t block_size;
+
+	/** Public. Callback to add options to every message. Could be NULL. */
+	coap_block_options_add_t options_add;
+
+	/** Public. Callback providing the body sent. Could be NULL for a client
+	 *  request without a body.
+	 */
+	coap_block_read_t read;
+
+	/** Public. Callback consuming the body received. Could be NULL if the
+	 *  body is not used.
+	 */
+	coap_block_write_t write;
+
+	/** Public. Callback called when a client transfer has ended. */
+	coap_block_done_t done;
+
+	/** Public. Miscellaneous pointer to application provided data that is
+	 *  associated with the transfer.
+	 */
+	void *arg;
+
+	/** Internal. Message configuration used for the client requests. */
+	coap_message_conf_t config;
+
+	/** Internal. Remote of the client transfer. */
+	struct sockaddr *remote;
+
+	/** Internal. Size of the blocks sent. */
+	u16_t block1_size;
+
+	/** Internal. Size of the blocks received. */
+	u16_t block2_size;
+
+	/** Internal. Number of body bytes sent and acknowledged. */
+	u32_t block1_offset;
+
+	/** Internal. Number of body bytes received. */
+	u32_t block2_offset;
+
+	/** Internal. Message ID of the last block received by a server. */
+	u16_t block1_mid;
+
+	/** Internal. True while the client is sending the request body. */
+	bool block1_active;
+
+	/** Internal. True while a client transfer is ongoing. */
+	bool active;
+};
+
+/**@brief Start a client block-wise transfer.
+ *
+ * @details The request body is sent in Block1 requests if the read callback
+ *          of the transfer is set. Response body is fetched in Block2
+ *          requests and passed to the write callback. The done callback is
+ *          called when the transfer has ended.
+ *
+ * @param[in] xfer   Block transfer to start. Public members shall be set.
+ * @param[in] config Configuration of the requests. Message ID is generated
+ *                   for every request, and the response callback is set by
+ *                   the transfer.
+ * @param[in] remote Remote to send the requests to. Shall be valid until the
+ *                   transfer has ended.
+ *
+ * @retval 0      If the first request was sent.
+ * @retval EINVAL If a parameter is NULL or the block size is not valid.
+ * @retval EBUSY  If the transfer is already ongoing.
+ */
+u32_t coap_block_client_start(coap_block_xfer_t *xfer,
+			      coap_message_conf_t *config,
+			      struct sockaddr *remote);
+
+/**@brief Respond to a GET request with a block of the resource body.
+ *
+ * @details The block requested by the Block2 option, or the first one, is read
+ *          using the read callback of the transfer and sent in a 2.05 Content
+ *          response. No state is kept between the requests, so one transfer
+ *          can serve any number of clients.
+ *
+ * @param[in] xfer    Server transfer of the resource.
+ * @param[in] request Request received.
+ *
+ * @retval 0      If the response was sent.
+ * @retval EINVAL If a parameter is NULL or the block size is not valid.
+ */
+u32_t coap_block_server_get_handle(coap_block_xfer_t *xfer,
+				   coap_message_t *request);
+
+/**@brief Handle a PUT or POST request carrying a block of the request body.
+ *
+ * @details The block is passed to the write callback of the transfer. Blocks
+ *          but the last one are responded with 2.31 Continue. The last one is
+ *          responded with the given code. A block out of sequence is
+ *          responded with 4.08 Request Entity Incomplete, and a retransmitted
+ *          block is acknowledged again without passing it to the write
+ *          callback. The transfer keeps the offset of the body, so it can
+ *          receive from one client at a time.
+ *
+ * @param[in] xfer    Server transfer of the resource.
+ * @param[in] request Request received.
+ * @param[in] code    Response code sent when the whole body is received.
+ *
+ * @retval 0      If the response was sent.
+ * @retval EINVAL If a parameter is NULL or the block size is not valid.
+ */
+u32_t coap_block_server_put_handle(coap_block_xfer_t *xfer,
+				   coap_message_t *request,
+				   coap_msg_code_t code);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* COAP_BLOCK_H__ */
 
 /** @} */
@@ -52,6 +52,11 @@ u32_t coap_message_create(coap_message_t *message,
  *          returns a decoded message if decoding was successfully, or NULL
  *          otherwise.
  *
+ *          Decoding does not copy nor allocate. Option values and the payload
+ *          of the decoded message point into raw_message, which must outlive
+ *          the message. The message itself may live in any caller-provided
+ *          memory, for example on the stack.
+ *
  * @param[out] message     The generated coap_message_t after decoding the raw
  *                         message.
  * @param[in]  raw_message Pointer to the encoded message memory buffer.
@@ -61,9 +66,12 @@ u32_t coap_message_create(coap_message_t *message,
  * @retval EINVAL   If pointer to the message or raw_message were NULL or the
  *                  message could not be decoded successfully. This could happen
  *                  if message length provided is larger than what is possible
- *                  to decode (ex. missing payload marker).
+ *                  to decode (ex. missing payload marker, reserved token
+ *                  length or an option running past message_len).
  * @retval EMSGSIZE If the message is less than 4 bytes, not containing a full
- *                  header.
+ *                  header, or the token is truncated.
+ * @retval ENOMEM   If the message holds more than COAP_MAX_NUMBER_OF_OPTIONS
+ *                  options.
  */
 u32_t coap_message_decode(coap_message_t *message, const u8_t *raw_message,
 			  u16_t message_len);
@@ -141,6 +141,42 @@ u32_t coap_observe_server_next_get(coap_observer_t **observer,
  */
 u32_t coap_observe_server_get(u32_t handle, coap_observer_t **observer);
 
+/**@brief Send a notification to all observers of a resource.
+ *
+ * @details The Observe, Content-Format and Max-Age options and the payload are
+ *          encoded once, only the header and token are written per observer.
+ *          Observers registered with another content type are skipped.
+ *
+ *          Notifications are sent as NON, except every
+ *          CONFIG_NRF_COAP_OBSERVE_CON_INTERVAL notification to an observer,
+ *          which is sent as CON to verify the observer is still interested.
+ *          An observer which rejects or does not acknowledge a CON
+ *          notification is unregistered. At most one CON notification per
+ *          observer is waiting for acknowledgment at a time.
+ *
+ * @param[in] resource    Pointer to the resource which changed. Should not be
+ *                        NULL.
+ * @param[in] type        COAP_TYPE_NON to let the library select the message
+ *                        type, or COAP_TYPE_CON to send CON notifications to
+ *                        all observers with no CON notification pending.
+ * @param[in] ct          Content format of the payload.
+ * @param[in] payload     Pointer to the payload. Can be NULL if payload_len
+ *                        is 0.
+ * @param[in] payload_len Length of the payload.
+ *
+ * @retval 0        If a notification was sent to every observer.
+ * @retval EINVAL   If resource is NULL, or payload is NULL while payload_len
+ *                  is not 0.
+ * @retval ENOENT   If the resource has no observer of the content type.
+ * @retval EMSGSIZE If the options and payload exceed
+ *                  CONFIG_NRF_COAP_MESSAGE_DATA_MAX_SIZE.
+ * @retval ENOMEM   If a CON notification could not be queued, the other
+ *                  observers are still notified.
+ */
+u32_t coap_observe_notify(coap_resource_t *resource, coap_msg_type_t type,
+			  coap_content_type_t ct, const u8_t *payload,
+			  u16_t payload_len);
+
 /**@brief Register a new observable resource.
  *
  * @param[out] handle     Handle to the observable resource instance registered.
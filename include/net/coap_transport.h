@@ -97,7 +97,9 @@ typedef struct {
 /**@brief Transport initialization information. */
 typedef struct {
 	/** Information about the ports being registered. Count is assumed to
-	 *  be COAP_PORT_COUNT.
+	 *  be COAP_PORT_COUNT. The table is copied, but the security
+	 *  parameters and the interface it points to are used to open a port
+	 *  again after an error, and shall remain valid.
 	 */
 	coap_local_t *port_table;
 
@@ -131,6 +133,22 @@ u32_t coap_transport_write(const coap_transport_handle_t handle,
 			   const struct sockaddr *remote, const u8_t *data,
 			   u16_t datalen);
 
+/**@brief Get the transport-owned buffer to serialize outgoing messages into.
+ *
+ * @details Messages that are neither retransmitted nor matched against a
+ *          response are encoded directly into this buffer and passed to
+ *          \ref coap_transport_write, avoiding an allocation per message.
+ *          The buffer is only used between the encode and the write of a
+ *          single message. If the transport does not provide a buffer, the
+ *          CoAP library allocates one per message.
+ *
+ * @param[out] length Size of the buffer.
+ *
+ * @return Pointer to the buffer, or NULL if the transport does not provide
+ *         one.
+ */
+u8_t *coap_transport_tx_buffer_get(u16_t *length);
+
 /**@brief Handles data received on a CoAP endpoint or port.
  *
  * This API is not implemented by the transport layer, but assumed to exist.
@@ -154,6 +172,33 @@ u32_t coap_transport_read(const coap_transport_handle_t handle,
 			  const struct sockaddr *local, u32_t result,
 			  const u8_t *data, u16_t datalen);
 
+/**@brief Handles a CoAP endpoint closed by the transport without an error.
+ *
+ * This API is not implemented by the transport layer, but assumed to exist,
+ * like \ref coap_transport_read. The transport calls it after it has closed
+ * an endpoint on its own, for example to reuse the slot of a cached DTLS
+ * session. Messages waiting for a response on it are failed with the error,
+ * before the handle can be given to a new endpoint.
+ *
+ * @param[in] handle   Transport which was closed.
+ * @param[in] err_code Error passed to the response callbacks.
+ */
+void coap_transport_closed(const coap_transport_handle_t handle,
+			   u32_t err_code);
+
+/**@brief Handles an error on a CoAP endpoint or port.
+ *
+ * This API is not implemented by the transport layer, but assumed to exist,
+ * like \ref coap_transport_read. The transport calls it after it has closed
+ * the endpoint, or opened the port again. Messages waiting for a response on it are failed with the
+ * error, and the error is reported to the application.
+ *
+ * @param[in] handle   Transport on which the error occurred.
+ * @param[in] err_code Error which occurred.
+ */
+void coap_transport_error(const coap_transport_handle_t handle,
+			  u32_t err_code);
+
 /**@brief Process loop to handle DTLS processing.
  *
  * @details The function handles any processing of encrypted packets.
@@ -167,14 +212,31 @@ void coap_transport_process(void);
 
 /**@brief Process loop when using CoAP BSD socket transport implementation.
  *
- * @details This is blocking call. The function unblock is only triggered upon
- *          an socket event registered to select() by CoAP transport. This
- *          function must be called as often as possible in order to dispatch
- *          incoming socket events. Preferred to be put in the application's
- *          main loop or similar.
+ * @details Handles the data pending on any of the CoAP sockets without
+ *          blocking, see \ref coap_transport_poll.
  */
 void coap_transport_input(void);
 
+/**@brief Wait for data on the CoAP endpoints and handle it.
+ *
+ * @details Waits with a single poll() on all ports and secure sessions, and
+ *          reads up to COAP_INPUT_BUDGET datagrams from every socket which is
+ *          ready for reading. Each datagram is passed to
+ *          \ref coap_transport_read. A session whose socket reports an error
+ *          is closed, and a port is opened again on the same address. Either
+ *          is passed to \ref coap_transport_error. A port which could not be
+ *          opened again is retried on the next call.
+ *
+ * @param[in] timeout Maximum time to wait in milliseconds. 0 to return
+ *                    immediately, or K_FOREVER to wait until data is
+ *                    received.
+ *
+ * @retval 0        If the data was handled, or the timeout expired.
+ * @retval ENOTCONN If there is no socket to wait on.
+ * @retval EIO      If poll() failed.
+ */
+u32_t coap_transport_poll(s32_t timeout);
+
 #ifdef __cplusplus
 }
 #endif
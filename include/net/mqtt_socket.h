@@ -25,6 +25,7 @@
 #include <stddef.h>
 
 #include <zephyr/types.h>
+#include <kernel.h>
 #include <net/tls_credentials.h>
 
 #ifdef __cplusplus
@@ -48,6 +49,11 @@ enum mqtt_evt_type {
 
 	/** Publish event received when message is published on a topic client
 	 *  is subscribed to.
+	 *
+	 *  @note If the message does not fit in the client RX buffer, payload
+	 *        data pointer is NULL and payload length is the total length of
+	 *        the payload. The payload shall be read with
+	 *        @ref mqtt_read_publish_payload.
 	 */
 	MQTT_EVT_PUBLISH,
 
@@ -73,7 +79,8 @@ enum mqtt_evt_type {
 /** @brief MQTT version protocol level. */
 enum mqtt_version {
 	MQTT_VERSION_3_1_0 = 3, /**< Protocol level for 3.1.0. */
-	MQTT_VERSION_3_1_1 = 4  /**< Protocol level for 3.1.1. */
+	MQTT_VERSION_3_1_1 = 4, /**< Protocol level for 3.1.1. */
+	MQTT_VERSION_5_0   = 5  /**< Protocol level for 5.0. */
 };
 
 /** @brief MQTT Quality of Service types. */
@@ -122,6 +129,28 @@ enum mqtt_conn_return_code {
 	MQTT_NOT_AUTHORIZED                     = 0x05
 };
 
+/** @brief MQTT 5.0 reason codes used in acknowledgments. Codes 0x80 and
+ *         above indicate a failure.
+ */
+enum mqtt_reason_code {
+	MQTT_REASON_SUCCESS                     = 0x00,
+	MQTT_REASON_NO_MATCHING_SUBSCRIBERS     = 0x10,
+	MQTT_REASON_UNSPECIFIED_ERROR           = 0x80,
+	MQTT_REASON_MALFORMED_PACKET            = 0x81,
+	MQTT_REASON_PROTOCOL_ERROR              = 0x82,
+	MQTT_REASON_IMPLEMENTATION_SPECIFIC     = 0x83,
+	MQTT_REASON_NOT_AUTHORIZED              = 0x87,
+	MQTT_REASON_SERVER_BUSY                 = 0x89,
+	MQTT_REASON_TOPIC_NAME_INVALID          = 0x90,
+	MQTT_REASON_PACKET_ID_IN_USE            = 0x91,
+	MQTT_REASON_PACKET_ID_NOT_FOUND         = 0x92,
+	MQTT_REASON_RECEIVE_MAXIMUM_EXCEEDED    = 0x93,
+	MQTT_REASON_TOPIC_ALIAS_INVALID         = 0x94,
+	MQTT_REASON_PACKET_TOO_LARGE            = 0x95,
+	MQTT_REASON_QUOTA_EXCEEDED              = 0x97,
+	MQTT_REASON_PAYLOAD_FORMAT_INVALID      = 0x99
+};
+
 /** @brief MQTT SUBACK return codes. */
 enum mqtt_suback_return_code {
 	/** Subscription with QoS 0 succeeded. */
@@ -178,33 +207,58 @@ struct mqtt_connack_param {
 
 	/** The appropriate non-zero Connect return code indicates if the Server
 	 *  is unable to process a connection request for some reason.
+	 *  With MQTT 5.0, this is the CONNACK reason code.
 	 */
 	enum mqtt_conn_return_code return_code;
+
+	/** MQTT 5.0 Receive Maximum of the server, the number of QoS 1 and
+	 *  QoS 2 messages that can be unacknowledged at a time.
+	 */
+	u16_t receive_max;
+
+	/** MQTT 5.0 Topic Alias Maximum of the server, 0 if the server does
+	 *  not accept topic aliases.
+	 */
+	u16_t topic_alias_max;
 };
 
 /** @brief Parameters for MQTT publish acknowledgment (PUBACK). */
 struct mqtt_puback_param {
 	u16_t message_id;
+
+	/** MQTT 5.0 reason code, see @ref mqtt_reason_code. */
+	u8_t reason_code;
 };
 
 /** @brief Parameters for MQTT publish receive (PUBREC). */
 struct mqtt_pubrec_param {
 	u16_t message_id;
+
+	/** MQTT 5.0 reason code, see @ref mqtt_reason_code. */
+	u8_t reason_code;
 };
 
 /** @brief Parameters for MQTT publish release (PUBREL). */
 struct mqtt_pubrel_param {
 	u16_t message_id;
+
+	/** MQTT 5.0 reason code, see @ref mqtt_reason_code. */
+	u8_t reason_code;
 };
 
 /** @brief Parameters for MQTT publish complete (PUBCOMP). */
 struct mqtt_pubcomp_param {
 	u16_t message_id;
+
+	/** MQTT 5.0 reason code, see @ref mqtt_reason_code. */
+	u8_t reason_code;
 };
 
 /** @brief Parameters for MQTT subscription acknowledgment (SUBACK). */
 struct mqtt_suback_param {
 	u16_t message_id;
+
+	/** Return codes, with MQTT 5.0 reason codes, of the subscriptions. */
 	struct mqtt_binstr return_codes;
 };
 
@@ -292,6 +346,17 @@ struct mqtt_evt {
 
 struct mqtt_client;
 
+#if defined(CONFIG_MQTT_LIB_V5)
+/** @brief Topic with an MQTT 5.0 topic alias assigned. Internal. */
+struct mqtt_topic_alias {
+	/** Copy of the topic. */
+	u8_t topic[CONFIG_MQTT_TOPIC_ALIAS_MAX_LENGTH];
+
+	/** Length of the topic, 0 if the alias is not assigned. */
+	u16_t size;
+};
+#endif /* CONFIG_MQTT_LIB_V5 */
+
 /**
  * @brief Asynchronous event notification callback registered by the
  *        application.
@@ -431,6 +496,60 @@ struct mqtt_client {
 	/** Internal. Shall not be touched by the application. */
 	u32_t rx_buf_datalen;
 
+	/** Internal. Shall not be touched by the application. Length of
+	 *  the received PUBLISH payload not yet read by the application.
+	 */
+	u32_t remaining_payload;
+
+	/** Internal. Shall not be touched by the application. Offset of
+	 *  the PUBLISH payload part received in the RX buffer.
+	 */
+	u32_t rx_payload_offset;
+
+	/** Internal. Shall not be touched by the application. Serializes
+	 *  procedures on the client, so that clients do not block each other.
+	 */
+	struct k_mutex lock;
+
+#if defined(CONFIG_MQTT_PUBLISH_BATCH)
+	/** Internal. Shall not be touched by the application. Buffer with
+	 *  the encoded messages waiting to be sent in a batch.
+	 */
+	u8_t *batch_buf;
+
+	/** Internal. Shall not be touched by the application. */
+	u32_t batch_len;
+
+	/** Internal. Shall not be touched by the application. Wall clock
+	 *  value (in milliseconds) when the first message was added to
+	 *  the batch.
+	 */
+	u32_t batch_timestamp;
+#endif /* CONFIG_MQTT_PUBLISH_BATCH */
+
+#if defined(CONFIG_MQTT_LIB_V5)
+	/** Internal. Shall not be touched by the application. Number of
+	 *  QoS 1 and QoS 2 messages that can still be sent before they are
+	 *  acknowledged, limited by the server Receive Maximum.
+	 */
+	u16_t send_quota;
+
+	/** Internal. Shall not be touched by the application. Receive
+	 *  Maximum of the server, received in the CONNACK.
+	 */
+	u16_t receive_max;
+
+	/** Internal. Shall not be touched by the application. Number of
+	 *  topic aliases that can be used on the connection.
+	 */
+	u16_t topic_alias_max;
+
+	/** Internal. Shall not be touched by the application. Topics with
+	 *  an alias assigned, the alias is the index plus one.
+	 */
+	struct mqtt_topic_alias topic_aliases[CONFIG_MQTT_TOPIC_ALIAS_MAX];
+#endif /* CONFIG_MQTT_LIB_V5 */
+
 	/** Unique client identification to be used for the connection. */
 	struct mqtt_utf8 client_id;
 
@@ -481,7 +600,9 @@ void mqtt_client_init(struct mqtt_client *client);
  * @return 0 or a negative error code (errno.h) indicating reason of failure.
  *
  * @note Default protocol revision used for connection request is 3.1.1. Please
- *       set client.protocol_version = MQTT_VERSION_3_1_0 to use protocol 3.1.0.
+ *       set client.protocol_version = MQTT_VERSION_3_1_0 to use protocol 3.1.0,
+ *       or MQTT_VERSION_5_0 to use protocol 5.0 if
+ *       :option:`CONFIG_MQTT_LIB_V5` is enabled.
  * @note If more than one simultaneous client connections are needed, please
  *       modify :option:`CONFIG_MQTT_MAX_CLIENTS` to override default of 1.
  * @note Please modify :option:`CONFIG_MQTT_KEEPALIVE` time to override default
@@ -501,6 +622,24 @@ int mqtt_connect(struct mqtt_client *client);
  *                  Shall not be NULL.
  *
  * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ *
+ * @note Only the fixed header, topic and message id are encoded in the client
+ *       TX buffer. The payload is passed to the transport directly from
+ *       the application buffer, so it is not limited by
+ *       :option:`CONFIG_MQTT_MAX_PACKET_LENGTH`.
+ * @note If :option:`CONFIG_MQTT_INFLIGHT` is enabled, messages with QoS 1 and
+ *       QoS 2 are stored until acknowledged and sent again if needed. Such
+ *       messages are limited by
+ *       :option:`CONFIG_MQTT_INFLIGHT_MAX_MESSAGE_LENGTH`. If the client
+ *       does not use a clean session, 0 is returned for a stored message
+ *       even if the connection is closed because it cannot be sent, as it
+ *       is sent again after reconnecting. The connection loss is reported
+ *       by the MQTT_EVT_DISCONNECT event. With a clean session, -EIO is
+ *       returned, as stored messages are dropped on reconnection.
+ * @note With MQTT 5.0, -EAGAIN is returned for a QoS 1 or QoS 2 message if as
+ *       many messages as the server Receive Maximum are not acknowledged yet.
+ *       Topic aliases are used automatically, a topic is sent only with
+ *       the first message on it after connecting.
  */
 int mqtt_publish(struct mqtt_client *client,
 		 const struct mqtt_publish_param *param);
@@ -646,6 +785,273 @@ int mqtt_live(void);
  */
 int mqtt_input(struct mqtt_client *client);
 
+/**
+ * @brief Wait for incoming data on all connected clients and process it,
+ *        keeping the connections alive. Can be used instead of calling
+ *        @ref mqtt_input and @ref mqtt_live.
+ *
+ * @details Sockets of all connected clients are polled together and only
+ *          clients with incoming data are read. The poll ends no later than
+ *          the nearest keep-alive or retransmission deadline of a client, so
+ *          the application does not need to call this function more often
+ *          than when it returns.
+ *
+ * @param[in] timeout Maximum time to wait for incoming data in milliseconds,
+ *                    K_NO_WAIT or K_FOREVER.
+ *
+ * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ *         -ENOTCONN if no client is connected.
+ */
+int mqtt_process(s32_t timeout);
+
+/**
+ * @brief Read the payload of a received PUBLISH message that does not fit in
+ *        the client RX buffer. The payload is read directly from
+ *        the transport, blocking until some data is available.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ * @param[out] buffer Buffer where the payload is to be stored.
+ * @param[in] length Size of the buffer.
+ *
+ * @return Number of bytes read, 0 if the whole payload was already read or
+ *         a negative error code (errno.h) indicating reason of failure.
+ *
+ * @note Shall be called from the @ref MQTT_EVT_PUBLISH event handler or
+ *       after it, but before the next call to @ref mqtt_input. The payload
+ *       not read by then is discarded.
+ */
+int mqtt_read_publish_payload(struct mqtt_client *client, void *buffer,
+			      size_t length);
+
+/**
+ * @brief Read the payload of a received PUBLISH message until the buffer is
+ *        full. See @ref mqtt_read_publish_payload for details.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ * @param[out] buffer Buffer where the payload is to be stored.
+ * @param[in] length Number of bytes to be read.
+ *
+ * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ *         -EIO is returned if the payload is shorter than requested.
+ */
+int mqtt_readall_publish_payload(struct mqtt_client *client, u8_t *buffer,
+				 size_t length);
+
+#if defined(CONFIG_MQTT_INFLIGHT)
+/** @brief Persistent storage backend for in-flight messages. Messages are
+ *         identified by the client id and the message id.
+ */
+struct mqtt_inflight_storage {
+	/** Store an encoded message, replacing the one with the same id. */
+	int (*store)(const struct mqtt_utf8 *client_id, u16_t message_id,
+		     const u8_t *data, u32_t len);
+
+	/** Remove a stored message. */
+	void (*remove)(const struct mqtt_utf8 *client_id, u16_t message_id);
+
+	/** Load all stored messages of the client, calling
+	 *  @ref mqtt_inflight_restore for each of them. Called on connection
+	 *  request with the clean session flag cleared.
+	 */
+	void (*load)(struct mqtt_client *client);
+};
+
+/**
+ * @brief Set persistent storage backend for in-flight messages.
+ *
+ * @param[in] storage Storage backend. NULL to keep the messages in RAM only.
+ */
+void mqtt_inflight_storage_set(const struct mqtt_inflight_storage *storage);
+
+/**
+ * @brief Restore an in-flight message loaded from the persistent storage.
+ *        The message is sent again once the client is connected.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ * @param[in] message_id Message id.
+ * @param[in] data Encoded message, as provided to the storage backend.
+ * @param[in] len Length of the encoded message.
+ *
+ * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ */
+int mqtt_inflight_restore(struct mqtt_client *client, u16_t message_id,
+			  const u8_t *data, u32_t len);
+
+/**
+ * @brief Get number of in-flight messages of the client, that is messages
+ *        published with QoS 1 or QoS 2 and not yet acknowledged.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *
+ * @return Number of in-flight messages.
+ */
+u32_t mqtt_inflight_count(const struct mqtt_client *client);
+#endif /* CONFIG_MQTT_INFLIGHT */
+
+#if defined(CONFIG_MQTT_PUBLISH_BATCH)
+/**
+ * @brief API to publish a message as a part of a batch. The message is
+ *        encoded into the batch buffer of the client and sent later together
+ *        with the other messages of the batch.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ * @param[in] param Parameters to be used for the publish message.
+ *                  Shall not be NULL.
+ *
+ * @note The payload is copied, the application buffer can be reused as soon
+ *       as the function returns.
+ *
+ * @note The batch is sent when the next message does not fit in it, when
+ *       it is older than :option:`CONFIG_MQTT_PUBLISH_BATCH_TIMEOUT` on
+ *       a call to @ref mqtt_live or @ref mqtt_process, before any other packet
+ *       of the client is sent, or by @ref mqtt_publish_batch_flush. Messages
+ *       with QoS 0 that are still in the batch on disconnection are lost,
+ *       stored QoS 1 and QoS 2 messages are handled as with
+ *       @ref mqtt_publish.
+ *
+ * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ */
+int mqtt_publish_batch(struct mqtt_client *client,
+		       const struct mqtt_publish_param *param);
+
+/**
+ * @brief API to send the messages waiting in the batch buffer of the client
+ *        with a single transport write.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ *
+ * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ */
+int mqtt_publish_batch_flush(struct mqtt_client *client);
+#endif /* CONFIG_MQTT_PUBLISH_BATCH */
+
+#if defined(CONFIG_MQTT_ROUTER)
+/**
+ * @brief Handler of received PUBLISH messages matching a route.
+ *
+ * @param[in] client Client instance which received the message.
+ * @param[in] param Received message.
+ * @param[in] user_data User data registered with the route.
+ */
+typedef void (*mqtt_route_handler_t)(struct mqtt_client *client,
+				     const struct mqtt_publish_param *param,
+				     void *user_data);
+
+/** @brief Node of the router trie, one per topic filter level. Internal. */
+struct mqtt_router_node {
+	/** Topic filter level, not terminated. NULL if the node is free. */
+	const u8_t *level;
+
+	/** Handler of the route ending at this level, if any. */
+	mqtt_route_handler_t handler;
+
+	/** User data passed to the handler. */
+	void *user_data;
+
+	/** Length of the level. */
+	u16_t level_len;
+
+	/** Index of the first child node, 0 if none. */
+	u16_t child;
+
+	/** Index of the next sibling node, 0 if none. */
+	u16_t sibling;
+};
+
+/**
+ * @brief Router of received PUBLISH messages to handlers of subscriptions.
+ *
+ * @details Topic filters are kept in a trie with a node per filter level,
+ *          so matching a topic takes time proportional to its depth rather
+ *          than to the number of routes. Node 0 is the root.
+ */
+struct mqtt_router {
+	/** Nodes of the trie. */
+	struct mqtt_router_node *nodes;
+
+	/** Number of nodes, including the root. */
+	u16_t node_count;
+};
+
+/**
+ * @brief Statically define a router.
+ *
+ * @param name Name of the router.
+ * @param max_levels Total number of distinct topic filter levels the router
+ *                   can hold, for example "a/b" and "a/+" take 3 levels.
+ */
+#define MQTT_ROUTER_DEFINE(name, max_levels)				\
+	static struct mqtt_router_node					\
+		_mqtt_router_nodes_##name[(max_levels) + 1];		\
+	static struct mqtt_router name = {				\
+		.nodes = _mqtt_router_nodes_##name,			\
+		.node_count = (max_levels) + 1,				\
+	}
+
+/**
+ * @brief Initialize a router with the provided nodes.
+ *
+ * @param[out] router Router to initialize.
+ * @param[in] nodes Node array, including a node for the root.
+ * @param[in] node_count Number of nodes in the array.
+ */
+void mqtt_router_init(struct mqtt_router *router,
+		      struct mqtt_router_node *nodes, u16_t node_count);
+
+/**
+ * @brief Add a route for a topic filter.
+ *
+ * @param[in] router Router. Shall not be NULL.
+ * @param[in] filter Topic filter, can contain '+' and '#' wildcards. The
+ *                   filter string is referenced, not copied, and shall be
+ *                   kept valid while the route exists.
+ * @param[in] handler Handler called for messages matching the filter.
+ * @param[in] user_data User data passed to the handler.
+ *
+ * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ *         -EEXIST if the filter already has a route, -ENOMEM if there are no
+ *         free nodes.
+ */
+int mqtt_router_add(struct mqtt_router *router,
+		    const struct mqtt_utf8 *filter,
+		    mqtt_route_handler_t handler, void *user_data);
+
+/**
+ * @brief Remove the route of a topic filter.
+ *
+ * @param[in] router Router. Shall not be NULL.
+ * @param[in] filter Topic filter the route was added with.
+ *
+ * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ */
+int mqtt_router_remove(struct mqtt_router *router,
+		       const struct mqtt_utf8 *filter);
+
+/**
+ * @brief Call handlers of all routes matching the topic of a message.
+ *        Intended to be called on @ref MQTT_EVT_PUBLISH.
+ *
+ * @param[in] router Router. Shall not be NULL.
+ * @param[in] client Client instance which received the message.
+ * @param[in] param Received message. Shall not be NULL.
+ *
+ * @note The router does not lock, routes shall not be modified while
+ *       messages are dispatched. If a payload is read with
+ *       @ref mqtt_read_publish_payload, only one route shall match it.
+ *
+ * @return Number of handlers called or a negative error code (errno.h)
+ *         indicating reason of failure.
+ */
+int mqtt_router_dispatch(const struct mqtt_router *router,
+			 struct mqtt_client *client,
+			 const struct mqtt_publish_param *param);
+#endif /* CONFIG_MQTT_ROUTER */
+
 #ifdef __cplusplus
 }
 #endif
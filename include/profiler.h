@@ -16,15 +16,17 @@
 
 
 #include <zephyr/types.h>
+#include <atomic.h>
 
 #ifndef CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS
 /** Maximum number of custom events. */
 #define CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS 0
 #endif
 
-/** @brief Set of flags for enabling/disabling profiling for given event types.
+/** @brief Bitmap of flags for enabling/disabling profiling for given
+ *         event types.
  */
-extern u32_t profiler_enabled_events;
+extern atomic_t profiler_enabled_events[];
 
 
 /** @brief Number of event types registered in the Profiler.
@@ -102,7 +104,8 @@ static inline bool is_profiling_enabled(size_t profiler_event_id)
 {
 	if (IS_ENABLED(CONFIG_PROFILER)) {
 		__ASSERT_NO_MSG(profiler_event_id < CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
-		return (profiler_enabled_events & BIT(profiler_event_id)) != 0;
+		return atomic_test_bit(profiler_enabled_events,
+				       profiler_event_id);
 	}
 	return false;
 }
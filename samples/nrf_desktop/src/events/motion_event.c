@@ -27,6 +27,24 @@ static void profile_motion_event(struct log_event_buf *buf,
 }
 
 
+static s16_t motion_sum(s16_t a, s16_t b)
+{
+	s32_t sum = (s32_t)a + b;
+
+	return MAX(MIN(sum, INT16_MAX), INT16_MIN);
+}
+
+static void merge_motion_event(struct event_header *queued,
+			       const struct event_header *eh)
+{
+	struct motion_event *event = cast_motion_event(queued);
+	const struct motion_event *new_event = cast_motion_event(eh);
+
+	event->dx = motion_sum(event->dx, new_event->dx);
+	event->dy = motion_sum(event->dy, new_event->dy);
+}
+
+
 EVENT_INFO_DEFINE(motion_event,
 		  ENCODE(PROFILER_ARG_S32, PROFILER_ARG_S32),
 		  ENCODE("dx", "dy"),
@@ -36,3 +54,5 @@ EVENT_TYPE_DEFINE(motion_event,
 		  IS_ENABLED(CONFIG_DESKTOP_INIT_LOG_MOTION_EVENT),
 		  log_motion_event,
 		  &motion_event_info);
+
+EVENT_TYPE_COALESCE(motion_event, merge_motion_event);
@@ -16,7 +16,19 @@ static int log_wheel_event(const struct event_header *eh, char *buf,
 	return snprintf(buf, buf_len, "wheel=%d", event->wheel);
 }
 
+static void merge_wheel_event(struct event_header *queued,
+			      const struct event_header *eh)
+{
+	struct wheel_event *event = cast_wheel_event(queued);
+	const struct wheel_event *new_event = cast_wheel_event(eh);
+	s32_t wheel = (s32_t)event->wheel + new_event->wheel;
+
+	event->wheel = MAX(MIN(wheel, INT16_MAX), INT16_MIN);
+}
+
 EVENT_TYPE_DEFINE(wheel_event,
 		  IS_ENABLED(CONFIG_DESKTOP_INIT_LOG_WHEEL_EVENT),
 		  log_wheel_event,
 		  NULL);
+
+EVENT_TYPE_COALESCE(wheel_event, merge_wheel_event);
@@ -0,0 +1,115 @@
+# Copyright (c) 2019 Nordic Semiconductor ASA
+# SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+
+from columnar_capture import CaptureReader, CaptureWriter
+from events import EventsData
+from stream_analyzer import StreamAnalyzer
+
+import argparse
+import logging
+import queue
+import signal
+import threading
+import time
+
+# Limits memory used by events waiting for analysis
+QUEUE_MAX_SIZE = 100000
+
+
+def rtt_thread(queue, finish_event, time_seconds, log_lvl_number):
+    from rtt_nordic_profiler_host import RttNordicProfilerHost
+
+    profiler = RttNordicProfilerHost(finish_event=finish_event, queue=queue,
+                                     log_lvl=log_lvl_number,
+                                     store_events=False)
+    profiler.get_events_descriptions()
+    profiler.read_events_rtt(time_seconds)
+
+
+def events_from_rtt(time_seconds, log_lvl_number):
+    end_ev = threading.Event()
+
+    def sigint_handler(sig, frame):
+        end_ev.set()
+
+    signal.signal(signal.SIGINT, sigint_handler)
+
+    que = queue.Queue(maxsize=QUEUE_MAX_SIZE)
+    t_rtt = threading.Thread(
+        target=rtt_thread,
+        args=[que, end_ev, time_seconds, log_lvl_number])
+    t_rtt.start()
+
+    registered_events_types = que.get()
+
+    def events():
+        while True:
+            event = que.get()
+            if event is None:
+                return
+            yield event
+
+    return registered_events_types, events()
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Analyzing events in bounded memory, live from Nordic profiler or from files.')
+    parser.add_argument('--input_capture', help='Capture file to read events from')
+    parser.add_argument('--input_csv', nargs=2, metavar=('EVENT_CSV', 'EVENT_DESCR'),
+                        help='.csv and .json files to read events from')
+    parser.add_argument('--time', type=int, default=-1,
+                        help='Time of collecting data from device [s]')
+    parser.add_argument('--capture', help='Capture file to save events')
+    parser.add_argument('--window', type=float, default=1.0,
+                        help='Length of rolling statistics window [s]')
+    parser.add_argument('--window_cnt', type=int, default=10,
+                        help='Number of windows used for rolling statistics')
+    parser.add_argument('--report_period', type=float, default=2.0,
+                        help='Period of printing statistics [s]')
+    parser.add_argument('--log', help='Log level')
+    args = parser.parse_args()
+
+    if args.log is not None:
+        log_lvl_number = int(getattr(logging, args.log.upper(), None))
+    else:
+        log_lvl_number = logging.WARNING
+
+    reader = None
+    if args.input_capture is not None:
+        reader = CaptureReader(args.input_capture)
+        registered_events_types = reader.registered_events_types
+        events = reader.events()
+    elif args.input_csv is not None:
+        events_data = EventsData([], {})
+        events_data.read_data_from_files(args.input_csv[0], args.input_csv[1])
+        registered_events_types = events_data.registered_events_types
+        events = iter(events_data.events)
+    else:
+        registered_events_types, events = events_from_rtt(args.time,
+                                                          log_lvl_number)
+
+    analyzer = StreamAnalyzer(registered_events_types, args.window,
+                              args.window_cnt, log_lvl_number)
+    writer = None
+    if args.capture is not None:
+        writer = CaptureWriter(args.capture, registered_events_types)
+
+    last_report = time.time()
+    for event in events:
+        analyzer.process(event)
+        if writer is not None:
+            writer.write(event)
+        if time.time() - last_report >= args.report_period:
+            analyzer.print_report()
+            last_report = time.time()
+
+    analyzer.print_report()
+
+    if writer is not None:
+        writer.close()
+    if reader is not None:
+        reader.close()
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,124 @@
+# Copyright (c) 2019 Nordic Semiconductor ASA
+# SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+
+from array import array
+from events import Event, EventType, EventsData
+import json
+import logging
+import struct
+import sys
+
+# Capture file layout (little endian):
+#   magic, header length (u32), header (json with event descriptions)
+#   chunks: event count (u32), data value count (u32),
+#           type ids (u8 array), timestamps (double array),
+#           event data of all events in the chunk (s64 array)
+CAPTURE_MAGIC = b'NPRFCAP1'
+CHUNK_HEADER = struct.Struct('<II')
+DEFAULT_CHUNK_SIZE = 4096
+
+
+def _to_le(arr):
+    if sys.byteorder != 'little':
+        arr.byteswap()
+    return arr.tobytes()
+
+
+def _from_le(typecode, buf):
+    arr = array(typecode)
+    arr.frombytes(buf)
+    if sys.byteorder != 'little':
+        arr.byteswap()
+    return arr
+
+
+class CaptureWriter():
+    def __init__(self, filename, registered_events_types,
+                 chunk_size=DEFAULT_CHUNK_SIZE):
+        self.chunk_size = chunk_size
+        self.logger = logging.getLogger('Capture Writer')
+        try:
+            self.file = open(filename, 'wb')
+        except IOError:
+            self.logger.error("Problem with accessing file: " + filename)
+            sys.exit()
+
+        header = json.dumps(dict((k, v.serialize())
+                            for k, v in registered_events_types.items()))
+        header = header.encode('utf-8')
+        self.file.write(CAPTURE_MAGIC)
+        self.file.write(struct.pack('<I', len(header)))
+        self.file.write(header)
+        self._reset_chunk()
+
+    def _reset_chunk(self):
+        self.type_ids = array('B')
+        self.timestamps = array('d')
+        self.data = array('q')
+
+    def write(self, event):
+        self.type_ids.append(event.type_id)
+        self.timestamps.append(event.timestamp)
+        self.data.extend(event.data)
+        if len(self.type_ids) >= self.chunk_size:
+            self.flush()
+
+    def flush(self):
+        if len(self.type_ids) == 0:
+            return
+        self.file.write(CHUNK_HEADER.pack(len(self.type_ids), len(self.data)))
+        self.file.write(_to_le(self.type_ids))
+        self.file.write(_to_le(self.timestamps))
+        self.file.write(_to_le(self.data))
+        self._reset_chunk()
+
+    def close(self):
+        self.flush()
+        self.file.close()
+
+
+class CaptureReader():
+    def __init__(self, filename):
+        self.filename = filename
+        self.logger = logging.getLogger('Capture Reader')
+        try:
+            self.file = open(filename, 'rb')
+        except IOError:
+            self.logger.error("Problem with accessing file: " + filename)
+            sys.exit()
+
+        if self.file.read(len(CAPTURE_MAGIC)) != CAPTURE_MAGIC:
+            self.logger.error("Not a capture file: " + filename)
+            sys.exit()
+
+        header_len = struct.unpack('<I', self.file.read(4))[0]
+        header = json.loads(self.file.read(header_len).decode('utf-8'))
+        self.registered_events_types = dict(
+            (int(k), EventType.deserialize(v)) for k, v in header.items())
+
+    def chunks(self):
+        # Yields (type ids, timestamps, data) column arrays of every chunk
+        while True:
+            buf = self.file.read(CHUNK_HEADER.size)
+            if len(buf) < CHUNK_HEADER.size:
+                return
+            ev_cnt, data_cnt = CHUNK_HEADER.unpack(buf)
+            type_ids = _from_le('B', self.file.read(ev_cnt))
+            timestamps = _from_le('d', self.file.read(8 * ev_cnt))
+            data = _from_le('q', self.file.read(8 * data_cnt))
+            yield type_ids, timestamps, data
+
+    def events(self):
+        for type_ids, timestamps, data in self.chunks():
+            pos = 0
+            for type_id, timestamp in zip(type_ids, timestamps):
+                data_cnt = len(
+                    self.registered_events_types[type_id].data_types)
+                yield Event(type_id, timestamp, list(data[pos:pos + data_cnt]))
+                pos += data_cnt
+
+    def read_events_data(self):
+        return EventsData(list(self.events()), self.registered_events_types)
+
+    def close(self):
+        self.file.close()
@@ -0,0 +1,29 @@
+# Copyright (c) 2019 Nordic Semiconductor ASA
+# SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+
+from events import EventsData
+import argparse
+import logging
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Decoding trace dumped by offline profiler and saving to files.')
+    parser.add_argument('dump', help='Text file with output of "profiler_trace dump" command')
+    parser.add_argument('event_csv', help='.csv file to save decoded events')
+    parser.add_argument('event_descr', help='.json file to save events descriptions')
+    parser.add_argument('--log', help='Log level')
+    args = parser.parse_args()
+
+    if args.log is not None:
+	    log_lvl_number = int(getattr(logging, args.log.upper(), None))
+    else:
+	    log_lvl_number = logging.WARNING
+
+    events_data = EventsData([], {})
+    events_data.logger.setLevel(log_lvl_number)
+    events_data.read_data_from_offline_dump(args.dump)
+    events_data.write_data_to_files(args.event_csv, args.event_descr)
+
+if __name__ == "__main__":
+    main()
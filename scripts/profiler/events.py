@@ -38,6 +38,16 @@ class EventType():
             json["data_types"],
             json["data_descriptions"])
 
+    @staticmethod
+    def parse_description(desc):
+        # Description sent by device: name,id,data types...,data descriptions...
+        desc_fields = desc.split(',')
+        name = desc_fields[0]
+        id = int(desc_fields[1])
+        data_types = desc_fields[2:len(desc_fields) // 2 + 1]
+        data_descriptions = desc_fields[len(desc_fields) // 2 + 1:]
+        return id, EventType(name, data_types, data_descriptions)
+
 
 class TrackedEvent():
     def __init__(self, submit, start_time, end_time):
@@ -83,6 +93,87 @@ class EventsData():
             self.logger.warning("Hash values of csv files do not match")
             self.logger.warning("Events and descriptions may be inconsistent")
 
+    def read_data_from_offline_dump(self, filename):
+        try:
+            with open(filename, 'r', errors='replace') as dump:
+                lines = dump.readlines()
+        except IOError:
+            self.logger.error("Problem with accessing file: " + filename)
+            sys.exit()
+
+        # Lines may be prefixed by shell prompt or log timestamps.
+        # If file contains multiple dumps, the last one is used.
+        cycles_per_sec = None
+        in_trace = False
+        for line in lines:
+            if 'profiler_trace_begin' in line:
+                fields = line[line.find('profiler_trace_begin'):].split()
+                cycles_per_sec = int(fields[1])
+                overwritten = int(fields[2])
+                raw_data = bytearray()
+                self.registered_events_types = {}
+                in_trace = True
+            elif not in_trace:
+                continue
+            elif 'profiler_trace_end' in line:
+                in_trace = False
+            elif 'desc:' in line:
+                id, et = EventType.parse_description(
+                             line[line.find('desc:') + 5:].strip())
+                self.registered_events_types[id] = et
+            elif 'data:' in line:
+                raw_data += bytes.fromhex(line[line.find('data:') + 5:].strip())
+
+        if cycles_per_sec is None:
+            self.logger.error("No trace found in file: " + filename)
+            sys.exit()
+
+        if overwritten > 0:
+            self.logger.warning("{} oldest events were overwritten on device"
+                                .format(overwritten))
+
+        self.events = []
+        self._decode_offline_events(raw_data, cycles_per_sec)
+
+    def _decode_offline_events(self, raw_data, cycles_per_sec):
+        # Records: type ID (u8), timestamp (u32) and event data (u32 each)
+        timestamp_raw_max = 2**32
+        timestamp_ticks = None
+        prev_timestamp_raw = 0
+        pos = 0
+        while pos < len(raw_data):
+            type_id = raw_data[pos]
+            if type_id not in self.registered_events_types:
+                self.logger.error("Unknown event type ID: {}".format(type_id))
+                return
+            et = self.registered_events_types[type_id]
+
+            timestamp_raw = int.from_bytes(raw_data[pos + 1:pos + 5],
+                                           byteorder='little', signed=False)
+            if timestamp_ticks is None:
+                timestamp_ticks = timestamp_raw
+            else:
+                # Signed 32-bit difference: only a backward jump of more
+                # than half the range is an overflow, smaller ones are
+                # events recorded out of order.
+                delta = (timestamp_raw - prev_timestamp_raw) % timestamp_raw_max
+                if delta >= timestamp_raw_max // 2:
+                    delta -= timestamp_raw_max
+                timestamp_ticks += delta
+            prev_timestamp_raw = timestamp_raw
+            timestamp = timestamp_ticks / cycles_per_sec
+            pos += 5
+
+            data = []
+            for i in et.data_types:
+                signum = False
+                if i[0] == 's':
+                    signum = True
+                data.append(int.from_bytes(raw_data[pos:pos + 4],
+                                           byteorder='little', signed=signum))
+                pos += 4
+            self.events.append(Event(type_id, timestamp, data))
+
     def _calculate_md5_hash_of_file(filename):
         return hashlib.md5(open(filename, 'rb').read()).hexdigest()
 
@@ -23,15 +23,20 @@ class RttNordicProfilerHost:
 
     def __init__(self, config=RttNordicConfig, finish_event=None,
                  queue=None, event_filename=None,
-                 event_types_filename=None, log_lvl=logging.WARNING):
+                 event_types_filename=None, log_lvl=logging.WARNING,
+                 store_events=True):
         self.event_filename = event_filename
         self.event_types_filename = event_types_filename
         self.config = config
         self.finish_event = finish_event
         self.queue = queue
         self.received_events = EventsData([], {})
+        # Events are passed only to the queue if not stored
+        self.store_events = store_events
         self.timestamp_overflows = 0
         self.after_half = False
+        self.timestamp_raw = None
+        self.dropped_events = 0
 
         self.desc_buf = ""
         self.bufs = list()
@@ -187,17 +192,7 @@ class RttNordicProfilerHost:
             return None, None
         self.desc_buf = self.desc_buf[self.desc_buf.find('\n')+1:]
 
-        desc_fields = desc.split(',')
-
-        name = desc_fields[0]
-        id = int(desc_fields[1])
-        data_type = []
-        for i in range(2, len(desc_fields) // 2 + 1):
-            data_type.append(desc_fields[i])
-        data = []
-        for i in range(len(desc_fields) // 2 + 1, len(desc_fields)):
-            data.append(desc_fields[i])
-        return id, EventType(name, data_type, data)
+        return EventType.parse_description(desc)
 
     def _read_all_events_descriptions(self):
         while True:
@@ -214,7 +209,59 @@ class RttNordicProfilerHost:
         self.logger.info("Received events descriptions")
         self.logger.info("Ready to start logging events")
 
+    def _read_varint(self):
+        val = 0
+        shift = 0
+        while True:
+            byte = self._read_bytes(1)[0]
+            val |= (byte & 0x7f) << shift
+            shift += 7
+            if byte & 0x80 == 0:
+                return val
+
+    def _read_event_data(self, et):
+        data = []
+        for i in et.data_types:
+            signum = False
+            if i[0] == 's':
+                signum = True
+            buf = self._read_bytes(4)
+            data.append(int.from_bytes(buf, byteorder=self.config['byteorder'],
+                                       signed=signum))
+        return data
+
+    def _read_single_event_rtt_compressed(self):
+        id = int.from_bytes(
+            self._read_bytes(1),
+            byteorder=self.config['byteorder'],
+            signed=False)
+
+        if id == self.config['dropped_events_id']:
+            dropped = self._read_varint()
+            self.dropped_events += dropped
+            self.logger.warning("Device dropped {} events".format(dropped))
+            return None
+
+        et = self.received_events.registered_events_types[id]
+
+        # Timestamps are zigzag encoded deltas from the previous event
+        delta = self._read_varint()
+        delta = (delta >> 1) ^ -(delta & 1)
+        if self.timestamp_raw is None:
+            # First delta is calculated from 0 as 32-bit value
+            self.timestamp_raw = delta % self.config['timestamp_raw_max']
+        else:
+            self.timestamp_raw += delta
+
+        timestamp = self._calculate_timestamp_from_clock_ticks(
+            self.timestamp_raw)
+
+        return Event(id, timestamp, self._read_event_data(et))
+
     def _read_single_event_rtt(self):
+        if self.config['ring_buffer']:
+            return self._read_single_event_rtt_compressed()
+
         id = int.from_bytes(
             self._read_bytes(1),
             byteorder=self.config['byteorder'],
@@ -239,21 +286,16 @@ class RttNordicProfilerHost:
 
         timestamp = self._calculate_timestamp_from_clock_ticks(timestamp_raw)
 
-        data = []
-        for i in et.data_types:
-            signum = False
-            if i[0] == 's':
-                signum = True
-            buf = self._read_bytes(4)
-            data.append(int.from_bytes(buf, byteorder=self.config['byteorder'],
-                                       signed=signum))
-        return Event(id, timestamp, data)
+        return Event(id, timestamp, self._read_event_data(et))
 
     def _read_remaining_events(self):
         self.reading_data = False
         while self.bcnt != 0:
             event = self._read_single_event_rtt()
-            self.received_events.events.append(event)
+            if event is None:
+                continue
+            if self.store_events:
+                self.received_events.events.append(event)
             if self.queue is not None:
                 self.queue.put(event)
 
@@ -268,16 +310,20 @@ class RttNordicProfilerHost:
         current_time = start_time
         while current_time - start_time < time_seconds or time_seconds < 0:
             event = self._read_single_event_rtt()
-            self.received_events.events.append(event)
+            current_time = time.time()
+            if event is None:
+                continue
+            if self.store_events:
+                self.received_events.events.append(event)
             if self.queue is not None:
                 self.queue.put(event)
-            current_time = time.time()
         self.logger.info("Real time transmission closed")
         self.shutdown()
         self.logger.info("Events data saved to files")
         sys.exit()
 
     def start_logging_events(self):
+        self.timestamp_raw = None
         self._send_command(Command.START)
 
     def stop_logging_events(self):
@@ -0,0 +1,200 @@
+# Copyright (c) 2019 Nordic Semiconductor ASA
+# SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+
+from collections import deque, OrderedDict
+import logging
+import math
+
+# Histogram resolution: number of buckets per power of two
+HISTOGRAM_SUB_BUCKETS = 8
+# Durations are stored in microseconds, up to 2^32 us
+HISTOGRAM_MAX_EXP = 32
+# Maximum number of event memory addresses tracked at once
+MAX_TRACKED_EVENTS = 4096
+
+
+class LogHistogram():
+    # Fixed size histogram with logarithmic buckets, so that relative error
+    # of percentiles does not depend on recorded values
+    def __init__(self):
+        self.counts = [0] * (1 + HISTOGRAM_MAX_EXP * HISTOGRAM_SUB_BUCKETS)
+        self.total = 0
+
+    @staticmethod
+    def _bucket(value):
+        if value < 1:
+            return 0
+        exp = min(int(math.log2(value)), HISTOGRAM_MAX_EXP - 1)
+        sub = int((value / 2**exp - 1) * HISTOGRAM_SUB_BUCKETS)
+        return 1 + exp * HISTOGRAM_SUB_BUCKETS + \
+            min(sub, HISTOGRAM_SUB_BUCKETS - 1)
+
+    @staticmethod
+    def _bucket_value(bucket):
+        # Middle of the bucket
+        if bucket == 0:
+            return 0.5
+        exp, sub = divmod(bucket - 1, HISTOGRAM_SUB_BUCKETS)
+        return 2**exp * (1 + (sub + 0.5) / HISTOGRAM_SUB_BUCKETS)
+
+    def add(self, value):
+        self.counts[self._bucket(value)] += 1
+        self.total += 1
+
+    def merge(self, other):
+        for i, cnt in enumerate(other.counts):
+            self.counts[i] += cnt
+        self.total += other.total
+
+    def percentile(self, pct):
+        if self.total == 0:
+            return None
+        threshold = math.ceil(self.total * pct / 100)
+        cumulative = 0
+        for i, cnt in enumerate(self.counts):
+            cumulative += cnt
+            if cumulative >= max(threshold, 1):
+                return self._bucket_value(i)
+
+
+class EventTypeStats():
+    def __init__(self, window_cnt):
+        self.count = 0
+        self.window_counts = deque([0], maxlen=window_cnt)
+        self.window_durations = deque([LogHistogram()], maxlen=window_cnt)
+        self.durations = LogHistogram()
+
+    def rotate(self):
+        self.window_counts.append(0)
+        self.window_durations.append(LogHistogram())
+
+    def rolling_durations(self):
+        hist = LogHistogram()
+        for h in self.window_durations:
+            hist.merge(h)
+        return hist
+
+
+class StreamAnalyzer():
+    # Computes per event type rates and processing time percentiles from
+    # a stream of events in bounded memory. Rolling statistics cover the
+    # last window_cnt windows of window_len seconds (device time).
+    def __init__(self, registered_events_types, window_len=1.0, window_cnt=10,
+                 log_lvl=logging.WARNING):
+        self.registered_events_types = registered_events_types
+        self.window_len = window_len
+        self.window_cnt = window_cnt
+        self.window_start = None
+        self.stats = dict()
+
+        self.event_processing_start_id = None
+        self.event_processing_end_id = None
+        for type_id, et in registered_events_types.items():
+            if et.name == 'event_processing_start':
+                self.event_processing_start_id = type_id
+            elif et.name == 'event_processing_end':
+                self.event_processing_end_id = type_id
+
+        # Memory address -> type ID of submitted event
+        self.submitted = OrderedDict()
+        # Memory address -> (type ID, processing start timestamp)
+        self.processing = OrderedDict()
+
+        self.logger = logging.getLogger('Stream Analyzer')
+        self.logger_console = logging.StreamHandler()
+        self.logger.setLevel(log_lvl)
+        self.log_format = logging.Formatter(
+            '[%(levelname)s] %(name)s: %(message)s')
+        self.logger_console.setFormatter(self.log_format)
+        self.logger.addHandler(self.logger_console)
+
+    def _get_stats(self, type_id):
+        if type_id not in self.stats:
+            self.stats[type_id] = EventTypeStats(self.window_cnt)
+        return self.stats[type_id]
+
+    def _update_window(self, timestamp):
+        if self.window_start is None:
+            self.window_start = timestamp
+            return
+
+        rotations = int((timestamp - self.window_start) // self.window_len)
+        if rotations <= 0:
+            return
+
+        self.window_start += rotations * self.window_len
+        for _ in range(min(rotations, self.window_cnt)):
+            for s in self.stats.values():
+                s.rotate()
+
+    @staticmethod
+    def _track(tracked, address, value):
+        tracked[address] = value
+        tracked.move_to_end(address)
+        if len(tracked) > MAX_TRACKED_EVENTS:
+            tracked.popitem(last=False)
+
+    def process(self, event):
+        self._update_window(event.timestamp)
+
+        if event.type_id == self.event_processing_start_id:
+            address = event.data[0]
+            type_id = self.submitted.pop(address, None)
+            if type_id is not None:
+                self._track(self.processing, address,
+                            (type_id, event.timestamp))
+            return
+
+        if event.type_id == self.event_processing_end_id:
+            start = self.processing.pop(event.data[0], None)
+            if start is not None:
+                type_id, start_time = start
+                duration = (event.timestamp - start_time) * 1e6
+                s = self._get_stats(type_id)
+                s.durations.add(duration)
+                s.window_durations[-1].add(duration)
+            return
+
+        s = self._get_stats(event.type_id)
+        s.count += 1
+        s.window_counts[-1] += 1
+
+        if self.event_processing_start_id is not None and \
+           len(event.data) > 0:
+            # First data field of Event Manager event is its memory address
+            self._track(self.submitted, event.data[0], event.type_id)
+
+    def report(self):
+        rows = []
+        for type_id, s in sorted(self.stats.items()):
+            name = self.registered_events_types[type_id].name
+            # Rate is calculated from complete windows only
+            complete = list(s.window_counts)[:-1]
+            if len(complete) > 0:
+                rate = sum(complete) / (len(complete) * self.window_len)
+            else:
+                rate = None
+            rolling = s.rolling_durations()
+            rows.append({
+                'name': name,
+                'count': s.count,
+                'rate': rate,
+                'p50_us': rolling.percentile(50),
+                'p90_us': rolling.percentile(90),
+                'p99_us': rolling.percentile(99),
+                'total_p99_us': s.durations.percentile(99)
+            })
+        return rows
+
+    def print_report(self):
+        def fmt(val):
+            return '-' if val is None else '{:.1f}'.format(val)
+
+        print('{:<32} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}'.format(
+              'event', 'count', 'rate/s', 'p50 us', 'p90 us', 'p99 us',
+              'all p99'))
+        for row in self.report():
+            print('{:<32} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}'.format(
+                  row['name'][:32], row['count'], fmt(row['rate']),
+                  fmt(row['p50_us']), fmt(row['p90_us']), fmt(row['p99_us']),
+                  fmt(row['total_p99_us'])))
@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #include <zephyr.h>
+#include <init.h>
 #include <spinlock.h>
 #include <misc/dlist.h>
 #include <event_manager.h>
@@ -18,27 +19,57 @@ static void event_processor_fn(struct k_work *work);
 
 
 #if CONFIG_DESKTOP_EVENT_MANAGER_PROFILER_ENABLED
-#define IDS_COUNT CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT
+/* Two additional IDs are used by event execution tracking. */
+#define IDS_COUNT (CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT + 2)
 #else
 #define IDS_COUNT 0
 #endif
 
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_CLASSES
+#define EVENT_QUEUE_COUNT CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_CLASS_COUNT
+#define DISPATCH_THREAD_COUNT (EVENT_QUEUE_COUNT - 1)
+
+BUILD_ASSERT_MSG(CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_THREAD_PRIORITY +
+		 DISPATCH_THREAD_COUNT - 1 < CONFIG_SYSTEM_WORKQUEUE_PRIORITY,
+		 "Dispatch threads must have higher priority than "
+		 "the system workqueue");
+#else
+#define EVENT_QUEUE_COUNT 1
+#endif
+
+/* Every dispatch class has its own event queue. Events of the lowest
+ * dispatch class are processed by the system workqueue, other classes
+ * are processed by dedicated workqueues.
+ */
+struct event_queue {
+	sys_dlist_t events;
+	struct k_spinlock lock;
+	struct k_work work;
+	struct k_work_q *work_q;
+};
+
 #ifdef CONFIG_SHELL
-extern u32_t event_manager_displayed_events;
+extern atomic_t event_manager_displayed_events[];
 #else
-static u32_t event_manager_displayed_events;
+static ATOMIC_DEFINE(event_manager_displayed_events,
+		     CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT);
 #endif
 
 static u16_t profiler_event_ids[IDS_COUNT];
-static K_WORK_DEFINE(event_processor, event_processor_fn);
-static sys_dlist_t eventq = SYS_DLIST_STATIC_INIT(&eventq);
-static struct k_spinlock lock;
+static struct event_queue event_queues[EVENT_QUEUE_COUNT];
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_CLASSES
+static K_THREAD_STACK_ARRAY_DEFINE(dispatch_thread_stacks,
+				   DISPATCH_THREAD_COUNT,
+				   CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_THREAD_STACK_SIZE);
+static struct k_work_q dispatch_work_qs[DISPATCH_THREAD_COUNT];
+#endif
 
 
 static bool log_is_event_displayed(const struct event_type *et)
 {
-	u32_t event_mask = BIT(et - __start_event_types);
-	return event_manager_displayed_events & event_mask;
+	return atomic_test_bit(event_manager_displayed_events,
+			       et - __start_event_types);
 }
 
 static void log_event(const struct event_header *eh)
@@ -92,8 +123,8 @@ static void log_event_init(void)
 	     (et != NULL) && (et != __stop_event_types);
 	     et++) {
 		if (et->init_log_enable) {
-			u32_t event_mask = BIT(et - __start_event_types);
-			event_manager_displayed_events |= event_mask;
+			atomic_set_bit(event_manager_displayed_events,
+				       et - __start_event_types);
 		}
 	}
 }
@@ -207,24 +238,219 @@ static int trace_event_init(void)
 	return 0;
 }
 
+static inline u32_t stats_timestamp(void)
+{
+	return IS_ENABLED(CONFIG_DESKTOP_EVENT_MANAGER_STATS) ?
+		k_cycle_get_32() : 0;
+}
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_STATS
+static void stats_update(struct event_stats *stats, u32_t cycles)
+{
+	stats->cnt++;
+	stats->total_cycles += cycles;
+	if (cycles > stats->max_cycles) {
+		stats->max_cycles = cycles;
+	}
+}
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_STATS */
+
+static void stats_event_submitted(struct event_header *eh)
+{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_STATS
+	eh->timestamp = k_cycle_get_32();
+#endif
+}
+
+static void stats_event_dispatched(const struct event_header *eh, u32_t start)
+{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_STATS
+	stats_update(&eh->type_id->stats->latency, start - eh->timestamp);
+#endif
+}
+
+static void stats_event_processed(const struct event_header *eh, u32_t start)
+{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_STATS
+	stats_update(&eh->type_id->stats->processing,
+		     k_cycle_get_32() - start);
+#endif
+}
+
+static void stats_listener_notified(const struct event_subscriber *es,
+				    u32_t start)
+{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_STATS
+	stats_update(es->stats, k_cycle_get_32() - start);
+#endif
+}
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOLS
+static bool is_pool_block(const struct k_mem_slab *slab, const void *mem)
+{
+	const char *start = slab->buffer;
+	const char *end = start + slab->num_blocks * slab->block_size;
+
+	return ((const char *)mem >= start) && ((const char *)mem < end);
+}
+
+static void pool_max_used_update(struct event_pool *pool)
+{
+	atomic_val_t used = k_mem_slab_num_used_get(pool->slab);
+	atomic_val_t max_used;
+
+	do {
+		max_used = atomic_get(&pool->max_used);
+		if (used <= max_used) {
+			break;
+		}
+	} while (!atomic_cas(&pool->max_used, max_used, used));
+}
+
+void *_event_pool_alloc(const struct event_type *et, size_t size)
+{
+	ASSERT_EVENT_ID(et);
+
+	struct event_pool *pool = et->pool;
+	void *mem;
+
+	__ASSERT_NO_MSG(size <= pool->slab->block_size);
+
+	if (!k_mem_slab_alloc(pool->slab, &mem, K_NO_WAIT)) {
+		pool_max_used_update(pool);
+		return mem;
+	}
+
+	atomic_inc(&pool->heap_alloc_cnt);
+
+	return k_malloc(size);
+}
+
+static void event_free(struct event_header *eh)
+{
+	struct k_mem_slab *slab = eh->type_id->pool->slab;
+
+	if (is_pool_block(slab, eh)) {
+		k_mem_slab_free(slab, (void **)&eh);
+	} else {
+		k_free(eh);
+	}
+}
+#else
+static void event_free(struct event_header *eh)
+{
+	k_free(eh);
+}
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOLS */
+
+/* Merge the event into the queued event of the same type.
+ * Must be called with the event queue lock held.
+ */
+static bool event_coalesce(struct event_header *eh)
+{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_COALESCING
+	struct event_coalesce *coalesce = eh->type_id->coalesce;
+
+	if (!coalesce) {
+		return false;
+	}
+
+	if (coalesce->pending) {
+		coalesce->merge(coalesce->pending, eh);
+		return true;
+	}
+
+	coalesce->pending = eh;
+#endif
+
+	return false;
+}
+
+/* Stop merging new events into the event that is going to be processed. */
+static void event_coalesce_end(struct event_queue *queue,
+			       const struct event_header *eh)
+{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_COALESCING
+	struct event_coalesce *coalesce = eh->type_id->coalesce;
+
+	if (coalesce) {
+		k_spinlock_key_t key = k_spin_lock(&queue->lock);
+
+		__ASSERT_NO_MSG(coalesce->pending == eh);
+		coalesce->pending = NULL;
+
+		k_spin_unlock(&queue->lock, key);
+	}
+#endif
+}
+
+static void process_event(struct event_header *eh)
+{
+	ASSERT_EVENT_ID(eh->type_id);
+
+	const struct event_type *et = eh->type_id;
+	u32_t process_start = stats_timestamp();
+
+	stats_event_dispatched(eh, process_start);
+
+	trace_event_execution(eh, true);
+
+	log_event(eh);
+
+	bool consumed = false;
+
+	for (size_t prio = SUBS_PRIO_MIN;
+	     (prio <= SUBS_PRIO_MAX) && !consumed;
+	     prio++) {
+		for (const struct event_subscriber *es =
+				et->subs_start[prio];
+		     (es != et->subs_stop[prio]) && !consumed;
+		     es++) {
+
+			__ASSERT_NO_MSG(es != NULL);
+
+			const struct event_listener *el = es->listener;
+
+			__ASSERT_NO_MSG(el != NULL);
+			__ASSERT_NO_MSG(el->notification != NULL);
+
+			u32_t notify_start = stats_timestamp();
+
+			consumed = el->notification(eh);
+
+			stats_listener_notified(es, notify_start);
+
+			log_event_progress(et, el, consumed);
+		}
+	}
+
+	stats_event_processed(eh, process_start);
+
+	trace_event_execution(eh, false);
+
+	event_free(eh);
+}
+
 static void event_processor_fn(struct k_work *work)
 {
+	struct event_queue *queue = CONTAINER_OF(work, struct event_queue,
+						 work);
 	sys_dlist_t events;
 
 	/* Make current event list local. */
-	k_spinlock_key_t key = k_spin_lock(&lock);
+	k_spinlock_key_t key = k_spin_lock(&queue->lock);
 
-	if (sys_dlist_is_empty(&eventq)) {
-		k_spin_unlock(&lock, key);
+	if (sys_dlist_is_empty(&queue->events)) {
+		k_spin_unlock(&queue->lock, key);
 		return;
 	}
 
-	events = eventq;
+	events = queue->events;
 	events.next->prev = &events;
 	events.prev->next = &events;
-	sys_dlist_init(&eventq);
+	sys_dlist_init(&queue->events);
 
-	k_spin_unlock(&lock, key);
+	k_spin_unlock(&queue->lock, key);
 
 
 	/* Traverse the list of events. */
@@ -234,60 +460,91 @@ static void event_processor_fn(struct k_work *work)
 						       struct event_header,
 						       node);
 
-		ASSERT_EVENT_ID(eh->type_id);
+		event_coalesce_end(queue, eh);
 
-		const struct event_type *et = eh->type_id;
+		process_event(eh);
 
-		trace_event_execution(eh, true);
+		/* Let dispatch threads of higher classes take over. */
+		if (IS_ENABLED(CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_CLASSES) &&
+		    (queue != &event_queues[0])) {
+			k_yield();
+		}
+	}
+}
 
-		log_event(eh);
+static struct event_queue *event_queue_get(const struct event_type *et)
+{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_CLASSES
+	if (et->dispatch_class) {
+		__ASSERT_NO_MSG(*et->dispatch_class < EVENT_QUEUE_COUNT);
+		return &event_queues[*et->dispatch_class];
+	}
+#endif
 
-		bool consumed = false;
+	return &event_queues[EVENT_QUEUE_COUNT - 1];
+}
 
-		for (size_t prio = SUBS_PRIO_MIN;
-		     (prio <= SUBS_PRIO_MAX) && !consumed;
-		     prio++) {
-			for (const struct event_subscriber *es =
-					et->subs_start[prio];
-			     (es != et->subs_stop[prio]) && !consumed;
-			     es++) {
+void _event_submit(struct event_header *eh)
+{
+	__ASSERT_NO_MSG(eh);
+	ASSERT_EVENT_ID(eh->type_id);
 
-				__ASSERT_NO_MSG(es != NULL);
+	trace_event_submission(eh);
 
-				const struct event_listener *el = es->listener;
+	stats_event_submitted(eh);
 
-				__ASSERT_NO_MSG(el != NULL);
-				__ASSERT_NO_MSG(el->notification != NULL);
+	struct event_queue *queue = event_queue_get(eh->type_id);
 
-				consumed = el->notification(eh);
+	k_spinlock_key_t key = k_spin_lock(&queue->lock);
 
-				log_event_progress(et, el, consumed);
-			}
-		}
+	if (event_coalesce(eh)) {
+		k_spin_unlock(&queue->lock, key);
+		event_free(eh);
+		return;
+	}
 
-		trace_event_execution(eh, false);
+	sys_dlist_append(&queue->events, &eh->node);
+	k_spin_unlock(&queue->lock, key);
 
-		k_free(eh);
-	}
+	k_work_submit_to_queue(queue->work_q, &queue->work);
 }
 
-void _event_submit(struct event_header *eh)
+static int event_queues_init(struct device *dev)
 {
-	__ASSERT_NO_MSG(eh);
-	ASSERT_EVENT_ID(eh->type_id);
+	ARG_UNUSED(dev);
 
-	trace_event_submission(eh);
+	for (size_t i = 0; i < EVENT_QUEUE_COUNT; i++) {
+		struct event_queue *queue = &event_queues[i];
 
-	k_spinlock_key_t key = k_spin_lock(&lock);
-	sys_dlist_append(&eventq, &eh->node);
-	k_spin_unlock(&lock, key);
+		sys_dlist_init(&queue->events);
+		k_work_init(&queue->work, event_processor_fn);
+		queue->work_q = &k_sys_work_q;
+	}
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_CLASSES
+	for (size_t i = 0; i < DISPATCH_THREAD_COUNT; i++) {
+		k_work_q_start(&dispatch_work_qs[i],
+			       dispatch_thread_stacks[i],
+			       K_THREAD_STACK_SIZEOF(dispatch_thread_stacks[i]),
+			       CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_THREAD_PRIORITY + i);
+		event_queues[i].work_q = &dispatch_work_qs[i];
+	}
+#endif
 
-	k_work_submit(&event_processor);
+	return 0;
 }
 
 int event_manager_init(void)
 {
+	if ((__stop_event_types - __start_event_types) >
+	    CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT) {
+		LOG_ERR("Too many event types defined");
+		return -ENOMEM;
+	}
+
 	log_event_init();
 
 	return trace_event_init();
 }
+
+SYS_INIT(event_queues_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
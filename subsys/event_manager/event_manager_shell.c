@@ -5,10 +5,12 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <shell/shell.h>
 #include <event_manager.h>
 
-u32_t event_manager_displayed_events;
+ATOMIC_DEFINE(event_manager_displayed_events,
+	      CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT);
 
 static int show_events(const struct shell *shell, size_t argc,
 		char **argv)
@@ -24,8 +26,8 @@ static int show_events(const struct shell *shell, size_t argc,
 		shell_fprintf(shell,
 			      SHELL_NORMAL,
 			      "%c %d:\t%s\n",
-			      (event_manager_displayed_events & BIT(ev_id)) ?
-				'E' : 'D',
+			      atomic_test_bit(event_manager_displayed_events,
+					      ev_id) ? 'E' : 'D',
 			      ev_id,
 			      et->name);
 	}
@@ -89,11 +91,169 @@ static int show_subscribers(const struct shell *shell, size_t argc,
 	return 0;
 }
 
+static int show_pools(const struct shell *shell, size_t argc,
+		      char **argv)
+{
+#ifndef CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOLS
+	shell_fprintf(shell, SHELL_NORMAL, "Event pools are disabled\n");
+#else
+	shell_fprintf(shell, SHELL_NORMAL, "Event pools:\n");
+	for (const struct event_type *et = __start_event_types;
+	     (et != NULL) && (et != __stop_event_types);
+	     et++) {
+
+		struct event_pool *pool = et->pool;
+
+		__ASSERT_NO_MSG(pool != NULL);
+		shell_fprintf(shell, SHELL_NORMAL,
+			      "|\t[E:%s] used:%u/%u max:%u heap:%u\n",
+			      et->name,
+			      k_mem_slab_num_used_get(pool->slab),
+			      pool->slab->num_blocks,
+			      (u32_t)atomic_get(&pool->max_used),
+			      (u32_t)atomic_get(&pool->heap_alloc_cnt));
+	}
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOLS */
+
+	return 0;
+}
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_STATS
+static void print_stats(const struct shell *shell, const char *prefix,
+			const char *name, const struct event_stats *stats)
+{
+	u32_t avg_cycles = 0;
+
+	if (stats->cnt > 0) {
+		avg_cycles = stats->total_cycles / stats->cnt;
+	}
+
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "%s%s\tcnt:%u avg:%u max:%u\n",
+		      prefix, name, stats->cnt, avg_cycles, stats->max_cycles);
+}
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_STATS */
+
+static int show_event_stats(const struct shell *shell, size_t argc,
+			    char **argv)
+{
+#ifndef CONFIG_DESKTOP_EVENT_MANAGER_STATS
+	shell_fprintf(shell, SHELL_NORMAL, "Statistics are disabled\n");
+#else
+	shell_fprintf(shell, SHELL_NORMAL, "Event statistics (cycles):\n");
+	for (const struct event_type *et = __start_event_types;
+	     (et != NULL) && (et != __stop_event_types);
+	     et++) {
+
+		shell_fprintf(shell, SHELL_NORMAL, "[E:%s]\n", et->name);
+		print_stats(shell, "|\t", "latency", &et->stats->latency);
+		print_stats(shell, "|\t", "processing",
+			    &et->stats->processing);
+
+		for (size_t prio = SUBS_PRIO_MIN;
+		     prio <= SUBS_PRIO_MAX;
+		     prio++) {
+			for (const struct event_subscriber *es =
+					et->subs_start[prio];
+			     es != et->subs_stop[prio];
+			     es++) {
+
+				__ASSERT_NO_MSG(es != NULL);
+				print_stats(shell, "|\t-> [L]", es->listener->name,
+					    es->stats);
+			}
+		}
+	}
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_STATS */
+
+	return 0;
+}
+
+static int show_listener_stats(const struct shell *shell, size_t argc,
+			       char **argv)
+{
+#ifndef CONFIG_DESKTOP_EVENT_MANAGER_STATS
+	shell_fprintf(shell, SHELL_NORMAL, "Statistics are disabled\n");
+#else
+	shell_fprintf(shell, SHELL_NORMAL, "Listener statistics (cycles):\n");
+	for (const struct event_listener *el = __start_event_listeners;
+	     el != __stop_event_listeners;
+	     el++) {
+
+		struct event_stats total = {0};
+
+		/* Sum up statistics of all subscriptions of the listener. */
+		for (const struct event_type *et = __start_event_types;
+		     (et != NULL) && (et != __stop_event_types);
+		     et++) {
+			for (size_t prio = SUBS_PRIO_MIN;
+			     prio <= SUBS_PRIO_MAX;
+			     prio++) {
+				for (const struct event_subscriber *es =
+						et->subs_start[prio];
+				     es != et->subs_stop[prio];
+				     es++) {
+
+					if (es->listener != el) {
+						continue;
+					}
+
+					total.cnt += es->stats->cnt;
+					total.total_cycles +=
+						es->stats->total_cycles;
+					total.max_cycles =
+						MAX(total.max_cycles,
+						    es->stats->max_cycles);
+				}
+			}
+		}
+
+		print_stats(shell, "[L]", el->name, &total);
+	}
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_STATS */
+
+	return 0;
+}
+
+static int reset_stats(const struct shell *shell, size_t argc, char **argv)
+{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_STATS
+	for (const struct event_type *et = __start_event_types;
+	     (et != NULL) && (et != __stop_event_types);
+	     et++) {
+
+		memset(et->stats, 0, sizeof(*et->stats));
+
+		for (size_t prio = SUBS_PRIO_MIN;
+		     prio <= SUBS_PRIO_MAX;
+		     prio++) {
+			for (const struct event_subscriber *es =
+					et->subs_start[prio];
+			     es != et->subs_stop[prio];
+			     es++) {
+				memset(es->stats, 0, sizeof(*es->stats));
+			}
+		}
+	}
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_STATS */
+
+	shell_fprintf(shell, SHELL_NORMAL, "Statistics reset\n");
+
+	return 0;
+}
+
+static void event_displaying_update(size_t ev_id, bool enable)
+{
+	if (enable) {
+		atomic_set_bit(event_manager_displayed_events, ev_id);
+	} else {
+		atomic_clear_bit(event_manager_displayed_events, ev_id);
+	}
+}
+
 static void set_event_displaying(const struct shell *shell, size_t argc,
 				 char **argv, bool enable)
 {
-	u32_t evt_mask = 0;
-
 	/* If no IDs specified, all registered events are affected */
 	if (argc == 1) {
 		for (const struct event_type *et = __start_event_types;
@@ -102,7 +262,7 @@ static void set_event_displaying(const struct shell *shell, size_t argc,
 
 			size_t ev_id = et - __start_event_types;
 
-			evt_mask |= BIT(ev_id);
+			event_displaying_update(ev_id, enable);
 		}
 
 		shell_fprintf(shell,
@@ -128,7 +288,7 @@ static void set_event_displaying(const struct shell *shell, size_t argc,
 		}
 
 		for (size_t i = 0; i < ARRAY_SIZE(event_indexes); i++) {
-			evt_mask |= BIT(event_indexes[i]);
+			event_displaying_update(event_indexes[i], enable);
 			const struct event_type *et =
 				__start_event_types + event_indexes[i];
 			const char *event_name = et->name;
@@ -140,11 +300,6 @@ static void set_event_displaying(const struct shell *shell, size_t argc,
 				      enable ? "en":"dis");
 		}
 	}
-	if (enable) {
-		event_manager_displayed_events |= evt_mask;
-	} else {
-		event_manager_displayed_events &= ~evt_mask;
-	}
 }
 
 static int enable_event_displaying(const struct shell *shell, size_t argc,
@@ -162,18 +317,30 @@ static int disable_event_displaying(const struct shell *shell, size_t argc,
 }
 
 
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_stats,
+	SHELL_CMD_ARG(events, NULL, "Show event type statistics",
+		      show_event_stats, 0, 0),
+	SHELL_CMD_ARG(listeners, NULL, "Show listener statistics",
+		      show_listener_stats, 0, 0),
+	SHELL_CMD_ARG(reset, NULL, "Reset statistics", reset_stats, 0, 0),
+	SHELL_SUBCMD_SET_END
+);
+
 SHELL_STATIC_SUBCMD_SET_CREATE(sub_event_manager,
 	SHELL_CMD_ARG(show_listeners, NULL, "Show listeners",
 		      show_listeners, 0, 0),
 	SHELL_CMD_ARG(show_subscribers, NULL, "Show subscribers",
 		      show_subscribers, 0, 0),
 	SHELL_CMD_ARG(show_events, NULL, "Show events", show_events, 0, 0),
+	SHELL_CMD_ARG(show_pools, NULL, "Show event pools usage",
+		      show_pools, 0, 0),
+	SHELL_CMD(stats, &sub_stats, "Event processing statistics", NULL),
 	SHELL_CMD_ARG(disable, NULL, "Disable displaying event with given ID",
 		      disable_event_displaying, 0,
-		      sizeof(event_manager_displayed_events) * 8 - 1),
+		      CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT),
 	SHELL_CMD_ARG(enable, NULL, "Enable displaying event with given ID",
 		      enable_event_displaying, 0,
-		      sizeof(event_manager_displayed_events) * 8 - 1),
+		      CONFIG_DESKTOP_EVENT_MANAGER_MAX_EVENT_CNT),
 	SHELL_SUBCMD_SET_END
 );
 
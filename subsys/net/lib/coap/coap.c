@@ -42,6 +42,10 @@ static coap_request_handler_t request_handler;
 static coap_alloc_t coap_alloc_fn;
 /** Memory free function, populated on @coap_init. */
 static coap_free_t coap_free_fn;
+/** Whether coap_process is calling coap_time_tick. */
+static bool ticking;
+/** Uptime in milliseconds of the next coap_time_tick by coap_process. */
+static s64_t next_tick_time;
 
 static coap_message_t coap_empty_message = {
 	.header = {
@@ -135,6 +139,7 @@ u32_t coap_init(u32_t token_rand_seed,
 
 	internal_coap_observe_init();
 	message_id_counter = 1;
+	ticking = false;
 
 	err_code = coap_transport_init(transport_param);
 	if (err_code != 0) {
@@ -170,6 +175,73 @@ u32_t coap_error_handler_register(coap_error_callback_t callback)
 	return 0;
 }
 
+/**@brief Check if a message is kept in the queue after being sent.
+ *
+ * @details CON messages are kept for retransmission, and NON requests with a
+ *          response callback to be matched against the response.
+ */
+static inline bool is_queued(coap_message_t *message)
+{
+	return is_con(message) ||
+	       (is_non(message) && is_request(message->header.code) &&
+		(message->response_callback != NULL));
+}
+
+/**@brief Add a sent message to the message queue.
+ *
+ * @param[out] handle     Handle to the queue item.
+ * @param[in]  message    Message which was sent.
+ * @param[in]  buffer     Allocated buffer holding the encoded message. Owned
+ *                        by the queue on success.
+ * @param[in]  buffer_len Length of the encoded message.
+ *
+ * @retval 0 If the message was added to the queue.
+ */
+static u32_t message_queue_add(u32_t *handle, coap_message_t *message,
+			       u8_t *buffer, u16_t buffer_len)
+{
+	coap_queue_item_t item;
+
+	item.arg = message->arg;
+	item.mid = message->header.id;
+	item.callback = message->response_callback;
+	item.buffer = buffer;
+	item.buffer_len = buffer_len;
+	item.timeout_val = COAP_ACK_TIMEOUT * COAP_ACK_RANDOM_FACTOR;
+
+	if (message->header.type == COAP_TYPE_CON) {
+		item.timeout = item.timeout_val;
+		item.retrans_count = 0;
+	} else {
+		item.timeout = COAP_MAX_TRANSMISSION_SPAN;
+		item.retrans_count = COAP_MAX_RETRANSMIT_COUNT;
+	}
+
+	item.transport = message->transport;
+	item.token_len = message->header.token_len;
+
+	if (message->remote->sa_family == AF_INET6) {
+		memcpy(&item.remote, message->remote,
+		       sizeof(struct sockaddr_in6));
+	} else {
+		memcpy(&item.remote, message->remote,
+		       sizeof(struct sockaddr_in));
+	}
+	memcpy(item.token, message->token, message->header.token_len);
+
+	u32_t err_code = coap_queue_add(&item);
+
+	if (err_code != 0) {
+		COAP_TRC("Message queue error = 0x%08lX!",
+			 (unsigned long)err_code);
+		return err_code;
+	}
+
+	*handle = item.handle;
+
+	return 0;
+}
+
 u32_t internal_coap_message_send(u32_t *handle, coap_message_t *message)
 {
 	if ((message == NULL) || (message->remote == NULL)) {
@@ -192,30 +264,50 @@ u32_t internal_coap_message_send(u32_t *handle, coap_message_t *message)
 		return err_code;
 	}
 
-	err_code = ENOMEM;
+	/* Messages that might need to be retransmitted or matched against a
+	 * response are kept in the message queue, and need their own buffer.
+	 */
+	bool queued = is_queued(message);
 
-	/* Allocate a buffer to serialize the message into. */
-	u8_t *buffer;
-	u32_t request_length = expected_length;
+	/* Serialize other messages in place, into the transport TX buffer. */
+	u8_t *buffer = NULL;
+	u16_t buffer_length = 0;
 
-	buffer = coap_alloc_fn(request_length);
-	if (buffer == NULL) {
-		COAP_TRC("buffer alloc error = 0x%08lX!",
-			 (unsigned long)err_code);
-		COAP_EXIT();
-		return err_code;
+	if (!queued) {
+		buffer = coap_transport_tx_buffer_get(&buffer_length);
+		if (buffer_length < expected_length) {
+			buffer = NULL;
+		}
 	}
-	memset(buffer, 0, request_length);
-	COAP_TRC("Alloc mem, buffer = %p", (u8_t *)buffer);
+
+	bool allocated = (buffer == NULL);
+
+	if (allocated) {
+		err_code = ENOMEM;
+
+		/* Allocate a buffer to serialize the message into. */
+		buffer = coap_alloc_fn(expected_length);
+		if (buffer == NULL) {
+			COAP_TRC("buffer alloc error = 0x%08lX!",
+				 (unsigned long)err_code);
+			COAP_EXIT();
+			return err_code;
+		}
+		COAP_TRC("Alloc mem, buffer = %p", (u8_t *)buffer);
+	}
+
+	memset(buffer, 0, expected_length);
 
 	/* Serialize the message. */
-	u16_t buffer_length = (u16_t)request_length;
+	buffer_length = expected_length;
 
 	err_code = coap_message_encode(message, buffer, &buffer_length);
 	if (err_code != 0) {
 		COAP_TRC("Encode error!");
-		COAP_TRC("Free mem, buffer = %p", buffer);
-		coap_free_fn(buffer);
+		if (allocated) {
+			COAP_TRC("Free mem, buffer = %p", buffer);
+			coap_free_fn(buffer);
+		}
 		COAP_EXIT();
 		return err_code;
 	}
@@ -223,60 +315,19 @@ u32_t internal_coap_message_send(u32_t *handle, coap_message_t *message)
 	err_code = coap_transport_write(message->transport, message->remote,
 					buffer, buffer_length);
 
-	if (err_code == 0) {
-		if (is_con(message) || (is_non(message) &&
-					is_request(message->header.code) &&
-					(message->response_callback != NULL))) {
-			coap_queue_item_t item;
-
-			item.arg = message->arg;
-			item.mid = message->header.id;
-			item.callback = message->response_callback;
-			item.buffer = buffer;
-			item.buffer_len = buffer_length;
-			item.timeout_val = COAP_ACK_TIMEOUT *
-					   COAP_ACK_RANDOM_FACTOR;
-
-			if (message->header.type == COAP_TYPE_CON) {
-				item.timeout = item.timeout_val;
-				item.retrans_count = 0;
-			} else {
-				item.timeout = COAP_MAX_TRANSMISSION_SPAN;
-				item.retrans_count = COAP_MAX_RETRANSMIT_COUNT;
-			}
-
-			item.transport = message->transport;
-			item.token_len = message->header.token_len;
-
-			if (message->remote->sa_family == AF_INET6) {
-				memcpy(&item.remote, message->remote,
-				       sizeof(struct sockaddr_in6));
-			} else {
-				memcpy(&item.remote, message->remote,
-				       sizeof(struct sockaddr_in));
-			}
-			memcpy(item.token, message->token,
-			       message->header.token_len);
-
-			err_code = coap_queue_add(&item);
-			if (err_code != 0) {
-				COAP_TRC("Message queue error = 0x%08lX!",
-					 (unsigned long)err_code);
-
-				COAP_TRC("Free mem, buffer = %p", buffer);
-				coap_free_fn(buffer);
-				COAP_EXIT();
-				return err_code;
-			}
-
-			*handle = item.handle;
-		} else {
-			*handle = COAP_MESSAGE_QUEUE_SIZE;
-
+	if (!allocated) {
+		/* The transport TX buffer is not owned by the message. */
+		*handle = COAP_MESSAGE_QUEUE_SIZE;
+	} else if ((err_code == 0) && queued) {
+		err_code = message_queue_add(handle, message, buffer,
+					     buffer_length);
+		if (err_code != 0) {
 			COAP_TRC("Free mem, buffer = %p", buffer);
 			coap_free_fn(buffer);
 		}
 	} else {
+		*handle = COAP_MESSAGE_QUEUE_SIZE;
+
 		COAP_TRC("Free mem, buffer = %p", buffer);
 		coap_free_fn(buffer);
 	}
@@ -285,37 +336,81 @@ u32_t internal_coap_message_send(u32_t *handle, coap_message_t *message)
 	return err_code;
 }
 
-
-static u32_t create_response(coap_message_t **response, coap_message_t *request,
-			     u16_t data_size)
+u32_t internal_coap_encoded_message_send(u32_t *handle,
+					 coap_message_t *message,
+					 const u8_t *data, u16_t data_len)
 {
-	u32_t err_code = ENOMEM;
+	if ((message == NULL) || (message->remote == NULL) ||
+	    (data == NULL)) {
+		return EINVAL;
+	}
 
-	/* Allocate space for a new message. */
-	u32_t size = sizeof(coap_message_t);
+	COAP_ENTRY();
+
+	u32_t err_code;
 
-	(*response) = coap_alloc_fn(size);
-	if (*response == NULL) {
+	if (!is_queued(message)) {
+		*handle = COAP_MESSAGE_QUEUE_SIZE;
+
+		err_code = coap_transport_write(message->transport,
+						message->remote, data,
+						data_len);
+		COAP_EXIT();
 		return err_code;
 	}
 
+	/* The message queue keeps its own copy for retransmission. */
+	u8_t *buffer = coap_alloc_fn(data_len);
+
+	if (buffer == NULL) {
+		COAP_EXIT();
+		return ENOMEM;
+	}
+	COAP_TRC("Alloc mem, buffer = %p", (u8_t *)buffer);
+
+	memcpy(buffer, data, data_len);
 
-	memset((*response), 0, sizeof(coap_message_t));
-	COAP_TRC("Alloc mem, response = %p", (u8_t *)(*response));
+	err_code = coap_transport_write(message->transport, message->remote,
+					buffer, data_len);
+	if (err_code == 0) {
+		err_code = message_queue_add(handle, message, buffer,
+					     data_len);
+	}
 
-	if (data_size > 0) {
-		/* Allocate a scratch buffer for payload and options. */
-		size = data_size;
-		(*response)->data = coap_alloc_fn(size);
-		if ((*response)->data == NULL) {
-			coap_free_fn(*response);
-			return err_code;
-		}
-		memset((*response)->data, 0, size);
-		(*response)->data_len = size;
-		COAP_TRC("Alloc mem, response->data = %p", (*response)->data);
+	if (err_code != 0) {
+		COAP_TRC("Free mem, buffer = %p", buffer);
+		coap_free_fn(buffer);
 	}
 
+	COAP_EXIT();
+	return err_code;
+}
+
+u16_t internal_coap_message_id_get(void)
+{
+	return message_id_counter++;
+}
+
+
+/**@brief Create a response to a request in caller-provided memory.
+ *
+ * @param[out] response Message to initialize as a response.
+ * @param[in]  request  Request to respond to.
+ * @param[in]  data     Scratch buffer for options, or NULL if the response
+ *                      carries none.
+ * @param[in]  data_len Size of the scratch buffer.
+ *
+ * @retval 0 If the response was created successfully.
+ */
+static u32_t create_response(coap_message_t *response, coap_message_t *request,
+			     u8_t *data, u16_t data_len)
+{
+	u32_t err_code;
+
+	memset(response, 0, sizeof(coap_message_t));
+	response->data = data;
+	response->data_len = data_len;
+
 	coap_message_conf_t config;
 
 	memset(&config, 0, sizeof(coap_message_conf_t));
@@ -332,12 +427,12 @@ static u32_t create_response(coap_message_t **response, coap_message_t *request,
 		config.type = (coap_msg_type_t)request->header.type;
 	}
 
-	err_code = coap_message_create(*response, &config);
+	err_code = coap_message_create(response, &config);
 	if (err_code != 0) {
 		return err_code;
 	}
 
-	(void)coap_message_remote_addr_set(*response, request->remote);
+	(void)coap_message_remote_addr_set(response, request->remote);
 
 	return 0;
 }
@@ -352,10 +447,12 @@ static u32_t create_response(coap_message_t **response, coap_message_t *request,
  */
 static u32_t send_error_response(coap_message_t *message, u8_t code)
 {
-	coap_message_t *error_response = NULL;
+	/* Error responses carry no options nor payload, so there is no need
+	 * for a scratch buffer.
+	 */
+	coap_message_t error_response;
 
-	u32_t err_code = create_response(&error_response, message,
-					 COAP_MESSAGE_DATA_MAX_SIZE);
+	u32_t err_code = create_response(&error_response, message, NULL, 0);
 
 	if (err_code != 0) {
 		/* If message could not be created, notify the application. */
@@ -364,21 +461,44 @@ static u32_t send_error_response(coap_message_t *message, u8_t code)
 	}
 
 	/* Set the response code. */
-	error_response->header.code = code;
+	error_response.header.code = code;
 
-	if (error_response != NULL) {
-		u32_t handle;
+	u32_t handle;
 
-		err_code = internal_coap_message_send(&handle, error_response);
+	return internal_coap_message_send(&handle, &error_response);
+}
 
-		COAP_TRC("Free mem, response->data = %p", error_response->data);
-		coap_free_fn(error_response->data);
+/**@brief Find the request which a response belongs to.
+ *
+ * @details A piggybacked response is matched by both the message ID and the
+ *          token of the request, as required by RFC 7252 chapter 5.3.2. A
+ *          retransmitted response to an earlier request with the same token,
+ *          like the requests of a block-wise transfer, is then not taken for
+ *          the response to the latest one. A separate response is matched by
+ *          the token only.
+ */
+static u32_t response_item_get(coap_queue_item_t **item,
+			       coap_message_t *message)
+{
+	u32_t err_code;
 
-		COAP_TRC("Free mem, response = %p", (u8_t *)error_response);
-		coap_free_fn(error_response);
+	if (message->header.type != COAP_TYPE_ACK) {
+		return coap_queue_item_by_token_get(item, message->token,
+						    message->header.token_len);
 	}
 
-	return err_code;
+	err_code = coap_queue_item_by_mid_get(item, message->header.id);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	if (((*item)->token_len != message->header.token_len) ||
+	    (memcmp((*item)->token, message->token,
+		    message->header.token_len) != 0)) {
+		return ENOENT;
+	}
+
+	return 0;
 }
 
 u32_t coap_transport_read(const coap_transport_handle_t transport,
@@ -394,25 +514,19 @@ u32_t coap_transport_read(const coap_transport_handle_t transport,
 		return 0;
 	}
 
-	u32_t err_code = ENOMEM;
-	coap_message_t *message;
-	/* Allocate space for a new message. */
-	u32_t size = sizeof(coap_message_t);
-
-	message = coap_alloc_fn(size);
-	if (message == NULL) {
-		COAP_EXIT();
-		return err_code;
-	}
+	/* The decoded message is a view into the datagram, both only live for
+	 * the duration of this call.
+	 */
+	coap_message_t decoded;
+	coap_message_t *message = &decoded;
 
 	memset(message, 0, sizeof(coap_message_t));
-	COAP_TRC("Alloc mem, message = %p", (u8_t *)message);
 
-	err_code = coap_message_decode(message, data, datalen);
+	u32_t err_code = coap_message_decode(message, data, datalen);
+
 	if (err_code != 0) {
 		app_error_notify(err_code, message);
 
-		coap_free_fn(message);
 		COAP_EXIT();
 		return err_code;
 	}
@@ -482,17 +596,13 @@ u32_t coap_transport_read(const coap_transport_handle_t transport,
 
 		coap_queue_item_t *item;
 
-		err_code = coap_queue_item_by_token_get(
-						&item, message->token,
-						message->header.token_len);
+		err_code = response_item_get(&item, message);
 		if (err_code != 0) {
 			/* Compiled away if COAP_ENABLE_OBSERVE_CLIENT is not
 			 * set to 1.
 			 */
 			coap_observe_client_response_handle(message, NULL);
 
-			coap_free_fn(message);
-
 			COAP_MUTEX_UNLOCK();
 			COAP_EXIT();
 			return err_code;
@@ -553,23 +663,37 @@ u32_t coap_transport_read(const coap_transport_handle_t transport,
 			}
 		} else {
 			u8_t *uri_pointers[COAP_RESOURCE_MAX_DEPTH] = { 0, };
+			u16_t uri_lengths[COAP_RESOURCE_MAX_DEPTH] = { 0, };
 			u8_t uri_path_count = 0;
+			bool uri_path_too_deep = false;
 			u16_t index;
 
 			for (index = 0; index < message->options_count;
 								index++) {
-				if (message->options[index].number ==
+				if (message->options[index].number !=
 							COAP_OPT_URI_PATH) {
-					uri_pointers[uri_path_count++] =
-						message->options[index].data;
+					continue;
+				}
+
+				if (uri_path_count == COAP_RESOURCE_MAX_DEPTH) {
+					uri_path_too_deep = true;
+					break;
 				}
+
+				uri_pointers[uri_path_count] =
+					message->options[index].data;
+				uri_lengths[uri_path_count++] =
+					message->options[index].length;
 			}
 
-			coap_resource_t *found_resource;
+			coap_resource_t *found_resource = NULL;
 
-			err_code = coap_resource_get(&found_resource,
-						     uri_pointers,
-						     uri_path_count);
+			if (!uri_path_too_deep) {
+				err_code = coap_resource_get(&found_resource,
+							     uri_pointers,
+							     uri_lengths,
+							     uri_path_count);
+			}
 
 			if (found_resource == NULL) {
 				/* Reply with NOT FOUND. */
@@ -600,9 +724,6 @@ u32_t coap_transport_read(const coap_transport_handle_t transport,
 		}
 	}
 
-	COAP_TRC("Free mem, message = %p", (u8_t *)message);
-	coap_free_fn((u8_t *)message);
-
 	COAP_EXIT();
 	return err_code;
 }
@@ -720,51 +841,50 @@ u32_t coap_time_tick(void)
 
 	coap_transport_process();
 
-	/* Loop through the message queue to see if any packets needs
-	 * retransmission, or has timed out.
+	coap_queue_time_tick();
+
+	/* Only the messages that need retransmission, or have timed out,
+	 * are visited.
 	 */
-	coap_queue_item_t *item = NULL;
-
-	while (coap_queue_item_next_get(&item, item) == 0) {
-		if (item->timeout == 0) {
-			/* If there is still retransmission attempts left. */
-			if (item->retrans_count < COAP_MAX_RETRANSMIT_COUNT) {
-				item->timeout = item->timeout_val * 2;
-				item->timeout_val = item->timeout;
-				item->retrans_count++;
-
-				/* Retransmit the message. */
-				u32_t err_code = coap_transport_write(
-					item->transport,
-					(struct sockaddr *)&item->remote,
-					item->buffer,
-					item->buffer_len);
-				if (err_code != 0) {
-					app_error_notify(err_code, NULL);
-				}
+	coap_queue_item_t *item;
+
+	while (coap_queue_item_expired_get(&item) == 0) {
+		/* If there is still retransmission attempts left. */
+		if (item->retrans_count < COAP_MAX_RETRANSMIT_COUNT) {
+			item->timeout = item->timeout_val * 2;
+			item->timeout_val = item->timeout;
+			item->retrans_count++;
+
+			/* Retransmit the message. */
+			u32_t err_code = coap_transport_write(
+				item->transport,
+				(struct sockaddr *)&item->remote,
+				item->buffer,
+				item->buffer_len);
+			if (err_code != 0) {
+				app_error_notify(err_code, NULL);
 			}
+		}
 
-			/* No more retransmission attempts left, or max transmit
-			 * span reached.
-			 */
-			if ((item->timeout > COAP_MAX_TRANSMISSION_SPAN) ||
-			    (item->retrans_count >=
-						COAP_MAX_RETRANSMIT_COUNT)) {
-
+		/* No more retransmission attempts left, or max transmit
+		 * span reached.
+		 */
+		if ((item->timeout > COAP_MAX_TRANSMISSION_SPAN) ||
+		    (item->retrans_count >= COAP_MAX_RETRANSMIT_COUNT)) {
+			if (item->callback != NULL) {
 				COAP_MUTEX_UNLOCK();
 
 				item->callback(ETIMEDOUT, item->arg, NULL);
 
 				COAP_MUTEX_LOCK();
+			}
 
-				COAP_TRC("Free mem, item->buffer = %p",
-					 item->buffer);
-				coap_free_fn(item->buffer);
+			COAP_TRC("Free mem, item->buffer = %p", item->buffer);
+			coap_free_fn(item->buffer);
 
-				(void)coap_queue_remove(item);
-			}
+			(void)coap_queue_remove(item);
 		} else {
-			item->timeout--;
+			(void)coap_queue_item_timeout_restart(item);
 		}
 	}
 
@@ -773,6 +893,74 @@ u32_t coap_time_tick(void)
 	return 0;
 }
 
+/**@brief Fail the messages waiting for a response on a transport.
+ *
+ * @note The mutex shall be held by the caller.
+ *
+ * @param[in] handle   Transport which was closed.
+ * @param[in] err_code Error passed to the response callbacks.
+ */
+static void transport_items_fail(const coap_transport_handle_t handle,
+				 u32_t err_code)
+{
+	coap_queue_item_t *item;
+
+	while (coap_queue_item_by_transport_get(&item, handle) == 0) {
+		coap_response_callback_t callback = item->callback;
+		void *arg = item->arg;
+
+		COAP_TRC("Free mem, item->buffer = %p", item->buffer);
+		coap_free_fn(item->buffer);
+
+		(void)coap_queue_remove(item);
+
+		if (callback != NULL) {
+			COAP_MUTEX_UNLOCK();
+
+			callback(err_code, arg, NULL);
+
+			COAP_MUTEX_LOCK();
+		}
+	}
+}
+
+void coap_transport_closed(const coap_transport_handle_t handle,
+			   u32_t err_code)
+{
+	COAP_MUTEX_LOCK();
+
+	/* The handle may be reused by the next endpoint opened. */
+	transport_items_fail(handle, err_code);
+
+	COAP_MUTEX_UNLOCK();
+}
+
+void coap_transport_error(const coap_transport_handle_t handle,
+			  u32_t err_code)
+{
+	COAP_MUTEX_LOCK();
+
+	/* Messages waiting for a response on the transport will not get one. */
+	transport_items_fail(handle, err_code);
+
+	app_error_notify(err_code, NULL);
+
+	COAP_MUTEX_UNLOCK();
+}
+
+u32_t coap_next_deadline(u32_t *ticks)
+{
+	NULL_PARAM_CHECK(ticks);
+
+	COAP_MUTEX_LOCK();
+
+	u32_t err_code = coap_queue_next_deadline_get(ticks);
+
+	COAP_MUTEX_UNLOCK();
+
+	return err_code;
+}
+
 u32_t coap_request_handler_register(coap_request_handler_t handler)
 {
 	COAP_MUTEX_LOCK();
@@ -784,6 +972,26 @@ u32_t coap_request_handler_register(coap_request_handler_t handler)
 	return 0;
 }
 
+__weak u32_t coap_transport_poll(s32_t timeout)
+{
+	/* By default the transport can only be polled, not waited on. */
+	ARG_UNUSED(timeout);
+
+	coap_transport_input();
+
+	return 0;
+}
+
+__weak u8_t *coap_transport_tx_buffer_get(u16_t *length)
+{
+	/* By default no transport buffer, messages are serialized into
+	 * allocated memory.
+	 */
+	*length = 0;
+
+	return NULL;
+}
+
 __weak void coap_transport_input(void)
 {
 	/* By default not implemented. Transport specific. */
@@ -797,3 +1005,69 @@ void coap_input(void)
 
 	COAP_MUTEX_UNLOCK();
 }
+
+/**@brief Call coap_time_tick for every tick interval elapsed.
+ *
+ * @details Ticks only run while the message queue is not empty. When a message
+ *          is queued after an idle period, the first tick is one interval
+ *          after it is noticed.
+ */
+static void tick_process(void)
+{
+	s64_t uptime = k_uptime_get();
+	u32_t ticks;
+
+	while (coap_next_deadline(&ticks) == 0) {
+		if (!ticking) {
+			ticking = true;
+			next_tick_time = uptime + COAP_TICK_INTERVAL_MS;
+		}
+
+		if (next_tick_time > uptime) {
+			return;
+		}
+
+		(void)coap_time_tick();
+		next_tick_time += COAP_TICK_INTERVAL_MS;
+	}
+
+	/* Nothing in the queue, no need to tick. */
+	ticking = false;
+}
+
+u32_t coap_process(s32_t timeout)
+{
+	COAP_ENTRY();
+
+	tick_process();
+
+	/* Do not sleep past the next retransmission or timeout. */
+	u32_t ticks;
+
+	if (coap_next_deadline(&ticks) == 0) {
+		s64_t due = next_tick_time - k_uptime_get();
+
+		if (ticks > 1) {
+			due += (s64_t)(ticks - 1) * COAP_TICK_INTERVAL_MS;
+		}
+
+		if (due < 0) {
+			due = 0;
+		}
+
+		if ((timeout == K_FOREVER) || (due < timeout)) {
+			timeout = (s32_t)MIN(due, INT32_MAX);
+		}
+	}
+
+	COAP_MUTEX_LOCK();
+
+	u32_t err_code = coap_transport_poll(timeout);
+
+	COAP_MUTEX_UNLOCK();
+
+	tick_process();
+
+	COAP_EXIT_WITH_RESULT(err_code);
+	return err_code;
+}
@@ -95,6 +95,28 @@ extern "C" {
  */
 u32_t internal_coap_message_send(u32_t *handle, coap_message_t *message);
 
+/**@brief Sends a CoAP message which is already encoded.
+ *
+ * @details Like \ref internal_coap_message_send, but the message is only used
+ *          for addressing and queueing, the bytes sent are taken from data.
+ *          The data is copied if the message is kept in the message queue.
+ *
+ * @param[out] handle   Handle to the message if CoAP CON/ACK messages has
+ *                      been used. Returned by reference.
+ * @param[in]  message  Message header, token, remote and transport of the
+ *                      encoded message.
+ * @param[in]  data     Encoded message.
+ * @param[in]  data_len Length of the encoded message.
+ *
+ * @retval 0 If the message was successfully scheduled for transmission.
+ */
+u32_t internal_coap_encoded_message_send(u32_t *handle,
+					 coap_message_t *message,
+					 const u8_t *data, u16_t data_len);
+
+/**@brief Get a new message ID. */
+u16_t internal_coap_message_id_get(void);
+
 #ifdef __cplusplus
 }
 #endif
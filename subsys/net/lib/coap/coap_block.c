@@ -9,8 +9,12 @@
 LOG_MODULE_REGISTER(coap_block);
 
 #include <stdbool.h>
+#include <string.h>
 #include <errno.h>
 
+#include <net/coap_api.h>
+#include <net/coap_message.h>
+#include <net/coap_option.h>
 #include <net/coap_block.h>
 
 #include "coap.h"
@@ -44,6 +48,9 @@ LOG_MODULE_REGISTER(coap_block);
 /** Maximum block number. 20 bits max value is (1 << 20) - 1. */
 #define BLOCK_NUMBER_MAX   0xFFFFF
 
+/** Maximum length of the encoded block option value. */
+#define BLOCK_OPT_MAX_LEN  3
+
 static u32_t block_opt_encode(u8_t more, u16_t size, u32_t number,
 			      u32_t *encoded)
 {
@@ -146,3 +153,541 @@ u32_t coap_block_opt_block2_decode(coap_block_opt_block2_t *opt, u32_t encoded)
 
 	return block_opt_decode(encoded, &opt->more, &opt->size, &opt->number);
 }
+
+/**@brief Decode block option of the message.
+ *
+ * @retval 0      If the option was decoded.
+ * @retval ENOENT If the message does not contain the option.
+ * @retval EINVAL If the option value is not valid.
+ */
+static u32_t block_opt_get(coap_message_t *message, u16_t option, u8_t *more,
+			   u16_t *size, u32_t *number)
+{
+	u32_t encoded = 0;
+	u32_t err_code;
+	u8_t index;
+
+	err_code = coap_message_opt_index_get(&index, message, option);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	if (message->options[index].length > 0) {
+		err_code = coap_opt_uint_decode(&encoded,
+						message->options[index].length,
+						message->options[index].data);
+		if (err_code != 0) {
+			return err_code;
+		}
+	}
+
+	return block_opt_decode(encoded, more, size, number);
+}
+
+static bool block_size_valid(u16_t size)
+{
+	u32_t encoded;
+
+	return block_opt_encode(0, size, 0, &encoded) == 0;
+}
+
+/**@brief Read the next block into the message scratch buffer.
+ *
+ * @details The block is placed after the space left for the block option,
+ *          which is added once it is known whether this is the last block.
+ */
+static u32_t block_read(coap_block_xfer_t *xfer, coap_message_t *message,
+			u32_t offset, u16_t size, bool *last)
+{
+	u16_t len = size;
+	u32_t err_code;
+
+	if (message->options_offset + BLOCK_OPT_MAX_LEN + size >
+	    message->data_len) {
+		return EMSGSIZE;
+	}
+
+	message->payload = &message->data[message->options_offset +
+					  BLOCK_OPT_MAX_LEN];
+	*last = false;
+
+	err_code = xfer->read(xfer, offset, message->payload, &len, last);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	if (len > size) {
+		return EMSGSIZE;
+	}
+
+	if (len < size) {
+		*last = true;
+	}
+
+	message->payload_len = len;
+
+	return 0;
+}
+
+static u32_t block_opt_add(coap_message_t *message, u16_t option, bool more,
+			   u16_t size, u32_t number)
+{
+	u32_t encoded;
+	u32_t err_code;
+
+	err_code = block_opt_encode(more ? BLOCK_MORE_BIT_SET :
+					   BLOCK_MORE_BIT_UNSET,
+				    size, number, &encoded);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	return coap_message_opt_uint_add(message, option, encoded);
+}
+
+static u32_t message_send(coap_message_t *message)
+{
+	u32_t handle;
+	u32_t err_code;
+
+	err_code = coap_message_send(&handle, message);
+
+	(void)coap_message_delete(message);
+
+	return err_code;
+}
+
+static void client_response_handle(u32_t status, void *arg,
+				   coap_message_t *response);
+
+static u32_t client_request_send(coap_block_xfer_t *xfer)
+{
+	coap_message_t *request;
+	coap_message_conf_t config = xfer->config;
+	u32_t err_code;
+	bool last;
+
+	config.id = 0;
+	config.response_callback = client_response_handle;
+
+	err_code = coap_message_new(&request, &config);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	request->arg = xfer;
+	(void)coap_message_remote_addr_set(request, xfer->remote);
+
+	if (xfer->options_add != NULL) {
+		err_code = xfer->options_add(xfer, request);
+	}
+
+	if (err_code == 0) {
+		if (xfer->block1_active) {
+			err_code = block_read(xfer, request,
+					      xfer->block1_offset,
+					      xfer->block1_size, &last);
+			if (err_code == 0) {
+				err_code = block_opt_add(
+					request, COAP_OPT_BLOCK1, !last,
+					xfer->block1_size,
+					xfer->block1_offset /
+							xfer->block1_size);
+			}
+		} else {
+			/* Early negotiation of the block size, see RFC 7959
+			 * chapter 2.4.
+			 */
+			err_code = block_opt_add(
+				request, COAP_OPT_BLOCK2, false,
+				xfer->block2_size,
+				xfer->block2_offset / xfer->block2_size);
+		}
+	}
+
+	if (err_code != 0) {
+		(void)coap_message_delete(request);
+		return err_code;
+	}
+
+	return message_send(request);
+}
+
+static void client_done(coap_block_xfer_t *xfer, u32_t status,
+			coap_message_t *response)
+{
+	xfer->active = false;
+
+	if (xfer->done != NULL) {
+		xfer->done(xfer, status, response);
+	}
+}
+
+/**@brief Handle the response to a Block1 request.
+ *
+ * @retval 0      If the next block was sent.
+ * @retval ENOENT If the request body was sent completely.
+ */
+static u32_t client_block1_handle(coap_block_xfer_t *xfer,
+				  coap_message_t *response)
+{
+	u32_t number;
+	u16_t size;
+	u8_t more;
+
+	if (response->header.code != COAP_CODE_231_CONTINUE) {
+		/* Final response, or the server gave up on the body. */
+		xfer->block1_active = false;
+		return ENOENT;
+	}
+
+	if ((block_opt_get(response, COAP_OPT_BLOCK1, &more, &size,
+			   &number) != 0) ||
+	    (number * xfer->block1_size != xfer->block1_offset) ||
+	    (size > xfer->block1_size)) {
+		return EPROTO;
+	}
+
+	/* The server can ask for smaller blocks, which are numbered by the
+	 * new size from then on.
+	 */
+	xfer->block1_offset += xfer->block1_size;
+	xfer->block1_size = size;
+
+	return client_request_send(xfer);
+}
+
+/**@brief Handle the response body.
+ *
+ * @retval 0      If the request for the next block was sent.
+ * @retval ENOENT If the response body was received completely.
+ */
+static u32_t client_block2_handle(coap_block_xfer_t *xfer,
+				  coap_message_t *response)
+{
+	u32_t err_code;
+	u32_t number;
+	u16_t size;
+	u8_t more;
+
+	err_code = block_opt_get(response, COAP_OPT_BLOCK2, &more, &size,
+				 &number);
+	if (err_code == ENOENT) {
+		/* Whole body in one response. */
+		number = 0;
+		size = xfer->block2_size;
+		more = BLOCK_MORE_BIT_UNSET;
+	} else if (err_code != 0) {
+		return EPROTO;
+	}
+
+	if ((number * size != xfer->block2_offset) ||
+	    ((more == BLOCK_MORE_BIT_SET) &&
+	     (response->payload_len != size))) {
+		return EPROTO;
+	}
+
+	if ((xfer->write != NULL) &&
+	    ((response->payload_len > 0) || (more == BLOCK_MORE_BIT_UNSET))) {
+		err_code = xfer->write(xfer, xfer->block2_offset,
+				       response->payload,
+				       response->payload_len,
+				       more == BLOCK_MORE_BIT_UNSET);
+		if (err_code != 0) {
+			return err_code;
+		}
+	}
+
+	xfer->block2_offset += response->payload_len;
+
+	if (more == BLOCK_MORE_BIT_UNSET) {
+		return ENOENT;
+	}
+
+	xfer->block2_size = MIN(size, xfer->block2_size);
+
+	return client_request_send(xfer);
+}
+
+static void client_response_handle(u32_t status, void *arg,
+				   coap_message_t *response)
+{
+	coap_block_xfer_t *xfer = arg;
+	u32_t err_code;
+
+	if ((status != 0) || (response == NULL)) {
+		client_done(xfer, status, response);
+		return;
+	}
+
+	if (xfer->block1_active) {
+		err_code = client_block1_handle(xfer, response);
+		if (err_code != ENOENT) {
+			if (err_code != 0) {
+				client_done(xfer, err_code, response);
+			}
+
+			return;
+		}
+	}
+
+	err_code = client_block2_handle(xfer, response);
+	if (err_code == ENOENT) {
+		client_done(xfer, 0, response);
+	} else if (err_code != 0) {
+		client_done(xfer, err_code, response);
+	}
+}
+
+u32_t coap_block_client_start(coap_block_xfer_t *xfer,
+			      coap_message_conf_t *config,
+			      struct sockaddr *remote)
+{
+	NULL_PARAM_CHECK(xfer);
+	NULL_PARAM_CHECK(config);
+	NULL_PARAM_CHECK(remote);
+
+	if (!block_size_valid(xfer->block_size)) {
+		return EINVAL;
+	}
+
+	if (xfer->active) {
+		return EBUSY;
+	}
+
+	COAP_ENTRY();
+
+	xfer->config = *config;
+	xfer->remote = remote;
+	xfer->block1_size = xfer->block_size;
+	xfer->block2_size = xfer->block_size;
+	xfer->block1_offset = 0;
+	xfer->block2_offset = 0;
+	xfer->block1_active = (xfer->read != NULL);
+	xfer->active = true;
+
+	u32_t err_code = client_request_send(xfer);
+
+	if (err_code != 0) {
+		xfer->active = false;
+	}
+
+	COAP_EXIT_WITH_RESULT(err_code);
+
+	return err_code;
+}
+
+static u32_t response_new(coap_message_t **response, coap_message_t *request,
+			  coap_msg_code_t code)
+{
+	coap_message_conf_t config;
+	u32_t err_code;
+
+	memset(&config, 0, sizeof(config));
+	config.code = code;
+	config.transport = request->transport;
+	config.token_len = request->header.token_len;
+	memcpy(config.token, request->token, request->header.token_len);
+
+	if (request->header.type == COAP_TYPE_CON) {
+		config.type = COAP_TYPE_ACK;
+		config.id = request->header.id;
+	} else {
+		config.type = COAP_TYPE_NON;
+	}
+
+	err_code = coap_message_new(response, &config);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	(void)coap_message_remote_addr_set(*response, request->remote);
+
+	return 0;
+}
+
+static u32_t server_response_send(coap_block_xfer_t *xfer,
+				  coap_message_t *request,
+				  coap_msg_code_t code)
+{
+	coap_message_t *response;
+	u32_t err_code;
+
+	err_code = response_new(&response, request, code);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	return message_send(response);
+}
+
+u32_t coap_block_server_get_handle(coap_block_xfer_t *xfer,
+				   coap_message_t *request)
+{
+	coap_message_t *response;
+	u32_t err_code;
+	u32_t number;
+	u16_t size;
+	u8_t more;
+	bool last;
+
+	NULL_PARAM_CHECK(xfer);
+	NULL_PARAM_CHECK(xfer->read);
+	NULL_PARAM_CHECK(request);
+
+	if (!block_size_valid(xfer->block_size)) {
+		return EINVAL;
+	}
+
+	err_code = block_opt_get(request, COAP_OPT_BLOCK2, &more, &size,
+				 &number);
+	if (err_code == ENOENT) {
+		number = 0;
+		size = xfer->block_size;
+	} else if (err_code != 0) {
+		return server_response_send(xfer, request,
+					    COAP_CODE_400_BAD_REQUEST);
+	}
+
+	if (size > xfer->block_size) {
+		/* Block number stays valid for the smaller size. */
+		number = number * (size / xfer->block_size);
+		size = xfer->block_size;
+	}
+
+	err_code = response_new(&response, request, COAP_CODE_205_CONTENT);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	if (xfer->options_add != NULL) {
+		err_code = xfer->options_add(xfer, response);
+	}
+
+	if (err_code == 0) {
+		err_code = block_read(xfer, response, number * size, size,
+				      &last);
+	}
+
+	/* Block2 option is omitted if the whole body fits in one response
+	 * to a request without it.
+	 */
+	if ((err_code == 0) && ((number > 0) || !last ||
+				(coap_message_opt_present(
+					request, COAP_OPT_BLOCK2) == 0))) {
+		err_code = block_opt_add(response, COAP_OPT_BLOCK2, !last,
+					 size, number);
+	}
+
+	if (err_code != 0) {
+		(void)coap_message_delete(response);
+
+		return server_response_send(
+				xfer, request,
+				COAP_CODE_500_INTERNAL_SERVER_ERROR);
+	}
+
+	return message_send(response);
+}
+
+u32_t coap_block_server_put_handle(coap_block_xfer_t *xfer,
+				   coap_message_t *request,
+				   coap_msg_code_t code)
+{
+	coap_message_t *response;
+	u32_t err_code;
+	u32_t number;
+	u16_t size;
+	u8_t more;
+
+	NULL_PARAM_CHECK(xfer);
+	NULL_PARAM_CHECK(request);
+
+	if (!block_size_valid(xfer->block_size)) {
+		return EINVAL;
+	}
+
+	err_code = block_opt_get(request, COAP_OPT_BLOCK1, &more, &size,
+				 &number);
+	if (err_code == ENOENT) {
+		/* Whole body in one request. */
+		number = 0;
+		size = 0;
+		more = BLOCK_MORE_BIT_UNSET;
+	} else if (err_code != 0) {
+		return server_response_send(xfer, request,
+					    COAP_CODE_400_BAD_REQUEST);
+	}
+
+	if ((more == BLOCK_MORE_BIT_SET) && (request->payload_len != size)) {
+		return server_response_send(xfer, request,
+					    COAP_CODE_400_BAD_REQUEST);
+	}
+
+	/* Retransmission of the previous block, whose response was lost, is
+	 * acknowledged again. The first block could also start a new body, so
+	 * it is only a retransmission if the message ID is the same.
+	 */
+	bool duplicate = (xfer->block1_offset > 0) &&
+			 (number * size + request->payload_len ==
+			  xfer->block1_offset) &&
+			 ((number > 0) ||
+			  (request->header.id == xfer->block1_mid));
+
+	if ((number == 0) && !duplicate) {
+		/* First block starts a new body. */
+		xfer->block1_offset = 0;
+	}
+
+	if (!duplicate && (number * size != xfer->block1_offset)) {
+		return server_response_send(
+			xfer, request, COAP_CODE_408_REQUEST_ENTITY_INCOMPLETE);
+	}
+
+	if (!duplicate && (xfer->write != NULL)) {
+		err_code = xfer->write(xfer, xfer->block1_offset,
+				       request->payload, request->payload_len,
+				       more == BLOCK_MORE_BIT_UNSET);
+		if (err_code != 0) {
+			xfer->block1_offset = 0;
+
+			return server_response_send(
+				xfer, request,
+				(err_code == EFBIG) ?
+				COAP_CODE_413_REQUEST_ENTITY_TOO_LARGE :
+				COAP_CODE_500_INTERNAL_SERVER_ERROR);
+		}
+	}
+
+	if (!duplicate) {
+		xfer->block1_offset += request->payload_len;
+		xfer->block1_mid = request->header.id;
+	}
+
+	err_code = response_new(&response, request,
+				(more == BLOCK_MORE_BIT_SET) ?
+				COAP_CODE_231_CONTINUE : code);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	if (xfer->options_add != NULL) {
+		err_code = xfer->options_add(xfer, response);
+	}
+
+	if ((err_code == 0) && (size > 0)) {
+		/* Acknowledge the block and propose the block size for the
+		 * following ones.
+		 */
+		err_code = block_opt_add(response, COAP_OPT_BLOCK1,
+					 more == BLOCK_MORE_BIT_SET,
+					 MIN(size, xfer->block_size), number);
+	}
+
+	if (err_code != 0) {
+		(void)coap_message_delete(response);
+		return err_code;
+	}
+
+	return message_send(response);
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <logging/log.h>
+#define LOG_LEVEL CONFIG_NRF_COAP_LOG_LEVEL
+LOG_MODULE_REGISTER(coap_mem);
+
+#include <string.h>
+#include <errno.h>
+#include <zephyr.h>
+
+#include <net/coap_api.h>
+
+#include "coap.h"
+
+/** Block sizes are rounded up to keep every block word aligned. */
+#define BLOCK_SIZE(size) (((size) + 3) & ~3)
+
+/** Largest encoded message: header, token, payload marker and an option
+ *  header with extension bytes for each option, on top of the option values
+ *  and payload which share the message data buffer.
+ */
+#define BUFFER_SIZE BLOCK_SIZE(4 + 8 + 1 + COAP_MESSAGE_DATA_MAX_SIZE + \
+			       (5 * COAP_MAX_NUMBER_OF_OPTIONS))
+
+#define MESSAGE_SIZE BLOCK_SIZE(sizeof(coap_message_t))
+
+#define SMALL_SIZE BLOCK_SIZE(COAP_MEM_SMALL_BUFFER_SIZE)
+
+BUILD_ASSERT_MSG(BUFFER_SIZE <= 0xFFFF, "CoAP pool buffer too large");
+
+#if (COAP_MEM_SMALL_BUFFER_COUNT > 0)
+K_MEM_SLAB_DEFINE(small_slab, SMALL_SIZE, COAP_MEM_SMALL_BUFFER_COUNT, 4);
+#endif
+K_MEM_SLAB_DEFINE(message_slab, MESSAGE_SIZE, COAP_MEM_MESSAGE_COUNT, 4);
+K_MEM_SLAB_DEFINE(buffer_slab, BUFFER_SIZE, COAP_MEM_BUFFER_COUNT, 4);
+
+/**@brief Block pool with its usage counters. */
+typedef struct {
+	/** Slab the blocks are taken from. NULL if the pool has no blocks. */
+	struct k_mem_slab *slab;
+
+	/** Highest number of blocks used at the same time. */
+	u16_t max_used;
+
+	/** Number of requests this pool was the best fit for, but had no free
+	 *  block.
+	 */
+	u32_t failures;
+} pool_t;
+
+/** Pools indexed by coap_mem_pool_t. */
+static pool_t pools[COAP_MEM_POOL_COUNT] = {
+#if (COAP_MEM_SMALL_BUFFER_COUNT > 0)
+	[COAP_MEM_POOL_SMALL] = { .slab = &small_slab },
+#endif
+	[COAP_MEM_POOL_MESSAGE] = { .slab = &message_slab },
+	[COAP_MEM_POOL_BUFFER] = { .slab = &buffer_slab },
+};
+
+static bool is_pool_block(const struct k_mem_slab *slab, const void *mem)
+{
+	const char *start = slab->buffer;
+	const char *end = start + slab->num_blocks * slab->block_size;
+
+	return ((const char *)mem >= start) && ((const char *)mem < end);
+}
+
+/**@brief Find the pool with the smallest blocks that fit the size.
+ *
+ * @param[in] size      Size of the requested memory.
+ * @param[in] need_free Only consider pools with a free block.
+ *
+ * @retval Pointer to the pool, or NULL if no pool fits.
+ */
+static pool_t *pool_best_fit(size_t size, bool need_free)
+{
+	pool_t *best = NULL;
+
+	for (int i = 0; i < COAP_MEM_POOL_COUNT; i++) {
+		struct k_mem_slab *slab = pools[i].slab;
+
+		if ((slab == NULL) || (slab->block_size < size)) {
+			continue;
+		}
+
+		if (need_free && (k_mem_slab_num_free_get(slab) == 0)) {
+			continue;
+		}
+
+		if ((best == NULL) ||
+		    (slab->block_size < best->slab->block_size)) {
+			best = &pools[i];
+		}
+	}
+
+	return best;
+}
+
+void *coap_mem_alloc(size_t size)
+{
+	pool_t *best = pool_best_fit(size, false);
+	pool_t *pool = pool_best_fit(size, true);
+	void *mem;
+
+	if (pool != best) {
+		/* The best fit is empty, a larger block is used if any. */
+		best->failures++;
+	}
+
+	if (pool == NULL) {
+		COAP_ERR("No CoAP pool block for %u bytes", (u32_t)size);
+		return NULL;
+	}
+
+	if (k_mem_slab_alloc(pool->slab, &mem, K_NO_WAIT) != 0) {
+		pool->failures++;
+		return NULL;
+	}
+
+	pool->max_used = MAX(pool->max_used,
+			     k_mem_slab_num_used_get(pool->slab));
+
+	return mem;
+}
+
+void coap_mem_free(void *memory)
+{
+	if (memory == NULL) {
+		return;
+	}
+
+	for (int i = 0; i < COAP_MEM_POOL_COUNT; i++) {
+		struct k_mem_slab *slab = pools[i].slab;
+
+		if ((slab != NULL) && is_pool_block(slab, memory)) {
+			k_mem_slab_free(slab, &memory);
+			return;
+		}
+	}
+
+	COAP_ERR("Free of memory not from a CoAP pool, %p", memory);
+}
+
+u32_t coap_mem_stats_get(coap_mem_pool_t pool, coap_mem_stats_t *stats)
+{
+	NULL_PARAM_CHECK(stats);
+
+	if (pool >= COAP_MEM_POOL_COUNT) {
+		return EINVAL;
+	}
+
+	memset(stats, 0, sizeof(coap_mem_stats_t));
+
+	if (pools[pool].slab != NULL) {
+		stats->block_size = pools[pool].slab->block_size;
+		stats->block_count = pools[pool].slab->num_blocks;
+		stats->used = k_mem_slab_num_used_get(pools[pool].slab);
+		stats->max_used = pools[pool].max_used;
+		stats->failures = pools[pool].failures;
+	}
+
+	return 0;
+}
@@ -54,9 +54,14 @@ u32_t coap_message_create(coap_message_t *message,
 }
 
 /**@brief Decode CoAP option
+ *
+ * @details The decoded option is a view into the raw message buffer, the
+ *          option value is not copied.
  *
  * @param[in]    raw_option Pointer to the memory buffer where the raw option
  *                          is located.
+ * @param[in]    raw_len    Number of bytes left in the raw message buffer,
+ *                          starting at raw_option.
  * @param[inout] message    Pointer to the current message. Used to retrieve
  *                          information about where current option delta and
  *                          the size of free memory to add the values of the
@@ -66,14 +71,20 @@ u32_t coap_message_create(coap_message_t *message,
  *                          next option might be located (if any left) in the
  *                          raw message buffer.
  *
- * @retval 0 If the option parsing went successful.
+ * @retval 0      If the option parsing went successful.
+ * @retval EINVAL If the option uses a reserved nibble value or runs past the
+ *                end of the raw message buffer.
+ * @retval ENOMEM If the message holds more than COAP_MAX_NUMBER_OF_OPTIONS
+ *                options.
  */
-static u32_t decode_option(const u8_t *raw_option, coap_message_t *message,
-			   u16_t *byte_count)
+static u32_t decode_option(const u8_t *raw_option, u16_t raw_len,
+			   coap_message_t *message, u16_t *byte_count)
 {
 	u16_t byte_index = 0;
 	u8_t option_num = message->options_count;
 
+	OPTION_INDEX_AVAIL_CHECK(option_num);
+
 	/* Calculate the option number. */
 	u16_t option_delta = (raw_option[byte_index] & 0xF0) >> 4;
 	/* Calculate the option length. */
@@ -81,7 +92,19 @@ static u32_t decode_option(const u8_t *raw_option, coap_message_t *message,
 
 	byte_index++;
 
-	u16_t acc_option_delta = message->options_delta;
+	/* Value 15 is reserved for the payload marker. */
+	if ((option_delta == 15) || (option_length == 15)) {
+		return EINVAL;
+	}
+
+	/* Verify that the extended bytes are within the buffer. */
+	if ((u32_t)byte_index + (option_delta == 13 ? 1 : 0) +
+	    (option_delta == 14 ? 2 : 0) + (option_length == 13 ? 1 : 0) +
+	    (option_length == 14 ? 2 : 0) > raw_len) {
+		return EINVAL;
+	}
+
+	u32_t acc_option_delta = message->options_delta;
 
 	if (option_delta == 13) {
 		/* read one additional byte to get the extended delta. */
@@ -96,8 +119,9 @@ static u32_t decode_option(const u8_t *raw_option, coap_message_t *message,
 		acc_option_delta += option_delta;
 	}
 
-	/* Set the accumulated delta as the option number. */
-	message->options[option_num].number = acc_option_delta;
+	if (acc_option_delta > 0xFFFF) {
+		return EINVAL;
+	}
 
 	if (option_length == 13) {
 		option_length = 13 + raw_option[byte_index++];
@@ -107,6 +131,14 @@ static u32_t decode_option(const u8_t *raw_option, coap_message_t *message,
 		option_length += raw_option[byte_index++];
 	}
 
+	/* Verify that the option value is within the buffer. */
+	if ((u32_t)byte_index + option_length > raw_len) {
+		return EINVAL;
+	}
+
+	/* Set the accumulated delta as the option number. */
+	message->options[option_num].number = acc_option_delta;
+
 	/* Set the option length including extended bytes. */
 	message->options[option_num].length = option_length;
 
@@ -229,14 +261,24 @@ u32_t coap_message_decode(coap_message_t *message, const u8_t *raw_message,
 	message->header.id = raw_message[byte_index++] << 8;
 	message->header.id += raw_message[byte_index++];
 
-	/* Parse the token, if any. */
-	for (u8_t index = 0; (byte_index < message_len) &&
-			     (index < message->header.token_len); index++) {
-		message->token[index] = raw_message[byte_index++];
+	/* Token lengths 9-15 are reserved. */
+	if (message->header.token_len > sizeof(message->token)) {
+		return EINVAL;
 	}
 
+	if (byte_index + message->header.token_len > message_len) {
+		return EMSGSIZE;
+	}
+
+	/* Parse the token, if any. */
+	memcpy(message->token, &raw_message[byte_index],
+	       message->header.token_len);
+	byte_index += message->header.token_len;
+
 	message->options_count = 0;
 	message->options_delta = 0;
+	message->payload = NULL;
+	message->payload_len = 0;
 
 	/* Parse the options if any. */
 	while ((byte_index < message_len) &&
@@ -244,7 +286,8 @@ u32_t coap_message_decode(coap_message_t *message, const u8_t *raw_message,
 		u32_t err_code;
 		u16_t byte_count = 0;
 
-		err_code = decode_option(&raw_message[byte_index], message,
+		err_code = decode_option(&raw_message[byte_index],
+					 message_len - byte_index, message,
 					 &byte_count);
 		if (err_code != 0) {
 			return err_code;
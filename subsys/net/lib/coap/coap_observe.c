@@ -18,21 +18,134 @@ LOG_MODULE_REGISTER(coap_observe);
 
 #if (COAP_ENABLE_OBSERVE_SERVER == 1)
 
+/** Observer index which does not point to any observer. */
+#define OBSERVER_INDEX_NONE 0xFFFF
+
+/** Number of observer buckets. Observers are in the bucket of their resource.
+ */
+#define OBSERVER_BUCKET_COUNT MAX(COAP_OBSERVE_MAX_NUM_OBSERVERS, 1)
+
+/** Largest token, room for which is reserved in front of a notification. */
+#define NOTIFICATION_TOKEN_MAX_LEN 8
+
+/** Size of the CoAP header without token. */
+#define NOTIFICATION_HEADER_LEN 4
+
 typedef struct {
 	coap_observer_t observer;
 	struct sockaddr_in6 remote; /* Provision for maximum size. */
+	/** Next observer in the same bucket. */
+	u16_t next;
+	/** Number of NON notifications since the last CON notification. */
+	u8_t non_count;
+	/** A CON notification is waiting to be acknowledged. */
+	bool con_pending;
+	/** Incremented when the observer is unregistered, so that responses
+	 *  to its notifications are not taken for the next observer in the
+	 *  slot.
+	 */
+	u16_t generation;
 } internal_coap_observer_t;
 
 static internal_coap_observer_t observers[COAP_OBSERVE_MAX_NUM_OBSERVERS];
 
+/** First observer in each bucket. */
+static u16_t buckets[OBSERVER_BUCKET_COUNT];
+
+/** Observe option value of the last notification. */
+static u32_t observe_sequence;
+
+/** Encoded notification, preceded by room for the header and token. */
+static u8_t notification_mem[NOTIFICATION_TOKEN_MAX_LEN +
+			     NOTIFICATION_HEADER_LEN +
+			     COAP_MESSAGE_DATA_MAX_SIZE];
+
+static inline u16_t bucket_get(const coap_resource_t *resource)
+{
+	/* Resources are usually allocated next to each other. */
+	return ((uintptr_t)resource / sizeof(coap_resource_t)) %
+	       OBSERVER_BUCKET_COUNT;
+}
+
 static void observe_server_init(void)
 {
 	COAP_ENTRY();
 	memset(observers, 0, sizeof(internal_coap_observer_t) *
 	       COAP_OBSERVE_MAX_NUM_OBSERVERS);
+
+	for (u32_t i = 0; i < OBSERVER_BUCKET_COUNT; i++) {
+		buckets[i] = OBSERVER_INDEX_NONE;
+	}
+
+	observe_sequence = 0;
 	COAP_EXIT();
 }
 
+/**@brief Add an observer to the bucket of its resource. */
+static void observer_link(u16_t index)
+{
+	internal_coap_observer_t *observer = &observers[index];
+	u16_t bucket = bucket_get(observer->observer.resource_of_interest);
+
+	observer->next = buckets[bucket];
+	buckets[bucket] = index;
+}
+
+/**@brief Remove an observer from the bucket of its resource.
+ *
+ * @details The next index of the observer is kept, so that an iteration
+ *          through \ref internal_coap_observe_server_next_get which is at
+ *          this observer can continue.
+ */
+static void observer_unlink(u16_t index)
+{
+	internal_coap_observer_t *observer = &observers[index];
+	u16_t bucket = bucket_get(observer->observer.resource_of_interest);
+	u16_t *link = &buckets[bucket];
+
+	while (*link != OBSERVER_INDEX_NONE) {
+		if (*link == index) {
+			*link = observer->next;
+			return;
+		}
+
+		link = &observers[*link].next;
+	}
+}
+
+/**@brief Compare the remote of an observer against an address. */
+static bool observer_remote_compare(const internal_coap_observer_t *observer,
+				    const struct sockaddr *observer_addr)
+{
+	const struct sockaddr *remote = (struct sockaddr *)&observer->remote;
+	const struct sockaddr_in6 *remote6 =
+				(struct sockaddr_in6 *)&observer->remote;
+	const struct sockaddr_in *remote4 =
+				(struct sockaddr_in *)&observer->remote;
+
+	const struct sockaddr_in6 *observer_addr6 =
+				(struct sockaddr_in6 *)observer_addr;
+	const struct sockaddr_in *observer_addr4 =
+				(struct sockaddr_in *)observer_addr;
+
+	if ((remote->sa_family         == AF_INET6) &&
+	    (observer_addr->sa_family  == AF_INET6) &&
+	    (observer_addr6->sin6_port == remote6->sin6_port)) {
+		return memcmp(observer_addr6->sin6_addr.s6_addr,
+			      remote6->sin6_addr.s6_addr,
+			      sizeof(struct in6_addr)) == 0;
+	}
+
+	if ((remote->sa_family        == AF_INET) &&
+	    (observer_addr->sa_family == AF_INET) &&
+	    (observer_addr4->sin_port == remote4->sin_port)) {
+		return memcmp(&observer_addr4->sin_addr, &remote4->sin_addr,
+			      sizeof(struct in_addr)) == 0;
+	}
+
+	return false;
+}
+
 u32_t internal_coap_observe_server_register(u32_t *handle,
 					    coap_observer_t *observer)
 {
@@ -46,13 +159,17 @@ u32_t internal_coap_observe_server_register(u32_t *handle,
 		return EINVAL;
 	}
 
+	if (observer->token_len > NOTIFICATION_TOKEN_MAX_LEN) {
+		return EINVAL;
+	}
+
 	COAP_ENTRY();
 
 	/* Check if there is already a registered observer in the list to be
 	 * reused.
 	 */
 	u32_t i;
-	u32_t err_code = coap_observe_server_search(
+	u32_t err_code = internal_coap_observe_server_search(
 			&i, observer->remote, observer->resource_of_interest);
 
 
@@ -82,6 +199,14 @@ u32_t internal_coap_observe_server_register(u32_t *handle,
 			}
 			observers[i].observer.remote =
 					(struct sockaddr *)&observers[i].remote;
+
+			/* Spread the CON notifications of the observers over
+			 * consecutive notifications.
+			 */
+			observers[i].non_count = i % COAP_OBSERVE_CON_INTERVAL;
+			observers[i].con_pending = false;
+
+			observer_link(i);
 			*handle = i;
 
 			COAP_EXIT();
@@ -108,7 +233,10 @@ u32_t internal_coap_observe_server_unregister(u32_t handle)
 		ret = ENOENT;
 	} else {
 		/* Unregister successfully. */
+		observer_unlink(handle);
 		observers[handle].observer.resource_of_interest = NULL;
+		observers[handle].con_pending = false;
+		observers[handle].generation++;
 	}
 
 	COAP_EXIT();
@@ -124,41 +252,13 @@ u32_t internal_coap_observe_server_search(u32_t *handle,
 	NULL_PARAM_CHECK(observer_addr);
 	NULL_PARAM_CHECK(resource);
 
-	for (u32_t i = 0; i < COAP_OBSERVE_MAX_NUM_OBSERVERS; i++) {
-		if (observers[i].observer.resource_of_interest == resource) {
-			const struct sockaddr *remote =
-				(struct sockaddr *)&observers[i].remote;
-			const struct sockaddr_in6 *remote6 =
-				(struct sockaddr_in6 *)&observers[i].remote;
-			const struct sockaddr_in *remote4 =
-				(struct sockaddr_in *)&observers[i].remote;
-
-			const struct sockaddr_in6 *observer_addr6 =
-					(struct sockaddr_in6 *)observer_addr;
-			const struct sockaddr_in *observer_addr4 =
-					(struct sockaddr_in *)observer_addr;
-
-			if ((remote->sa_family         == AF_INET6) &&
-			    (observer_addr->sa_family  == AF_INET6) &&
-			    (observer_addr6->sin6_port == remote6->sin6_port)) {
-				if (memcmp(observer_addr6->sin6_addr.s6_addr,
-					   remote6->sin6_addr.s6_addr,
-					   sizeof(struct in6_addr)) == 0) {
-					*handle = i;
-					return 0;
-				}
-			}
+	u16_t i = buckets[bucket_get(resource)];
 
-			if ((remote->sa_family        == AF_INET) &&
-			    (observer_addr->sa_family == AF_INET) &&
-			    (observer_addr4->sin_port == remote4->sin_port)) {
-				if (memcmp(&observer_addr4->sin_addr,
-					   &remote4->sin_addr,
-					   sizeof(struct in_addr)) == 0) {
-					*handle = i;
-					return 0;
-				}
-			}
+	for (; i != OBSERVER_INDEX_NONE; i = observers[i].next) {
+		if ((observers[i].observer.resource_of_interest == resource) &&
+		    observer_remote_compare(&observers[i], observer_addr)) {
+			*handle = i;
+			return 0;
 		}
 	}
 
@@ -173,26 +273,18 @@ u32_t internal_coap_observe_server_next_get(coap_observer_t **observer,
 	NULL_PARAM_CHECK(resource);
 	NULL_PARAM_CHECK(observer);
 
+	u16_t i;
+
 	if (start == NULL) {
-		for (u32_t i = 0; i < COAP_OBSERVE_MAX_NUM_OBSERVERS; i++) {
-			if (observers[i].observer.resource_of_interest ==
-								resource) {
-				(*observer) = &observers[i].observer;
-				return 0;
-			}
-		}
+		i = buckets[bucket_get(resource)];
 	} else {
-		u32_t index_to_previous =
-				(u8_t)(((u32_t)start - (u32_t)observers) /
-				(u32_t)sizeof(internal_coap_observer_t));
+		i = ((internal_coap_observer_t *)start)->next;
+	}
 
-		for (u32_t i = index_to_previous + 1;
-		     i < COAP_OBSERVE_MAX_NUM_OBSERVERS; i++) {
-			if (observers[i].observer.resource_of_interest ==
-								resource) {
-				(*observer) = &observers[i].observer;
-				return 0;
-			}
+	for (; i != OBSERVER_INDEX_NONE; i = observers[i].next) {
+		if (observers[i].observer.resource_of_interest == resource) {
+			(*observer) = &observers[i].observer;
+			return 0;
 		}
 	}
 
@@ -216,6 +308,235 @@ u32_t internal_coap_observe_server_get(u32_t handle, coap_observer_t **observer)
 	*observer = &observers[handle].observer;
 	return 0;
 }
+
+/**@brief Reference to an observer passed with its CON notification. */
+static inline void *notification_arg_get(u16_t index)
+{
+	return UINT_TO_POINTER(((u32_t)observers[index].generation << 16) |
+			       index);
+}
+
+/**@brief Handle the acknowledgment, reset or timeout of a CON notification.
+ */
+static void notification_response_handle(u32_t status, void *arg,
+					 coap_message_t *response)
+{
+	u32_t ref = POINTER_TO_UINT(arg);
+	u16_t index = ref & 0xFFFF;
+	internal_coap_observer_t *observer = &observers[index];
+
+	/* The observer was unregistered since the notification was sent, the
+	 * slot may hold another observer now.
+	 */
+	if ((observer->observer.resource_of_interest == NULL) ||
+	    (observer->generation != (u16_t)(ref >> 16))) {
+		return;
+	}
+
+	observer->con_pending = false;
+
+	/* The observer rejected the notification, or is gone. */
+	if (status != 0) {
+		(void)internal_coap_observe_server_unregister(index);
+	}
+}
+
+/**@brief Select the message type of the next notification to an observer.
+ *
+ * @details Every COAP_OBSERVE_CON_INTERVAL notification is sent as CON to
+ *          verify that the observer is still interested, with at most one CON
+ *          notification waiting for acknowledgment per observer.
+ */
+static coap_msg_type_t notification_type_get(internal_coap_observer_t *observer,
+					     coap_msg_type_t type)
+{
+	if (observer->con_pending) {
+		return COAP_TYPE_NON;
+	}
+
+	if ((type == COAP_TYPE_CON) ||
+	    (observer->non_count + 1 >= COAP_OBSERVE_CON_INTERVAL)) {
+		return COAP_TYPE_CON;
+	}
+
+	return COAP_TYPE_NON;
+}
+
+/**@brief Encode the part of a notification shared between all observers.
+ *
+ * @details The notification is encoded without token after the room reserved
+ *          for the header and largest token in notification_mem.
+ *
+ * @param[in]  resource    Resource to notify about.
+ * @param[in]  ct          Content format of the payload.
+ * @param[in]  payload     Payload of the notification.
+ * @param[in]  payload_len Length of the payload.
+ * @param[out] body_len    Length of the options and payload.
+ *
+ * @retval 0        If the notification was encoded.
+ * @retval EMSGSIZE If the notification does not fit in notification_mem.
+ */
+static u32_t notification_encode(coap_resource_t *resource,
+				 coap_content_type_t ct, const u8_t *payload,
+				 u16_t payload_len, u16_t *body_len)
+{
+	coap_message_t message;
+	u8_t option_data[12];
+
+	memset(&message, 0, sizeof(coap_message_t));
+	message.header.version = COAP_VERSION;
+	message.header.code = COAP_CODE_205_CONTENT;
+	message.data = option_data;
+	message.data_len = sizeof(option_data);
+
+	/* Options are added in increasing option number order. */
+	u32_t err_code = coap_message_opt_uint_add(&message, COAP_OPT_OBSERVE,
+						   observe_sequence);
+
+	if (err_code == 0) {
+		err_code = coap_message_opt_uint_add(
+					&message, COAP_OPT_CONTENT_FORMAT, ct);
+	}
+
+	if (err_code == 0) {
+		err_code = coap_message_opt_uint_add(&message, COAP_OPT_MAX_AGE,
+						     resource->max_age);
+	}
+
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	/* The payload is encoded straight from the caller's buffer. */
+	message.payload = (u8_t *)payload;
+	message.payload_len = payload_len;
+
+	u16_t length = 0;
+
+	err_code = coap_message_encode(&message, NULL, &length);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	if (length > sizeof(notification_mem) - NOTIFICATION_TOKEN_MAX_LEN) {
+		return EMSGSIZE;
+	}
+
+	err_code = coap_message_encode(
+			&message, &notification_mem[NOTIFICATION_TOKEN_MAX_LEN],
+			&length);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	*body_len = length - NOTIFICATION_HEADER_LEN;
+
+	return 0;
+}
+
+u32_t internal_coap_observe_notify(coap_resource_t *resource,
+				   coap_msg_type_t type,
+				   coap_content_type_t ct,
+				   const u8_t *payload, u16_t payload_len)
+{
+	NULL_PARAM_CHECK(resource);
+
+	if ((payload == NULL) && (payload_len > 0)) {
+		return EINVAL;
+	}
+
+	COAP_ENTRY();
+
+	/* The Observe option only needs to increase between notifications of
+	 * the same resource, one sequence shared by all resources does that.
+	 */
+	observe_sequence = (observe_sequence + 1) & 0xFFFFFF;
+
+	u16_t body_len;
+	u32_t err_code = notification_encode(resource, ct, payload,
+					     payload_len, &body_len);
+
+	if (err_code != 0) {
+		COAP_EXIT();
+		return err_code;
+	}
+
+	coap_message_t message;
+
+	memset(&message, 0, sizeof(coap_message_t));
+	message.header.version = COAP_VERSION;
+	message.header.code = COAP_CODE_205_CONTENT;
+
+	u32_t result = ENOENT;
+	u16_t i = buckets[bucket_get(resource)];
+
+	for (; i != OBSERVER_INDEX_NONE; i = observers[i].next) {
+		internal_coap_observer_t *observer = &observers[i];
+
+		if ((observer->observer.resource_of_interest != resource) ||
+		    (observer->observer.ct != ct)) {
+			continue;
+		}
+
+		/* Only the header and token differ between observers. They
+		 * are written right in front of the shared options and
+		 * payload.
+		 */
+		u8_t token_len = observer->observer.token_len;
+		u8_t *header = &notification_mem[NOTIFICATION_TOKEN_MAX_LEN -
+						 token_len];
+
+		message.header.type = notification_type_get(observer, type);
+		message.header.id = internal_coap_message_id_get();
+		message.header.token_len = token_len;
+		memcpy(message.token, observer->observer.token, token_len);
+		message.remote = observer->observer.remote;
+		message.transport = observer->observer.transport;
+
+		if (message.header.type == COAP_TYPE_CON) {
+			message.response_callback =
+					notification_response_handle;
+			message.arg = notification_arg_get(i);
+		} else {
+			message.response_callback = NULL;
+			message.arg = NULL;
+		}
+
+		header[0] = (COAP_VERSION << 6) |
+			    ((message.header.type & 0x03) << 4) | token_len;
+		header[1] = message.header.code;
+		header[2] = (u8_t)(message.header.id >> 8);
+		header[3] = (u8_t)(message.header.id);
+		memcpy(&header[NOTIFICATION_HEADER_LEN], message.token,
+		       token_len);
+
+		u32_t handle;
+
+		err_code = internal_coap_encoded_message_send(
+				&handle, &message, header,
+				NOTIFICATION_HEADER_LEN + token_len + body_len);
+		if (err_code != 0) {
+			COAP_TRC("Notification error = 0x%08lX!",
+				 (unsigned long)err_code);
+			result = err_code;
+			continue;
+		}
+
+		if (message.header.type == COAP_TYPE_CON) {
+			observer->con_pending = true;
+			observer->non_count = 0;
+		} else if (observer->non_count < UINT8_MAX) {
+			observer->non_count++;
+		}
+
+		if (result == ENOENT) {
+			result = 0;
+		}
+	}
+
+	COAP_EXIT();
+	return result;
+}
 #else
 #define observe_server_init(...)
 #endif
@@ -666,6 +987,20 @@ u32_t coap_observe_server_get(u32_t handle, coap_observer_t **observer)
 	return err_code;
 }
 
+u32_t coap_observe_notify(coap_resource_t *resource, coap_msg_type_t type,
+			  coap_content_type_t ct, const u8_t *payload,
+			  u16_t payload_len)
+{
+	COAP_MUTEX_LOCK();
+
+	u32_t err_code = internal_coap_observe_notify(resource, type, ct,
+						      payload, payload_len);
+
+	COAP_MUTEX_UNLOCK();
+
+	return err_code;
+}
+
 #endif /* COAP_ENABLE_OBSERVE_SERVER = 1 */
 
 #if (COAP_ENABLE_OBSERVE_CLIENT == 1)
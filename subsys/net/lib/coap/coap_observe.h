@@ -115,6 +115,15 @@ u32_t internal_coap_observe_server_get(u32_t handle,
 u32_t internal_coap_observe_client_register(u32_t *handle,
 					    coap_observable_t *observable);
 
+/**@brief Send a notification to all observers of a resource.
+ *
+ * @details See \ref coap_observe_notify.
+ */
+u32_t internal_coap_observe_notify(coap_resource_t *resource,
+				   coap_msg_type_t type,
+				   coap_content_type_t ct,
+				   const u8_t *payload, u16_t payload_len);
+
 /**@brief Unregister an observable resource.
  *
  * @details Unregister the observable resource and clear the memory used by
@@ -14,16 +14,165 @@ LOG_MODULE_REGISTER(coap_queue);
 #include "coap.h"
 #include "coap_queue.h"
 
+/** Marks the end of a hash bucket chain and a free item. */
+#define QUEUE_INDEX_NONE 0xFFFF
+
+/** Initial value of the tick counter. The counter wraps 300 ticks after the
+ *  initialization, so deadlines across the wrap are exercised by every run
+ *  rather than never in practice.
+ */
+#define QUEUE_TICK_START ((u32_t)-300)
+
+/** Number of hash buckets in the message ID and token indexes. */
+#define QUEUE_BUCKET_COUNT COAP_MESSAGE_QUEUE_SIZE
+
+BUILD_ASSERT_MSG(COAP_MESSAGE_QUEUE_SIZE < QUEUE_INDEX_NONE,
+		 "CoAP message queue too large");
+
 static coap_queue_item_t queue[COAP_MESSAGE_QUEUE_SIZE];
-static u8_t message_queue_count;
+static u16_t message_queue_count;
+
+/** Item indexes chained in the hash buckets. */
+static u16_t mid_bucket[QUEUE_BUCKET_COUNT];
+static u16_t mid_next[COAP_MESSAGE_QUEUE_SIZE];
+static u16_t token_bucket[QUEUE_BUCKET_COUNT];
+static u16_t token_next[COAP_MESSAGE_QUEUE_SIZE];
+
+/** Binary min-heap of item indexes ordered by the item deadline. */
+static u16_t heap[COAP_MESSAGE_QUEUE_SIZE];
+static u16_t heap_position[COAP_MESSAGE_QUEUE_SIZE];
+static u32_t deadline[COAP_MESSAGE_QUEUE_SIZE];
+
+/** Tick counter, advanced by one on every time tick. */
+static u32_t now;
+
+static u16_t mid_hash(u16_t mid)
+{
+	return mid % QUEUE_BUCKET_COUNT;
+}
+
+static u16_t token_hash(const u8_t *token, u8_t token_len)
+{
+	/* FNV-1a */
+	u32_t hash = 2166136261U;
+
+	for (u8_t i = 0; i < token_len; i++) {
+		hash = (hash ^ token[i]) * 16777619U;
+	}
+
+	return hash % QUEUE_BUCKET_COUNT;
+}
+
+static void bucket_insert(u16_t *bucket, u16_t *next, u16_t index)
+{
+	next[index] = *bucket;
+	*bucket = index;
+}
+
+static void bucket_remove(u16_t *bucket, u16_t *next, u16_t index)
+{
+	u16_t *link = bucket;
+
+	while (*link != QUEUE_INDEX_NONE) {
+		if (*link == index) {
+			*link = next[index];
+			return;
+		}
+
+		link = &next[*link];
+	}
+}
+
+/** Deadline comparison which handles wrapping of the tick counter. */
+static bool deadline_before(u32_t a, u32_t b)
+{
+	return (s32_t)(a - b) < 0;
+}
+
+static void heap_set(u16_t position, u16_t index)
+{
+	heap[position] = index;
+	heap_position[index] = position;
+}
+
+static void heap_up(u16_t position)
+{
+	u16_t index = heap[position];
+
+	while (position > 0) {
+		u16_t parent = (position - 1) / 2;
+
+		if (!deadline_before(deadline[index],
+				     deadline[heap[parent]])) {
+			break;
+		}
+
+		heap_set(position, heap[parent]);
+		position = parent;
+	}
+
+	heap_set(position, index);
+}
+
+static void heap_down(u16_t position)
+{
+	u16_t index = heap[position];
+
+	for (;;) {
+		u32_t child = 2 * (u32_t)position + 1;
+
+		if (child >= message_queue_count) {
+			break;
+		}
+
+		if ((child + 1 < message_queue_count) &&
+		    deadline_before(deadline[heap[child + 1]],
+				    deadline[heap[child]])) {
+			child++;
+		}
+
+		if (!deadline_before(deadline[heap[child]], deadline[index])) {
+			break;
+		}
+
+		heap_set(position, heap[child]);
+		position = child;
+	}
+
+	heap_set(position, index);
+}
+
+/** Restores the heap order after the deadline of the item changed. */
+static void heap_update(u16_t position)
+{
+	u16_t index = heap[position];
+
+	heap_up(position);
+	heap_down(heap_position[index]);
+}
+
+static void deadline_set(u16_t index, u16_t timeout)
+{
+	/* Same as counting the timeout down to zero on every tick and
+	 * expiring on the following one.
+	 */
+	deadline[index] = now + timeout + 1;
+}
 
 u32_t coap_queue_init(void)
 {
-	for (u8_t i = 0; i < COAP_MESSAGE_QUEUE_SIZE; i++) {
+	for (u16_t i = 0; i < COAP_MESSAGE_QUEUE_SIZE; i++) {
 		memset(&queue[i], 0, sizeof(coap_queue_item_t));
 		queue[i].handle = i;
 	}
+
+	for (u16_t i = 0; i < QUEUE_BUCKET_COUNT; i++) {
+		mid_bucket[i] = QUEUE_INDEX_NONE;
+		token_bucket[i] = QUEUE_INDEX_NONE;
+	}
+
 	message_queue_count = 0;
+	now = QUEUE_TICK_START;
 
 	return 0;
 }
@@ -36,11 +185,26 @@ u32_t coap_queue_add(coap_queue_item_t *item)
 		return ENOMEM;
 	}
 
-	for (u8_t i = 0; i < COAP_MESSAGE_QUEUE_SIZE; i++) {
+	for (u16_t i = 0; i < COAP_MESSAGE_QUEUE_SIZE; i++) {
 		if (queue[i].buffer == NULL) {
 			/* Free spot in message queue. Add message here... */
+			item->handle = i;
 			memcpy(&queue[i], item, sizeof(coap_queue_item_t));
+
+			bucket_insert(&mid_bucket[mid_hash(item->mid)],
+				      mid_next, i);
+
+			if (item->token_len != 0) {
+				bucket_insert(&token_bucket[token_hash(
+							item->token,
+							item->token_len)],
+					      token_next, i);
+			}
+
+			deadline_set(i, item->timeout);
+			heap_set(message_queue_count, i);
 			message_queue_count++;
+			heap_up(message_queue_count - 1);
 
 			return 0;
 		}
@@ -51,28 +215,52 @@ u32_t coap_queue_add(coap_queue_item_t *item)
 
 u32_t coap_queue_remove(coap_queue_item_t *item)
 {
-	for (u8_t i = 0; i < COAP_MESSAGE_QUEUE_SIZE; i++) {
-		if (item == (coap_queue_item_t *)&queue[i]) {
-			memset(&queue[i], 0, sizeof(coap_queue_item_t));
-			message_queue_count--;
-			return 0;
-		}
+	NULL_PARAM_CHECK(item);
+
+	if ((item < queue) || (item >= queue + COAP_MESSAGE_QUEUE_SIZE) ||
+	    (item->buffer == NULL)) {
+		return ENOENT;
 	}
 
-	return ENOENT;
+	u16_t index = item - queue;
+	u16_t position = heap_position[index];
+
+	bucket_remove(&mid_bucket[mid_hash(item->mid)], mid_next, index);
+
+	if (item->token_len != 0) {
+		bucket_remove(&token_bucket[token_hash(item->token,
+						       item->token_len)],
+			      token_next, index);
+	}
+
+	/* Move the last heap entry in place of the removed one. */
+	message_queue_count--;
+	if (position < message_queue_count) {
+		heap_set(position, heap[message_queue_count]);
+		heap_update(position);
+	}
+
+	memset(item, 0, sizeof(coap_queue_item_t));
+	item->handle = index;
+
+	return 0;
 }
 
 u32_t coap_queue_item_by_token_get(coap_queue_item_t **item, u8_t *token,
 				   u8_t token_len)
 {
-	for (u8_t i = 0; i < COAP_MESSAGE_QUEUE_SIZE; i++) {
-		if (queue[i].token_len == token_len) {
-			if ((queue[i].token_len != 0) &&
-			    (memcmp(queue[i].token, token,
-				    queue[i].token_len) == 0)) {
-				*item = &queue[i];
-				return 0;
-			}
+	NULL_PARAM_CHECK(item);
+
+	if (token_len == 0) {
+		return ENOENT;
+	}
+
+	for (u16_t i = token_bucket[token_hash(token, token_len)];
+	     i != QUEUE_INDEX_NONE; i = token_next[i]) {
+		if ((queue[i].token_len == token_len) &&
+		    (memcmp(queue[i].token, token, token_len) == 0)) {
+			*item = &queue[i];
+			return 0;
 		}
 	}
 
@@ -81,9 +269,10 @@ u32_t coap_queue_item_by_token_get(coap_queue_item_t **item, u8_t *token,
 
 u32_t coap_queue_item_by_mid_get(coap_queue_item_t **item, u16_t message_id)
 {
+	NULL_PARAM_CHECK(item);
 
-
-	for (u8_t i = 0; i < COAP_MESSAGE_QUEUE_SIZE; i++) {
+	for (u16_t i = mid_bucket[mid_hash(message_id)];
+	     i != QUEUE_INDEX_NONE; i = mid_next[i]) {
 		if (queue[i].mid == message_id) {
 			*item = &queue[i];
 			return 0;
@@ -93,29 +282,71 @@ u32_t coap_queue_item_by_mid_get(coap_queue_item_t **item, u16_t message_id)
 	return ENOENT;
 }
 
-u32_t coap_queue_item_next_get(coap_queue_item_t **item,
-			       coap_queue_item_t *start)
+u32_t coap_queue_item_by_transport_get(coap_queue_item_t **item,
+				       coap_transport_handle_t transport)
 {
-	if (start == NULL) {
-		for (u8_t i = 0; i < COAP_MESSAGE_QUEUE_SIZE; i++) {
-			if (queue[i].buffer != NULL) {
-				(*item) = &queue[i];
-				return 0;
-			}
-		}
-	} else {
-		u8_t index_to_previous = (u8_t)(((u32_t)start - (u32_t)queue) /
-					 (u32_t)sizeof(coap_queue_item_t));
-
-		for (u8_t i = index_to_previous + 1;
-		     i < COAP_MESSAGE_QUEUE_SIZE; i++) {
-			if (queue[i].buffer != NULL) {
-				(*item) = &queue[i];
-				return 0;
-			}
+	NULL_PARAM_CHECK(item);
+
+	/* Only used when a transport is closed, so not indexed. */
+	for (u16_t i = 0; i < message_queue_count; i++) {
+		if (queue[heap[i]].transport == transport) {
+			*item = &queue[heap[i]];
+			return 0;
 		}
 	}
-	(*item) = NULL;
 
 	return ENOENT;
 }
+
+u32_t coap_queue_item_timeout_restart(coap_queue_item_t *item)
+{
+	NULL_PARAM_CHECK(item);
+
+	if ((item < queue) || (item >= queue + COAP_MESSAGE_QUEUE_SIZE) ||
+	    (item->buffer == NULL)) {
+		return ENOENT;
+	}
+
+	u16_t index = item - queue;
+
+	deadline_set(index, item->timeout);
+	heap_update(heap_position[index]);
+
+	return 0;
+}
+
+void coap_queue_time_tick(void)
+{
+	now++;
+}
+
+u32_t coap_queue_item_expired_get(coap_queue_item_t **item)
+{
+	NULL_PARAM_CHECK(item);
+
+	if ((message_queue_count == 0) ||
+	    deadline_before(now, deadline[heap[0]])) {
+		return ENOENT;
+	}
+
+	*item = &queue[heap[0]];
+
+	return 0;
+}
+
+u32_t coap_queue_next_deadline_get(u32_t *ticks)
+{
+	NULL_PARAM_CHECK(ticks);
+
+	if (message_queue_count == 0) {
+		return ENOENT;
+	}
+
+	if (deadline_before(now, deadline[heap[0]])) {
+		*ticks = deadline[heap[0]] - now;
+	} else {
+		*ticks = 0;
+	}
+
+	return 0;
+}
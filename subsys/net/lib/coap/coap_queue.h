@@ -46,7 +46,9 @@ typedef struct {
 	/** Re-transmission attempt count. */
 	u8_t retrans_count;
 
-	/** Time until new re-transmission attempt. */
+	/** Time ticks until new re-transmission attempt. Used when the item
+	 *  is added and when its timeout is restarted.
+	 */
 	u16_t timeout;
 
 	/** Last timeout value used. */
@@ -80,8 +82,9 @@ u32_t coap_queue_init(void);
 
 /**@brief Add item to the queue.
  *
- * @param[in] item Pointer to an item which to add to the queue. The function
- *                 will copy all data provided.
+ * @param[inout] item Pointer to an item which to add to the queue. The
+ *                    function will copy all data provided, and set the handle
+ *                    of the item.
  *
  * @retval 0       If adding the item was successful.
  * @retval ENOMEM  If max number of queued elements has been reached. This is
@@ -131,19 +134,59 @@ u32_t coap_queue_item_by_token_get(coap_queue_item_t **item, u8_t *token,
  */
 u32_t coap_queue_item_by_mid_get(coap_queue_item_t **item, u16_t message_id);
 
-/**@brief Iterate through items.
+/**@brief Search for item by transport.
  *
- * @param[out] item  Pointer to be filled by the search function upon finding
- *                   the next queued item starting from the item pointer
- *                   provided. Should not be NULL.
- * @param[in]  start Pointer to the item where to start the search.
+ * @param[out] item      Pointer to be filled by the function if item sent on
+ *                       the transport has been found. Should not be NULL.
+ * @param[in]  transport Transport to be matched.
  *
- * @retval 0      If item was found.
+ * @retval 0      If an item was successfully located.
  * @retval EINVAL If item pointer is NULL.
- * @retval ENOENT If next item was not found.
+ * @retval ENOENT If no item was found.
+ */
+u32_t coap_queue_item_by_transport_get(coap_queue_item_t **item,
+				       coap_transport_handle_t transport);
+
+/**@brief Restart the retransmission timeout of an item.
+ *
+ * @details The item expires after the number of time ticks given by the
+ *          timeout member of the item.
+ *
+ * @param[in] item Pointer to an item in the queue. Should not be NULL.
+ *
+ * @retval 0      If the timeout was restarted.
+ * @retval EINVAL If item pointer is NULL.
+ * @retval ENOENT If the item was not located in the queue.
+ */
+u32_t coap_queue_item_timeout_restart(coap_queue_item_t *item);
+
+/**@brief Advance the queue time by one tick. */
+void coap_queue_time_tick(void);
+
+/**@brief Get the item with the earliest timeout if it has expired.
+ *
+ * @details The item stays expired until it is removed or its timeout is
+ *          restarted.
+ *
+ * @param[out] item Pointer to be filled by the function if an expired item
+ *                  has been found. Should not be NULL.
+ *
+ * @retval 0      If an expired item was found.
+ * @retval EINVAL If item pointer is NULL.
+ * @retval ENOENT If no item has expired.
+ */
+u32_t coap_queue_item_expired_get(coap_queue_item_t **item);
+
+/**@brief Get the number of time ticks until the earliest item expires.
+ *
+ * @param[out] ticks Number of ticks, 0 if an item has already expired.
+ *                   Should not be NULL.
+ *
+ * @retval 0      If the queue is not empty.
+ * @retval EINVAL If ticks pointer is NULL.
+ * @retval ENOENT If the queue is empty.
  */
-u32_t coap_queue_item_next_get(coap_queue_item_t **item,
-			       coap_queue_item_t *start);
+u32_t coap_queue_next_deadline_get(u32_t *ticks);
 
 #ifdef __cplusplus
 }
@@ -8,6 +8,7 @@
 #define LOG_LEVEL CONFIG_NRF_COAP_LOG_LEVEL
 LOG_MODULE_REGISTER(coap_resource);
 
+#include <stdbool.h>
 #include <string.h>
 #include <errno.h>
 
@@ -18,13 +19,151 @@ LOG_MODULE_REGISTER(coap_resource);
 
 #define COAP_RESOURCE_MAX_AGE_INIFINITE  0xFFFFFFFF
 
+/** Index entry which does not point to any entry. */
+#define INDEX_ENTRY_NONE 0xFFFF
+
+/** FNV-1a offset basis, the hash of the root path. */
+#define PATH_HASH_INIT 2166136261U
+
+/**@brief Entry of the index from full path to resource. */
+typedef struct {
+	/** Indexed resource. */
+	coap_resource_t *resource;
+	/** Hash of the full path of the resource. */
+	u32_t hash;
+	/** Entry of the parent resource, INDEX_ENTRY_NONE for the root. */
+	u16_t parent;
+	/** Next entry in the same bucket. */
+	u16_t next;
+} index_entry_t;
+
 static coap_resource_t *root_resource;
 static char scratch_buffer[(COAP_RESOURCE_MAX_NAME_LEN + 1) *
 			   COAP_RESOURCE_MAX_DEPTH + 6];
 
+static index_entry_t index_entries[COAP_RESOURCE_INDEX_SIZE];
+static u16_t index_buckets[COAP_RESOURCE_INDEX_SIZE];
+static u16_t index_count;
+/** Whether all resources of the tree fit in the index. */
+static bool index_complete;
+
+#if (COAP_WELL_KNOWN_CACHE_SIZE > 0)
+/** Last generated .well-known/core string, without terminating zero. */
+static char well_known_cache[COAP_WELL_KNOWN_CACHE_SIZE];
+static u16_t well_known_cache_len;
+static bool well_known_cache_valid;
+#endif
+
+static u32_t path_hash_append(u32_t hash, const u8_t *segment, u16_t length)
+{
+	/* FNV-1a, with a separator so that "a/bc" and "ab/c" differ. */
+	hash = (hash ^ '/') * 16777619U;
+
+	for (u16_t i = 0; i < length; i++) {
+		hash = (hash ^ segment[i]) * 16777619U;
+	}
+
+	return hash;
+}
+
+static void index_add(coap_resource_t *resource, u16_t parent, u32_t hash)
+{
+	if (index_count >= COAP_RESOURCE_INDEX_SIZE) {
+		/* Lookups fall back to walking the tree. */
+		index_complete = false;
+		return;
+	}
+
+	u16_t entry = index_count++;
+	u16_t bucket = hash % COAP_RESOURCE_INDEX_SIZE;
+
+	index_entries[entry].resource = resource;
+	index_entries[entry].hash = hash;
+	index_entries[entry].parent = parent;
+	index_entries[entry].next = index_buckets[bucket];
+	index_buckets[bucket] = entry;
+
+	for (coap_resource_t *child = resource->front; child != NULL;
+	     child = child->sibling) {
+		index_add(child, entry,
+			  path_hash_append(hash, (u8_t *)child->name,
+					   strlen(child->name)));
+	}
+}
+
+/**@brief Rebuild the path index and drop the cached discovery string. */
+static void resource_tree_changed(void)
+{
+	for (u16_t i = 0; i < COAP_RESOURCE_INDEX_SIZE; i++) {
+		index_buckets[i] = INDEX_ENTRY_NONE;
+	}
+
+	index_count = 0;
+	index_complete = true;
+
+	if (root_resource != NULL) {
+		index_add(root_resource, INDEX_ENTRY_NONE, PATH_HASH_INIT);
+	}
+
+#if (COAP_WELL_KNOWN_CACHE_SIZE > 0)
+	well_known_cache_valid = false;
+#endif
+}
+
+static bool name_compare(const coap_resource_t *resource, const u8_t *segment,
+			 u16_t length)
+{
+	return (strlen(resource->name) == length) &&
+	       (memcmp(resource->name, segment, length) == 0);
+}
+
+/**@brief Verify that the path of an index entry matches the URI path. */
+static bool index_path_compare(u16_t entry, u8_t **uri_pointers,
+			       u16_t *uri_lengths, u8_t num_of_uris)
+{
+	/* Walk from the resource up to the root, matching the segments
+	 * backwards.
+	 */
+	for (u8_t i = num_of_uris; i > 0; i--) {
+		if ((entry == INDEX_ENTRY_NONE) ||
+		    !name_compare(index_entries[entry].resource,
+				  uri_pointers[i - 1], uri_lengths[i - 1])) {
+			return false;
+		}
+
+		entry = index_entries[entry].parent;
+	}
+
+	return (entry != INDEX_ENTRY_NONE) &&
+	       (index_entries[entry].parent == INDEX_ENTRY_NONE);
+}
+
+static coap_resource_t *index_lookup(u8_t **uri_pointers, u16_t *uri_lengths,
+				     u8_t num_of_uris)
+{
+	u32_t hash = PATH_HASH_INIT;
+
+	for (u8_t i = 0; i < num_of_uris; i++) {
+		hash = path_hash_append(hash, uri_pointers[i], uri_lengths[i]);
+	}
+
+	u16_t entry = index_buckets[hash % COAP_RESOURCE_INDEX_SIZE];
+
+	for (; entry != INDEX_ENTRY_NONE; entry = index_entries[entry].next) {
+		if ((index_entries[entry].hash == hash) &&
+		    index_path_compare(entry, uri_pointers, uri_lengths,
+				       num_of_uris)) {
+			return index_entries[entry].resource;
+		}
+	}
+
+	return NULL;
+}
+
 u32_t coap_resource_init(void)
 {
 	root_resource = NULL;
+	resource_tree_changed();
 	return 0;
 }
 
@@ -45,6 +184,8 @@ u32_t coap_resource_create(coap_resource_t *resource, const char *name)
 
 	resource->max_age = COAP_RESOURCE_MAX_AGE_INIFINITE;
 
+	resource_tree_changed();
+
 	return 0;
 }
 
@@ -65,6 +206,8 @@ u32_t coap_resource_child_add(coap_resource_t *parent, coap_resource_t *child)
 
 	parent->child_count++;
 
+	resource_tree_changed();
+
 	return 0;
 }
 
@@ -142,17 +285,47 @@ u32_t coap_resource_well_known_generate(u8_t *string, u16_t *length)
 		return ENOENT;
 	}
 
+#if (COAP_WELL_KNOWN_CACHE_SIZE > 0)
+	if (well_known_cache_valid) {
+		/* Room for the string and the zero termination, which
+		 * replaced the last comma.
+		 */
+		if (well_known_cache_len + 1 > *length) {
+			return ENOMEM;
+		}
+
+		memcpy(string, well_known_cache, well_known_cache_len);
+		string[well_known_cache_len] = '\0';
+		*length -= well_known_cache_len + 1;
+
+		return 0;
+	}
+#endif
+
 	memset(string, 0, *length);
 
 	u32_t err_code = generate_path(0, root_resource, NULL, string, length);
 
-	string[strlen((char *)string) - 1] = '\0'; /* remove the last comma */
+	size_t string_len = strlen((char *)string);
+
+	if (string_len > 0) {
+		string_len--;
+		string[string_len] = '\0'; /* remove the last comma */
+	}
+
+#if (COAP_WELL_KNOWN_CACHE_SIZE > 0)
+	if ((err_code == 0) && (string_len <= sizeof(well_known_cache))) {
+		memcpy(well_known_cache, string, string_len);
+		well_known_cache_len = string_len;
+		well_known_cache_valid = true;
+	}
+#endif
 
 	return err_code;
 }
 
 static coap_resource_t *coap_resource_child_resolve(coap_resource_t *parent,
-						    char *path)
+						    u8_t *path, u16_t length)
 {
 	coap_resource_t *result = NULL;
 
@@ -161,10 +334,7 @@ static coap_resource_t *coap_resource_child_resolve(coap_resource_t *parent,
 
 		do {
 			/* Check if the sibling name match. */
-			size_t size = strlen(sibling_in_question->name);
-
-			if (strncmp(sibling_in_question->name,
-				    path, size) == 0) {
+			if (name_compare(sibling_in_question, path, length)) {
 				return sibling_in_question;
 			}
 
@@ -175,7 +345,7 @@ static coap_resource_t *coap_resource_child_resolve(coap_resource_t *parent,
 }
 
 u32_t coap_resource_get(coap_resource_t **resource, u8_t **uri_pointers,
-			u8_t num_of_uris)
+			u16_t *uri_lengths, u8_t num_of_uris)
 {
 	if (root_resource == NULL) {
 		/* Make sure pointer is set to NULL before returning. */
@@ -185,16 +355,22 @@ u32_t coap_resource_get(coap_resource_t **resource, u8_t **uri_pointers,
 
 	coap_resource_t *current_resource = root_resource;
 
-	/* Every node should start at root. */
-	for (u8_t i = 0; i < num_of_uris; i++) {
-		current_resource = coap_resource_child_resolve(
-				current_resource, (char *)uri_pointers[i]);
-
-		if (current_resource == NULL) {
-			/* Stop looping as this direction will not give anything
-			 * more.
-			 */
-			break;
+	if (index_complete) {
+		current_resource = index_lookup(uri_pointers, uri_lengths,
+						num_of_uris);
+	} else {
+		/* Every node should start at root. */
+		for (u8_t i = 0; i < num_of_uris; i++) {
+			current_resource = coap_resource_child_resolve(
+				current_resource, uri_pointers[i],
+				uri_lengths[i]);
+
+			if (current_resource == NULL) {
+				/* Stop looping as this direction will not give
+				 * anything more.
+				 */
+				break;
+			}
 		}
 	}
 
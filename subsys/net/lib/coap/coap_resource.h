@@ -34,11 +34,18 @@ extern "C" {
  */
 u32_t coap_resource_init(void);
 
-/**@brief Find a resource by traversing the resource names.
+/**@brief Find a resource by its path.
+ *
+ * @details The resource is looked up in an index from full path to resource,
+ *          which is rebuilt whenever a resource is created or added. If the
+ *          tree holds more than CONFIG_NRF_COAP_RESOURCE_INDEX_SIZE resources,
+ *          the resource names are traversed instead.
  *
  * @param[out] resource     Located resource.
  * @param[in]  uri_pointers Array of strings which forms the hierarchical path
- *                          to the resource.
+ *                          to the resource. The strings need not be zero
+ *                          terminated.
+ * @param[in]  uri_lengths  Array of the lengths of the strings.
  * @param[in]  num_of_uris  Number of URIs supplied through the path pointer
  *                          list.
  *
@@ -47,7 +54,7 @@ u32_t coap_resource_init(void);
  *                registered.
  */
 u32_t coap_resource_get(coap_resource_t **resource, u8_t **uri_pointers,
-			u8_t num_of_uris);
+			u16_t *uri_lengths, u8_t num_of_uris);
 
 /**@brief Process the request related to the resource.
  *
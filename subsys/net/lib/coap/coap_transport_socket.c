@@ -34,6 +34,50 @@ typedef struct {
 	struct sockaddr_in6 local;
 } transport_t;
 
+/**@brief Port configuration, kept to open the port again after an error. */
+typedef struct {
+	/** Port information as given at initialization, with the address
+	 *  pointing to the copy below.
+	 */
+	coap_local_t local;
+
+	/** Copy of the local address and port. */
+	struct sockaddr_in6 addr;
+} port_config_t;
+
+/** Session index which does not point to any session. */
+#define SESSION_INDEX_NONE 0xFFFF
+
+/** Maximum number of security tags stored for a session. */
+#define SESSION_SEC_TAG_MAX 4
+
+/** Maximum length of the peer hostname stored for a session. */
+#define SESSION_HOSTNAME_MAX_LEN 64
+
+/**@brief Security settings a session was set up with. */
+typedef struct {
+	/** Settings fit in this structure, the session may be resumed. */
+	bool stored;
+
+	/** DTLS role. */
+	int role;
+
+	/** Preference for peer verification. */
+	int peer_verify;
+
+	/** Number of entries in the sec tag list. */
+	u32_t sec_tag_count;
+
+	/** Security tags used for the session. */
+	sec_tag_t sec_tag_list[SESSION_SEC_TAG_MAX];
+
+	/** Peer hostname was given for certificate verification. */
+	bool hostname_set;
+
+	/** Peer hostname for certificate verification. */
+	char hostname[SESSION_HOSTNAME_MAX_LEN + 1];
+} session_security_t;
+
 /**@brief Session information. */
 typedef struct {
 	/** Remote endpoint - address and port. Provision for maximum size. */
@@ -41,6 +85,20 @@ typedef struct {
 
 	transport_t *local;
 	/** Local endpoint associated with the session. */
+
+	/** Uptime in milliseconds when the session was last set up or
+	 *  released.
+	 */
+	s64_t last_used;
+
+	/** Next session in the same bucket. */
+	u16_t next;
+
+	/** Released by the application, and kept for reuse. */
+	bool cached;
+
+	/** Security settings, a session is only reused with the same. */
+	session_security_t security;
 } session_t;
 
 /** Table maintaining association between CoAP local ports and corresponding
@@ -48,11 +106,17 @@ typedef struct {
  */
 static transport_t port_table[COAP_SOCKET_COUNT];
 
+/** Configuration of the CoAP local ports, set once they are initialized. */
+static port_config_t port_config[COAP_PORT_COUNT];
+
 #if (COAP_SESSION_COUNT > 0)
 /** Table maintaining association between CoAP remote and end point used for
  *  a session.
  */
 static session_t session_table[COAP_SESSION_COUNT];
+
+/** First session in each bucket, sessions are hashed by their endpoints. */
+static u16_t session_buckets[COAP_SESSION_COUNT];
 #endif /* COAP_SESSION_COUNT */
 
 /**@brief Internal method to get address length based on the address family.
@@ -120,6 +184,87 @@ static bool address_compare(struct sockaddr const *addr1,
 #endif /* (COAP_SESSION_COUNT > 0) */
 
 #if (COAP_SESSION_COUNT > 0)
+/**@brief Internal method to hash the endpoints of a session.
+ *
+ * @note The internal method relies on the calling function to have done
+ *       necessary parameter validation before calling this method.
+ *
+ * @param local  Identifies the local endpoint.
+ * @param remote Identifies the remote endpoint.
+ *
+ * @retval Bucket of the session in session_buckets.
+ */
+static u16_t session_hash(const struct sockaddr *local,
+			  const struct sockaddr *remote)
+{
+	const struct sockaddr_in *remote4 = (struct sockaddr_in *)remote;
+	const struct sockaddr_in6 *remote6 = (struct sockaddr_in6 *)remote;
+	const u8_t *bytes;
+	size_t length;
+	u16_t local_port;
+
+	if (remote->sa_family == AF_INET) {
+		bytes = (const u8_t *)&remote4->sin_addr;
+		length = sizeof(struct in_addr);
+	} else {
+		bytes = (const u8_t *)&remote6->sin6_addr;
+		length = sizeof(struct in6_addr);
+	}
+
+	if (local->sa_family == AF_INET) {
+		local_port = ((struct sockaddr_in *)local)->sin_port;
+	} else {
+		local_port = ((struct sockaddr_in6 *)local)->sin6_port;
+	}
+
+	/* FNV-1a over the remote address, and both ports. The ports are at
+	 * the same offset for both families.
+	 */
+	u32_t hash = 2166136261U;
+	u16_t ports[2] = { remote4->sin_port, local_port };
+
+	for (size_t i = 0; i < length; i++) {
+		hash = (hash ^ bytes[i]) * 16777619U;
+	}
+
+	for (size_t i = 0; i < sizeof(ports); i++) {
+		hash = (hash ^ ((u8_t *)ports)[i]) * 16777619U;
+	}
+
+	return hash % COAP_SESSION_COUNT;
+}
+
+/**@brief Internal method to add a connected session to its bucket. */
+static void session_link(session_t *session)
+{
+	u16_t bucket = session_hash((struct sockaddr *)&session->local->local,
+				    (struct sockaddr *)&session->remote);
+
+	session->next = session_buckets[bucket];
+	session_buckets[bucket] = session - session_table;
+}
+
+/**@brief Internal method to remove a session from its bucket, if it is in
+ *        one.
+ */
+static void session_unlink(session_t *session)
+{
+	u16_t index = session - session_table;
+
+	for (u16_t bucket = 0; bucket < COAP_SESSION_COUNT; bucket++) {
+		u16_t *link = &session_buckets[bucket];
+
+		while (*link != SESSION_INDEX_NONE) {
+			if (*link == index) {
+				*link = session->next;
+				return;
+			}
+
+			link = &session_table[*link].next;
+		}
+	}
+}
+
 /**@brief Internal method to free a session.
  *
  * @note The internal method relies on the calling function to have done
@@ -130,11 +275,145 @@ static bool address_compare(struct sockaddr const *addr1,
  */
 static void session_free(session_t *session)
 {
+	session_unlink(session);
 	close(session->local->socket_fd);
 	memset(session->local, 0, sizeof(transport_t));
+	session->local->socket_fd = -1;
 	memset(session, 0, sizeof(session_t));
 }
 
+/**@brief Internal method to close a session which the application did not
+ *        report an error for.
+ *
+ * @details Messages waiting for a response on the session are failed, so
+ *          that they are not sent on the next session given the same socket
+ *          descriptor.
+ *
+ * @param session Identifies the session being closed.
+ */
+static void session_close(session_t *session)
+{
+	coap_transport_handle_t transport = session->local->socket_fd;
+
+	session_free(session);
+	coap_transport_closed(transport, ECONNABORTED);
+}
+
+/**@brief Internal method to check if a cached session is too old to reuse.
+ *
+ * @param session Identifies the session.
+ *
+ * @retval true if the session was released more than
+ *         COAP_SESSION_CACHE_TIMEOUT seconds ago, else, false.
+ */
+static bool session_expired(const session_t *session)
+{
+	if ((COAP_SESSION_CACHE_TIMEOUT == 0) || !session->cached) {
+		return false;
+	}
+
+	return (k_uptime_get() - session->last_used) >
+	       ((s64_t)COAP_SESSION_CACHE_TIMEOUT * 1000);
+}
+
+/**@brief Internal method to store the security settings of a session.
+ *
+ * @details Settings with more security tags or a longer hostname than can be
+ *          stored are not, and the session is then never reused.
+ *
+ * @param session Identifies the session.
+ * @param setting Security settings the session was set up with.
+ */
+static void session_security_store(session_t *session,
+				   const coap_sec_config_t *setting)
+{
+	session_security_t *security = &session->security;
+
+	memset(security, 0, sizeof(session_security_t));
+
+	if ((setting->sec_tag_count > SESSION_SEC_TAG_MAX) ||
+	    ((setting->hostname != NULL) &&
+	     (strlen(setting->hostname) > SESSION_HOSTNAME_MAX_LEN))) {
+		return;
+	}
+
+	security->role = setting->role;
+	security->peer_verify = setting->peer_verify;
+	security->sec_tag_count = setting->sec_tag_count;
+	memcpy(security->sec_tag_list, setting->sec_tag_list,
+	       setting->sec_tag_count * sizeof(sec_tag_t));
+
+	if (setting->hostname != NULL) {
+		security->hostname_set = true;
+		strcpy(security->hostname, setting->hostname);
+	}
+
+	security->stored = true;
+}
+
+/**@brief Internal method to check if a session was set up with the given
+ *        security settings.
+ *
+ * @param session Identifies the session.
+ * @param setting Security settings requested.
+ *
+ * @retval true if the settings match, else, false.
+ */
+static bool session_security_match(const session_t *session,
+				   const coap_sec_config_t *setting)
+{
+	const session_security_t *security = &session->security;
+
+	if (!security->stored ||
+	    (security->role != setting->role) ||
+	    (security->peer_verify != setting->peer_verify) ||
+	    (security->sec_tag_count != setting->sec_tag_count) ||
+	    (security->hostname_set != (setting->hostname != NULL))) {
+		return false;
+	}
+
+	if (memcmp(security->sec_tag_list, setting->sec_tag_list,
+		   setting->sec_tag_count * sizeof(sec_tag_t)) != 0) {
+		return false;
+	}
+
+	return !security->hostname_set ||
+	       (strcmp(security->hostname, setting->hostname) == 0);
+}
+
+/**@brief Internal method to get a session slot for a new session.
+ *
+ * @details If all slots are in use, the least recently released cached
+ *          session is closed to make room.
+ *
+ * @retval A free session, or NULL if all sessions are in use by the
+ *         application.
+ */
+static session_t *session_slot_get(void)
+{
+	session_t *oldest = NULL;
+
+	for (int index = 0; index < COAP_SESSION_COUNT; index++) {
+		session_t *session = &session_table[index];
+
+		if (session->local == NULL) {
+			return session;
+		}
+
+		if (session->cached &&
+		    ((oldest == NULL) ||
+		     (session->last_used < oldest->last_used))) {
+			oldest = session;
+		}
+	}
+
+	if (oldest != NULL) {
+		session_close(oldest);
+	}
+
+	return oldest;
+}
+
 
 /**@brief Internal method to find a session based on given local and remote
  *        endpoints.
@@ -153,8 +432,9 @@ static session_t *session_find(const struct sockaddr *local,
 			       const struct sockaddr *remote)
 {
 	session_t *session;
+	u16_t index = session_buckets[session_hash(local, remote)];
 
-	for (int index = 0; index < COAP_SESSION_COUNT; index++) {
+	for (; index != SESSION_INDEX_NONE; index = session->next) {
 		session = &session_table[index];
 		if (address_compare(remote,
 				    (struct sockaddr *)&session->remote)) {
@@ -164,9 +444,6 @@ static session_t *session_find(const struct sockaddr *local,
 				local,
 				(struct sockaddr *)&session->local->local))) {
 				/* Session already exists. */
-				/* TODO: we do not compare if the security
-				 * parameters used are the same yet.
-				 */
 				return session;
 			}
 		}
@@ -187,6 +464,11 @@ static session_t *session_find(const struct sockaddr *local,
  */
 static int local_endpoint_find(coap_transport_handle_t handle)
 {
+	if (handle < 0) {
+		/* Free session slots have no socket. */
+		return -1;
+	}
+
 	for (int index = 0; index < COAP_SOCKET_COUNT; index++) {
 		if (port_table[index].socket_fd == handle) {
 			return index;
@@ -290,6 +572,39 @@ static coap_transport_handle_t socket_create_and_bind(u32_t index,
 	return socket_fd;
 }
 
+/**@brief Keeps the configuration of a port, to open it again after an error.
+ *
+ * @param[in] index Index of the port in the port_table.
+ * @param[in] local Port information the port was created with.
+ */
+static void port_config_store(u32_t index, const coap_local_t *local)
+{
+	port_config_t *config = &port_config[index];
+
+	/* The port table of the application may not outlive the call. */
+	config->local = *local;
+	memcpy(&config->addr, local->addr, address_length_get(local->addr));
+	config->local.addr = (struct sockaddr *)&config->addr;
+}
+
+/**@brief Opens a port again on its address after its socket was closed.
+ *
+ * @param[in] index Index of the port in the port_table.
+ *
+ * @retval true if the port is open, else false.
+ */
+static bool port_reopen(u32_t index)
+{
+	port_config_t *config = &port_config[index];
+
+	if (config->local.addr == NULL) {
+		/* The port was never initialized. */
+		return false;
+	}
+
+	return socket_create_and_bind(index, &config->local) != -1;
+}
+
 
 u32_t coap_transport_init(coap_transport_init_t *param)
 {
@@ -300,6 +615,11 @@ u32_t coap_transport_init(coap_transport_init_t *param)
 
 #if (COAP_SESSION_COUNT > 0)
 	memset(session_table, 0, sizeof(session_table));
+
+	for (index = 0; index < COAP_SESSION_COUNT; index++) {
+		session_buckets[index] = SESSION_INDEX_NONE;
+		port_table[COAP_PORT_COUNT + index].socket_fd = -1;
+	}
 #endif /* (COAP_SESSION_COUNT > 0) */
 
 	for (index = 0; index < COAP_PORT_COUNT; index++) {
@@ -315,12 +635,24 @@ u32_t coap_transport_init(coap_transport_init_t *param)
 
 		param->port_table[index].transport =
 				port_table[index].socket_fd;
+
+		port_config_store(index, &param->port_table[index]);
 	}
 
 	return 0;
 }
 
 
+u8_t *coap_transport_tx_buffer_get(u16_t *length)
+{
+	/* Only used between encoding and sending a single message. */
+	static u8_t tx_mem[COAP_MESSAGE_DATA_MAX_SIZE];
+
+	*length = sizeof(tx_mem);
+
+	return tx_mem;
+}
+
 u32_t coap_transport_write(const coap_transport_handle_t transport,
 			   const struct sockaddr *remote, const u8_t *data,
 			   u16_t datalen)
@@ -391,54 +723,75 @@ u32_t coap_security_setup(coap_local_t *local, struct sockaddr const *remote)
 	/* Search if the entry already exists in the port table. */
 	session_t *session = session_find(local->addr, remote);
 
+	if ((session != NULL) &&
+	    !session_security_match(session, local->setting)) {
+		if (!session->cached) {
+			/* Still in use with other security settings. */
+			return EBUSY;
+		}
+
+		/* The session cannot be resumed with these settings. */
+		session_close(session);
+		session = NULL;
+	}
+
+	if ((session != NULL) && session_expired(session)) {
+		/* The peer has likely dropped the session by now. */
+		session_close(session);
+		session = NULL;
+	}
+
 	if (session != NULL) {
+		/* A cached session is resumed without a new handshake. */
+		session->cached = false;
+		session->last_used = k_uptime_get();
 		local->transport = session->local->socket_fd;
 
-		/* Note that we do not validate if the security parameters
-		 * requested match the existing session or not.
-		 * TODO: Do something about this.
-		 */
 		return 0;
 	}
 
 	/* The session does not exist, we create one. */
-	for (int index = 0; index < COAP_SESSION_COUNT; index++) {
-		session = &session_table[index];
+	session = session_slot_get();
 
-		if (session->local == NULL) {
-			coap_transport_handle_t transport;
-
-			/* We have a free slot available.
-			 * Lets create a socket for the session.
-			 * Note that the first COAP_PORT_COUNT are already
-			 * created on init.
-			 * So, we now request an entry at COAP_PORT_COUNT+index.
-			 */
-			const int port_entry = COAP_PORT_COUNT + index;
+	if (session != NULL) {
+		const int index = session - session_table;
 
-			transport = socket_create_and_bind(port_entry, local);
+		coap_transport_handle_t transport;
 
-			if (transport != -1) {
-				session->local = &port_table[port_entry];
+		/* We have a free slot available.
+		 * Lets create a socket for the session.
+		 * Note that the first COAP_PORT_COUNT are already
+		 * created on init.
+		 * So, we now request an entry at COAP_PORT_COUNT+index.
+		 */
+		const int port_entry = COAP_PORT_COUNT + index;
 
-				/* Initiate a connection. */
-				int err = connect(session->local->socket_fd,
-						  remote,
-						  address_length_get(remote));
+		transport = socket_create_and_bind(port_entry, local);
 
-				if (err) {
-					/* Free the allocated session. */
-					session_free(session);
+		if (transport != -1) {
+			session->local = &port_table[port_entry];
 
-					return EIO;
-				}
+			/* Initiate a connection. */
+			int err = connect(session->local->socket_fd,
+					  remote,
+					  address_length_get(remote));
 
-				memcpy(&session->remote, remote,
-				       address_length_get(remote));
-				local->transport = transport;
+			if (err) {
+				/* Free the allocated session. */
+				session_free(session);
 
-				return 0;
+				return EIO;
 			}
+
+			memcpy(&session->remote, remote,
+			       address_length_get(remote));
+			session_security_store(session, local->setting);
+			session->cached = false;
+			session->last_used = k_uptime_get();
+			session_link(session);
+			local->transport = transport;
+
+			return 0;
 		}
 	}
 #endif /* (COAP_SESSION_COUNT > 0) */
@@ -446,6 +799,31 @@ u32_t coap_security_setup(coap_local_t *local, struct sockaddr const *remote)
 }
 
 
+u32_t coap_security_release(coap_transport_handle_t transport)
+{
+#if (COAP_SESSION_COUNT > 0)
+	int index = local_endpoint_find(transport);
+
+	if (index == -1) {
+		return EBADF;
+	}
+
+	if (secure_endpoint_check(index)) {
+		session_t *session = &session_table[index - COAP_PORT_COUNT];
+
+		/* Keep the session for reuse, it is closed when the slot is
+		 * needed or the session has expired.
+		 */
+		session->cached = true;
+		session->last_used = k_uptime_get();
+		return 0;
+	}
+#endif /* (COAP_SESSION_COUNT > 0) */
+
+	return ENOENT;
+}
+
+
 u32_t coap_security_destroy(coap_transport_handle_t transport)
 {
 #if (COAP_SESSION_COUNT > 0)
@@ -459,7 +837,7 @@ u32_t coap_security_destroy(coap_transport_handle_t transport)
 		session_t   *session = &session_table[index - COAP_PORT_COUNT];
 
 		/* Free the session. */
-		session_free(session);
+		session_close(session);
 		return 0;
 	}
 #endif /* (COAP_SESSION_COUNT > 0) */
@@ -468,77 +846,180 @@ u32_t coap_security_destroy(coap_transport_handle_t transport)
 }
 
 
-/* lint --e{14} */
-/*suppress "Symbol 'coap_transport_input(void)' previously defined" (WEAK) */
-void coap_transport_input(void)
+/**@brief Internal method to check if an entry of port_table has a socket.
+ *
+ * @param[in] index Identifies the index of port_table.
+ *
+ * @retval true if the entry is an open port, or a session in use, else false.
+ */
+static bool socket_active_check(u32_t index)
+{
+	/* Closed ports and free session slots have no socket. */
+	return port_table[index].socket_fd != -1;
+}
+
+/**@brief Closes a session, or opens a port again, after its socket reported
+ *        an error.
+ *
+ * @param[in] index    Identifies the index of port_table.
+ * @param[in] err_code Error to report for the transport.
+ */
+static void socket_error_handle(u32_t index, u32_t err_code)
+{
+	coap_transport_handle_t transport = port_table[index].socket_fd;
+
+#if (COAP_SESSION_COUNT > 0)
+	if (secure_endpoint_check(index)) {
+		session_free(&session_table[index - COAP_PORT_COUNT]);
+	} else
+#endif /* (COAP_SESSION_COUNT > 0) */
+	{
+		(void)close(transport);
+		port_table[index].socket_fd = -1;
+
+		/* Usually the same descriptor is given to the new socket.
+		 * If the port cannot be opened now, it stays out of the poll
+		 * set and is retried on the next poll.
+		 */
+		(void)port_reopen(index);
+	}
+
+	coap_transport_error(transport, err_code);
+}
+
+/**@brief Reads the datagrams pending on a socket and passes them to CoAP.
+ *
+ * @details At most COAP_INPUT_BUDGET datagrams are read, so that other
+ *          sockets ready for reading are served as well.
+ *
+ * @param[in] index Identifies the index of port_table.
+ *
+ * @retval Number of datagrams read.
+ */
+static u32_t socket_receive(u32_t index)
 {
 	socklen_t address_length;
 	struct sockaddr_in remote4;
-	struct sockaddr_in remote6;
+	struct sockaddr_in6 remote6;
 	struct sockaddr *remote;
-	struct sockaddr *local;
-	transport_t *port;
+	transport_t *port = &port_table[index];
+	struct sockaddr *local = (struct sockaddr *)&port->local;
+	u32_t count;
 
 	static u8_t read_mem[COAP_MESSAGE_DATA_MAX_SIZE];
 
+	for (count = 0; count < COAP_INPUT_BUDGET; count++) {
+		/* The session might have been destroyed by the application
+		 * while handling the previous datagram.
+		 */
+		if (!socket_active_check(index)) {
+			break;
+		}
+
+		int bytes_read;
+
 #if (COAP_SESSION_COUNT > 0)
-	for (u32_t index = 0; index < COAP_SESSION_COUNT; index++) {
-		const int port_entry = index + COAP_PORT_COUNT;
+		if (secure_endpoint_check(index)) {
+			const session_t *session =
+				&session_table[index - COAP_PORT_COUNT];
+
+			remote = (struct sockaddr *)&session->remote;
+			bytes_read = recv(port->socket_fd, read_mem,
+					  COAP_MESSAGE_DATA_MAX_SIZE,
+					  MSG_DONTWAIT);
+		} else
+#endif /* (COAP_SESSION_COUNT > 0) */
+		{
+			if ((local->sa_family) == AF_INET6) {
+				address_length = sizeof(struct sockaddr_in6);
+				remote = (struct sockaddr *)&remote6;
+			} else {
+				address_length = sizeof(struct sockaddr_in);
+				remote = (struct sockaddr *)&remote4;
+			}
 
-		port = &port_table[port_entry];
+			bytes_read = recvfrom(port->socket_fd, read_mem,
+					      COAP_MESSAGE_DATA_MAX_SIZE,
+					      MSG_DONTWAIT, remote,
+					      &address_length);
+		}
 
-		int bytes_read = recv(port->socket_fd, read_mem,
-				      COAP_MESSAGE_DATA_MAX_SIZE, MSG_DONTWAIT);
+		if (bytes_read < 0) {
+			/* Nothing more to read, or error in recvfrom(). */
+			break;
+		}
 
-		if (bytes_read >= 0) {
-			const session_t *session = &session_table[index];
+		/* Notify the CoAP module of received data. */
+		int retval = coap_transport_read(port->socket_fd, remote, local,
+						 0, read_mem,
+						 (u16_t)bytes_read);
 
-			/* Notify the CoAP module of received data. */
-			int retval = coap_transport_read(
-					port->socket_fd,
-					(struct sockaddr *)&session->remote,
-					(struct sockaddr *)&port->local,
-					0, read_mem, (u16_t)bytes_read);
+		/* Nothing much to do if CoAP could not interpret the
+		 * datagram.
+		 */
+		(void)(retval);
+	}
 
-			/* Nothing much to do if CoAP could not interpret the
-			 * datagram.
-			 */
-			(void)(retval);
+	return count;
+}
+
+u32_t coap_transport_poll(s32_t timeout)
+{
+	struct pollfd fds[COAP_SOCKET_COUNT];
+	u16_t entries[COAP_SOCKET_COUNT];
+	int nfds = 0;
+
+	for (u32_t index = 0; index < COAP_SOCKET_COUNT; index++) {
+		/* Ports closed after an error are retried here. */
+		if (!socket_active_check(index) &&
+		    (secure_endpoint_check(index) || !port_reopen(index))) {
+			continue;
 		}
+
+		fds[nfds].fd = port_table[index].socket_fd;
+		fds[nfds].events = POLLIN;
+		fds[nfds].revents = 0;
+		entries[nfds] = index;
+		nfds++;
 	}
-#endif /* (COAP_SESSION_COUNT > 0) */
 
-	for (u32_t index = 0; index < COAP_PORT_COUNT; index++) {
-		port = &port_table[index];
-		local = (struct sockaddr *)&port->local;
+	if (nfds == 0) {
+		return ENOTCONN;
+	}
 
-		if ((local->sa_family) == AF_INET6) {
-			address_length = sizeof(struct sockaddr_in6);
-			remote = (struct sockaddr *)&remote6;
-		} else {
-			address_length = sizeof(struct sockaddr_in);
-			remote = (struct sockaddr *)&remote4;
+	/* Wait for any of the ports and sessions to become readable. */
+	int retval = poll(fds, nfds, timeout);
+
+	if (retval < 0) {
+		return EIO;
+	}
+
+	for (int index = 0; (index < nfds) && (retval > 0); index++) {
+		if (fds[index].revents == 0) {
+			continue;
 		}
 
-		int bytes_read = recvfrom(port->socket_fd,
-					  read_mem,
-					  COAP_MESSAGE_DATA_MAX_SIZE,
-					  MSG_DONTWAIT,
-					  remote,
-					  &address_length);
-		if (bytes_read >= 0) {
-			/* Notify the CoAP module of received data. */
-			int retval = coap_transport_read(
-					port->socket_fd,
-					remote, local, 0, read_mem,
-					(u16_t)bytes_read);
-
-			/* Nothing much to do if CoAP could not interpret the
-			 * datagram.
-			 */
-			(void)(retval);
-		} else {
-			/* Error in recvfrom(). Placeholder for debugging. */
+		retval--;
+
+		/* A socket in error would make every poll() return at once,
+		 * so it is closed and replaced.
+		 */
+		if ((fds[index].revents & POLLNVAL) != 0) {
+			socket_error_handle(entries[index], EBADF);
+		} else if ((fds[index].revents & (POLLERR | POLLHUP)) != 0) {
+			socket_error_handle(entries[index], EIO);
+		} else if ((fds[index].revents & POLLIN) != 0) {
+			(void)socket_receive(entries[index]);
 		}
 	}
+
+	return 0;
+}
+
+/* lint --e{14} */
+/*suppress "Symbol 'coap_transport_input(void)' previously defined" (WEAK) */
+void coap_transport_input(void)
+{
+	/* Read whatever is pending, without blocking. */
+	(void)coap_transport_poll(0);
 }
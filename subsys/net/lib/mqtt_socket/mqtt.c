@@ -13,6 +13,7 @@
 LOG_MODULE_REGISTER(net_mqtt, CONFIG_MQTT_SOCKET_LOG_LEVEL);
 
 #include <net/mqtt_socket.h>
+#include <net/socket.h>
 
 #include "mqtt_transport.h"
 #include "mqtt_internal.h"
@@ -27,7 +28,7 @@ LOG_MODULE_REGISTER(net_mqtt, CONFIG_MQTT_SOCKET_LOG_LEVEL);
 /** MQTT Client table. */
 static struct mqtt_client *mqtt_client[MQTT_MAX_CLIENTS];
 
-/** Mutex used by MQTT implementation. */
+/** Mutex protecting the client table and data shared between clients. */
 struct k_mutex mqtt_mutex;
 
 /** Memory slab submitted to the MQTT memory management.*/
@@ -50,6 +51,14 @@ static void client_free(struct mqtt_client *client)
 {
 	MQTT_STATE_INIT(client);
 
+	client->rx_buf_datalen = 0;
+	client->remaining_payload = 0;
+	client->rx_payload_offset = 0;
+
+	if (IS_ENABLED(CONFIG_MQTT_PUBLISH_BATCH)) {
+		mqtt_batch_drop(client);
+	}
+
 	/* Free memory used for TX packets and reset the pointer. */
 	if (client->tx_buf != NULL) {
 		mqtt_free(client->tx_buf);
@@ -66,6 +75,8 @@ static void client_init(struct mqtt_client *client)
 {
 	memset(client, 0, sizeof(*client));
 
+	mqtt_client_lock_init(client);
+
 	MQTT_STATE_INIT(client);
 
 	client->protocol_version = MQTT_VERSION_3_1_1;
@@ -87,11 +98,11 @@ void event_notify(struct mqtt_client *client, const struct mqtt_evt *evt,
 	const mqtt_evt_cb_t evt_cb = client->evt_cb;
 
 	if (evt_cb != NULL) {
-		mqtt_mutex_unlock();
+		mqtt_client_unlock(client);
 
 		evt_cb(client, evt);
 
-		mqtt_mutex_lock();
+		mqtt_client_lock(client);
 	}
 }
 
@@ -102,14 +113,19 @@ void event_notify(struct mqtt_client *client, const struct mqtt_evt *evt,
  */
 static void disconnect_event_notify(struct mqtt_client *client, int result)
 {
-	const u32_t client_index = get_client_index(client);
+	u32_t client_index;
 	struct mqtt_evt evt;
 
 	/* Remove the client from internal table. */
+	mqtt_mutex_lock();
+
+	client_index = get_client_index(client);
 	if (client_index != MQTT_MAX_CLIENTS) {
 		mqtt_client[client_index] = NULL;
 	}
 
+	mqtt_mutex_unlock();
+
 	/* Determine appropriate event to generate. */
 	if (MQTT_VERIFY_STATE(client, MQTT_STATE_CONNECTED) ||
 	    MQTT_VERIFY_STATE(client, MQTT_STATE_DISCONNECTING)) {
@@ -193,7 +209,7 @@ static int client_read(struct mqtt_client *client)
 
 	err_code = mqtt_transport_read(client,
 				       client->rx_buf + client->rx_buf_datalen,
-				       &data_len);
+				       &data_len, false);
 
 	if (err_code < 0) {
 		if (err_code == -EAGAIN) {
@@ -240,11 +256,113 @@ static int client_read(struct mqtt_client *client)
 	return err_code;
 }
 
+static int read_publish_payload(struct mqtt_client *client, void *buffer,
+				size_t length, bool shall_block)
+{
+	u32_t data_len = MIN(length, client->remaining_payload);
+	int err_code;
+
+	if (client->remaining_payload == 0) {
+		return 0;
+	}
+
+	if (client->rx_buf_datalen > 0) {
+		/* Part of the payload received along with the header. */
+		data_len = MIN(data_len, client->rx_buf_datalen -
+					 client->rx_payload_offset);
+		memcpy(buffer, client->rx_buf + client->rx_payload_offset,
+		       data_len);
+
+		client->rx_payload_offset += data_len;
+		if (client->rx_payload_offset == client->rx_buf_datalen) {
+			client->rx_payload_offset = 0;
+			client->rx_buf_datalen = 0;
+		}
+	} else {
+		err_code = mqtt_transport_read(client, buffer, &data_len,
+					       shall_block);
+		if (err_code < 0) {
+			if (err_code != -EAGAIN) {
+				MQTT_TRC("Error receiving payload, error = %d, "
+					 "closing connection", err_code);
+				client_abort(client);
+			}
+
+			return err_code;
+		}
+
+		if (data_len == 0) {
+			MQTT_TRC("Received end of stream, closing connection");
+			client_disconnect(client, 0);
+			return -ENOTCONN;
+		}
+	}
+
+	client->remaining_payload -= data_len;
+
+	return data_len;
+}
+
+static int client_payload_discard(struct mqtt_client *client)
+{
+	int ret;
+
+	if (client->remaining_payload == 0) {
+		return 0;
+	}
+
+	MQTT_TRC("[%p]: Discarding %d bytes of payload.", client,
+		 client->remaining_payload);
+
+	/* Drop the payload part kept in the RX buffer first, so that the
+	 * buffer can be used to read the rest.
+	 */
+	client->remaining_payload -= client->rx_buf_datalen -
+				     client->rx_payload_offset;
+	client->rx_payload_offset = 0;
+	client->rx_buf_datalen = 0;
+
+	while (client->remaining_payload > 0) {
+		ret = read_publish_payload(client, client->rx_buf,
+					   MQTT_MAX_PACKET_LENGTH, false);
+		if (ret < 0) {
+			return (ret == -EAGAIN) ? 0 : ret;
+		}
+	}
+
+	return 0;
+}
+
+static int client_batch_flush(struct mqtt_client *client)
+{
+	int err_code;
+
+	if (!IS_ENABLED(CONFIG_MQTT_PUBLISH_BATCH)) {
+		return 0;
+	}
+
+	err_code = mqtt_batch_flush(client);
+	if (err_code != 0) {
+		MQTT_TRC("TCP write failed, errno = %d, "
+			 "closing connection", errno);
+		client_disconnect(client, err_code);
+		return -EIO;
+	}
+
+	return 0;
+}
+
 static int client_write(struct mqtt_client *client, const u8_t *data,
 			u32_t datalen)
 {
 	int err_code;
 
+	/* Batched messages are sent first to keep the order of packets. */
+	err_code = client_batch_flush(client);
+	if (err_code != 0) {
+		return err_code;
+	}
+
 	MQTT_TRC("[%p]: Transport writing %d bytes.", client, datalen);
 
 	MQTT_SET_STATE(client, MQTT_STATE_PENDING_WRITE);
@@ -266,6 +384,182 @@ static int client_write(struct mqtt_client *client, const u8_t *data,
 	return 0;
 }
 
+static int client_write_msg(struct mqtt_client *client, const u8_t *header,
+			    u32_t header_len, const u8_t *payload,
+			    u32_t payload_len)
+{
+	u8_t *header_end = (u8_t *)header + header_len;
+	u32_t room = client->tx_buf + MQTT_MAX_PACKET_LENGTH - header_end;
+	int err_code;
+
+	/* The header is encoded in the TX buffer. A payload fitting behind it
+	 * is copied there, so that the message is sent with a single write.
+	 */
+	if (payload_len <= room) {
+		if (payload_len > 0) {
+			memcpy(header_end, payload, payload_len);
+		}
+
+		return client_write(client, header, header_len + payload_len);
+	}
+
+	err_code = client_batch_flush(client);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	MQTT_TRC("[%p]: Transport writing message.", client);
+
+	MQTT_SET_STATE(client, MQTT_STATE_PENDING_WRITE);
+
+	err_code = mqtt_transport_write_msg(client, header, header_len,
+					    payload, payload_len);
+
+	MQTT_RESET_STATE(client, MQTT_STATE_PENDING_WRITE);
+
+	if (err_code != 0) {
+		MQTT_TRC("TCP write failed, errno = %d, "
+			 "closing connection", errno);
+		client_disconnect(client, err_code);
+		return -EIO;
+	}
+
+	MQTT_TRC("[%p]: Transport write complete.", client);
+	client->last_activity = mqtt_sys_tick_in_ms_get();
+
+	return 0;
+}
+
+/**@brief Gets the clients registered in the client table.
+ *
+ * @param[out] clients Array of MQTT_MAX_CLIENTS entries to store the clients.
+ *
+ * @retval Number of registered clients.
+ */
+static u32_t clients_get(struct mqtt_client **clients)
+{
+	u32_t count = 0;
+
+	mqtt_mutex_lock();
+
+	for (u32_t index = 0; index < MQTT_MAX_CLIENTS; index++) {
+		if (mqtt_client[index] != NULL) {
+			clients[count++] = mqtt_client[index];
+		}
+	}
+
+	mqtt_mutex_unlock();
+
+	return count;
+}
+
+static int client_input(struct mqtt_client *client)
+{
+	int err_code;
+
+	MQTT_TRC("state:0x%08x", client->state);
+
+	if (MQTT_VERIFY_STATE(client, MQTT_STATE_DISCONNECTING)) {
+		err_code = client_disconnect(client, 0);
+	} else if (MQTT_VERIFY_STATE(client, MQTT_STATE_TCP_CONNECTED)) {
+		/* Payload not read by the application is dropped. */
+		err_code = client_payload_discard(client);
+
+		if ((err_code == 0) && (client->remaining_payload == 0)) {
+			err_code = client_read(client);
+		}
+	} else {
+		err_code = -EACCES;
+	}
+
+	return err_code;
+}
+
+static void client_live(struct mqtt_client *client)
+{
+	u32_t elapsed_time;
+
+	if (MQTT_VERIFY_STATE(client, MQTT_STATE_DISCONNECTING)) {
+		client_disconnect(client, 0);
+		return;
+	}
+
+	/* Client could be disconnected since it was taken from the table. */
+	if (!MQTT_VERIFY_STATE(client, MQTT_STATE_TCP_CONNECTED)) {
+		return;
+	}
+
+	if (IS_ENABLED(CONFIG_MQTT_INFLIGHT) &&
+	    MQTT_VERIFY_STATE(client, MQTT_STATE_CONNECTED) &&
+	    (mqtt_inflight_resend(client, false) != 0)) {
+		client_disconnect(client, -EIO);
+		return;
+	}
+
+	if (IS_ENABLED(CONFIG_MQTT_PUBLISH_BATCH) &&
+	    (mqtt_batch_timeout_get(client) == K_NO_WAIT) &&
+	    (client_batch_flush(client) != 0)) {
+		return;
+	}
+
+	elapsed_time = mqtt_elapsed_time_in_ms_get(client->last_activity);
+
+	if ((MQTT_KEEPALIVE > 0) &&
+	    (elapsed_time >= (MQTT_KEEPALIVE * 1000))) {
+		(void)mqtt_ping(client);
+	}
+}
+
+static s32_t timeout_min(s32_t timeout1, s32_t timeout2)
+{
+	if (timeout1 == K_FOREVER) {
+		return timeout2;
+	} else if (timeout2 == K_FOREVER) {
+		return timeout1;
+	}
+
+	return MIN(timeout1, timeout2);
+}
+
+/**@brief Gets time until the client needs to be kept alive by client_live.
+ *
+ * @param[in] client Identifies the client for which the procedure is requested.
+ *
+ * @retval Time in milliseconds or K_FOREVER.
+ */
+static s32_t client_live_timeout(struct mqtt_client *client)
+{
+	s32_t timeout = K_FOREVER;
+	u32_t elapsed_time;
+
+	if (MQTT_VERIFY_STATE(client, MQTT_STATE_DISCONNECTING)) {
+		return K_NO_WAIT;
+	}
+
+	if (!MQTT_VERIFY_STATE(client, MQTT_STATE_TCP_CONNECTED)) {
+		return K_FOREVER;
+	}
+
+	if (MQTT_KEEPALIVE > 0) {
+		elapsed_time = mqtt_elapsed_time_in_ms_get(
+						client->last_activity);
+		timeout = (elapsed_time < (MQTT_KEEPALIVE * 1000)) ?
+			  (MQTT_KEEPALIVE * 1000) - elapsed_time : K_NO_WAIT;
+	}
+
+	if (IS_ENABLED(CONFIG_MQTT_INFLIGHT) &&
+	    MQTT_VERIFY_STATE(client, MQTT_STATE_CONNECTED)) {
+		timeout = timeout_min(timeout,
+				      mqtt_inflight_timeout_get(client));
+	}
+
+	if (IS_ENABLED(CONFIG_MQTT_PUBLISH_BATCH)) {
+		timeout = timeout_min(timeout, mqtt_batch_timeout_get(client));
+	}
+
+	return timeout;
+}
+
 int mqtt_init(void)
 {
 	mqtt_mutex_init();
@@ -302,6 +596,8 @@ int mqtt_connect(struct mqtt_client *client)
 	NULL_PARAM_CHECK(client);
 	NULL_PARAM_CHECK(client->client_id.utf8);
 
+	mqtt_client_lock(client);
+
 	mqtt_mutex_lock();
 
 	for (client_index = 0; client_index < MQTT_MAX_CLIENTS;
@@ -313,21 +609,35 @@ int mqtt_connect(struct mqtt_client *client)
 		}
 	}
 
+	mqtt_mutex_unlock();
+
 	if ((client_index == MQTT_MAX_CLIENTS) || (client->tx_buf == NULL) ||
 	    (client->rx_buf == NULL)) {
 		client_free(client);
 		err_code = -ENOMEM;
 	} else {
+		if (IS_ENABLED(CONFIG_MQTT_INFLIGHT)) {
+			if (client->clean_session) {
+				mqtt_inflight_clear(client);
+			} else {
+				mqtt_inflight_load(client);
+			}
+		}
+
 		err_code = client_connect(client);
 		if (err_code != 0) {
 			/* Free the instance. */
 			client_free(client);
+
+			mqtt_mutex_lock();
 			mqtt_client[client_index] = NULL;
+			mqtt_mutex_unlock();
+
 			err_code = -ECONNREFUSED;
 		}
 	}
 
-	mqtt_mutex_unlock();
+	mqtt_client_unlock(client);
 
 	return err_code;
 }
@@ -345,13 +655,91 @@ static int verify_tx_state(const struct mqtt_client *client)
 	return 0;
 }
 
-int mqtt_publish(struct mqtt_client *client,
-		 const struct mqtt_publish_param *param)
+/* A stored message is not lost when the connection closes on a failed write
+ * if the client keeps its session, it is sent again after reconnecting. The
+ * failure is reported only by the MQTT_EVT_DISCONNECT event then, so that
+ * the application does not publish the message again. With a clean session
+ * the message is dropped on reconnection, so the error is returned.
+ */
+static int publish_result(const struct mqtt_client *client, bool stored,
+			  int err_code)
 {
+	if (stored && !client->clean_session && (err_code == -EIO)) {
+		return 0;
+	}
+
+	return err_code;
+}
+
+static int client_publish(struct mqtt_client *client,
+			  const struct mqtt_publish_param *param, bool batch)
+{
+	/* Retransmissions by the application do not take another slot of
+	 * the server Receive Maximum.
+	 */
+	const bool quota = mqtt_is_v5(client) && !param->dup_flag &&
+			   (param->message.topic.qos != MQTT_QOS_0_AT_MOST_ONCE);
+	const bool stored = IS_ENABLED(CONFIG_MQTT_INFLIGHT) &&
+			    (param->message.topic.qos != MQTT_QOS_0_AT_MOST_ONCE);
 	int err_code;
 	const u8_t *packet;
 	u32_t packetlen;
 
+	if (quota) {
+		err_code = mqtt_v5_send_quota_take(client);
+		if (err_code != 0) {
+			return err_code;
+		}
+	}
+
+	err_code = publish_header_encode(client, param, &packet, &packetlen);
+
+	if (stored && (err_code == 0)) {
+		err_code = mqtt_inflight_add(client, param->message_id,
+					     packet, packetlen,
+					     param->message.payload.data,
+					     param->message.payload.len);
+	}
+
+	if (err_code != 0) {
+		if (quota) {
+			mqtt_v5_send_quota_give(client);
+		}
+
+		return err_code;
+	}
+
+	if (IS_ENABLED(CONFIG_MQTT_PUBLISH_BATCH) && batch) {
+		err_code = mqtt_batch_append(client, packet, packetlen,
+					     param->message.payload.data,
+					     param->message.payload.len);
+		if (err_code == -ENOSPC) {
+			err_code = client_batch_flush(client);
+			if (err_code == 0) {
+				err_code = mqtt_batch_append(
+					client, packet, packetlen,
+					param->message.payload.data,
+					param->message.payload.len);
+			}
+		}
+
+		/* Message longer than the batch buffer is sent right away. */
+		if ((err_code != -ENOSPC) && (err_code != -ENOMEM)) {
+			return publish_result(client, stored, err_code);
+		}
+	}
+
+	return publish_result(client, stored,
+			      client_write_msg(client, packet, packetlen,
+					       param->message.payload.data,
+					       param->message.payload.len));
+}
+
+int mqtt_publish(struct mqtt_client *client,
+		 const struct mqtt_publish_param *param)
+{
+	int err_code;
+
 	NULL_PARAM_CHECK(client);
 	NULL_PARAM_CHECK(param);
 
@@ -360,18 +748,14 @@ int mqtt_publish(struct mqtt_client *client,
 		 param->message.topic.topic.size,
 		 param->message.payload.len);
 
-	mqtt_mutex_lock();
+	mqtt_client_lock(client);
 
 	err_code = verify_tx_state(client);
 	if (err_code == 0) {
-		err_code = publish_encode(client, param, &packet, &packetlen);
-
-		if (err_code == 0) {
-			err_code = client_write(client, packet, packetlen);
-		}
+		err_code = client_publish(client, param, false);
 	}
 
-	mqtt_mutex_unlock();
+	mqtt_client_unlock(client);
 
 	MQTT_TRC("[CID %p]:[State 0x%02x]: << result 0x%08x",
 			 client, client->state, err_code);
@@ -379,6 +763,54 @@ int mqtt_publish(struct mqtt_client *client,
 	return err_code;
 }
 
+#if defined(CONFIG_MQTT_PUBLISH_BATCH)
+int mqtt_publish_batch(struct mqtt_client *client,
+		       const struct mqtt_publish_param *param)
+{
+	int err_code;
+
+	NULL_PARAM_CHECK(client);
+	NULL_PARAM_CHECK(param);
+
+	MQTT_TRC("[CID %p]:[State 0x%02x]: >> Topic size 0x%08x, "
+		 "Data size 0x%08x", client, client->state,
+		 param->message.topic.topic.size,
+		 param->message.payload.len);
+
+	mqtt_client_lock(client);
+
+	err_code = verify_tx_state(client);
+	if (err_code == 0) {
+		err_code = client_publish(client, param, true);
+	}
+
+	mqtt_client_unlock(client);
+
+	MQTT_TRC("[CID %p]:[State 0x%02x]: << result 0x%08x",
+		 client, client->state, err_code);
+
+	return err_code;
+}
+
+int mqtt_publish_batch_flush(struct mqtt_client *client)
+{
+	int err_code;
+
+	NULL_PARAM_CHECK(client);
+
+	mqtt_client_lock(client);
+
+	err_code = verify_tx_state(client);
+	if (err_code == 0) {
+		err_code = client_batch_flush(client);
+	}
+
+	mqtt_client_unlock(client);
+
+	return err_code;
+}
+#endif /* CONFIG_MQTT_PUBLISH_BATCH */
+
 int mqtt_publish_qos1_ack(struct mqtt_client *client,
 			  const struct mqtt_puback_param *param)
 {
@@ -392,7 +824,7 @@ int mqtt_publish_qos1_ack(struct mqtt_client *client,
 	MQTT_TRC("[CID %p]:[State 0x%02x]: >> Message id 0x%04x",
 		 client, client->state, param->message_id);
 
-	mqtt_mutex_lock();
+	mqtt_client_lock(client);
 
 	err_code = verify_tx_state(client);
 	if (err_code == 0) {
@@ -404,7 +836,7 @@ int mqtt_publish_qos1_ack(struct mqtt_client *client,
 		}
 	}
 
-	mqtt_mutex_unlock();
+	mqtt_client_unlock(client);
 
 	MQTT_TRC("[CID %p]:[State 0x%02x]: << result 0x%08x",
 		 client, client->state, err_code);
@@ -425,7 +857,7 @@ int mqtt_publish_qos2_receive(struct mqtt_client *client,
 	MQTT_TRC("[CID %p]:[State 0x%02x]: >> Message id 0x%04x",
 		 client, client->state, param->message_id);
 
-	mqtt_mutex_lock();
+	mqtt_client_lock(client);
 
 	err_code = verify_tx_state(client);
 	if (err_code == 0) {
@@ -437,7 +869,7 @@ int mqtt_publish_qos2_receive(struct mqtt_client *client,
 		}
 	}
 
-	mqtt_mutex_unlock();
+	mqtt_client_unlock(client);
 
 	MQTT_TRC("[CID %p]:[State 0x%02x]: << result 0x%08x",
 		 client, client->state, err_code);
@@ -458,19 +890,26 @@ int mqtt_publish_qos2_release(struct mqtt_client *client,
 	MQTT_TRC("[CID %p]:[State 0x%02x]: >> Message id 0x%04x",
 		 client, client->state, param->message_id);
 
-	mqtt_mutex_lock();
+	mqtt_client_lock(client);
 
 	err_code = verify_tx_state(client);
 	if (err_code == 0) {
 		err_code = publish_release_encode(client, param, &packet,
 						   &packetlen);
 
+		if (IS_ENABLED(CONFIG_MQTT_INFLIGHT) && (err_code == 0)) {
+			/* PUBREL replaces the stored PUBLISH message. */
+			err_code = mqtt_inflight_add(client, param->message_id,
+						     packet, packetlen,
+						     NULL, 0);
+		}
+
 		if (err_code == 0) {
 			err_code = client_write(client, packet, packetlen);
 		}
 	}
 
-	mqtt_mutex_unlock();
+	mqtt_client_unlock(client);
 
 	MQTT_TRC("[CID %p]:[State 0x%02x]: << result 0x%08x",
 		 client, client->state, err_code);
@@ -491,7 +930,7 @@ int mqtt_publish_qos2_complete(struct mqtt_client *client,
 	MQTT_TRC("[CID %p]:[State 0x%02x]: >> Message id 0x%04x",
 		 client, client->state, param->message_id);
 
-	mqtt_mutex_lock();
+	mqtt_client_lock(client);
 
 	err_code = verify_tx_state(client);
 	if (err_code == 0) {
@@ -503,7 +942,7 @@ int mqtt_publish_qos2_complete(struct mqtt_client *client,
 		}
 	}
 
-	mqtt_mutex_unlock();
+	mqtt_client_unlock(client);
 
 	MQTT_TRC("[CID %p]:[State 0x%02x]: << result 0x%08x",
 		 client, client->state, err_code);
@@ -519,7 +958,7 @@ int mqtt_disconnect(struct mqtt_client *client)
 
 	NULL_PARAM_CHECK(client);
 
-	mqtt_mutex_lock();
+	mqtt_client_lock(client);
 
 	err_code = verify_tx_state(client);
 	if (err_code == 0) {
@@ -535,7 +974,7 @@ int mqtt_disconnect(struct mqtt_client *client)
 		}
 	}
 
-	mqtt_mutex_unlock();
+	mqtt_client_unlock(client);
 
 	return err_code;
 }
@@ -554,7 +993,7 @@ int mqtt_subscribe(struct mqtt_client *client,
 		 "topic count 0x%04x", client, client->state,
 		 param->message_id, param->list_count);
 
-	mqtt_mutex_lock();
+	mqtt_client_lock(client);
 
 	err_code = verify_tx_state(client);
 	if (err_code == 0) {
@@ -568,7 +1007,7 @@ int mqtt_subscribe(struct mqtt_client *client,
 	MQTT_TRC("[CID %p]:[State 0x%02x]: << result 0x%08x",
 		 client, client->state, err_code);
 
-	mqtt_mutex_unlock();
+	mqtt_client_unlock(client);
 
 	return err_code;
 }
@@ -583,7 +1022,7 @@ int mqtt_unsubscribe(struct mqtt_client *client,
 	NULL_PARAM_CHECK(client);
 	NULL_PARAM_CHECK(param);
 
-	mqtt_mutex_lock();
+	mqtt_client_lock(client);
 
 	err_code = verify_tx_state(client);
 	if (err_code == 0) {
@@ -595,7 +1034,7 @@ int mqtt_unsubscribe(struct mqtt_client *client,
 		}
 	}
 
-	mqtt_mutex_unlock();
+	mqtt_client_unlock(client);
 
 	return err_code;
 }
@@ -608,7 +1047,7 @@ int mqtt_ping(struct mqtt_client *client)
 
 	NULL_PARAM_CHECK(client);
 
-	mqtt_mutex_lock();
+	mqtt_client_lock(client);
 
 	err_code = verify_tx_state(client);
 	if (err_code == 0) {
@@ -619,54 +1058,39 @@ int mqtt_ping(struct mqtt_client *client)
 		}
 	}
 
-	mqtt_mutex_unlock();
+	mqtt_client_unlock(client);
 
 	return err_code;
 }
 
 int mqtt_abort(struct mqtt_client *client)
 {
-	mqtt_mutex_lock();
-
 	NULL_PARAM_CHECK(client);
 
+	mqtt_client_lock(client);
+
 	if (client->state != MQTT_STATE_IDLE) {
 		client_abort(client);
 	}
 
-	mqtt_mutex_unlock();
+	mqtt_client_unlock(client);
 
 	return 0;
 }
 
 int mqtt_live(void)
 {
-	u32_t elapsed_time;
-	u32_t index;
+	struct mqtt_client *clients[MQTT_MAX_CLIENTS];
+	u32_t count = clients_get(clients);
 
-	mqtt_mutex_lock();
-
-	for (index = 0; index < MQTT_MAX_CLIENTS; index++) {
-		struct mqtt_client *client = mqtt_client[index];
+	for (u32_t index = 0; index < count; index++) {
+		mqtt_client_lock(clients[index]);
 
-		if (client != NULL) {
-			if (MQTT_VERIFY_STATE(client,
-					      MQTT_STATE_DISCONNECTING)) {
-				client_disconnect(client, 0);
-			} else {
-				elapsed_time = mqtt_elapsed_time_in_ms_get(
-							client->last_activity);
+		client_live(clients[index]);
 
-				if ((MQTT_KEEPALIVE > 0) &&
-				    (elapsed_time >= (MQTT_KEEPALIVE * 1000))) {
-					(void)mqtt_ping(client);
-				}
-			}
-		}
+		mqtt_client_unlock(clients[index]);
 	}
 
-	mqtt_mutex_unlock();
-
 	return 0;
 }
 
@@ -676,19 +1100,100 @@ int mqtt_input(struct mqtt_client *client)
 
 	NULL_PARAM_CHECK(client);
 
-	mqtt_mutex_lock();
+	mqtt_client_lock(client);
 
-	MQTT_TRC("state:0x%08x", client->state);
+	err_code = client_input(client);
 
-	if (MQTT_VERIFY_STATE(client, MQTT_STATE_DISCONNECTING)) {
-		err_code = client_disconnect(client, 0);
-	} else if (MQTT_VERIFY_STATE(client, MQTT_STATE_TCP_CONNECTED)) {
-		err_code = client_read(client);
+	mqtt_client_unlock(client);
+
+	return err_code;
+}
+
+int mqtt_process(s32_t timeout)
+{
+	struct mqtt_client *clients[MQTT_MAX_CLIENTS];
+	struct pollfd fds[MQTT_MAX_CLIENTS];
+	u32_t count = clients_get(clients);
+	u32_t index;
+	int ret;
+
+	if (count == 0) {
+		return -ENOTCONN;
+	}
+
+	for (index = 0; index < count; index++) {
+		mqtt_client_lock(clients[index]);
+
+		fds[index].fd = mqtt_transport_sock_get(clients[index]);
+		fds[index].events = POLLIN;
+		fds[index].revents = 0;
+
+		timeout = timeout_min(timeout,
+				      client_live_timeout(clients[index]));
+
+		mqtt_client_unlock(clients[index]);
+	}
+
+	ret = poll(fds, count, timeout);
+	if (ret < 0) {
+		MQTT_ERR("Poll failed, errno = %d", errno);
+		return -errno;
+	}
+
+	for (index = 0; index < count; index++) {
+		mqtt_client_lock(clients[index]);
+
+		/* Errors and hang-ups are reported by the read. */
+		if (fds[index].revents != 0) {
+			(void)client_input(clients[index]);
+		}
+
+		client_live(clients[index]);
+
+		mqtt_client_unlock(clients[index]);
+	}
+
+	return 0;
+}
+
+int mqtt_read_publish_payload(struct mqtt_client *client, void *buffer,
+			      size_t length)
+{
+	int ret;
+
+	NULL_PARAM_CHECK(client);
+	NULL_PARAM_CHECK(buffer);
+
+	mqtt_client_lock(client);
+
+	if (MQTT_VERIFY_STATE(client, MQTT_STATE_TCP_CONNECTED)) {
+		ret = read_publish_payload(client, buffer, length, true);
 	} else {
-		err_code = -EACCES;
+		ret = -ENOTCONN;
 	}
 
-	mqtt_mutex_unlock();
+	mqtt_client_unlock(client);
 
-	return err_code;
+	return ret;
+}
+
+int mqtt_readall_publish_payload(struct mqtt_client *client, u8_t *buffer,
+				 size_t length)
+{
+	u8_t *end = buffer + length;
+	int ret;
+
+	while (buffer < end) {
+		ret = mqtt_read_publish_payload(client, buffer, end - buffer);
+		if (ret < 0) {
+			return ret;
+		} else if (ret == 0) {
+			/* Payload is shorter than requested. */
+			return -EIO;
+		}
+
+		buffer += ret;
+	}
+
+	return 0;
 }
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/** @file mqtt_batch.c
+ *
+ * @brief Batching of published messages into a single transport write.
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_mqtt_batch, CONFIG_MQTT_SOCKET_LOG_LEVEL);
+
+#include <net/mqtt_socket.h>
+
+#include "mqtt_transport.h"
+#include "mqtt_internal.h"
+#include "mqtt_os.h"
+
+#define BATCH_SIZE CONFIG_MQTT_PUBLISH_BATCH_SIZE
+#define BATCH_TIMEOUT_MS CONFIG_MQTT_PUBLISH_BATCH_TIMEOUT
+
+/* A batch buffer is only held by a client with pending messages. */
+K_MEM_SLAB_DEFINE(batch_slab, BATCH_SIZE, MQTT_MAX_CLIENTS, 4);
+
+int mqtt_batch_append(struct mqtt_client *client, const u8_t *header,
+		      u32_t header_len, const u8_t *payload, u32_t payload_len)
+{
+	if ((header_len > BATCH_SIZE - client->batch_len) ||
+	    (payload_len > BATCH_SIZE - client->batch_len - header_len)) {
+		return -ENOSPC;
+	}
+
+	if (client->batch_buf == NULL) {
+		if (k_mem_slab_alloc(&batch_slab, (void **)&client->batch_buf,
+				     K_NO_WAIT) != 0) {
+			client->batch_buf = NULL;
+			return -ENOMEM;
+		}
+
+		client->batch_len = 0;
+		client->batch_timestamp = mqtt_sys_tick_in_ms_get();
+	}
+
+	memcpy(client->batch_buf + client->batch_len, header, header_len);
+	client->batch_len += header_len;
+
+	if (payload_len > 0) {
+		memcpy(client->batch_buf + client->batch_len, payload,
+		       payload_len);
+		client->batch_len += payload_len;
+	}
+
+	MQTT_TRC("[%p]: Batched %d bytes, batch size %d.", client,
+		 header_len + payload_len, client->batch_len);
+
+	return 0;
+}
+
+int mqtt_batch_flush(struct mqtt_client *client)
+{
+	int err_code;
+
+	if (client->batch_buf == NULL) {
+		return 0;
+	}
+
+	MQTT_TRC("[%p]: Transport writing batch of %d bytes.", client,
+		 client->batch_len);
+
+	MQTT_SET_STATE(client, MQTT_STATE_PENDING_WRITE);
+
+	err_code = mqtt_transport_write(client, client->batch_buf,
+					client->batch_len);
+
+	MQTT_RESET_STATE(client, MQTT_STATE_PENDING_WRITE);
+
+	if (err_code == 0) {
+		client->last_activity = mqtt_sys_tick_in_ms_get();
+	}
+
+	/* Messages that failed to be sent are only kept by the in-flight
+	 * store, as the connection is closed on a write error.
+	 */
+	mqtt_batch_drop(client);
+
+	return err_code;
+}
+
+void mqtt_batch_drop(struct mqtt_client *client)
+{
+	if (client->batch_buf != NULL) {
+		k_mem_slab_free(&batch_slab, (void **)&client->batch_buf);
+		client->batch_buf = NULL;
+	}
+
+	client->batch_len = 0;
+}
+
+s32_t mqtt_batch_timeout_get(struct mqtt_client *client)
+{
+	u32_t elapsed_time;
+
+	if ((client->batch_buf == NULL) || (BATCH_TIMEOUT_MS == 0)) {
+		return K_FOREVER;
+	}
+
+	elapsed_time = mqtt_elapsed_time_in_ms_get(client->batch_timestamp);
+	if (elapsed_time >= BATCH_TIMEOUT_MS) {
+		return K_NO_WAIT;
+	}
+
+	return BATCH_TIMEOUT_MS - elapsed_time;
+}
@@ -102,6 +102,43 @@ static int unpack_uint16(u16_t *val, u32_t buffer_len, u8_t *buffer,
 	return err_code;
 }
 
+/**
+ * @brief Unpacks unsigned 32 bit value from the buffer from the offset
+ *        requested.
+ *
+ * @param[out] val Memory where the value is to be unpacked.
+ * @param[in] buffer_len Total size of the buffer. This shall not be zero.
+ * @param[in] buffer Buffer from which the value is to be unpacked.
+ * @param[inout] offset Offset on the buffer from where the value is to be
+ *                      unpacked. If the procedure is successful, the offset
+ *                      is incremented to point to the next read/unpack location
+ *                      on the buffer.
+ *
+ * @retval 0 if the procedure is successful.
+ * @retval -EINVAL if the offset is greater than or equal to the buffer length.
+ */
+static int unpack_uint32(u32_t *val, u32_t buffer_len, u8_t *buffer,
+			 u32_t *offset)
+{
+	u16_t msb, lsb;
+	int err_code;
+
+	if ((buffer_len < *offset) || (buffer_len - *offset < sizeof(u32_t))) {
+		return -EINVAL;
+	}
+
+	err_code = unpack_uint16(&msb, buffer_len, buffer, offset);
+	if (err_code == 0) {
+		err_code = unpack_uint16(&lsb, buffer_len, buffer, offset);
+	}
+
+	if (err_code == 0) {
+		*val = ((u32_t)msb << 16) | lsb;
+	}
+
+	return err_code;
+}
+
 /**
  * @brief Unpacks utf8 string from the buffer from the offset requested.
  *
@@ -233,6 +270,156 @@ int packet_length_decode(u8_t *buffer, u32_t buffer_len,
 	return 0;
 }
 
+/**
+ * @brief Decodes MQTT 5.0 properties. Properties not used by the client are
+ *        skipped.
+ *
+ * @param[in] buffer_len Total size of the buffer. This shall not be zero.
+ * @param[in] buffer Buffer from which the properties are to be decoded.
+ * @param[inout] offset Offset of the property length on the buffer. If the
+ *                      procedure is successful, the offset is incremented to
+ *                      point to the first byte after the properties.
+ * @param[out] connack Connect Ack parameters where the server limits are to
+ *                     be stored, NULL when decoding other packets.
+ *
+ * @retval 0 if the procedure is successful.
+ * @retval -EINVAL if the properties are malformed or not complete.
+ */
+static int properties_decode(u32_t buffer_len, u8_t *buffer, u32_t *offset,
+			     struct mqtt_connack_param *connack)
+{
+	struct mqtt_utf8 str;
+	u32_t length;
+	u32_t value32;
+	u16_t value16;
+	u8_t value8;
+	u8_t id;
+	int err_code;
+
+	err_code = packet_length_decode(buffer, buffer_len, &length, offset);
+	if ((err_code != 0) || (length > buffer_len - *offset)) {
+		return -EINVAL;
+	}
+
+	/* Properties shall not be read past their length. */
+	buffer_len = *offset + length;
+
+	while ((err_code == 0) && (*offset < buffer_len)) {
+		err_code = unpack_uint8(&id, buffer_len, buffer, offset);
+		if (err_code != 0) {
+			break;
+		}
+
+		switch (id) {
+		case MQTT_PROP_PAYLOAD_FORMAT_INDICATOR:
+		case MQTT_PROP_REQUEST_PROBLEM_INFORMATION:
+		case MQTT_PROP_REQUEST_RESPONSE_INFORMATION:
+		case MQTT_PROP_MAXIMUM_QOS:
+		case MQTT_PROP_RETAIN_AVAILABLE:
+		case MQTT_PROP_WILDCARD_SUBSCRIPTION_AVAILABLE:
+		case MQTT_PROP_SUBSCRIPTION_IDENTIFIER_AVAILABLE:
+		case MQTT_PROP_SHARED_SUBSCRIPTION_AVAILABLE:
+			err_code = unpack_uint8(&value8, buffer_len, buffer,
+						offset);
+			break;
+
+		case MQTT_PROP_SERVER_KEEP_ALIVE:
+		case MQTT_PROP_TOPIC_ALIAS:
+			err_code = unpack_uint16(&value16, buffer_len, buffer,
+						 offset);
+			break;
+
+		case MQTT_PROP_RECEIVE_MAXIMUM:
+			err_code = unpack_uint16(&value16, buffer_len, buffer,
+						 offset);
+			if ((err_code == 0) && (value16 == 0)) {
+				/* Protocol error. */
+				err_code = -EINVAL;
+			}
+
+			if ((err_code == 0) && (connack != NULL)) {
+				connack->receive_max = value16;
+			}
+			break;
+
+		case MQTT_PROP_TOPIC_ALIAS_MAXIMUM:
+			err_code = unpack_uint16(&value16, buffer_len, buffer,
+						 offset);
+			if ((err_code == 0) && (connack != NULL)) {
+				connack->topic_alias_max = value16;
+			}
+			break;
+
+		case MQTT_PROP_MESSAGE_EXPIRY_INTERVAL:
+		case MQTT_PROP_SESSION_EXPIRY_INTERVAL:
+		case MQTT_PROP_WILL_DELAY_INTERVAL:
+		case MQTT_PROP_MAXIMUM_PACKET_SIZE:
+			err_code = unpack_uint32(&value32, buffer_len, buffer,
+						 offset);
+			break;
+
+		case MQTT_PROP_SUBSCRIPTION_IDENTIFIER:
+			err_code = packet_length_decode(buffer, buffer_len,
+							&value32, offset);
+			break;
+
+		case MQTT_PROP_USER_PROPERTY:
+			/* Name followed by the value. */
+			err_code = unpack_utf8_str(&str, buffer_len, buffer,
+						   offset);
+			if (err_code != 0) {
+				break;
+			}
+
+			/* Fall through. */
+		case MQTT_PROP_CONTENT_TYPE:
+		case MQTT_PROP_RESPONSE_TOPIC:
+		case MQTT_PROP_CORRELATION_DATA:
+		case MQTT_PROP_ASSIGNED_CLIENT_IDENTIFIER:
+		case MQTT_PROP_AUTHENTICATION_METHOD:
+		case MQTT_PROP_AUTHENTICATION_DATA:
+		case MQTT_PROP_RESPONSE_INFORMATION:
+		case MQTT_PROP_SERVER_REFERENCE:
+		case MQTT_PROP_REASON_STRING:
+			/* Binary data is encoded like UTF-8 strings. */
+			err_code = unpack_utf8_str(&str, buffer_len, buffer,
+						   offset);
+			break;
+
+		default:
+			MQTT_TRC("Unknown property 0x%02x", id);
+			err_code = -EINVAL;
+			break;
+		}
+	}
+
+	return err_code;
+}
+
+/**
+ * @brief Decodes the reason code of an acknowledgment, which MQTT 5.0 servers
+ *        omit when it is 0.
+ *
+ * @param[out] reason_code Memory where the reason code is to be unpacked.
+ * @param[in] buffer_len Total size of the buffer. This shall not be zero.
+ * @param[in] buffer Buffer from which the reason code is to be unpacked.
+ * @param[in] offset Offset of the reason code on the buffer.
+ *
+ * @retval 0 if the procedure is successful.
+ */
+static int reason_code_decode(u8_t *reason_code, u32_t buffer_len,
+			      u8_t *buffer, u32_t offset)
+{
+	*reason_code = MQTT_REASON_SUCCESS;
+
+	if (offset >= buffer_len) {
+		return 0;
+	}
+
+	/* Properties following the reason code are not used. */
+	return unpack_uint8(reason_code, buffer_len, buffer, &offset);
+}
+
 int connect_ack_decode(const struct mqtt_client *client, u8_t *data,
 		       u32_t datalen, u32_t offset,
 		       struct mqtt_connack_param *param)
@@ -240,9 +427,12 @@ int connect_ack_decode(const struct mqtt_client *client, u8_t *data,
 	int err_code;
 	u8_t flags, ret_code;
 
+	param->receive_max = MQTT_RECEIVE_MAXIMUM_DEFAULT;
+	param->topic_alias_max = 0;
+
 	err_code = unpack_uint8(&flags, datalen, data, &offset);
 	if (err_code == 0) {
-		if (client->protocol_version == MQTT_VERSION_3_1_1) {
+		if (client->protocol_version >= MQTT_VERSION_3_1_1) {
 			param->session_present_flag =
 				flags & MQTT_CONNACK_FLAG_SESSION_PRESENT;
 
@@ -257,11 +447,16 @@ int connect_ack_decode(const struct mqtt_client *client, u8_t *data,
 		param->return_code = (enum mqtt_conn_return_code)ret_code;
 	}
 
+	if ((err_code == 0) && mqtt_is_v5(client)) {
+		err_code = properties_decode(datalen, data, &offset, param);
+	}
+
 	return err_code;
 }
 
-int publish_decode(u8_t *data, u32_t datalen, u32_t offset,
-		   struct mqtt_publish_param *param)
+int publish_header_decode(const struct mqtt_client *client, u8_t *data,
+			  u32_t datalen, u32_t *offset,
+			  struct mqtt_publish_param *param)
 {
 	int err_code;
 
@@ -273,15 +468,32 @@ int publish_decode(u8_t *data, u32_t datalen, u32_t offset,
 
 	err_code = unpack_utf8_str(
 		&param->message.topic.topic,
-		datalen, data, &offset);
+		datalen, data, offset);
 
 	if (err_code == 0) {
 		if (param->message.topic.qos) {
 			err_code = unpack_uint16(&param->message_id,
-						 datalen, data, &offset);
+						 datalen, data, offset);
 		}
 	}
 
+	if ((err_code == 0) && mqtt_is_v5(client)) {
+		/* Topic aliases are not accepted from the server. */
+		err_code = properties_decode(datalen, data, offset, NULL);
+	}
+
+	return err_code;
+}
+
+int publish_decode(const struct mqtt_client *client, u8_t *data,
+		   u32_t datalen, u32_t offset,
+		   struct mqtt_publish_param *param)
+{
+	int err_code;
+
+	err_code = publish_header_decode(client, data, datalen, &offset,
+					 param);
+
 	if (err_code == 0) {
 		err_code = unpack_data(&param->message.payload,
 					  datalen, data, &offset);
@@ -299,34 +511,71 @@ int publish_decode(u8_t *data, u32_t datalen, u32_t offset,
 int publish_ack_decode(u8_t *data, u32_t datalen, u32_t offset,
 		       struct mqtt_puback_param *param)
 {
-	return unpack_uint16(&param->message_id, datalen, data, &offset);
+	int err_code;
+
+	err_code = unpack_uint16(&param->message_id, datalen, data, &offset);
+	if (err_code == 0) {
+		err_code = reason_code_decode(&param->reason_code, datalen,
+					      data, offset);
+	}
+
+	return err_code;
 }
 
 int publish_receive_decode(u8_t *data, u32_t datalen, u32_t offset,
 			   struct mqtt_pubrec_param *param)
 {
-	return unpack_uint16(&param->message_id, datalen, data, &offset);
+	int err_code;
+
+	err_code = unpack_uint16(&param->message_id, datalen, data, &offset);
+	if (err_code == 0) {
+		err_code = reason_code_decode(&param->reason_code, datalen,
+					      data, offset);
+	}
+
+	return err_code;
 }
 
 int publish_release_decode(u8_t *data, u32_t datalen, u32_t offset,
 			   struct mqtt_pubrel_param *param)
 {
-	return unpack_uint16(&param->message_id, datalen, data, &offset);
+	int err_code;
+
+	err_code = unpack_uint16(&param->message_id, datalen, data, &offset);
+	if (err_code == 0) {
+		err_code = reason_code_decode(&param->reason_code, datalen,
+					      data, offset);
+	}
+
+	return err_code;
 }
 
 int publish_complete_decode(u8_t *data, u32_t datalen, u32_t offset,
 			    struct mqtt_pubcomp_param *param)
 {
-	return unpack_uint16(&param->message_id, datalen, data, &offset);
+	int err_code;
+
+	err_code = unpack_uint16(&param->message_id, datalen, data, &offset);
+	if (err_code == 0) {
+		err_code = reason_code_decode(&param->reason_code, datalen,
+					      data, offset);
+	}
+
+	return err_code;
 }
 
-int subscribe_ack_decode(u8_t *data, u32_t datalen, u32_t offset,
+int subscribe_ack_decode(const struct mqtt_client *client, u8_t *data,
+			 u32_t datalen, u32_t offset,
 			 struct mqtt_suback_param *param)
 {
 	int err_code;
 
 	err_code = unpack_uint16(&param->message_id, datalen, data, &offset);
 
+	if ((err_code == 0) && mqtt_is_v5(client)) {
+		err_code = properties_decode(datalen, data, &offset, NULL);
+	}
+
 	if (err_code == 0) {
 		err_code = unpack_data(&param->return_codes, datalen,
 					  data, &offset);
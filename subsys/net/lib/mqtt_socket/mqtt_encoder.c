@@ -127,6 +127,35 @@ static int pack_uint16(u16_t val, u32_t buffer_len, u8_t *buffer,
 	return err_code;
 }
 
+/**
+ * @brief Packs unsigned 32 bit value to the buffer at the offset requested.
+ *
+ * @param[in] val Value to be packed.
+ * @param[in] buffer_len Total size of the buffer on which value is to be
+ *                       packed. This shall not be zero.
+ * @param[out] buffer Buffer where the value is to be packed.
+ * @param[inout] offset Offset on the buffer where the value is to be packed.
+ *                      If the procedure is successful, the offset is
+ *                      incremented to point to the next write/pack location on
+ *                      the buffer.
+ *
+ * @retval 0 if the procedure is successful.
+ * @retval -EINVAL if the offset is greater than or equal to the buffer length
+ *                 minus the size of unsigned 32 bit integer.
+ */
+static int pack_uint32(u32_t val, u32_t buffer_len, u8_t *buffer,
+		       u32_t *offset)
+{
+	int err_code = pack_uint16(val >> 16, buffer_len, buffer, offset);
+
+	if (err_code == 0) {
+		err_code = pack_uint16(val & 0xFFFF, buffer_len, buffer,
+				       offset);
+	}
+
+	return err_code;
+}
+
 /**
  * @brief Packs utf8 string to the buffer at the offset requested.
  *
@@ -175,48 +204,6 @@ static int pack_utf8_str(const struct mqtt_utf8 *str, u32_t buffer_len,
 	return err_code;
 }
 
-/**
- * @brief Packs binary string to the buffer at the offset requested.
- *
- * @param[in] str Binary string and its length to be packed.
- * @param[in] buffer_len Total size of the buffer on which string is to be
- *                       packed.
- * @param[in] buffer Buffer where the string is to be packed.
- * @param[inout] offset Offset on the buffer where the string is to be packed.
- *                      If the procedure is successful, the offset is
- *                      incremented to point to the next write/pack location on
- *                      the buffer.
- *
- * @retval 0 if the procedure is successful.
- * @retval -EINVAL if the offset is greater than or equal to the buffer length.
- * @retval -ENOMEM if there is no room on the buffer to pack the string.
- */
-static int pack_data(const struct mqtt_binstr *str, u32_t buffer_len,
-		     u8_t *buffer, u32_t *offset)
-{
-	int err_code = -EINVAL;
-
-	if (buffer_len > *offset) {
-		const u32_t available_len = buffer_len - *offset;
-
-		MQTT_TRC(">> BSL:%08x BL:%08x, B:%p, O:%08x A:%08x",
-			 GET_BINSTR_BUFFER_SIZE(str), buffer_len,
-			 buffer, *offset, available_len);
-
-		if (available_len >= GET_BINSTR_BUFFER_SIZE(str)) {
-			memcpy(&buffer[*offset], str->data,
-			       str->len);
-
-			*offset += str->len;
-			err_code = 0;
-		} else {
-			err_code = -ENOMEM;
-		}
-	}
-
-	return err_code;
-}
-
 /**
  * @brief Computes and encodes length for the MQTT fixed header.
  *
@@ -339,6 +326,50 @@ static int zero_len_str_encode(u32_t buffer_len, u8_t *buffer,
 	return pack_uint16(0x0000, buffer_len, buffer, offset);
 }
 
+/**
+ * @brief Encodes MQTT 5.0 properties of the Connect packet.
+ *
+ * @note Properties are short enough for their length to be encoded as
+ *       a single byte variable byte integer.
+ *
+ * @param[in] client Identifies the client for which the procedure is requested.
+ * @param[in] buffer_len Total size of the buffer on which properties will be
+ *                       encoded. This shall not be zero.
+ * @param[out] buffer Buffer where the properties are to be encoded.
+ * @param[inout] offset Offset on the buffer where the properties are to be
+ *                      encoded. If the procedure is successful, the offset is
+ *                      incremented to point to the next write/pack location on
+ *                      the buffer.
+ *
+ * @retval 0 if the procedure is successful.
+ * @retval -EINVAL if there is no room on the buffer for the properties.
+ */
+static int connect_properties_encode(const struct mqtt_client *client,
+				     u32_t buffer_len, u8_t *buffer,
+				     u32_t *offset)
+{
+	/* Session of MQTT 3.1.1 ends with the connection only if clean
+	 * session flag is set, MQTT 5.0 needs an expiry interval for that.
+	 */
+	const bool keep_session = !client->clean_session;
+	int err_code;
+
+	err_code = pack_uint8(keep_session ? 5 : 0, buffer_len, buffer,
+			      offset);
+
+	if ((err_code == 0) && keep_session) {
+		err_code = pack_uint8(MQTT_PROP_SESSION_EXPIRY_INTERVAL,
+				      buffer_len, buffer, offset);
+	}
+
+	if ((err_code == 0) && keep_session) {
+		err_code = pack_uint32(MQTT_SESSION_EXPIRY_NEVER, buffer_len,
+				       buffer, offset);
+	}
+
+	return err_code;
+}
+
 /**
  * @brief Encodes and sends messages that contain only message id in
  *        the variable header.
@@ -346,13 +377,15 @@ static int zero_len_str_encode(u32_t buffer_len, u8_t *buffer,
  * @param[in] client Identifies the client for which the procedure is requested.
  * @param[in] message_type Message type and reserved bit fields.
  * @param[in] message_id Message id to be encoded in the variable header.
+ * @param[in] reason_code MQTT 5.0 reason code, only encoded if it is not 0.
  * @param[out] packet A pointer to store a pointer to encoded message.
  * @param[out] packet_length A pointer to store message length.
  * @retval 0 or an error code indicating a reason for failure.
  */
 static int mqtt_message_id_only_enc(const struct mqtt_client *client,
 				    u8_t message_type, u16_t message_id,
-				    const u8_t **packet, u32_t *packet_length)
+				    u8_t reason_code, const u8_t **packet,
+				    u32_t *packet_length)
 {
 	int err_code = -ENOTCONN;
 	u32_t offset = 0;
@@ -371,6 +404,13 @@ static int mqtt_message_id_only_enc(const struct mqtt_client *client,
 			       MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
 			       payload, &offset);
 
+	/* Success without properties is implied by a short packet. */
+	if ((err_code == 0) && mqtt_is_v5(client) && (reason_code != 0)) {
+		err_code = pack_uint8(reason_code,
+				      MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
+				      payload, &offset);
+	}
+
 	if (err_code == 0) {
 		mqtt_packetlen = mqtt_encode_fixed_header(message_type,
 							  offset,
@@ -396,7 +436,13 @@ int connect_request_encode(const struct mqtt_client *client,
 	int err_code;
 	const struct mqtt_utf8 *mqtt_proto_desc;
 
-	if (client->protocol_version == MQTT_VERSION_3_1_1) {
+	if ((client->protocol_version == MQTT_VERSION_5_0) &&
+	    !IS_ENABLED(CONFIG_MQTT_LIB_V5)) {
+		return -ENOTSUP;
+	}
+
+	if (client->protocol_version >= MQTT_VERSION_3_1_1) {
+		/* MQTT 5.0 uses the same protocol name. */
 		mqtt_proto_desc = &mqtt_3_1_1_proto_desc;
 	} else {
 		mqtt_proto_desc = &mqtt_3_1_0_proto_desc;
@@ -435,6 +481,12 @@ int connect_request_encode(const struct mqtt_client *client,
 				       payload, &offset);
 	}
 
+	if ((err_code == 0) && mqtt_is_v5(client)) {
+		err_code = connect_properties_encode(
+			client, MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
+			payload, &offset);
+	}
+
 	if (err_code == 0) {
 		MQTT_TRC("Encoding Client Id. Str:%s Size:%08x.",
 			 client->client_id.utf8,
@@ -456,10 +508,19 @@ int connect_request_encode(const struct mqtt_client *client,
 			/* Set Will topic in connect flags. */
 			connect_flags |= MQTT_CONNECT_FLAG_WILL_TOPIC;
 
-			err_code = pack_utf8_str(
-				&client->will_topic->topic,
-				MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
-				payload, &offset);
+			if (mqtt_is_v5(client)) {
+				/* No Will properties. */
+				err_code = pack_uint8(
+					0, MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
+					payload, &offset);
+			}
+
+			if (err_code == 0) {
+				err_code = pack_utf8_str(
+					&client->will_topic->topic,
+					MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
+					payload, &offset);
+			}
 
 			if (err_code == 0) {
 				/* QoS is always 1 as of now. */
@@ -549,27 +610,71 @@ int connect_request_encode(const struct mqtt_client *client,
 	return err_code;
 }
 
-int publish_encode(const struct mqtt_client *client,
-		   const struct mqtt_publish_param *param,
-		   const u8_t **packet, u32_t *packet_length)
+/**
+ * @brief Gets MQTT 5.0 topic alias to be used for a published message.
+ *
+ * @param[in] client Identifies the client for which the procedure is requested.
+ * @param[in] param Publish message parameters.
+ * @param[out] alias_set Set to true if the alias is already known to the
+ *                       server, so that the topic can be omitted.
+ *
+ * @retval Topic alias, 0 if no alias is used.
+ */
+static u16_t publish_topic_alias_get(const struct mqtt_client *client,
+				     const struct mqtt_publish_param *param,
+				     bool *alias_set)
+{
+	u16_t alias;
+
+	*alias_set = false;
+
+	/* Stored messages can be sent again on another connection, where
+	 * the alias is not known.
+	 */
+	if (IS_ENABLED(CONFIG_MQTT_INFLIGHT) &&
+	    (param->message.topic.qos != MQTT_QOS_0_AT_MOST_ONCE)) {
+		return 0;
+	}
+
+	*alias_set = mqtt_v5_topic_alias_find(client,
+					      &param->message.topic.topic,
+					      &alias);
+
+	return alias;
+}
+
+int publish_header_encode(struct mqtt_client *client,
+			  const struct mqtt_publish_param *param,
+			  const u8_t **packet, u32_t *packet_length)
 {
 	int err_code = -ENOTCONN;
 	u32_t offset = 0;
 	u32_t mqtt_packetlen = 0;
 	u8_t *payload;
+	bool alias_set = false;
+	u16_t alias = 0;
 
 	/* Message id zero is not permitted by spec. */
 	if ((param->message.topic.qos) && (param->message_id == 0)) {
 		return -EINVAL;
 	}
 
+	if (mqtt_is_v5(client)) {
+		alias = publish_topic_alias_get(client, param, &alias_set);
+	}
+
 	payload = &client->tx_buf[MQTT_FIXED_HEADER_EXTENDED_SIZE];
 	memset(payload, 0, MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD);
 
-	/* Pack topic. */
-	err_code = pack_utf8_str(&param->message.topic.topic,
-				 MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
-				 payload, &offset);
+	/* Pack topic, the topic alias replaces it once set. */
+	if (alias_set) {
+		err_code = zero_len_str_encode(
+			MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD, payload, &offset);
+	} else {
+		err_code = pack_utf8_str(&param->message.topic.topic,
+					 MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
+					 payload, &offset);
+	}
 
 	if (err_code == 0) {
 		if (param->message.topic.qos) {
@@ -580,11 +685,35 @@ int publish_encode(const struct mqtt_client *client,
 		}
 	}
 
+	if ((err_code == 0) && mqtt_is_v5(client)) {
+		/* Property length, followed by the Topic Alias if used. */
+		err_code = pack_uint8(alias ? 3 : 0,
+				      MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
+				      payload, &offset);
+
+		if ((err_code == 0) && alias) {
+			err_code = pack_uint8(
+				MQTT_PROP_TOPIC_ALIAS,
+				MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
+				payload, &offset);
+		}
+
+		if ((err_code == 0) && alias) {
+			err_code = pack_uint16(
+				alias, MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
+				payload, &offset);
+		}
+	}
+
 	if (err_code == 0) {
-		/* Pack message on the topic. */
-		err_code = pack_data(&param->message.payload,
-					MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
-					payload, &offset);
+		/* Message on the topic is not packed, it is sent directly
+		 * from the application buffer. Only its length is accounted
+		 * for in the fixed header.
+		 */
+		if (param->message.payload.len >
+		    MQTT_MAX_PAYLOAD_SIZE - offset) {
+			err_code = -EMSGSIZE;
+		}
 	}
 
 	if (err_code == 0) {
@@ -592,12 +721,17 @@ int publish_encode(const struct mqtt_client *client,
 			MQTT_PKT_TYPE_PUBLISH, param->dup_flag,
 			param->message.topic.qos, param->retain_flag);
 
-		mqtt_packetlen = mqtt_encode_fixed_header(message_type,
-							  offset,
-							  &payload);
+		mqtt_packetlen = mqtt_encode_fixed_header(
+			message_type, offset + param->message.payload.len,
+			&payload);
 
-		*packet_length = mqtt_packetlen;
+		*packet_length = mqtt_packetlen - param->message.payload.len;
 		*packet = payload;
+
+		if (mqtt_is_v5(client) && alias && !alias_set) {
+			mqtt_v5_topic_alias_set(client, alias,
+						&param->message.topic.topic);
+		}
 	} else {
 		*packet_length = 0;
 		*packet = NULL;
@@ -614,7 +748,8 @@ int publish_ack_encode(const struct mqtt_client *client,
 		MQTT_MESSAGES_OPTIONS(MQTT_PKT_TYPE_PUBACK, 0, 0, 0);
 
 	return mqtt_message_id_only_enc(client, message_type, param->message_id,
-					packet, packet_length);
+					param->reason_code, packet,
+					packet_length);
 }
 
 int publish_receive_encode(const struct mqtt_client *client,
@@ -625,7 +760,8 @@ int publish_receive_encode(const struct mqtt_client *client,
 		MQTT_MESSAGES_OPTIONS(MQTT_PKT_TYPE_PUBREC, 0, 0, 0);
 
 	return mqtt_message_id_only_enc(client, message_type, param->message_id,
-					packet, packet_length);
+					param->reason_code, packet,
+					packet_length);
 }
 
 int publish_release_encode(const struct mqtt_client *client,
@@ -636,7 +772,8 @@ int publish_release_encode(const struct mqtt_client *client,
 		MQTT_MESSAGES_OPTIONS(MQTT_PKT_TYPE_PUBREL, 0, 1, 0);
 
 	return mqtt_message_id_only_enc(client, message_type, param->message_id,
-					packet, packet_length);
+					param->reason_code, packet,
+					packet_length);
 }
 
 int publish_complete_encode(const struct mqtt_client *client,
@@ -647,7 +784,8 @@ int publish_complete_encode(const struct mqtt_client *client,
 		MQTT_MESSAGES_OPTIONS(MQTT_PKT_TYPE_PUBCOMP, 0, 0, 0);
 
 	return mqtt_message_id_only_enc(client, message_type, param->message_id,
-					packet, packet_length);
+					param->reason_code, packet,
+					packet_length);
 }
 
 int disconnect_encode(const struct mqtt_client *client, const u8_t **packet,
@@ -682,6 +820,13 @@ int subscribe_encode(const struct mqtt_client *client,
 	err_code = pack_uint16(param->message_id,
 			       MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
 			       payload, &offset);
+
+	if ((err_code == 0) && mqtt_is_v5(client)) {
+		/* No properties. */
+		err_code = pack_uint8(0, MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
+				      payload, &offset);
+	}
+
 	if (err_code == 0) {
 		do {
 			err_code = pack_utf8_str(
@@ -738,6 +883,12 @@ int unsubscribe_encode(const struct mqtt_client *client,
 			       payload,
 			       &offset);
 
+	if ((err_code == 0) && mqtt_is_v5(client)) {
+		/* No properties. */
+		err_code = pack_uint8(0, MQTT_MAX_VARIABLE_HEADER_N_PAYLOAD,
+				      payload, &offset);
+	}
+
 	if (err_code == 0) {
 		do {
 			err_code = pack_utf8_str(
@@ -0,0 +1,408 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/** @file mqtt_inflight.c
+ *
+ * @brief Store of in-flight QoS 1 and QoS 2 messages.
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_mqtt_inflight, CONFIG_MQTT_SOCKET_LOG_LEVEL);
+
+#include <misc/slist.h>
+#include <net/mqtt_socket.h>
+
+#include "mqtt_transport.h"
+#include "mqtt_internal.h"
+#include "mqtt_os.h"
+
+/**@brief In-flight message, followed by the encoded MQTT packet. */
+struct inflight_msg {
+	sys_snode_t node;
+	const struct mqtt_client *client;
+	u32_t timestamp;
+	u32_t len;
+	u16_t message_id;
+	/** Waits for a slot of the server Receive Maximum to be sent again. */
+	bool queued;
+	u8_t data[];
+};
+
+#define INFLIGHT_BLOCK_SIZE \
+	ROUND_UP(sizeof(struct inflight_msg) + \
+		 CONFIG_MQTT_INFLIGHT_MAX_MESSAGE_LENGTH, 4)
+
+#define INFLIGHT_RETRY_TIMEOUT_MS (CONFIG_MQTT_INFLIGHT_RETRY_TIMEOUT * 1000)
+
+K_MEM_SLAB_DEFINE(inflight_slab, INFLIGHT_BLOCK_SIZE,
+		  CONFIG_MQTT_INFLIGHT_MAX_MESSAGES, 4);
+
+/** In-flight messages of all clients, in order of sending. */
+static sys_slist_t inflight_list;
+
+/** Persistent storage backend, NULL if not used. */
+static const struct mqtt_inflight_storage *inflight_storage;
+
+static struct inflight_msg *inflight_find(const struct mqtt_client *client,
+					  u16_t message_id,
+					  struct inflight_msg **prev)
+{
+	struct inflight_msg *msg;
+
+	*prev = NULL;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&inflight_list, msg, node) {
+		if ((msg->client == client) &&
+		    (msg->message_id == message_id)) {
+			return msg;
+		}
+
+		*prev = msg;
+	}
+
+	return NULL;
+}
+
+static void inflight_free(struct inflight_msg *msg, struct inflight_msg *prev)
+{
+	sys_slist_remove(&inflight_list, prev ? &prev->node : NULL,
+			 &msg->node);
+	k_mem_slab_free(&inflight_slab, (void **)&msg);
+}
+
+static int inflight_send(struct mqtt_client *client, struct inflight_msg *msg)
+{
+	int err_code;
+
+	MQTT_TRC("[%p]: Sending message id 0x%04x again.", client,
+		 msg->message_id);
+
+	MQTT_SET_STATE(client, MQTT_STATE_PENDING_WRITE);
+
+	err_code = mqtt_transport_write(client, msg->data, msg->len);
+
+	MQTT_RESET_STATE(client, MQTT_STATE_PENDING_WRITE);
+
+	if (err_code == 0) {
+		msg->timestamp = mqtt_sys_tick_in_ms_get();
+		client->last_activity = msg->timestamp;
+	}
+
+	return err_code;
+}
+
+static int inflight_put(struct mqtt_client *client, u16_t message_id,
+			const u8_t *header, u32_t header_len,
+			const u8_t *payload, u32_t payload_len)
+{
+	struct inflight_msg *msg;
+	struct inflight_msg *prev;
+
+	if ((header_len > CONFIG_MQTT_INFLIGHT_MAX_MESSAGE_LENGTH) ||
+	    (payload_len > CONFIG_MQTT_INFLIGHT_MAX_MESSAGE_LENGTH -
+			   header_len)) {
+		return -EMSGSIZE;
+	}
+
+	/* Message with the same id is replaced in place, for example PUBLISH
+	 * by PUBREL, so that it keeps its position in the sending order.
+	 */
+	msg = inflight_find(client, message_id, &prev);
+	if (msg == NULL) {
+		if (k_mem_slab_alloc(&inflight_slab, (void **)&msg,
+				     K_NO_WAIT) != 0) {
+			return -ENOMEM;
+		}
+
+		sys_slist_append(&inflight_list, &msg->node);
+	}
+
+	msg->client = client;
+	msg->message_id = message_id;
+	msg->queued = false;
+	msg->timestamp = mqtt_sys_tick_in_ms_get();
+	msg->len = header_len + payload_len;
+	memcpy(msg->data, header, header_len);
+	if (payload_len > 0) {
+		memcpy(msg->data + header_len, payload, payload_len);
+	}
+
+	/* Stored copy is only used for retransmissions. */
+	if ((msg->data[0] & 0xF0) == MQTT_PKT_TYPE_PUBLISH) {
+		msg->data[0] |= MQTT_HEADER_DUP_MASK;
+	}
+
+	return 0;
+}
+
+int mqtt_inflight_add(struct mqtt_client *client, u16_t message_id,
+		      const u8_t *header, u32_t header_len,
+		      const u8_t *payload, u32_t payload_len)
+{
+	struct inflight_msg *msg;
+	struct inflight_msg *prev;
+	int err_code;
+
+	mqtt_mutex_lock();
+
+	err_code = inflight_put(client, message_id, header, header_len,
+				payload, payload_len);
+	if (err_code != 0) {
+		mqtt_mutex_unlock();
+
+		MQTT_ERR("Cannot store message id 0x%04x, error %d",
+			 message_id, err_code);
+		return err_code;
+	}
+
+	if (inflight_storage != NULL) {
+		msg = inflight_find(client, message_id, &prev);
+		err_code = inflight_storage->store(&client->client_id,
+						   message_id, msg->data,
+						   msg->len);
+		if (err_code != 0) {
+			/* Message is still retransmitted until reset. */
+			MQTT_ERR("Cannot store message id 0x%04x persistently,"
+				 " error %d", message_id, err_code);
+		}
+	}
+
+	mqtt_mutex_unlock();
+
+	return 0;
+}
+
+void mqtt_inflight_remove(struct mqtt_client *client, u16_t message_id)
+{
+	struct inflight_msg *msg;
+	struct inflight_msg *prev;
+
+	mqtt_mutex_lock();
+
+	msg = inflight_find(client, message_id, &prev);
+	if (msg != NULL) {
+		MQTT_TRC("[%p]: Message id 0x%04x acknowledged.", client,
+			 message_id);
+
+		inflight_free(msg, prev);
+
+		if (inflight_storage != NULL) {
+			inflight_storage->remove(&client->client_id,
+						 message_id);
+		}
+	}
+
+	mqtt_mutex_unlock();
+}
+
+void mqtt_inflight_clear(struct mqtt_client *client)
+{
+	struct inflight_msg *msg;
+	struct inflight_msg *tmp;
+	struct inflight_msg *prev = NULL;
+
+	mqtt_mutex_lock();
+
+	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&inflight_list, msg, tmp, node) {
+		if (msg->client != client) {
+			prev = msg;
+			continue;
+		}
+
+		if (inflight_storage != NULL) {
+			inflight_storage->remove(&client->client_id,
+						 msg->message_id);
+		}
+
+		inflight_free(msg, prev);
+	}
+
+	mqtt_mutex_unlock();
+}
+
+void mqtt_inflight_load(struct mqtt_client *client)
+{
+	if ((inflight_storage != NULL) && (inflight_storage->load != NULL)) {
+		inflight_storage->load(client);
+	}
+}
+
+static int inflight_send_due(struct mqtt_client *client,
+			     struct inflight_msg **due, size_t due_count)
+{
+	int err_code = 0;
+
+	/* Messages are sent without the module mutex, so that a blocking
+	 * write does not stall the other clients. The messages of the client
+	 * are only changed or freed with the client mutex held, which the
+	 * caller holds.
+	 */
+	for (size_t i = 0; i < due_count; i++) {
+		err_code = inflight_send(client, due[i]);
+		if (err_code != 0) {
+			break;
+		}
+	}
+
+	return err_code;
+}
+
+int mqtt_inflight_resend(struct mqtt_client *client, bool all)
+{
+	struct inflight_msg *due[CONFIG_MQTT_INFLIGHT_MAX_MESSAGES];
+	struct inflight_msg *msg;
+	size_t due_count = 0;
+
+	if (!all && (INFLIGHT_RETRY_TIMEOUT_MS == 0)) {
+		return 0;
+	}
+
+	mqtt_mutex_lock();
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&inflight_list, msg, node) {
+		if (msg->client != client) {
+			continue;
+		}
+
+		if (all) {
+			/* Replayed messages take a slot of the server Receive
+			 * Maximum each, the ones over it wait for a slot to be
+			 * returned.
+			 */
+			msg->queued = mqtt_is_v5(client) &&
+				      (mqtt_v5_send_quota_take(client) != 0);
+			if (msg->queued) {
+				continue;
+			}
+		} else if (msg->queued ||
+			   (mqtt_elapsed_time_in_ms_get(msg->timestamp) <
+			    INFLIGHT_RETRY_TIMEOUT_MS)) {
+			continue;
+		}
+
+		due[due_count++] = msg;
+	}
+
+	mqtt_mutex_unlock();
+
+	return inflight_send_due(client, due, due_count);
+}
+
+int mqtt_inflight_send_queued(struct mqtt_client *client)
+{
+	struct inflight_msg *due[CONFIG_MQTT_INFLIGHT_MAX_MESSAGES];
+	struct inflight_msg *msg;
+	size_t due_count = 0;
+
+	/* Messages are only queued for the MQTT 5.0 Receive Maximum. */
+	if (!mqtt_is_v5(client)) {
+		return 0;
+	}
+
+	mqtt_mutex_lock();
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&inflight_list, msg, node) {
+		if ((msg->client != client) || !msg->queued) {
+			continue;
+		}
+
+		if (mqtt_v5_send_quota_take(client) != 0) {
+			break;
+		}
+
+		msg->queued = false;
+		due[due_count++] = msg;
+	}
+
+	mqtt_mutex_unlock();
+
+	return inflight_send_due(client, due, due_count);
+}
+
+s32_t mqtt_inflight_timeout_get(struct mqtt_client *client)
+{
+	struct inflight_msg *msg;
+	s32_t timeout = K_FOREVER;
+	s32_t remaining;
+
+	if (INFLIGHT_RETRY_TIMEOUT_MS == 0) {
+		return K_FOREVER;
+	}
+
+	mqtt_mutex_lock();
+
+	/* Messages are kept in order of sending, except for the ones replaced
+	 * in place, so all of the client messages are checked.
+	 */
+	SYS_SLIST_FOR_EACH_CONTAINER(&inflight_list, msg, node) {
+		if ((msg->client != client) || msg->queued) {
+			continue;
+		}
+
+		remaining = INFLIGHT_RETRY_TIMEOUT_MS -
+			    mqtt_elapsed_time_in_ms_get(msg->timestamp);
+		if (remaining <= 0) {
+			timeout = K_NO_WAIT;
+			break;
+		}
+
+		if ((timeout == K_FOREVER) || (remaining < timeout)) {
+			timeout = remaining;
+		}
+	}
+
+	mqtt_mutex_unlock();
+
+	return timeout;
+}
+
+void mqtt_inflight_storage_set(const struct mqtt_inflight_storage *storage)
+{
+	mqtt_mutex_lock();
+
+	inflight_storage = storage;
+
+	mqtt_mutex_unlock();
+}
+
+int mqtt_inflight_restore(struct mqtt_client *client, u16_t message_id,
+			  const u8_t *data, u32_t len)
+{
+	int err_code;
+
+	NULL_PARAM_CHECK(client);
+	NULL_PARAM_CHECK(data);
+
+	if (len < MQTT_FIXED_HEADER_SIZE) {
+		return -EINVAL;
+	}
+
+	mqtt_mutex_lock();
+
+	err_code = inflight_put(client, message_id, data, len, NULL, 0);
+
+	mqtt_mutex_unlock();
+
+	return err_code;
+}
+
+u32_t mqtt_inflight_count(const struct mqtt_client *client)
+{
+	struct inflight_msg *msg;
+	u32_t count = 0;
+
+	mqtt_mutex_lock();
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&inflight_list, msg, node) {
+		if (msg->client == client) {
+			count++;
+		}
+	}
+
+	mqtt_mutex_unlock();
+
+	return count;
+}
@@ -73,6 +73,41 @@ extern "C" {
 
 #define MQTT_CONNACK_FLAG_SESSION_PRESENT 0x01
 
+/**@brief MQTT 5.0 property identifiers. */
+#define MQTT_PROP_PAYLOAD_FORMAT_INDICATOR      0x01
+#define MQTT_PROP_MESSAGE_EXPIRY_INTERVAL       0x02
+#define MQTT_PROP_CONTENT_TYPE                  0x03
+#define MQTT_PROP_RESPONSE_TOPIC                0x08
+#define MQTT_PROP_CORRELATION_DATA              0x09
+#define MQTT_PROP_SUBSCRIPTION_IDENTIFIER       0x0B
+#define MQTT_PROP_SESSION_EXPIRY_INTERVAL       0x11
+#define MQTT_PROP_ASSIGNED_CLIENT_IDENTIFIER    0x12
+#define MQTT_PROP_SERVER_KEEP_ALIVE             0x13
+#define MQTT_PROP_AUTHENTICATION_METHOD         0x15
+#define MQTT_PROP_AUTHENTICATION_DATA           0x16
+#define MQTT_PROP_REQUEST_PROBLEM_INFORMATION   0x17
+#define MQTT_PROP_WILL_DELAY_INTERVAL           0x18
+#define MQTT_PROP_REQUEST_RESPONSE_INFORMATION  0x19
+#define MQTT_PROP_RESPONSE_INFORMATION          0x1A
+#define MQTT_PROP_SERVER_REFERENCE              0x1C
+#define MQTT_PROP_REASON_STRING                 0x1F
+#define MQTT_PROP_RECEIVE_MAXIMUM               0x21
+#define MQTT_PROP_TOPIC_ALIAS_MAXIMUM           0x22
+#define MQTT_PROP_TOPIC_ALIAS                   0x23
+#define MQTT_PROP_MAXIMUM_QOS                   0x24
+#define MQTT_PROP_RETAIN_AVAILABLE              0x25
+#define MQTT_PROP_USER_PROPERTY                 0x26
+#define MQTT_PROP_MAXIMUM_PACKET_SIZE           0x27
+#define MQTT_PROP_WILDCARD_SUBSCRIPTION_AVAILABLE 0x28
+#define MQTT_PROP_SUBSCRIPTION_IDENTIFIER_AVAILABLE 0x29
+#define MQTT_PROP_SHARED_SUBSCRIPTION_AVAILABLE 0x2A
+
+/**@brief Receive Maximum assumed when the server does not send one. */
+#define MQTT_RECEIVE_MAXIMUM_DEFAULT 0xFFFF
+
+/**@brief Session Expiry Interval of a session that does not expire. */
+#define MQTT_SESSION_EXPIRY_NEVER 0xFFFFFFFF
+
 /**@brief Size of mandatory header of MQTT packet. */
 #define MQTT_PKT_HEADER_SIZE 2
 
@@ -166,6 +201,18 @@ enum mqtt_state {
 	MQTT_STATE_DISCONNECTING        = 0x00000010
 };
 
+/**@brief Checks if the client uses MQTT 5.0.
+ *
+ * @param[in] client Identifies the client.
+ *
+ * @retval true if MQTT 5.0 support is enabled and used by the client.
+ */
+static inline bool mqtt_is_v5(const struct mqtt_client *client)
+{
+	return IS_ENABLED(CONFIG_MQTT_LIB_V5) &&
+	       (client->protocol_version == MQTT_VERSION_5_0);
+}
+
 /**@brief Notify application about MQTT event.
  *
  * @param[in] client Identifies the client for which event occurred.
@@ -188,6 +235,163 @@ void event_notify(struct mqtt_client *client, const struct mqtt_evt *evt,
 u32_t mqtt_handle_rx_data(struct mqtt_client *client, u8_t *data,
 			  u32_t datalen);
 
+/**@brief Stores a copy of an in-flight message until it is acknowledged.
+ *        A message of the client with the same message id is replaced.
+ *
+ * @param[in] client Identifies the client which sends the message.
+ * @param[in] message_id Message id.
+ * @param[in] header Encoded message, or its header if payload is sent
+ *                   separately.
+ * @param[in] header_len Length of the encoded message or its header.
+ * @param[in] payload Payload sent after the header. Can be NULL.
+ * @param[in] payload_len Length of the payload.
+ *
+ * @retval 0 if the procedure is successful.
+ * @retval -EMSGSIZE if the message is too long to be stored.
+ * @retval -ENOMEM if there is no room for another in-flight message.
+ */
+int mqtt_inflight_add(struct mqtt_client *client, u16_t message_id,
+		      const u8_t *header, u32_t header_len,
+		      const u8_t *payload, u32_t payload_len);
+
+/**@brief Removes an acknowledged message from the in-flight store.
+ *
+ * @param[in] client Identifies the client which sent the message.
+ * @param[in] message_id Message id.
+ */
+void mqtt_inflight_remove(struct mqtt_client *client, u16_t message_id);
+
+/**@brief Removes all in-flight messages of the client.
+ *
+ * @param[in] client Identifies the client.
+ */
+void mqtt_inflight_clear(struct mqtt_client *client);
+
+/**@brief Loads in-flight messages of the client from the persistent storage.
+ *
+ * @param[in] client Identifies the client.
+ */
+void mqtt_inflight_load(struct mqtt_client *client);
+
+/**@brief Sends in-flight messages of the client again.
+ *
+ * @note Shall be called with the client mutex held, the module mutex is not
+ *       held while the messages are written.
+ *
+ * @param[in] client Identifies the client.
+ * @param[in] all Send all messages if true, only the ones that were not
+ *                acknowledged within the retransmission timeout otherwise.
+ *                With MQTT 5.0, all messages are sent after connecting, and
+ *                take a slot of the server Receive Maximum each. Messages
+ *                over the Receive Maximum are queued.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int mqtt_inflight_resend(struct mqtt_client *client, bool all);
+
+/**@brief Sends queued in-flight messages of the client, as long as slots of
+ *        the server Receive Maximum are free.
+ *
+ * @note Shall be called with the client mutex held.
+ *
+ * @param[in] client Identifies the client.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int mqtt_inflight_send_queued(struct mqtt_client *client);
+
+/**@brief Gets time until the next retransmission of the client messages.
+ *
+ * @param[in] client Identifies the client.
+ *
+ * @return Time in milliseconds or K_FOREVER if nothing is to be sent again.
+ */
+s32_t mqtt_inflight_timeout_get(struct mqtt_client *client);
+
+/**@brief Appends an encoded message to the batch of the client.
+ *
+ * @param[in] client Identifies the client.
+ * @param[in] header Encoded message without the payload.
+ * @param[in] header_len Length of the header.
+ * @param[in] payload Payload of the message, can be NULL.
+ * @param[in] payload_len Length of the payload.
+ *
+ * @return 0 if the message was added, -ENOSPC if it does not fit in the free
+ *         space of the batch buffer, -ENOMEM if no buffer is available.
+ */
+int mqtt_batch_append(struct mqtt_client *client, const u8_t *header,
+		      u32_t header_len, const u8_t *payload, u32_t payload_len);
+
+/**@brief Sends all messages of the batch with a single transport write.
+ *
+ * @param[in] client Identifies the client.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int mqtt_batch_flush(struct mqtt_client *client);
+
+/**@brief Drops the messages of the batch and releases the batch buffer.
+ *
+ * @param[in] client Identifies the client.
+ */
+void mqtt_batch_drop(struct mqtt_client *client);
+
+/**@brief Gets time until the batch of the client shall be sent.
+ *
+ * @param[in] client Identifies the client.
+ *
+ * @return Time in milliseconds or K_FOREVER if there is nothing to send.
+ */
+s32_t mqtt_batch_timeout_get(struct mqtt_client *client);
+
+/**@brief Sets up MQTT 5.0 flow control and topic aliases for a connection
+ *        accepted by the server.
+ *
+ * @param[in] client Identifies the client.
+ * @param[in] param Decoded Connect Ack parameters.
+ */
+void mqtt_v5_connected(struct mqtt_client *client,
+		       const struct mqtt_connack_param *param);
+
+/**@brief Takes a slot of the server Receive Maximum for a QoS 1 or QoS 2
+ *        PUBLISH message.
+ *
+ * @param[in] client Identifies the client.
+ *
+ * @return 0 if the message can be sent, -EAGAIN if as many messages as the
+ *         server accepts are waiting for acknowledgment.
+ */
+int mqtt_v5_send_quota_take(struct mqtt_client *client);
+
+/**@brief Returns a slot of the server Receive Maximum when a QoS 1 or QoS 2
+ *        message flow completes. The quota never exceeds the Receive
+ *        Maximum received in the CONNACK.
+ *
+ * @param[in] client Identifies the client.
+ */
+void mqtt_v5_send_quota_give(struct mqtt_client *client);
+
+/**@brief Looks up the topic alias of a topic.
+ *
+ * @param[in] client Identifies the client.
+ * @param[in] topic Topic of a message to send.
+ * @param[out] alias Alias of the topic, or a free alias which can be set for
+ *                   the topic. 0 if no alias can be used.
+ *
+ * @retval true if the alias is already set for the topic on the connection.
+ */
+bool mqtt_v5_topic_alias_find(const struct mqtt_client *client,
+			      const struct mqtt_utf8 *topic, u16_t *alias);
+
+/**@brief Sets a topic alias once a message establishing it is encoded.
+ *
+ * @param[in] client Identifies the client.
+ * @param[in] alias Free alias returned by @ref mqtt_v5_topic_alias_find.
+ * @param[in] topic Topic to set the alias for.
+ */
+void mqtt_v5_topic_alias_set(struct mqtt_client *client, u16_t alias,
+			     const struct mqtt_utf8 *topic);
+
 /**@brief Constructs/encodes Connect packet.
  *
  * @param[in] client Identifies the client for which the procedure is requested.
@@ -203,18 +407,22 @@ u32_t mqtt_handle_rx_data(struct mqtt_client *client, u8_t *data,
 int connect_request_encode(const struct mqtt_client *client,
 			   const u8_t **packet, u32_t *packet_length);
 
-/**@brief Constructs/encodes Publish packet.
+/**@brief Constructs/encodes Publish packet header.
+ *
+ * Only the fixed header, topic and message id are encoded. The message
+ * payload is not copied, it shall be sent right after the header.
+ * With MQTT 5.0, a topic alias is used for the topic when possible.
  *
  * @param[in] client Identifies the client for which packet is encoded.
    @param[in] param Publish message parameters.
- * @param[out] packet Pointer to the MQTT Publish message.
- * @param[out] packet_length Length of the Publish message.
+ * @param[out] packet Pointer to the MQTT Publish message header.
+ * @param[out] packet_length Length of the Publish message header.
  *
  * @return 0 if the procedure is successful, an error code otherwise.
  */
-int publish_encode(const struct mqtt_client *client,
-		   const struct mqtt_publish_param *param,
-		   const u8_t **packet, u32_t *packet_length);
+int publish_header_encode(struct mqtt_client *client,
+			  const struct mqtt_publish_param *param,
+			  const u8_t **packet, u32_t *packet_length);
 
 /**@brief Constructs/encodes Publish Ack packet.
  *
@@ -346,8 +554,23 @@ int connect_ack_decode(const struct mqtt_client *client, u8_t *data,
 		       u32_t datalen, u32_t offset,
 		       struct mqtt_connack_param *param);
 
+/**@brief Decode MQTT Publish packet header, without the payload.
+ *
+ * @param[in] client MQTT client for which packet is decoded.
+ * @param[in] data Buffer containing message to decode.
+ * @param[in] datalen Length of the message available in the buffer.
+ * @param[inout] offset Offset of the first byte after MQTT fixed header as
+ *                      input, offset of the first payload byte as output.
+ * @param[out] param Pointer to buffer for decoded Publish parameters.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int publish_header_decode(const struct mqtt_client *client, u8_t *data, u32_t datalen, u32_t *offset,
+			  struct mqtt_publish_param *param);
+
 /**@brief Decode MQTT Publish packet.
  *
+ * @param[in] client MQTT client for which packet is decoded.
  * @param[in] data Buffer containing message to decode.
  * @param[in] datalen Length of the message.
  * @param[in] offset Offset of the first byte after MQTT fixed header.
@@ -355,7 +578,8 @@ int connect_ack_decode(const struct mqtt_client *client, u8_t *data,
  *
  * @return 0 if the procedure is successful, an error code otherwise.
  */
-int publish_decode(u8_t *data, u32_t datalen, u32_t offset,
+int publish_decode(const struct mqtt_client *client, u8_t *data,
+		   u32_t datalen, u32_t offset,
 		   struct mqtt_publish_param *param);
 
 /**@brief Decode MQTT Publish Ack packet.
@@ -408,6 +632,7 @@ int publish_complete_decode(u8_t *data, u32_t datalen, u32_t offset,
 
 /**@brief Decode MQTT Subscribe packet.
  *
+ * @param[in] client MQTT client for which packet is decoded.
  * @param[in] data Buffer containing message to decode.
  * @param[in] datalen Length of the message.
  * @param[in] offset Offset of the first byte after MQTT fixed header.
@@ -415,7 +640,8 @@ int publish_complete_decode(u8_t *data, u32_t datalen, u32_t offset,
  *
  * @return 0 if the procedure is successful, an error code otherwise.
  */
-int subscribe_ack_decode(u8_t *data, u32_t datalen, u32_t offset,
+int subscribe_ack_decode(const struct mqtt_client *client, u8_t *data,
+			 u32_t datalen, u32_t offset,
 			 struct mqtt_suback_param *param);
 
 /**@brief Decode MQTT Unsubscribe packet.
@@ -64,6 +64,36 @@ static inline void mqtt_mutex_unlock(void)
 	k_mutex_unlock(&mqtt_mutex);
 }
 
+/**@brief Initialize the mutex of a client instance.
+ *
+ * @param[in] client Client instance to initialize the mutex of.
+ */
+static inline void mqtt_client_lock_init(struct mqtt_client *client)
+{
+	k_mutex_init(&client->lock);
+}
+
+/**@brief Acquire lock on the mutex of a client instance.
+ *
+ * @details When both are needed, the client mutex shall be acquired before
+ *          the module specific mutex.
+ *
+ * @param[in] client Client instance to lock.
+ */
+static inline void mqtt_client_lock(struct mqtt_client *client)
+{
+	(void)k_mutex_lock(&client->lock, K_FOREVER);
+}
+
+/**@brief Release the lock on the mutex of a client instance.
+ *
+ * @param[in] client Client instance to unlock.
+ */
+static inline void mqtt_client_unlock(struct mqtt_client *client)
+{
+	k_mutex_unlock(&client->lock);
+}
+
 /**@brief Method to allocate memory for internal use in the module.
  *
  * @param[in] size Size of memory requested.
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/** @file mqtt_router.c
+ *
+ * @brief Routing of received PUBLISH messages to subscription handlers.
+ */
+
+#include <net/mqtt_socket.h>
+
+#include "mqtt_internal.h"
+
+#define ROOT_NODE 0
+
+static u32_t level_len_get(const u8_t *topic, u32_t offset, u32_t size)
+{
+	u32_t end = offset;
+
+	while ((end < size) && (topic[end] != '/')) {
+		end++;
+	}
+
+	return end - offset;
+}
+
+static bool level_equal(const struct mqtt_router_node *node,
+			const u8_t *level, u32_t len)
+{
+	return (node->level_len == len) &&
+	       (memcmp(node->level, level, len) == 0);
+}
+
+static bool level_is_wildcard(const struct mqtt_router_node *node,
+			      u8_t wildcard)
+{
+	return (node->level_len == 1) && (node->level[0] == wildcard);
+}
+
+static u16_t child_find(const struct mqtt_router *router, u16_t parent,
+			const u8_t *level, u32_t len)
+{
+	for (u16_t index = router->nodes[parent].child; index != 0;
+	     index = router->nodes[index].sibling) {
+		if (level_equal(&router->nodes[index], level, len)) {
+			return index;
+		}
+	}
+
+	return 0;
+}
+
+static u16_t child_add(struct mqtt_router *router, u16_t parent,
+		       const u8_t *level, u32_t len)
+{
+	for (u16_t index = ROOT_NODE + 1; index < router->node_count;
+	     index++) {
+		struct mqtt_router_node *node = &router->nodes[index];
+
+		if (node->level == NULL) {
+			memset(node, 0, sizeof(*node));
+			node->level = level;
+			node->level_len = len;
+			node->sibling = router->nodes[parent].child;
+			router->nodes[parent].child = index;
+
+			return index;
+		}
+	}
+
+	return 0;
+}
+
+/**@brief Frees the subtree nodes which are not a part of any route. */
+static void prune(struct mqtt_router *router, u16_t parent)
+{
+	u16_t *link = &router->nodes[parent].child;
+
+	while (*link != 0) {
+		struct mqtt_router_node *node = &router->nodes[*link];
+
+		prune(router, *link);
+
+		if ((node->child == 0) && (node->handler == NULL)) {
+			*link = node->sibling;
+			node->level = NULL;
+		} else {
+			link = &node->sibling;
+		}
+	}
+}
+
+static int filter_validate(const struct mqtt_utf8 *filter)
+{
+	u32_t offset = 0;
+	u32_t len;
+
+	if ((filter->utf8 == NULL) || (filter->size == 0)) {
+		return -EINVAL;
+	}
+
+	for (;;) {
+		len = level_len_get(filter->utf8, offset, filter->size);
+
+		for (u32_t i = offset; i < offset + len; i++) {
+			u8_t c = filter->utf8[i];
+
+			/* Wildcard shall take the whole level and '#' shall
+			 * be the last level.
+			 */
+			if (((c == '+') || (c == '#')) && (len != 1)) {
+				return -EINVAL;
+			}
+
+			if ((c == '#') && (offset + len != filter->size)) {
+				return -EINVAL;
+			}
+		}
+
+		offset += len;
+		if (offset >= filter->size) {
+			return 0;
+		}
+
+		/* Skip the separator. */
+		offset++;
+	}
+}
+
+/**@brief Finds the node of the last filter level, 0 if not found. */
+static u16_t filter_find(const struct mqtt_router *router,
+			 const struct mqtt_utf8 *filter)
+{
+	u16_t node = ROOT_NODE;
+	u32_t offset = 0;
+	u32_t len;
+
+	for (;;) {
+		len = level_len_get(filter->utf8, offset, filter->size);
+		node = child_find(router, node, filter->utf8 + offset, len);
+		if (node == 0) {
+			return 0;
+		}
+
+		offset += len;
+		if (offset >= filter->size) {
+			return node;
+		}
+
+		offset++;
+	}
+}
+
+static u32_t route_call(const struct mqtt_router *router, u16_t node,
+			struct mqtt_client *client,
+			const struct mqtt_publish_param *param)
+{
+	const struct mqtt_router_node *route = &router->nodes[node];
+
+	if (route->handler == NULL) {
+		return 0;
+	}
+
+	route->handler(client, param, route->user_data);
+
+	return 1;
+}
+
+/**@brief Matches children of the node with the topic level at offset and
+ *        calls handlers of the routes matching the whole topic.
+ */
+static u32_t route_match(const struct mqtt_router *router, u16_t parent,
+			 u32_t offset, struct mqtt_client *client,
+			 const struct mqtt_publish_param *param)
+{
+	const u8_t *topic = param->message.topic.topic.utf8;
+	const u32_t size = param->message.topic.topic.size;
+	const u32_t len = level_len_get(topic, offset, size);
+	/* Wildcards do not match the first level of topics beginning with
+	 * '$', which are reserved for the server.
+	 */
+	const bool wildcards = (parent != ROOT_NODE) || (topic[0] != '$');
+	u32_t count = 0;
+
+	for (u16_t index = router->nodes[parent].child; index != 0;
+	     index = router->nodes[index].sibling) {
+		const struct mqtt_router_node *node = &router->nodes[index];
+
+		if (wildcards && level_is_wildcard(node, '#')) {
+			count += route_call(router, index, client, param);
+			continue;
+		}
+
+		if (!(wildcards && level_is_wildcard(node, '+')) &&
+		    !level_equal(node, topic + offset, len)) {
+			continue;
+		}
+
+		if (offset + len < size) {
+			count += route_match(router, index, offset + len + 1,
+					     client, param);
+			continue;
+		}
+
+		count += route_call(router, index, client, param);
+
+		/* Filter "a/#" matches topic "a" as well. */
+		for (u16_t child = node->child; child != 0;
+		     child = router->nodes[child].sibling) {
+			if (level_is_wildcard(&router->nodes[child], '#')) {
+				count += route_call(router, child, client,
+						    param);
+			}
+		}
+	}
+
+	return count;
+}
+
+void mqtt_router_init(struct mqtt_router *router,
+		      struct mqtt_router_node *nodes, u16_t node_count)
+{
+	NULL_PARAM_CHECK_VOID(router);
+	NULL_PARAM_CHECK_VOID(nodes);
+
+	memset(nodes, 0, node_count * sizeof(*nodes));
+
+	router->nodes = nodes;
+	router->node_count = node_count;
+}
+
+int mqtt_router_add(struct mqtt_router *router,
+		    const struct mqtt_utf8 *filter,
+		    mqtt_route_handler_t handler, void *user_data)
+{
+	u16_t node = ROOT_NODE;
+	u32_t offset = 0;
+	u16_t child;
+	u32_t len;
+	int err_code;
+
+	NULL_PARAM_CHECK(router);
+	NULL_PARAM_CHECK(filter);
+	NULL_PARAM_CHECK(handler);
+
+	err_code = filter_validate(filter);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	for (;;) {
+		len = level_len_get(filter->utf8, offset, filter->size);
+
+		child = child_find(router, node, filter->utf8 + offset, len);
+		if (child == 0) {
+			child = child_add(router, node, filter->utf8 + offset,
+					  len);
+		}
+
+		if (child == 0) {
+			/* Release levels added for this filter. */
+			prune(router, ROOT_NODE);
+			return -ENOMEM;
+		}
+
+		node = child;
+		offset += len;
+		if (offset >= filter->size) {
+			break;
+		}
+
+		offset++;
+	}
+
+	if (router->nodes[node].handler != NULL) {
+		return -EEXIST;
+	}
+
+	router->nodes[node].handler = handler;
+	router->nodes[node].user_data = user_data;
+
+	return 0;
+}
+
+int mqtt_router_remove(struct mqtt_router *router,
+		       const struct mqtt_utf8 *filter)
+{
+	u16_t node;
+
+	NULL_PARAM_CHECK(router);
+	NULL_PARAM_CHECK(filter);
+	NULL_PARAM_CHECK(filter->utf8);
+
+	node = filter_find(router, filter);
+	if ((node == 0) || (router->nodes[node].handler == NULL)) {
+		return -ENOENT;
+	}
+
+	router->nodes[node].handler = NULL;
+	router->nodes[node].user_data = NULL;
+
+	prune(router, ROOT_NODE);
+
+	return 0;
+}
+
+int mqtt_router_dispatch(const struct mqtt_router *router,
+			 struct mqtt_client *client,
+			 const struct mqtt_publish_param *param)
+{
+	NULL_PARAM_CHECK(router);
+	NULL_PARAM_CHECK(param);
+
+	if ((param->message.topic.topic.utf8 == NULL) ||
+	    (param->message.topic.topic.size == 0)) {
+		return -EINVAL;
+	}
+
+	return route_match(router, ROOT_NODE, 0, client, param);
+}
@@ -15,6 +15,19 @@ LOG_MODULE_REGISTER(net_mqtt_rx, CONFIG_MQTT_SOCKET_LOG_LEVEL);
  * @brief MQTT Received data handling.
  */
 
+/* Returns a slot of the server Receive Maximum, taken by the next queued
+ * in-flight message if there is one.
+ */
+static void send_quota_give(struct mqtt_client *client)
+{
+	mqtt_v5_send_quota_give(client);
+
+	if (IS_ENABLED(CONFIG_MQTT_INFLIGHT)) {
+		/* A write failure is detected by the next read. */
+		(void)mqtt_inflight_send_queued(client);
+	}
+}
+
 static int mqtt_handle_packet(struct mqtt_client *client, u8_t *data,
 			      u32_t datalen, u32_t offset)
 {
@@ -41,6 +54,17 @@ static int mqtt_handle_packet(struct mqtt_client *client, u8_t *data,
 						MQTT_CONNECTION_ACCEPTED) {
 				/* Set state. */
 				MQTT_SET_STATE(client, MQTT_STATE_CONNECTED);
+
+				if (mqtt_is_v5(client)) {
+					mqtt_v5_connected(client,
+							  &evt.param.connack);
+				}
+
+				if (IS_ENABLED(CONFIG_MQTT_INFLIGHT)) {
+					/* Replay unacknowledged messages. */
+					(void)mqtt_inflight_resend(client,
+								   true);
+				}
 			}
 
 			evt.result = evt.param.connack.return_code;
@@ -54,7 +78,7 @@ static int mqtt_handle_packet(struct mqtt_client *client, u8_t *data,
 		MQTT_TRC("[CID %p]: Received MQTT_PKT_TYPE_PUBLISH", client);
 
 		evt.type = MQTT_EVT_PUBLISH;
-		err_code = publish_decode(data, datalen, offset,
+		err_code = publish_decode(client, data, datalen, offset,
 					  &evt.param.publish);
 		evt.result = err_code;
 
@@ -72,6 +96,15 @@ static int mqtt_handle_packet(struct mqtt_client *client, u8_t *data,
 		err_code = publish_ack_decode(data, datalen, offset,
 					      &evt.param.puback);
 		evt.result = err_code;
+
+		if (IS_ENABLED(CONFIG_MQTT_INFLIGHT) && (err_code == 0)) {
+			mqtt_inflight_remove(client,
+					     evt.param.puback.message_id);
+		}
+
+		if (mqtt_is_v5(client) && (err_code == 0)) {
+			send_quota_give(client);
+		}
 		break;
 
 	case MQTT_PKT_TYPE_PUBREC:
@@ -81,6 +114,18 @@ static int mqtt_handle_packet(struct mqtt_client *client, u8_t *data,
 		err_code = publish_receive_decode(data, datalen, offset,
 						  &evt.param.pubrec);
 		evt.result = err_code;
+
+		/* Message flow ends with a PUBREC indicating a failure. */
+		if (mqtt_is_v5(client) && (err_code == 0) &&
+		    (evt.param.pubrec.reason_code >=
+					MQTT_REASON_UNSPECIFIED_ERROR)) {
+			if (IS_ENABLED(CONFIG_MQTT_INFLIGHT)) {
+				mqtt_inflight_remove(
+					client, evt.param.pubrec.message_id);
+			}
+
+			send_quota_give(client);
+		}
 		break;
 
 	case MQTT_PKT_TYPE_PUBREL:
@@ -99,13 +144,22 @@ static int mqtt_handle_packet(struct mqtt_client *client, u8_t *data,
 		err_code = publish_complete_decode(data, datalen, offset,
 						   &evt.param.pubcomp);
 		evt.result = err_code;
+
+		if (IS_ENABLED(CONFIG_MQTT_INFLIGHT) && (err_code == 0)) {
+			mqtt_inflight_remove(client,
+					     evt.param.pubcomp.message_id);
+		}
+
+		if (mqtt_is_v5(client) && (err_code == 0)) {
+			send_quota_give(client);
+		}
 		break;
 
 	case MQTT_PKT_TYPE_SUBACK:
 		MQTT_TRC("[CID %p]: Received MQTT_PKT_TYPE_SUBACK!", client);
 
 		evt.type = MQTT_EVT_SUBACK;
-		err_code = subscribe_ack_decode(data, datalen, offset,
+		err_code = subscribe_ack_decode(client, data, datalen, offset,
 						&evt.param.suback);
 		evt.result = err_code;
 		break;
@@ -139,6 +193,41 @@ static int mqtt_handle_packet(struct mqtt_client *client, u8_t *data,
 	return err_code;
 }
 
+static u32_t mqtt_handle_publish_stream(struct mqtt_client *client,
+					u8_t *data, u32_t datalen,
+					u32_t offset, u32_t packet_length)
+{
+	struct mqtt_evt evt;
+	int err_code;
+
+	evt.type = MQTT_EVT_PUBLISH;
+	err_code = publish_header_decode(client, data, datalen, &offset,
+					 &evt.param.publish);
+	if (err_code != 0) {
+		/* Header is not complete yet. It can only be completed if
+		 * there is room left in the RX buffer.
+		 */
+		return (datalen < MQTT_MAX_PACKET_LENGTH) ? 0 : packet_length;
+	}
+
+	MQTT_TRC("[CID %p]: Streaming PUBLISH payload of %08x bytes", client,
+		 packet_length - offset);
+
+	/* Part of the payload received so far is kept in the RX buffer, the
+	 * rest is read by the application directly from the transport.
+	 */
+	client->rx_payload_offset = offset;
+	client->remaining_payload = packet_length - offset;
+
+	evt.param.publish.message.payload.data = NULL;
+	evt.param.publish.message.payload.len = client->remaining_payload;
+	evt.result = 0;
+
+	event_notify(client, &evt, MQTT_EVT_FLAG_NONE);
+
+	return 0;
+}
+
 u32_t mqtt_handle_rx_data(struct mqtt_client *client, u8_t *data, u32_t datalen)
 {
 	int err_code = 0;
@@ -158,8 +247,24 @@ u32_t mqtt_handle_rx_data(struct mqtt_client *client, u8_t *data, u32_t datalen)
 		u32_t packet_length = offset + remaining_length;
 
 		if (packet_length > MQTT_MAX_PACKET_LENGTH) {
-			/* We receiving data we cannot handle. */
-			return packet_length;
+			if ((data[start] & 0xF0) != MQTT_PKT_TYPE_PUBLISH) {
+				/* We receiving data we cannot handle. */
+				return packet_length;
+			}
+
+			if (start > 0) {
+				/* Move the packet to the beginning of
+				 * the buffer first.
+				 */
+				return start;
+			}
+
+			/* Payload of a large PUBLISH message is read by
+			 * the application. The received data that remains
+			 * in the buffer is already handled.
+			 */
+			return mqtt_handle_publish_stream(client, data, datalen,
+							  offset, packet_length);
 		}
 
 		if (start + packet_length > datalen) {
@@ -15,8 +15,11 @@
 extern int mqtt_client_tcp_connect(struct mqtt_client *client);
 extern int mqtt_client_tcp_write(struct mqtt_client *client, const u8_t *data,
 				 u32_t datalen);
+extern int mqtt_client_tcp_write_msg(struct mqtt_client *client,
+				     const u8_t *header, u32_t header_len,
+				     const u8_t *payload, u32_t payload_len);
 extern int mqtt_client_tcp_read(struct mqtt_client *client, u8_t *data,
-				u32_t *datalen);
+				u32_t *datalen, bool shall_block);
 extern int mqtt_client_tcp_disconnect(struct mqtt_client *client);
 
 #if defined(CONFIG_MQTT_LIB_TLS)
@@ -24,8 +27,11 @@ extern int mqtt_client_tcp_disconnect(struct mqtt_client *client);
 extern int mqtt_client_tls_connect(struct mqtt_client *client);
 extern int mqtt_client_tls_write(struct mqtt_client *client, const u8_t *data,
 				 u32_t datalen);
+extern int mqtt_client_tls_write_msg(struct mqtt_client *client,
+				     const u8_t *header, u32_t header_len,
+				     const u8_t *payload, u32_t payload_len);
 extern int mqtt_client_tls_read(struct mqtt_client *client, u8_t *data,
-				u32_t *datalen);
+				u32_t *datalen, bool shall_block);
 extern int mqtt_client_tls_disconnect(struct mqtt_client *client);
 #endif /* CONFIG_MQTT_LIB_TLS */
 
@@ -34,6 +40,7 @@ const struct transport_procedure transport_fn[MQTT_TRANSPORT_NUM] = {
 	{
 		mqtt_client_tcp_connect,
 		mqtt_client_tcp_write,
+		mqtt_client_tcp_write_msg,
 		mqtt_client_tcp_read,
 		mqtt_client_tcp_disconnect,
 	},
@@ -41,6 +48,7 @@ const struct transport_procedure transport_fn[MQTT_TRANSPORT_NUM] = {
 	{
 		mqtt_client_tls_connect,
 		mqtt_client_tls_write,
+		mqtt_client_tls_write_msg,
 		mqtt_client_tls_read,
 		mqtt_client_tls_disconnect,
 	}
@@ -59,12 +67,38 @@ int mqtt_transport_write(struct mqtt_client *client, const u8_t *data,
 							  datalen);
 }
 
-int mqtt_transport_read(struct mqtt_client *client, u8_t *data, u32_t *datalen)
+int mqtt_transport_write_msg(struct mqtt_client *client, const u8_t *header,
+			     u32_t header_len, const u8_t *payload,
+			     u32_t payload_len)
 {
-	return transport_fn[client->transport.type].read(client, data, datalen);
+	return transport_fn[client->transport.type].write_msg(client, header,
+							      header_len,
+							      payload,
+							      payload_len);
+}
+
+int mqtt_transport_read(struct mqtt_client *client, u8_t *data, u32_t *datalen,
+			bool shall_block)
+{
+	return transport_fn[client->transport.type].read(client, data, datalen,
+							 shall_block);
 }
 
 int mqtt_transport_disconnect(struct mqtt_client *client)
 {
 	return transport_fn[client->transport.type].disconnect(client);
 }
+
+int mqtt_transport_sock_get(const struct mqtt_client *client)
+{
+	switch (client->transport.type) {
+	case MQTT_TRANSPORT_NON_SECURE:
+		return client->transport.tcp.sock;
+#if defined(CONFIG_MQTT_LIB_TLS)
+	case MQTT_TRANSPORT_SECURE:
+		return client->transport.tls.sock;
+#endif /* CONFIG_MQTT_LIB_TLS */
+	default:
+		return -1;
+	}
+}
@@ -25,9 +25,16 @@ typedef int (*transport_connect_handler_t)(struct mqtt_client *client);
 typedef int (*transport_write_handler_t)(struct mqtt_client *client,
 					 const u8_t *data, u32_t datalen);
 
+/**@brief Transport write message handler. */
+typedef int (*transport_write_msg_handler_t)(struct mqtt_client *client,
+					     const u8_t *header,
+					     u32_t header_len,
+					     const u8_t *payload,
+					     u32_t payload_len);
+
 /**@brief Transport read handler. */
 typedef int (*transport_read_handler_t)(struct mqtt_client *client, u8_t *data,
-					u32_t *datalen);
+					u32_t *datalen, bool shall_block);
 
 /**@brief Transport disconnect handler. */
 typedef int (*transport_disconnect_handler_t)(struct mqtt_client *client);
@@ -44,6 +51,12 @@ struct transport_procedure {
 	 */
 	transport_write_handler_t write;
 
+	/** Transport write message handler. Handles transport write of a
+	 *  header and a payload stored in separate buffers based on type of
+	 *  transport.
+	 */
+	transport_write_msg_handler_t write_msg;
+
 	/** Transport read handler. Handles transport read based on type of
 	 *  transport.
 	 */
@@ -74,16 +87,33 @@ int mqtt_transport_connect(struct mqtt_client *client);
 int mqtt_transport_write(struct mqtt_client *client, const u8_t *data,
 			 u32_t datalen);
 
+/**@brief Handles write message requests on configured transport.
+ *
+ * @param[in] client Identifies the client on which the procedure is requested.
+ * @param[in] header Header of the message to be written on the transport.
+ * @param[in] header_len Length of the header.
+ * @param[in] payload Payload of the message, written after the header.
+ * @param[in] payload_len Length of the payload.
+ *
+ * @retval 0 or an error code indicating reason for failure.
+ */
+int mqtt_transport_write_msg(struct mqtt_client *client, const u8_t *header,
+			     u32_t header_len, const u8_t *payload,
+			     u32_t payload_len);
+
 /**@brief Handles read requests on configured transport.
  *
  * @param[in] client Identifies the client on which the procedure is requested.
  * @param[in] data Pointer where read data is to be fetched.
  * @param[inout] datalen Size of memory provided for the operation as input,
  *                       received data length as output.
+ * @param[in] shall_block Information whether the read shall block until
+ *                        some data is available.
  *
  * @retval 0 or an error code indicating reason for failure.
  */
-int mqtt_transport_read(struct mqtt_client *client, u8_t *data, u32_t *datalen);
+int mqtt_transport_read(struct mqtt_client *client, u8_t *data, u32_t *datalen,
+			bool shall_block);
 
 /**@brief Handles transport disconnection requests on configured transport.
  *
@@ -93,6 +123,14 @@ int mqtt_transport_read(struct mqtt_client *client, u8_t *data, u32_t *datalen);
  */
 int mqtt_transport_disconnect(struct mqtt_client *client);
 
+/**@brief Gets the socket used by the configured transport.
+ *
+ * @param[in] client Identifies the client on which the procedure is requested.
+ *
+ * @retval Socket descriptor, negative if the transport has no socket.
+ */
+int mqtt_transport_sock_get(const struct mqtt_client *client);
+
 #ifdef __cplusplus
 }
 #endif
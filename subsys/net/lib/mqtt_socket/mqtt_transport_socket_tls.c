@@ -120,19 +120,50 @@ int mqtt_client_tls_write(struct mqtt_client *client, const u8_t *data,
 	return 0;
 }
 
+/**@brief Handles write message requests on TLS socket transport.
+ *
+ * Used for messages not fitting in the client TX buffer. The header and the
+ * payload are sent one after the other, without copying the payload.
+ *
+ * @param[in] client Identifies the client on which the procedure is requested.
+ * @param[in] header Header of the message to be written on the transport.
+ * @param[in] header_len Length of the header.
+ * @param[in] payload Payload of the message, written after the header.
+ * @param[in] payload_len Length of the payload.
+ *
+ * @retval 0 or an error code indicating reason for failure.
+ */
+int mqtt_client_tls_write_msg(struct mqtt_client *client, const u8_t *header,
+			     u32_t header_len, const u8_t *payload,
+			     u32_t payload_len)
+{
+	int err_code;
+
+	err_code = mqtt_client_tls_write(client, header, header_len);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	return mqtt_client_tls_write(client, payload, payload_len);
+}
+
 /**@brief Handles read requests on TLS socket transport.
  *
  * @param[in] client Identifies the client on which the procedure is requested.
  * @param[in] data Pointer where read data is to be fetched.
  * @param[in] datalen Size of memory provided for the operation.
+ * @param[in] shall_block Information whether the read shall block until
+ *                        some data is available.
  *
  * @retval 0 or an error code indicating reason for failure.
  */
-int mqtt_client_tls_read(struct mqtt_client *client, u8_t *data, u32_t *datalen)
+int mqtt_client_tls_read(struct mqtt_client *client, u8_t *data, u32_t *datalen,
+			 bool shall_block)
 {
+	int flags = shall_block ? 0 : MSG_DONTWAIT;
 	int ret;
 
-	ret = recv(client->transport.tls.sock, data, *datalen, MSG_DONTWAIT);
+	ret = recv(client->transport.tls.sock, data, *datalen, flags);
 	if (ret < 0) {
 		return -errno;
 	}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/** @file mqtt_v5.c
+ *
+ * @brief MQTT 5.0 flow control and topic aliases.
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_mqtt_v5, CONFIG_MQTT_SOCKET_LOG_LEVEL);
+
+#include <net/mqtt_socket.h>
+
+#include "mqtt_internal.h"
+#include "mqtt_os.h"
+
+void mqtt_v5_connected(struct mqtt_client *client,
+		       const struct mqtt_connack_param *param)
+{
+	/* Messages replayed after the CONNACK take their slots when they
+	 * are sent again.
+	 */
+	client->receive_max = param->receive_max;
+	client->send_quota = param->receive_max;
+	client->topic_alias_max = MIN(param->topic_alias_max,
+				      CONFIG_MQTT_TOPIC_ALIAS_MAX);
+
+	/* Aliases are only valid for the connection they were set on. */
+	for (u32_t i = 0; i < CONFIG_MQTT_TOPIC_ALIAS_MAX; i++) {
+		client->topic_aliases[i].size = 0;
+	}
+
+	MQTT_TRC("[%p]: Send quota %d, topic aliases %d.", client,
+		 client->send_quota, client->topic_alias_max);
+}
+
+int mqtt_v5_send_quota_take(struct mqtt_client *client)
+{
+	if (client->send_quota == 0) {
+		MQTT_TRC("[%p]: Server Receive Maximum reached.", client);
+		return -EAGAIN;
+	}
+
+	client->send_quota--;
+
+	return 0;
+}
+
+void mqtt_v5_send_quota_give(struct mqtt_client *client)
+{
+	/* Acknowledgments of messages sent before the CONNACK, or duplicate
+	 * ones, do not raise the quota above the server Receive Maximum.
+	 */
+	if (client->send_quota < client->receive_max) {
+		client->send_quota++;
+	}
+}
+
+bool mqtt_v5_topic_alias_find(const struct mqtt_client *client,
+			      const struct mqtt_utf8 *topic, u16_t *alias)
+{
+	*alias = 0;
+
+	if ((topic->size == 0) ||
+	    (topic->size > CONFIG_MQTT_TOPIC_ALIAS_MAX_LENGTH)) {
+		return false;
+	}
+
+	for (u16_t i = 0; i < client->topic_alias_max; i++) {
+		const struct mqtt_topic_alias *entry =
+						&client->topic_aliases[i];
+
+		if (entry->size == 0) {
+			/* First free alias, taken if the topic is sent. */
+			if (*alias == 0) {
+				*alias = i + 1;
+			}
+
+			continue;
+		}
+
+		if ((entry->size == topic->size) &&
+		    (memcmp(entry->topic, topic->utf8, topic->size) == 0)) {
+			*alias = i + 1;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void mqtt_v5_topic_alias_set(struct mqtt_client *client, u16_t alias,
+			     const struct mqtt_utf8 *topic)
+{
+	struct mqtt_topic_alias *entry = &client->topic_aliases[alias - 1];
+
+	memcpy(entry->topic, topic->utf8, topic->size);
+	entry->size = topic->size;
+
+	MQTT_TRC("[%p]: Topic alias %d set.", client, alias);
+}
@@ -15,9 +15,8 @@
 #include <string.h>
 
 
-/* By default, when there is no shell, all events are profiled. */
 #ifndef CONFIG_SHELL
-u32_t profiler_enabled_events = 0xffffffff;
+ATOMIC_DEFINE(profiler_enabled_events, CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
 #endif
 
 
@@ -56,6 +55,173 @@ static K_THREAD_STACK_DEFINE(profiler_nordic_stack,
 			     CONFIG_PROFILER_NORDIC_STACK_SIZE);
 static struct k_thread profiler_nordic_thread;
 
+#ifdef CONFIG_PROFILER_NORDIC_RING_BUFFER
+#define THREAD_PERIOD		CONFIG_PROFILER_NORDIC_FLUSH_PERIOD
+#else
+#define THREAD_PERIOD		500
+#endif
+
+#ifdef CONFIG_PROFILER_NORDIC_RING_BUFFER
+#define RING_SIZE		CONFIG_PROFILER_NORDIC_RING_BUFFER_SIZE
+#define RING_MASK		(RING_SIZE - 1)
+#define BLOCK_SIZE		256
+
+/* Type ID of the in-band record reporting number of dropped events. */
+#define DROPPED_EVENTS_ID	UCHAR_MAX
+
+/* Ring buffer record: length byte followed by the logged data (type ID,
+ * timestamp and event data). A record is committed when its length
+ * byte becomes non-zero. Consumed records are zeroed.
+ */
+static u8_t ring_buf[RING_SIZE];
+static atomic_t ring_head;
+static atomic_t ring_tail;
+static atomic_t dropped_events;
+
+static u8_t block[BLOCK_SIZE];
+static size_t block_len;
+static u32_t prev_timestamp;
+
+BUILD_ASSERT_MSG((RING_SIZE & RING_MASK) == 0,
+		 "Ring buffer size must be a power of two");
+BUILD_ASSERT_MSG(CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN <= UCHAR_MAX,
+		 "Logged data must fit in a single ring buffer record");
+BUILD_ASSERT_MSG(CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN + 1 <= BLOCK_SIZE,
+		 "Encoded record must fit in a block");
+
+static bool ring_put(const u8_t *data, size_t len)
+{
+	u32_t size = len + 1;
+	u32_t head;
+	u32_t used;
+
+	do {
+		head = atomic_get(&ring_head);
+		used = head - (u32_t)atomic_get(&ring_tail);
+
+		if (used + size > RING_SIZE) {
+			return false;
+		}
+	} while (!atomic_cas(&ring_head, head, head + size));
+
+	for (size_t i = 0; i < len; i++) {
+		ring_buf[(head + 1 + i) & RING_MASK] = data[i];
+	}
+
+	/* Make sure that data is visible before the record is committed. */
+	__DMB();
+	ring_buf[head & RING_MASK] = len;
+
+	if ((used <= RING_SIZE / 2) && (used + size > RING_SIZE / 2)) {
+		k_wakeup(protocol_thread_id);
+	}
+
+	return true;
+}
+
+static u8_t ring_get_byte(u32_t idx)
+{
+	return ring_buf[idx & RING_MASK];
+}
+
+static size_t varint_encode(u8_t *buf, u32_t val)
+{
+	size_t len = 0;
+
+	while (val >= 0x80) {
+		buf[len++] = (val & 0x7F) | 0x80;
+		val >>= 7;
+	}
+	buf[len++] = val;
+
+	return len;
+}
+
+static bool block_send(void)
+{
+	/* In SEGGER_RTT_MODE_NO_BLOCK_SKIP nothing is written if the block
+	 * does not fit. It is kept and sent again during the next flush.
+	 */
+	if (SEGGER_RTT_WriteNoLock(CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
+				   block, block_len) == 0) {
+		return false;
+	}
+	block_len = 0;
+
+	return true;
+}
+
+static void block_add_record(u32_t idx, u8_t len)
+{
+	/* Type ID */
+	block[block_len++] = ring_get_byte(idx);
+
+	u32_t timestamp = 0;
+
+	for (size_t i = 0; i < sizeof(timestamp); i++) {
+		timestamp |= (u32_t)ring_get_byte(idx + 1 + i) << (8 * i);
+	}
+
+	/* Events logged from different contexts may be stored out of order,
+	 * zigzag encoding keeps negative deltas short.
+	 */
+	s32_t delta = timestamp - prev_timestamp;
+
+	prev_timestamp = timestamp;
+	block_len += varint_encode(&block[block_len],
+				   ((u32_t)delta << 1) ^ (u32_t)(delta >> 31));
+
+	for (size_t i = 1 + sizeof(timestamp); i < len; i++) {
+		block[block_len++] = ring_get_byte(idx + i);
+	}
+}
+
+static void ring_flush(void)
+{
+	if ((block_len > 0) && !block_send()) {
+		return;
+	}
+
+	u32_t dropped = atomic_set(&dropped_events, 0);
+
+	if (dropped > 0) {
+		block[block_len++] = DROPPED_EVENTS_ID;
+		block_len += varint_encode(&block[block_len], dropped);
+	}
+
+	u32_t tail = atomic_get(&ring_tail);
+
+	while (true) {
+		u8_t len = ring_get_byte(tail);
+
+		if (len == 0) {
+			break;
+		}
+
+		/* Make sure that data is read after the record is committed. */
+		__DMB();
+
+		if ((block_len + len + 1 > BLOCK_SIZE) && !block_send()) {
+			break;
+		}
+		block_add_record(tail + 1, len);
+
+		for (size_t i = 0; i <= len; i++) {
+			ring_buf[(tail + i) & RING_MASK] = 0;
+		}
+		tail += len + 1;
+
+		/* Make sure that the record is zeroed before it is released. */
+		__DMB();
+		atomic_set(&ring_tail, tail);
+	}
+
+	if (block_len > 0) {
+		block_send();
+	}
+}
+#endif /* CONFIG_PROFILER_NORDIC_RING_BUFFER */
+
 static void send_system_description(void)
 {
 	size_t num_bytes_send;
@@ -99,6 +265,10 @@ static void profiler_nordic_thread_fn(void)
 			command = (enum nordic_command)read_data;
 			switch (command) {
 			case NORDIC_COMMAND_START:
+#ifdef CONFIG_PROFILER_NORDIC_RING_BUFFER
+				/* First timestamp is sent as a delta from 0. */
+				prev_timestamp = 0;
+#endif
 				sending_events = true;
 				break;
 			case NORDIC_COMMAND_STOP:
@@ -112,7 +282,10 @@ static void profiler_nordic_thread_fn(void)
 				break;
 			}
 		}
-		k_sleep(500);
+#ifdef CONFIG_PROFILER_NORDIC_RING_BUFFER
+		ring_flush();
+#endif
+		k_sleep(THREAD_PERIOD);
 	}
 	k_sem_give(&profiler_sem);
 }
@@ -180,6 +353,9 @@ u16_t profiler_register_event_type(const char *name, const char **args,
 	 */
 	k_sched_lock();
 	u8_t ne = profiler_num_events;
+
+	__ASSERT_NO_MSG(ne < CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
+
 	size_t temp = snprintf(descr[ne],
 			CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS,
 			"%s,%d", name, ne);
@@ -212,6 +388,11 @@ u16_t profiler_register_event_type(const char *name, const char **args,
 	 */
 	__DMB();
 	profiler_num_events++;
+
+	/* By default, when there is no shell, all events are profiled. */
+	if (!IS_ENABLED(CONFIG_SHELL)) {
+		atomic_set_bit(profiler_enabled_events, ne);
+	}
 	k_sched_unlock();
 
 	return ne;
@@ -246,6 +427,13 @@ void profiler_log_send(struct log_event_buf *buf, u16_t event_type_id)
 		u8_t type_id = event_type_id & UCHAR_MAX;
 
 		buf->payload_start[0] = type_id;
+
+#ifdef CONFIG_PROFILER_NORDIC_RING_BUFFER
+		if (!ring_put(buf->payload_start,
+			      buf->payload - buf->payload_start)) {
+			atomic_inc(&dropped_events);
+		}
+#else
 		int key = irq_lock();
 
 		u8_t num_bytes_send = SEGGER_RTT_WriteNoLock(
@@ -255,5 +443,6 @@ void profiler_log_send(struct log_event_buf *buf, u16_t event_type_id)
 		ARG_UNUSED(num_bytes_send);
 		irq_unlock(key);
 		__ASSERT_NO_MSG(num_bytes_send > 0);
+#endif
 	}
 }
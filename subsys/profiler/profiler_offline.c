@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <zephyr.h>
+#include <misc/util.h>
+#include <misc/byteorder.h>
+#include <profiler.h>
+#include <shell/shell.h>
+
+
+#ifndef CONFIG_SHELL
+ATOMIC_DEFINE(profiler_enabled_events, CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
+#endif
+
+#define TRACE_SIZE		CONFIG_PROFILER_OFFLINE_BUFFER_SIZE
+#define TRACE_MASK		(TRACE_SIZE - 1)
+#define TRACE_MAGIC		0x50524f46
+
+/* Smallest record contains type ID and timestamp. */
+#define RECORD_MIN_LEN		(sizeof(u8_t) + sizeof(u32_t))
+
+#define DUMP_LINE_LEN		32
+
+BUILD_ASSERT_MSG((TRACE_SIZE & TRACE_MASK) == 0,
+		 "Trace buffer size must be a power of two");
+BUILD_ASSERT_MSG(CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN <= UCHAR_MAX,
+		 "Logged data must fit in a single trace record");
+
+/* Trace buffer record: length byte followed by the logged data (type ID,
+ * timestamp and event data). The oldest records are overwritten when the
+ * buffer is full. The buffer is not initialized on start, so that the trace
+ * recorded before a reset can be retrieved.
+ */
+struct trace_buf {
+	u32_t magic;
+	u32_t head;
+	u32_t tail;
+	u32_t overwritten;
+	u32_t check;
+	u8_t data[TRACE_SIZE];
+};
+
+static struct trace_buf trace __noinit;
+static bool recording;
+
+static char descr[CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS]
+		 [CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS];
+static char *arg_types_encodings[] = {
+					"u8",  /* u8_t */
+					"s8",  /* s8_t */
+					"u16", /* u16_t */
+					"s16", /* s16_t */
+					"u32", /* u32_t */
+					"s32", /* s32_t */
+					"s",   /* string */
+					"t"    /* time */
+				     };
+
+u8_t profiler_num_events;
+
+
+static u32_t trace_check_calc(void)
+{
+	return ~(trace.magic ^ trace.head ^ trace.tail ^ trace.overwritten);
+}
+
+static bool trace_is_valid(void)
+{
+	return (trace.magic == TRACE_MAGIC) &&
+	       (trace.check == trace_check_calc()) &&
+	       (trace.head - trace.tail <= TRACE_SIZE);
+}
+
+static void trace_clear(void)
+{
+	unsigned int key = irq_lock();
+
+	trace.magic = TRACE_MAGIC;
+	trace.head = 0;
+	trace.tail = 0;
+	trace.overwritten = 0;
+	trace.check = trace_check_calc();
+
+	irq_unlock(key);
+}
+
+static u8_t trace_get_byte(u32_t idx)
+{
+	return trace.data[idx & TRACE_MASK];
+}
+
+static void trace_put(const u8_t *data, u8_t len)
+{
+	u32_t size = len + 1;
+	unsigned int key = irq_lock();
+
+	while (trace.head - trace.tail + size > TRACE_SIZE) {
+		trace.tail += trace_get_byte(trace.tail) + 1;
+		trace.overwritten++;
+	}
+
+	trace.data[trace.head & TRACE_MASK] = len;
+	for (size_t i = 0; i < len; i++) {
+		trace.data[(trace.head + 1 + i) & TRACE_MASK] = data[i];
+	}
+	trace.head += size;
+	trace.check = trace_check_calc();
+
+	irq_unlock(key);
+}
+
+int profiler_init(void)
+{
+	if (!trace_is_valid()) {
+		trace_clear();
+	} else if (IS_ENABLED(CONFIG_PROFILER_OFFLINE_KEEP_AFTER_RESET) &&
+		   (trace.head != trace.tail)) {
+		/* Trace recorded before the reset is kept until it is
+		 * cleared.
+		 */
+		return 0;
+	}
+
+	recording = true;
+
+	return 0;
+}
+
+void profiler_term(void)
+{
+	recording = false;
+}
+
+const char *profiler_get_event_descr(size_t profiler_event_id)
+{
+	return descr[profiler_event_id];
+}
+
+u16_t profiler_register_event_type(const char *name, const char **args,
+				   const enum profiler_arg *arg_types,
+				   u8_t arg_cnt)
+{
+	/* Lock to make sure that this function can be called
+	 * from multiple threads
+	 */
+	k_sched_lock();
+	u8_t ne = profiler_num_events;
+
+	__ASSERT_NO_MSG(ne < CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
+
+	size_t temp = snprintf(descr[ne],
+			CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS,
+			"%s,%d", name, ne);
+	size_t pos = temp;
+
+	__ASSERT_NO_MSG((pos < CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS)
+			 && (temp > 0));
+
+	for (size_t t = 0; t < arg_cnt; t++) {
+		temp = snprintf(descr[ne] + pos,
+			 CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS - pos,
+			 ",%s", arg_types_encodings[arg_types[t]]);
+		pos += temp;
+		__ASSERT_NO_MSG(
+		  (pos < CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS)
+		   && (temp > 0));
+	}
+
+	for (size_t t = 0; t < arg_cnt; t++) {
+		temp = snprintf(descr[ne] + pos,
+			CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS - pos,
+			",%s", args[t]);
+		pos += temp;
+		__ASSERT_NO_MSG(
+		  (pos < CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS)
+		   && (temp > 0));
+	}
+	/* Make sure that description is written before it is used. */
+	compiler_barrier();
+	profiler_num_events++;
+
+	/* By default, when there is no shell, all events are profiled. */
+	if (!IS_ENABLED(CONFIG_SHELL)) {
+		atomic_set_bit(profiler_enabled_events, ne);
+	}
+	k_sched_unlock();
+
+	return ne;
+}
+
+void profiler_log_start(struct log_event_buf *buf)
+{
+	/* Adding one to pointer to make space for event type ID */
+	__ASSERT_NO_MSG(sizeof(u8_t) <= CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN);
+	buf->payload = buf->payload_start + sizeof(u8_t);
+	profiler_log_encode_u32(buf, k_cycle_get_32());
+}
+
+void profiler_log_encode_u32(struct log_event_buf *buf, u32_t data)
+{
+	__ASSERT_NO_MSG(buf->payload - buf->payload_start + sizeof(data)
+			 <= CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN);
+	sys_put_le32(data, buf->payload);
+	buf->payload += sizeof(data);
+}
+
+void profiler_log_add_mem_address(struct log_event_buf *buf,
+				  const void *mem_address)
+{
+	profiler_log_encode_u32(buf, (u32_t)mem_address);
+}
+
+void profiler_log_send(struct log_event_buf *buf, u16_t event_type_id)
+{
+	__ASSERT_NO_MSG(event_type_id <= UCHAR_MAX);
+	if (recording) {
+		buf->payload_start[0] = event_type_id & UCHAR_MAX;
+		trace_put(buf->payload_start,
+			  buf->payload - buf->payload_start);
+	}
+}
+
+#ifdef CONFIG_SHELL
+static int trace_info(const struct shell *shell, size_t argc, char **argv)
+{
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "Trace %s, %u of %u bytes used, %u events overwritten\n",
+		      recording ? "recording" : "stopped",
+		      trace.head - trace.tail, TRACE_SIZE, trace.overwritten);
+
+	return 0;
+}
+
+static int trace_dump(const struct shell *shell, size_t argc, char **argv)
+{
+	bool was_recording = recording;
+
+	/* Recording is stopped so that dumped records are not overwritten. */
+	recording = false;
+
+	shell_fprintf(shell, SHELL_NORMAL, "profiler_trace_begin %u %u\n",
+		      sys_clock_hw_cycles_per_sec(), trace.overwritten);
+
+	for (size_t i = 0; i < profiler_num_events; i++) {
+		shell_fprintf(shell, SHELL_NORMAL, "desc:%s\n", descr[i]);
+	}
+
+	u32_t idx = trace.tail;
+	size_t line_pos = 0;
+
+	while (idx != trace.head) {
+		u8_t len = trace_get_byte(idx);
+
+		if ((len < RECORD_MIN_LEN) || (trace.head - idx < len + 1U)) {
+			shell_error(shell, "Trace is corrupted");
+			break;
+		}
+
+		for (size_t i = 1; i <= len; i++) {
+			if (line_pos == 0) {
+				shell_fprintf(shell, SHELL_NORMAL, "data:");
+			}
+			shell_fprintf(shell, SHELL_NORMAL, "%02x",
+				      trace_get_byte(idx + i));
+			if (++line_pos == DUMP_LINE_LEN) {
+				shell_fprintf(shell, SHELL_NORMAL, "\n");
+				line_pos = 0;
+			}
+		}
+		idx += len + 1;
+	}
+
+	if (line_pos > 0) {
+		shell_fprintf(shell, SHELL_NORMAL, "\n");
+	}
+	shell_fprintf(shell, SHELL_NORMAL, "profiler_trace_end\n");
+
+	recording = was_recording;
+
+	return 0;
+}
+
+static int trace_reset(const struct shell *shell, size_t argc, char **argv)
+{
+	trace_clear();
+	recording = true;
+	shell_fprintf(shell, SHELL_NORMAL, "Trace cleared, recording\n");
+
+	return 0;
+}
+
+SHELL_CREATE_STATIC_SUBCMD_SET(sub_profiler_trace)
+{
+	SHELL_CMD_ARG(info, NULL, "Display trace buffer usage",
+			trace_info, 0, 0),
+	SHELL_CMD_ARG(dump, NULL, "Dump recorded trace",
+			trace_dump, 0, 0),
+	SHELL_CMD_ARG(clear, NULL, "Clear trace and start recording",
+			trace_reset, 0, 0),
+	SHELL_SUBCMD_SET_END
+};
+
+SHELL_CMD_REGISTER(profiler_trace, &sub_profiler_trace,
+		   "Offline profiler trace commands", NULL);
+#endif /* CONFIG_SHELL */
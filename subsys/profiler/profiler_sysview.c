@@ -9,9 +9,8 @@
 #include <kernel_structs.h>
 
 
-/* By default, when there is no shell, all events are profiled. */
 #ifndef CONFIG_SHELL
-u32_t profiler_enabled_events = 0xffffffff;
+ATOMIC_DEFINE(profiler_enabled_events, CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
 #endif
 
 static char descr[CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS]
@@ -89,6 +88,8 @@ u16_t profiler_register_event_type(const char *name, const char **args,
 	k_sched_lock();
 	u32_t ne = events.NumEvents;
 
+	__ASSERT_NO_MSG(ne < CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS);
+
 	size_t temp = snprintf(descr[ne],
 			CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS,
 			"%u %s", ne, name);
@@ -113,8 +114,17 @@ u16_t profiler_register_event_type(const char *name, const char **args,
 	__DMB();
 	events.NumEvents++;
 	profiler_num_events = events.NumEvents;
+
+	/* By default, when there is no shell, all events are profiled. */
+	if (!IS_ENABLED(CONFIG_SHELL)) {
+		atomic_set_bit(profiler_enabled_events, ne);
+	}
 	k_sched_unlock();
-	return events.EventOffset + ne;
+
+	/* Event type IDs are indexes in the profiler_enabled_events bitmap.
+	 * SystemView module event offset is added when the event is sent.
+	 */
+	return ne;
 }
 
 void profiler_log_start(struct log_event_buf *buf)
@@ -146,5 +156,5 @@ void profiler_log_add_mem_address(struct log_event_buf *buf,
 void profiler_log_send(struct log_event_buf *buf, u16_t event_type_id)
 {
 	SEGGER_SYSVIEW_SendPacket(buf->payload_start, buf->payload,
-				  event_type_id);
+				  events.EventOffset + event_type_id);
 }
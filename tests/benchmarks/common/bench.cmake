@@ -0,0 +1,16 @@
+#
+# Copyright (c) 2019 Nordic Semiconductor
+#
+# SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+#
+
+# Timing and reporting helpers shared by the benchmarks.
+target_include_directories(app PRIVATE ${CMAKE_CURRENT_LIST_DIR})
+
+if(CONFIG_BOARD_NATIVE_POSIX)
+  # Simulated time does not advance while code executes, the host clock
+  # is read by a helper built against the host C library.
+  target_sources(app PRIVATE ${CMAKE_CURRENT_LIST_DIR}/bench_native.c)
+  set_source_files_properties(${CMAKE_CURRENT_LIST_DIR}/bench_native.c
+    PROPERTIES COMPILE_DEFINITIONS NO_POSIX_CHEATS)
+endif()
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+/**
+ * @brief Time measurement and reporting shared by the benchmarks.
+ */
+
+#include <zephyr.h>
+#include <stdarg.h>
+#include <misc/printk.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef CONFIG_BOARD_NATIVE_POSIX
+/** Get the monotonic host time in nanoseconds, see bench_native.c. */
+u64_t bench_host_time_ns(void);
+#endif
+
+/** Get the current benchmark timestamp. */
+static inline u64_t bench_timestamp(void)
+{
+#ifdef CONFIG_BOARD_NATIVE_POSIX
+	/* Simulated time, including the native RTC, does not advance while
+	 * code executes. Read the host clock instead.
+	 */
+	return bench_host_time_ns();
+#else
+	return k_cycle_get_32();
+#endif
+}
+
+/** Get the time in nanoseconds elapsed between two timestamps. */
+static inline u64_t bench_elapsed_ns(u64_t start, u64_t end)
+{
+#ifdef CONFIG_BOARD_NATIVE_POSIX
+	return end - start;
+#else
+	return SYS_CLOCK_HW_CYCLES_TO_NS64((u32_t)end - (u32_t)start);
+#endif
+}
+
+/** Get the number of operations per second, 0 if no time elapsed. */
+static inline u32_t bench_rate(u64_t cnt, u64_t elapsed_ns)
+{
+	return (elapsed_ns > 0) ? (cnt * NSEC_PER_SEC / elapsed_ns) : (0);
+}
+
+/** Print the results of a scenario. The format string gives the members of
+ *  a JSON object, which is printed on one line prefixed with BENCH to ease
+ *  extraction from the console output.
+ */
+static inline void bench_report(const char *fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	printk("BENCH {");
+	vprintk(fmt, args);
+	printk("}\n");
+	va_end(args);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BENCH_H_ */
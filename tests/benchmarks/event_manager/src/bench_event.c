@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include "bench_event.h"
+
+
+EVENT_TYPE_DEFINE(bench_event_subs_1, false, NULL, NULL);
+EVENT_TYPE_DEFINE(bench_event_subs_4, false, NULL, NULL);
+EVENT_TYPE_DEFINE(bench_event_subs_16, false, NULL, NULL);
+EVENT_TYPE_DEFINE(bench_event_prio_4, false, NULL, NULL);
+EVENT_TYPE_DEFINE(bench_event_payload_64, false, NULL, NULL);
+EVENT_TYPE_DEFINE(bench_event_payload_256, false, NULL, NULL);
+
+/* Dispatched by the dedicated thread of the highest class when dispatch
+ * classes are enabled, instead of the system workqueue.
+ */
+EVENT_TYPE_DISPATCH_CLASS(bench_event_subs_1, EVENT_DISPATCH_CLASS_HIGHEST);
+EVENT_TYPE_DISPATCH_CLASS(bench_event_subs_4, EVENT_DISPATCH_CLASS_HIGHEST);
+EVENT_TYPE_DISPATCH_CLASS(bench_event_subs_16, EVENT_DISPATCH_CLASS_HIGHEST);
+EVENT_TYPE_DISPATCH_CLASS(bench_event_prio_4, EVENT_DISPATCH_CLASS_HIGHEST);
+EVENT_TYPE_DISPATCH_CLASS(bench_event_payload_64,
+			  EVENT_DISPATCH_CLASS_HIGHEST);
+EVENT_TYPE_DISPATCH_CLASS(bench_event_payload_256,
+			  EVENT_DISPATCH_CLASS_HIGHEST);
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _BENCH_EVENT_H_
+#define _BENCH_EVENT_H_
+
+/**
+ * @brief Benchmark Events
+ * @defgroup bench_event Benchmark Events
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Common initial part of all benchmark events. */
+struct bench_event_common {
+	struct event_header header;
+
+	u64_t timestamp;
+};
+
+/** Declare a benchmark event carrying a payload of the given size.
+ *  The event starts with the same members as struct bench_event_common.
+ */
+#define BENCH_EVENT_DECLARE(ename, payload_size)	\
+	struct ename {					\
+		struct event_header header;		\
+							\
+		u64_t timestamp;			\
+		u8_t payload[payload_size];		\
+	};						\
+	EVENT_TYPE_DECLARE(ename)
+
+/* One subscriber (measuring listener only). */
+BENCH_EVENT_DECLARE(bench_event_subs_1, 4);
+/* Measuring listener and 3 normal priority work listeners. */
+BENCH_EVENT_DECLARE(bench_event_subs_4, 4);
+/* Measuring listener and 15 normal priority work listeners. */
+BENCH_EVENT_DECLARE(bench_event_subs_16, 4);
+/* Measuring listener and work listeners on early, normal and final lists. */
+BENCH_EVENT_DECLARE(bench_event_prio_4, 4);
+/* Measuring listener only, bigger payloads. */
+BENCH_EVENT_DECLARE(bench_event_payload_64, 64);
+BENCH_EVENT_DECLARE(bench_event_payload_256, 256);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _BENCH_EVENT_H_ */
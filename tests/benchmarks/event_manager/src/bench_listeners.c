@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+
+#include "event_bench.h"
+
+/* The measuring listener is notified first. Remaining listeners only
+ * add the cost of being notified.
+ */
+static bool measure_handler(const struct event_header *eh)
+{
+	bench_event_received((const struct bench_event_common *)eh);
+
+	return false;
+}
+
+static volatile u32_t work_cnt;
+
+static bool work_handler(const struct event_header *eh)
+{
+	work_cnt++;
+
+	return false;
+}
+
+#define BENCH_WORK_LISTENER(n) \
+	EVENT_LISTENER(bench_work_##n, work_handler)
+
+#define BENCH_WORK_SUBSCRIBE(n, ename) \
+	EVENT_SUBSCRIBE(bench_work_##n, ename)
+
+EVENT_LISTENER(bench_measure, measure_handler);
+EVENT_SUBSCRIBE_EARLY(bench_measure, bench_event_subs_1);
+EVENT_SUBSCRIBE_EARLY(bench_measure, bench_event_subs_4);
+EVENT_SUBSCRIBE_EARLY(bench_measure, bench_event_subs_16);
+EVENT_SUBSCRIBE_EARLY(bench_measure, bench_event_prio_4);
+EVENT_SUBSCRIBE_EARLY(bench_measure, bench_event_payload_64);
+EVENT_SUBSCRIBE_EARLY(bench_measure, bench_event_payload_256);
+
+BENCH_WORK_LISTENER(0);
+BENCH_WORK_LISTENER(1);
+BENCH_WORK_LISTENER(2);
+BENCH_WORK_LISTENER(3);
+BENCH_WORK_LISTENER(4);
+BENCH_WORK_LISTENER(5);
+BENCH_WORK_LISTENER(6);
+BENCH_WORK_LISTENER(7);
+BENCH_WORK_LISTENER(8);
+BENCH_WORK_LISTENER(9);
+BENCH_WORK_LISTENER(10);
+BENCH_WORK_LISTENER(11);
+BENCH_WORK_LISTENER(12);
+BENCH_WORK_LISTENER(13);
+BENCH_WORK_LISTENER(14);
+
+BENCH_WORK_SUBSCRIBE(0, bench_event_subs_4);
+BENCH_WORK_SUBSCRIBE(1, bench_event_subs_4);
+BENCH_WORK_SUBSCRIBE(2, bench_event_subs_4);
+
+BENCH_WORK_SUBSCRIBE(0, bench_event_subs_16);
+BENCH_WORK_SUBSCRIBE(1, bench_event_subs_16);
+BENCH_WORK_SUBSCRIBE(2, bench_event_subs_16);
+BENCH_WORK_SUBSCRIBE(3, bench_event_subs_16);
+BENCH_WORK_SUBSCRIBE(4, bench_event_subs_16);
+BENCH_WORK_SUBSCRIBE(5, bench_event_subs_16);
+BENCH_WORK_SUBSCRIBE(6, bench_event_subs_16);
+BENCH_WORK_SUBSCRIBE(7, bench_event_subs_16);
+BENCH_WORK_SUBSCRIBE(8, bench_event_subs_16);
+BENCH_WORK_SUBSCRIBE(9, bench_event_subs_16);
+BENCH_WORK_SUBSCRIBE(10, bench_event_subs_16);
+BENCH_WORK_SUBSCRIBE(11, bench_event_subs_16);
+BENCH_WORK_SUBSCRIBE(12, bench_event_subs_16);
+BENCH_WORK_SUBSCRIBE(13, bench_event_subs_16);
+BENCH_WORK_SUBSCRIBE(14, bench_event_subs_16);
+
+EVENT_SUBSCRIBE_EARLY(bench_work_0, bench_event_prio_4);
+EVENT_SUBSCRIBE(bench_work_1, bench_event_prio_4);
+EVENT_SUBSCRIBE_FINAL(bench_work_2, bench_event_prio_4);
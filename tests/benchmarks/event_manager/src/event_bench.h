@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _EVENT_BENCH_H_
+#define _EVENT_BENCH_H_
+
+#include <zephyr/types.h>
+
+#include "bench_event.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of events submitted in every benchmark scenario. */
+#define BENCH_EVENT_CNT		2000
+
+/* Maximum number of threads producing events in a scenario. */
+#define BENCH_PRODUCER_MAX	4
+
+/* Number of events a producer submits before it yields to the dispatcher. */
+#define BENCH_BURST_CNT		16
+
+/** Record reception of a benchmark event by the measuring listener. */
+void bench_event_received(const struct bench_event_common *event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EVENT_BENCH_H_ */
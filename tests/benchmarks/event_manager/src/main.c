@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <event_manager.h>
+
+#include "bench.h"
+#include "event_bench.h"
+
+#define PRODUCER_STACK_SIZE	1024
+
+/* Producers are cooperative, with the priority of the system workqueue.
+ * Events are dispatched only when a producer yields after a burst, so
+ * the dispatcher finds BENCH_BURST_CNT events queued instead of running
+ * after every submit.
+ */
+#define PRODUCER_PRIORITY	CONFIG_SYSTEM_WORKQUEUE_PRIORITY
+
+#define BENCH_EVENT_NEW(ename)						\
+	static struct bench_event_common *_CONCAT(fill_, ename)(void)	\
+	{								\
+		struct ename *event = _CONCAT(new_, ename)();		\
+									\
+		memset(event->payload, 0xA5, sizeof(event->payload));	\
+		return (struct bench_event_common *)event;		\
+	}
+
+BENCH_EVENT_NEW(bench_event_subs_1);
+BENCH_EVENT_NEW(bench_event_subs_4);
+BENCH_EVENT_NEW(bench_event_subs_16);
+BENCH_EVENT_NEW(bench_event_prio_4);
+BENCH_EVENT_NEW(bench_event_payload_64);
+BENCH_EVENT_NEW(bench_event_payload_256);
+
+struct bench_scenario {
+	const char *name;
+	struct bench_event_common *(*new_event)(void);
+	u16_t payload_size;
+	u8_t subscriber_cnt;
+	u8_t producer_cnt;
+};
+
+static K_THREAD_STACK_ARRAY_DEFINE(producer_stack, BENCH_PRODUCER_MAX,
+				   PRODUCER_STACK_SIZE);
+static struct k_thread producer_thread[BENCH_PRODUCER_MAX];
+
+static K_SEM_DEFINE(bench_done_sem, 0, 1);
+static K_SEM_DEFINE(producer_done_sem, 0, BENCH_PRODUCER_MAX);
+
+static atomic_t received_cnt;
+static atomic_t excess_cnt;
+static u32_t latency_ns[BENCH_EVENT_CNT];
+
+void bench_event_received(const struct bench_event_common *event)
+{
+	u64_t now = bench_timestamp();
+	atomic_val_t idx = atomic_inc(&received_cnt);
+
+	if (idx >= BENCH_EVENT_CNT) {
+		/* Checked by the test thread, listeners cannot fail a test. */
+		atomic_inc(&excess_cnt);
+		return;
+	}
+
+	u64_t latency = bench_elapsed_ns(event->timestamp, now);
+
+	latency_ns[idx] = (latency > UINT32_MAX) ? (UINT32_MAX) : (latency);
+
+	if (idx == BENCH_EVENT_CNT - 1) {
+		k_sem_give(&bench_done_sem);
+	}
+}
+
+static void producer_fn(void *p1, void *p2, void *p3)
+{
+	const struct bench_scenario *scenario = p1;
+	size_t cnt = POINTER_TO_UINT(p2);
+
+	ARG_UNUSED(p3);
+
+	for (size_t i = 0; i < cnt; i++) {
+		struct bench_event_common *event = scenario->new_event();
+
+		event->timestamp = bench_timestamp();
+		EVENT_SUBMIT(event);
+
+		if (((i + 1) % BENCH_BURST_CNT) == 0) {
+			k_yield();
+		}
+	}
+
+	k_sem_give(&producer_done_sem);
+}
+
+static void latency_sort(u32_t *data, size_t cnt)
+{
+	/* Shell sort, C library qsort is not always available. */
+	for (size_t gap = cnt / 2; gap > 0; gap /= 2) {
+		for (size_t i = gap; i < cnt; i++) {
+			u32_t val = data[i];
+			size_t j = i;
+
+			while ((j >= gap) && (data[j - gap] > val)) {
+				data[j] = data[j - gap];
+				j -= gap;
+			}
+			data[j] = val;
+		}
+	}
+}
+
+static u32_t latency_percentile(const u32_t *sorted, size_t cnt,
+				unsigned int pct)
+{
+	size_t idx = (cnt * pct + 99) / 100;
+
+	return sorted[(idx > 0) ? (idx - 1) : (0)];
+}
+
+static void bench_run(const struct bench_scenario *scenario)
+{
+	__ASSERT_NO_MSG(scenario->producer_cnt <= BENCH_PRODUCER_MAX);
+	__ASSERT_NO_MSG((BENCH_EVENT_CNT % scenario->producer_cnt) == 0);
+
+	atomic_set(&received_cnt, 0);
+	atomic_set(&excess_cnt, 0);
+	k_sem_reset(&bench_done_sem);
+	k_sem_reset(&producer_done_sem);
+
+	u64_t start = bench_timestamp();
+
+	for (size_t i = 0; i < scenario->producer_cnt; i++) {
+		k_thread_create(&producer_thread[i], producer_stack[i],
+				K_THREAD_STACK_SIZEOF(producer_stack[i]),
+				producer_fn, (void *)scenario,
+				UINT_TO_POINTER(BENCH_EVENT_CNT /
+						scenario->producer_cnt),
+				NULL, PRODUCER_PRIORITY, 0, K_NO_WAIT);
+	}
+
+	int err = k_sem_take(&bench_done_sem, K_SECONDS(30));
+
+	u64_t end = bench_timestamp();
+
+	zassert_equal(err, 0, "Benchmark execution hanged");
+
+	for (size_t i = 0; i < scenario->producer_cnt; i++) {
+		err = k_sem_take(&producer_done_sem, K_SECONDS(1));
+		zassert_equal(err, 0, "Producer did not finish");
+	}
+
+	zassert_equal(atomic_get(&excess_cnt), 0, "Too many events received");
+
+	u64_t elapsed = bench_elapsed_ns(start, end);
+
+	latency_sort(latency_ns, BENCH_EVENT_CNT);
+
+	/* A clock which stands still while code executes gives rates and
+	 * latencies that do not depend on the event manager configuration.
+	 */
+	zassert_true(elapsed > 0, "Benchmark clock not running");
+	zassert_true(latency_ns[BENCH_EVENT_CNT - 1] > 0,
+		     "No submit to dispatch latency measured");
+
+	bench_report("\"scenario\":\"%s\","
+		     "\"subscribers\":%u,\"payload\":%u,\"producers\":%u,"
+		     "\"burst\":%u,"
+		     "\"event_pools\":%d,\"dispatch_classes\":%d,"
+		     "\"events\":%u,\"events_per_sec\":%u,"
+		     "\"latency_p50_ns\":%u,\"latency_p99_ns\":%u,"
+		     "\"latency_max_ns\":%u",
+		     scenario->name,
+		     scenario->subscriber_cnt, scenario->payload_size,
+		     scenario->producer_cnt, BENCH_BURST_CNT,
+		     IS_ENABLED(CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOLS),
+		     IS_ENABLED(CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_CLASSES),
+		     BENCH_EVENT_CNT,
+		     bench_rate(BENCH_EVENT_CNT, elapsed),
+		     latency_percentile(latency_ns, BENCH_EVENT_CNT, 50),
+		     latency_percentile(latency_ns, BENCH_EVENT_CNT, 99),
+		     latency_ns[BENCH_EVENT_CNT - 1]);
+}
+
+static void bench_run_all(const struct bench_scenario *scenarios, size_t cnt)
+{
+	for (size_t i = 0; i < cnt; i++) {
+		bench_run(&scenarios[i]);
+	}
+}
+
+static void test_init(void)
+{
+	zassert_false(event_manager_init(), "Error when initializing");
+}
+
+static void test_subscribers(void)
+{
+	static const struct bench_scenario scenarios[] = {
+		{"subs_1", fill_bench_event_subs_1, 4, 1, 1},
+		{"subs_4", fill_bench_event_subs_4, 4, 4, 1},
+		{"subs_16", fill_bench_event_subs_16, 4, 16, 1},
+	};
+
+	bench_run_all(scenarios, ARRAY_SIZE(scenarios));
+}
+
+static void test_priorities(void)
+{
+	/* Same number of subscribers as subs_4, but spread over the early,
+	 * normal and final notification lists.
+	 */
+	static const struct bench_scenario scenarios[] = {
+		{"prio_4", fill_bench_event_prio_4, 4, 4, 1},
+	};
+
+	bench_run_all(scenarios, ARRAY_SIZE(scenarios));
+}
+
+static void test_payload(void)
+{
+	static const struct bench_scenario scenarios[] = {
+		{"payload_64", fill_bench_event_payload_64, 64, 1, 1},
+		{"payload_256", fill_bench_event_payload_256, 256, 1, 1},
+	};
+
+	bench_run_all(scenarios, ARRAY_SIZE(scenarios));
+}
+
+static void test_producers(void)
+{
+	static const struct bench_scenario scenarios[] = {
+		{"producers_2", fill_bench_event_subs_1, 4, 1, 2},
+		{"producers_4", fill_bench_event_subs_1, 4, 1, 4},
+	};
+
+	bench_run_all(scenarios, ARRAY_SIZE(scenarios));
+}
+
+void test_main(void)
+{
+	ztest_test_suite(event_manager_benchmark,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_subscribers),
+			 ztest_unit_test(test_priorities),
+			 ztest_unit_test(test_payload),
+			 ztest_unit_test(test_producers)
+			 );
+
+	ztest_run_test_suite(event_manager_benchmark);
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _FUZZ_H_
+#define _FUZZ_H_
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Fuzz target of the MQTT receive path, with the libFuzzer entry point
+ *        signature.
+ *
+ * The first input byte selects the protocol version, the second one the size
+ * of the reads the input is split into. The rest is handled as data received
+ * from the broker.
+ *
+ * @return Always 0.
+ */
+int LLVMFuzzerTestOneInput(const u8_t *data, size_t size);
+
+/** Number of events decoded by the fuzz target since the start. */
+u32_t fuzz_event_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FUZZ_H_ */
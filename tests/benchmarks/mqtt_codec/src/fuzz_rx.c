@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <net/mqtt_socket.h>
+
+#include "mqtt_internal.h"
+#include "mqtt_os.h"
+#include "fuzz.h"
+
+static struct mqtt_client client;
+static u8_t rx_buf[MQTT_MAX_PACKET_LENGTH];
+static u8_t tx_buf[MQTT_MAX_PACKET_LENGTH];
+static u32_t rx_len;
+static u32_t event_cnt;
+
+static bool in_rx_buf(const u8_t *ptr, u32_t len)
+{
+	if (len == 0) {
+		return true;
+	}
+
+	return (ptr >= rx_buf) && (ptr < rx_buf + sizeof(rx_buf)) &&
+	       (len <= sizeof(rx_buf) - (ptr - rx_buf));
+}
+
+/* Events decoded by the receive path of the library. */
+static void evt_handler(struct mqtt_client *c, const struct mqtt_evt *evt)
+{
+	const struct mqtt_publish_message *msg;
+
+	event_cnt++;
+
+	if (evt->result != 0) {
+		return;
+	}
+
+	/* Decoded strings shall point into the received data. */
+	switch (evt->type) {
+	case MQTT_EVT_PUBLISH:
+		msg = &evt->param.publish.message;
+
+		__ASSERT(in_rx_buf(msg->topic.topic.utf8, msg->topic.topic.size),
+			 "Topic out of bounds");
+		__ASSERT((msg->payload.data == NULL) ||
+			 in_rx_buf(msg->payload.data, msg->payload.len),
+			 "Payload out of bounds");
+		break;
+
+	case MQTT_EVT_SUBACK:
+		__ASSERT(in_rx_buf(evt->param.suback.return_codes.data,
+				   evt->param.suback.return_codes.len),
+			 "Return codes out of bounds");
+		break;
+
+	default:
+		break;
+	}
+}
+
+int LLVMFuzzerTestOneInput(const u8_t *data, size_t size)
+{
+	u32_t processed;
+	u32_t chunk;
+	u32_t len;
+
+	if (size < 2) {
+		return 0;
+	}
+
+	memset(&client, 0, sizeof(client));
+	mqtt_client_lock_init(&client);
+	client.protocol_version = (data[0] & 0x01) ? MQTT_VERSION_5_0 :
+						     MQTT_VERSION_3_1_1;
+	client.rx_buf = rx_buf;
+	client.tx_buf = tx_buf;
+	client.evt_cb = evt_handler;
+	MQTT_SET_STATE(&client, MQTT_STATE_TCP_CONNECTED);
+
+	chunk = data[1] + 1;
+	data += 2;
+	size -= 2;
+	rx_len = 0;
+
+	/* Events are notified with the client locked, as in mqtt_input. */
+	mqtt_client_lock(&client);
+
+	/* Same buffer handling as client_read and client_payload_discard. */
+	while (size > 0) {
+		if (client.remaining_payload > 0) {
+			/* Streamed payload is not read by the application. */
+			client.remaining_payload -=
+				MIN(client.remaining_payload,
+				    rx_len - client.rx_payload_offset);
+			client.rx_payload_offset = 0;
+			rx_len = 0;
+
+			len = MIN(size, client.remaining_payload);
+			client.remaining_payload -= len;
+			data += len;
+			size -= len;
+			continue;
+		}
+
+		len = MIN(MIN(size, chunk), sizeof(rx_buf) - rx_len);
+		memcpy(rx_buf + rx_len, data, len);
+		rx_len += len;
+		data += len;
+		size -= len;
+
+		processed = mqtt_handle_rx_data(&client, rx_buf, rx_len);
+		if (processed > rx_len) {
+			/* Connection is closed on invalid data. */
+			break;
+		}
+
+		if (client.remaining_payload > 0) {
+			continue;
+		}
+
+		if ((processed == 0) && (rx_len == sizeof(rx_buf))) {
+			break;
+		}
+
+		rx_len -= processed;
+		memmove(rx_buf, rx_buf + processed, rx_len);
+	}
+
+	mqtt_client_unlock(&client);
+
+	return 0;
+}
+
+u32_t fuzz_event_count(void)
+{
+	return event_cnt;
+}
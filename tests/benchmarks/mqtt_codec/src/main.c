@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <net/mqtt_socket.h>
+
+#include "bench.h"
+#include "mqtt_internal.h"
+#include "fuzz.h"
+
+/* Number of packets encoded or decoded in every benchmark scenario. */
+#define BENCH_PACKET_CNT	20000
+
+/* Number of mutated inputs passed to the fuzz target. */
+#define FUZZ_INPUT_CNT		50000
+#define FUZZ_INPUT_MAX_SIZE	256
+
+#define BENCH_TOPIC		"sensors/living_room/temperature"
+#define BENCH_TOPIC_MAX		24
+
+static struct mqtt_client client;
+static u8_t tx_buf[MQTT_MAX_PACKET_LENGTH];
+static u8_t rx_buf[MQTT_MAX_PACKET_LENGTH];
+static u8_t payload[MQTT_MAX_PACKET_LENGTH];
+static u8_t packet[MQTT_MAX_PACKET_LENGTH];
+
+static void codec_report(const char *scenario, u32_t size, u32_t packet_cnt,
+			 u64_t byte_cnt, u64_t start)
+{
+	u64_t elapsed = bench_elapsed_ns(start, bench_timestamp());
+
+	zassert_true(elapsed > 0, "Benchmark clock not running");
+
+	bench_report("\"scenario\":\"%s\",\"size\":%u,\"packets\":%u,"
+		     "\"packets_per_sec\":%u,\"bytes_per_sec\":%u",
+		     scenario, size, packet_cnt,
+		     bench_rate(packet_cnt, elapsed),
+		     bench_rate(byte_cnt, elapsed));
+}
+
+static void client_setup(u8_t protocol_version)
+{
+	memset(&client, 0, sizeof(client));
+	client.protocol_version = protocol_version;
+	client.tx_buf = tx_buf;
+	client.rx_buf = rx_buf;
+	MQTT_SET_STATE(&client, MQTT_STATE_CONNECTED);
+}
+
+static void publish_param_init(struct mqtt_publish_param *param,
+			       u32_t payload_len)
+{
+	memset(param, 0, sizeof(*param));
+
+	param->message.topic.topic.utf8 = (u8_t *)BENCH_TOPIC;
+	param->message.topic.topic.size = strlen(BENCH_TOPIC);
+	param->message.topic.qos = MQTT_QOS_1_AT_LEAST_ONCE;
+	param->message.payload.data = payload;
+	param->message.payload.len = payload_len;
+	param->message_id = 1;
+}
+
+/* Encodes a PUBLISH message with the payload into the packet buffer. */
+static u32_t publish_packet_build(u32_t payload_len)
+{
+	struct mqtt_publish_param param;
+	const u8_t *header;
+	u32_t header_len;
+
+	publish_param_init(&param, payload_len);
+
+	zassert_equal(publish_header_encode(&client, &param, &header,
+					    &header_len), 0,
+		      "Cannot encode PUBLISH");
+	zassert_true(header_len + payload_len <= sizeof(packet),
+		     "PUBLISH too long");
+
+	memcpy(packet, header, header_len);
+	memcpy(packet + header_len, payload, payload_len);
+
+	return header_len + payload_len;
+}
+
+static const u32_t publish_sizes[] = { 16, 128, 512, 960 };
+static const u32_t topic_counts[] = { 1, 8, BENCH_TOPIC_MAX };
+
+static void test_publish_encode(void)
+{
+	struct mqtt_publish_param param;
+	const u8_t *header;
+	u32_t header_len;
+
+	client_setup(MQTT_VERSION_3_1_1);
+
+	for (size_t i = 0; i < ARRAY_SIZE(publish_sizes); i++) {
+		u64_t start = bench_timestamp();
+		u64_t byte_cnt = 0;
+
+		publish_param_init(&param, publish_sizes[i]);
+
+		for (u32_t j = 0; j < BENCH_PACKET_CNT; j++) {
+			param.message_id = (j & 0xFFFF) | 0x01;
+			(void)publish_header_encode(&client, &param, &header,
+						    &header_len);
+			byte_cnt += header_len + param.message.payload.len;
+		}
+
+		codec_report("publish_encode", publish_sizes[i],
+			     BENCH_PACKET_CNT, byte_cnt, start);
+	}
+}
+
+static void test_publish_decode(void)
+{
+	struct mqtt_publish_param param;
+	u32_t remaining_length;
+	u32_t offset;
+	u32_t len;
+
+	client_setup(MQTT_VERSION_3_1_1);
+
+	for (size_t i = 0; i < ARRAY_SIZE(publish_sizes); i++) {
+		len = publish_packet_build(publish_sizes[i]);
+
+		u64_t start = bench_timestamp();
+
+		for (u32_t j = 0; j < BENCH_PACKET_CNT; j++) {
+			offset = 1;
+			(void)packet_length_decode(packet, len,
+						   &remaining_length, &offset);
+			(void)publish_decode(&client, packet, len, offset,
+					     &param);
+		}
+
+		codec_report("publish_decode", publish_sizes[i],
+			     BENCH_PACKET_CNT, (u64_t)len * BENCH_PACKET_CNT,
+			     start);
+
+		zassert_equal(param.message.payload.len, publish_sizes[i],
+			      "Invalid payload decoded");
+	}
+}
+
+static void test_publish_rx(void)
+{
+	/* Back to back QoS 1 messages, as read from the socket. */
+	const u32_t len = publish_packet_build(64);
+	const u32_t packets_per_read = sizeof(rx_buf) / len;
+	const u32_t read_cnt = BENCH_PACKET_CNT / packets_per_read;
+
+	client_setup(MQTT_VERSION_3_1_1);
+	for (u32_t i = 0; i < packets_per_read; i++) {
+		memcpy(rx_buf + i * len, packet, len);
+	}
+
+	u64_t start = bench_timestamp();
+
+	for (u32_t i = 0; i < read_cnt; i++) {
+		(void)mqtt_handle_rx_data(&client, rx_buf,
+					  packets_per_read * len);
+	}
+
+	codec_report("publish_rx", 64, read_cnt * packets_per_read,
+		     (u64_t)read_cnt * packets_per_read * len, start);
+}
+
+static void test_subscribe_encode(void)
+{
+	static char names[BENCH_TOPIC_MAX][sizeof(BENCH_TOPIC) + 4];
+	struct mqtt_topic topics[BENCH_TOPIC_MAX];
+	struct mqtt_subscription_list list = {
+		.list = topics,
+		.message_id = 1,
+	};
+	const u8_t *out;
+	u32_t out_len = 0;
+
+	client_setup(MQTT_VERSION_3_1_1);
+
+	for (size_t i = 0; i < BENCH_TOPIC_MAX; i++) {
+		snprintk(names[i], sizeof(names[i]), "%s/%u", BENCH_TOPIC,
+			 (unsigned int)i);
+		topics[i].topic.utf8 = (u8_t *)names[i];
+		topics[i].topic.size = strlen(names[i]);
+		topics[i].qos = MQTT_QOS_1_AT_LEAST_ONCE;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(topic_counts); i++) {
+		u64_t start = bench_timestamp();
+
+		list.list_count = topic_counts[i];
+
+		for (u32_t j = 0; j < BENCH_PACKET_CNT; j++) {
+			(void)subscribe_encode(&client, &list, &out, &out_len);
+		}
+
+		codec_report("subscribe_encode", topic_counts[i],
+			     BENCH_PACKET_CNT,
+			     (u64_t)out_len * BENCH_PACKET_CNT, start);
+
+		zassert_true(out_len > 0, "Cannot encode SUBSCRIBE");
+	}
+}
+
+static void test_suback_decode(void)
+{
+	struct mqtt_suback_param param;
+	u32_t len;
+
+	client_setup(MQTT_VERSION_3_1_1);
+
+	for (size_t i = 0; i < ARRAY_SIZE(topic_counts); i++) {
+		len = 0;
+		packet[len++] = MQTT_PKT_TYPE_SUBACK;
+		packet[len++] = 2 + topic_counts[i];
+		packet[len++] = 0x00;
+		packet[len++] = 0x01;
+		memset(packet + len, MQTT_SUBACK_SUCCESS_QoS_1,
+		       topic_counts[i]);
+		len += topic_counts[i];
+
+		u64_t start = bench_timestamp();
+
+		for (u32_t j = 0; j < BENCH_PACKET_CNT; j++) {
+			(void)subscribe_ack_decode(&client, packet, len, 2,
+						   &param);
+		}
+
+		codec_report("suback_decode", topic_counts[i],
+			     BENCH_PACKET_CNT, (u64_t)len * BENCH_PACKET_CNT,
+			     start);
+
+		zassert_equal(param.return_codes.len, topic_counts[i],
+			      "Invalid return codes decoded");
+	}
+}
+
+/* Valid packets mutated by the fuzz test. The first byte selects MQTT 5.0 if
+ * odd, the second one the size of reads.
+ */
+static const u8_t seed_connack[] = { 0, 255, 0x20, 0x02, 0x01, 0x00 };
+static const u8_t seed_connack_v5[] = {
+	1, 255, 0x20, 0x09, 0x00, 0x00,
+	0x06, 0x21, 0x00, 0x0A, 0x22, 0x00, 0x04
+};
+static const u8_t seed_publish[] = {
+	0, 3, 0x30, 0x0B, 0x00, 0x05, 't', 'o', 'p', 'i', 'c',
+	'2', '1', '.', '5',
+	0x32, 0x0D, 0x00, 0x05, 't', 'o', 'p', 'i', 'c', 0x00, 0x01,
+	'2', '1', '.', '5'
+};
+static const u8_t seed_publish_v5[] = {
+	1, 255, 0x34, 0x11, 0x00, 0x05, 't', 'o', 'p', 'i', 'c', 0x00, 0x02,
+	0x03, 0x23, 0x00, 0x01, '2', '1', '.', '5'
+};
+static const u8_t seed_publish_stream[] = {
+	0, 63, 0x30, 0xD0, 0x0F, 0x00, 0x05, 't', 'o', 'p', 'i', 'c',
+	'2', '1', '.', '5', 0xD0, 0x00
+};
+static const u8_t seed_acks[] = {
+	0, 7, 0x40, 0x02, 0x00, 0x01, 0x50, 0x02, 0x00, 0x02,
+	0x62, 0x02, 0x00, 0x03, 0x70, 0x02, 0x00, 0x04,
+	0xB0, 0x02, 0x00, 0x06, 0xD0, 0x00
+};
+static const u8_t seed_acks_v5[] = {
+	1, 255, 0x40, 0x03, 0x00, 0x01, 0x10,
+	0x50, 0x04, 0x00, 0x02, 0x80, 0x00,
+	0x90, 0x05, 0x00, 0x05, 0x00, 0x01, 0x02
+};
+static const u8_t seed_suback[] = {
+	0, 255, 0x90, 0x05, 0x00, 0x05, 0x00, 0x01, 0x80
+};
+
+static const struct {
+	const u8_t *data;
+	size_t size;
+} seeds[] = {
+	{ seed_connack, sizeof(seed_connack) },
+	{ seed_connack_v5, sizeof(seed_connack_v5) },
+	{ seed_publish, sizeof(seed_publish) },
+	{ seed_publish_v5, sizeof(seed_publish_v5) },
+	{ seed_publish_stream, sizeof(seed_publish_stream) },
+	{ seed_acks, sizeof(seed_acks) },
+	{ seed_acks_v5, sizeof(seed_acks_v5) },
+	{ seed_suback, sizeof(seed_suback) },
+};
+
+static u32_t fuzz_rand(void)
+{
+	/* Fixed xorshift sequence to make failures reproducible. */
+	static u32_t state = 0x12345678;
+
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+
+	return state;
+}
+
+static size_t fuzz_mutate(u8_t *data, size_t size)
+{
+	u32_t pos = fuzz_rand() % size;
+
+	switch (fuzz_rand() % 5) {
+	case 0:
+		data[pos] ^= BIT(fuzz_rand() % 8);
+		break;
+	case 1:
+		data[pos] = fuzz_rand();
+		break;
+	case 2:
+		/* Lengths with the continuation bit set. */
+		data[pos] = 0x80 | fuzz_rand();
+		break;
+	case 3:
+		size = pos + 1;
+		break;
+	default:
+		if (size < FUZZ_INPUT_MAX_SIZE) {
+			memmove(data + pos + 1, data + pos, size - pos);
+			data[pos] = fuzz_rand();
+			size++;
+		}
+		break;
+	}
+
+	return size;
+}
+
+static void test_fuzz_rx(void)
+{
+	static u8_t input[FUZZ_INPUT_MAX_SIZE];
+	u32_t event_cnt = fuzz_event_count();
+
+	for (size_t i = 0; i < ARRAY_SIZE(seeds); i++) {
+		(void)LLVMFuzzerTestOneInput(seeds[i].data, seeds[i].size);
+	}
+
+	zassert_true(fuzz_event_count() > event_cnt, "Seeds not decoded");
+
+	u64_t start = bench_timestamp();
+
+	for (u32_t i = 0; i < FUZZ_INPUT_CNT; i++) {
+		size_t seed = fuzz_rand() % ARRAY_SIZE(seeds);
+		size_t size = seeds[seed].size;
+		u32_t mutations = 1 + fuzz_rand() % 4;
+
+		memcpy(input, seeds[seed].data, size);
+
+		for (u32_t j = 0; j < mutations; j++) {
+			size = fuzz_mutate(input, size);
+		}
+
+		(void)LLVMFuzzerTestOneInput(input, size);
+	}
+
+	codec_report("fuzz_rx", FUZZ_INPUT_MAX_SIZE, FUZZ_INPUT_CNT, 0, start);
+}
+
+void test_main(void)
+{
+	for (size_t i = 0; i < sizeof(payload); i++) {
+		payload[i] = i;
+	}
+
+	ztest_test_suite(mqtt_codec_benchmark,
+			 ztest_unit_test(test_publish_encode),
+			 ztest_unit_test(test_publish_decode),
+			 ztest_unit_test(test_publish_rx),
+			 ztest_unit_test(test_subscribe_encode),
+			 ztest_unit_test(test_suback_decode),
+			 ztest_unit_test(test_fuzz_rx)
+			 );
+
+	ztest_run_test_suite(mqtt_codec_benchmark);
+}
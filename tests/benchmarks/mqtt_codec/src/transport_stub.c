@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <errno.h>
+
+#include "mqtt_transport.h"
+
+/* The benchmark drives the codec and the receive path directly, the client
+ * is never connected.
+ */
+
+int mqtt_transport_connect(struct mqtt_client *client)
+{
+	return -ENOTCONN;
+}
+
+int mqtt_transport_write(struct mqtt_client *client, const u8_t *data,
+			 u32_t datalen)
+{
+	return -ENOTCONN;
+}
+
+int mqtt_transport_write_msg(struct mqtt_client *client, const u8_t *header,
+			     u32_t header_len, const u8_t *payload,
+			     u32_t payload_len)
+{
+	return -ENOTCONN;
+}
+
+int mqtt_transport_read(struct mqtt_client *client, u8_t *data, u32_t *datalen,
+			bool shall_block)
+{
+	return -ENOTCONN;
+}
+
+int mqtt_transport_disconnect(struct mqtt_client *client)
+{
+	return 0;
+}
+
+int mqtt_transport_sock_get(const struct mqtt_client *client)
+{
+	return -1;
+}
@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include "class_event.h"
+
+
+EVENT_TYPE_DEFINE(high_class_event,
+		  true,
+		  NULL,
+		  NULL);
+
+EVENT_TYPE_DISPATCH_CLASS(high_class_event, EVENT_DISPATCH_CLASS_HIGHEST);
+
+EVENT_TYPE_DEFINE(low_class_event,
+		  true,
+		  NULL,
+		  NULL);
+
+EVENT_TYPE_DISPATCH_CLASS(low_class_event, EVENT_DISPATCH_CLASS_LOWEST);
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _CLASS_EVENT_H_
+#define _CLASS_EVENT_H_
+
+/**
+ * @brief Dispatch Class Events
+ * @defgroup class_event Dispatch Class Events
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Event dispatched in the highest class. */
+struct high_class_event {
+	struct event_header header;
+
+	int val;
+};
+
+EVENT_TYPE_DECLARE(high_class_event);
+
+/* Event dispatched in the lowest class. */
+struct low_class_event {
+	struct event_header header;
+
+	int val;
+};
+
+EVENT_TYPE_DECLARE(low_class_event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _CLASS_EVENT_H_ */
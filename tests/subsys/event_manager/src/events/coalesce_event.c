@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include "coalesce_event.h"
+
+
+static void merge_coalesce_event(struct event_header *queued,
+				 const struct event_header *eh)
+{
+	struct coalesce_event *event = cast_coalesce_event(queued);
+	const struct coalesce_event *new_event = cast_coalesce_event(eh);
+
+	event->val += new_event->val;
+}
+
+EVENT_TYPE_DEFINE(coalesce_event,
+		  true,
+		  NULL,
+		  NULL);
+
+EVENT_TYPE_COALESCE(coalesce_event, merge_coalesce_event);
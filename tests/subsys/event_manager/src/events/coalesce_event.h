@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _COALESCE_EVENT_H_
+#define _COALESCE_EVENT_H_
+
+/**
+ * @brief Coalesce Event
+ * @defgroup coalesce_event Coalesce Event
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct coalesce_event {
+	struct event_header header;
+
+	int val;
+};
+
+EVENT_TYPE_DECLARE(coalesce_event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _COALESCE_EVENT_H_ */
@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include "pool_event.h"
+
+
+EVENT_TYPE_DEFINE(pool_event,
+		  true,
+		  NULL,
+		  NULL,
+		  POOL_EVENT_POOL_SIZE);
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _POOL_EVENT_H_
+#define _POOL_EVENT_H_
+
+/**
+ * @brief Pool Event
+ * @defgroup pool_event Pool Event
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of events in the pool of the event type. */
+#define POOL_EVENT_POOL_SIZE 2
+
+struct pool_event {
+	struct event_header header;
+
+	int val;
+};
+
+EVENT_TYPE_DECLARE(pool_event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _POOL_EVENT_H_ */
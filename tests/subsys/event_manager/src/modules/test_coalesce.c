@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <test_events.h>
+#include <coalesce_event.h>
+
+#include "test_config.h"
+
+#define MODULE test_coalesce
+
+static enum test_id cur_test_id;
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		cur_test_id = st->test_id;
+
+		switch (st->test_id) {
+		case TEST_COALESCE:
+		{
+			/* Events are submitted before the first of them is
+			 * processed, so they can be merged.
+			 */
+			for (size_t i = 0; i < TEST_COALESCE_CNT; i++) {
+				struct coalesce_event *event =
+					new_coalesce_event();
+
+				event->val = 1;
+				EVENT_SUBMIT(event);
+			}
+			break;
+		}
+
+		default:
+			/* Ignore other test cases, check if proper test_id. */
+			zassert_true(st->test_id < TEST_CNT,
+				     "test_id out of range");
+			break;
+		}
+
+		return false;
+	}
+
+	if (is_coalesce_event(eh)) {
+		if (cur_test_id == TEST_COALESCE) {
+			static int sum;
+			static int cnt;
+			struct coalesce_event *event = cast_coalesce_event(eh);
+
+			sum += event->val;
+			cnt++;
+
+			if (sum == TEST_COALESCE_CNT) {
+				int expected_cnt =
+				    IS_ENABLED(CONFIG_DESKTOP_EVENT_MANAGER_COALESCING) ?
+				    1 : TEST_COALESCE_CNT;
+
+				zassert_equal(cnt, expected_cnt,
+					      "Invalid number of events");
+
+				struct test_end_event *te =
+					new_test_end_event();
+
+				te->test_id = TEST_COALESCE;
+				EVENT_SUBMIT(te);
+			}
+		}
+
+		return false;
+	}
+
+	zassert_true(false, "Event unhandled");
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
+EVENT_SUBSCRIBE(MODULE, coalesce_event);
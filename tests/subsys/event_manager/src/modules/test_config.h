@@ -13,3 +13,15 @@
 
 /* TEST_EVENT_ORDER */
 #define TEST_EVENT_ORDER_CNT 20
+
+
+/* TEST_COALESCE */
+#define TEST_COALESCE_CNT 10
+
+
+/* TEST_EVENT_POOL */
+#define TEST_POOL_HEAP_CNT 2
+
+
+/* TEST_DISPATCH_CLASS */
+#define TEST_DISPATCH_CLASS_CNT 5
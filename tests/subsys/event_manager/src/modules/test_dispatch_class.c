@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <test_events.h>
+#include <class_event.h>
+
+#include "test_config.h"
+
+#define MODULE test_dispatch_class
+
+/* With dispatch classes the highest class takes over between the events
+ * of the lowest class. Without them all events are processed in order.
+ */
+#define CLASSES_ENABLED IS_ENABLED(CONFIG_DESKTOP_EVENT_MANAGER_DISPATCH_CLASSES)
+
+static enum test_id cur_test_id;
+static int high_cnt;
+static int low_cnt;
+
+
+static void submit_high(int val)
+{
+	struct high_class_event *event = new_high_class_event();
+
+	event->val = val;
+	EVENT_SUBMIT(event);
+}
+
+static void submit_low(int val)
+{
+	struct low_class_event *event = new_low_class_event();
+
+	event->val = val;
+	EVENT_SUBMIT(event);
+}
+
+static void test_end_check(void)
+{
+	/* One additional high class event is submitted from the first
+	 * low class event handler.
+	 */
+	if ((high_cnt == TEST_DISPATCH_CLASS_CNT + 1) &&
+	    (low_cnt == TEST_DISPATCH_CLASS_CNT)) {
+		struct test_end_event *te = new_test_end_event();
+
+		te->test_id = TEST_DISPATCH_CLASS;
+		EVENT_SUBMIT(te);
+	}
+}
+
+static void low_class_event_handle(const struct low_class_event *event)
+{
+	zassert_equal(event->val, low_cnt, "Incorrect event order in class");
+	low_cnt++;
+
+	if (event->val == 0) {
+		zassert_equal(high_cnt,
+			      CLASSES_ENABLED ? TEST_DISPATCH_CLASS_CNT : 0,
+			      "Higher class not dispatched first");
+		submit_high(TEST_DISPATCH_CLASS_CNT);
+	} else if (event->val == 1) {
+		zassert_equal(high_cnt,
+			      CLASSES_ENABLED ? TEST_DISPATCH_CLASS_CNT + 1 : 0,
+			      "Higher class did not preempt lower class");
+	}
+
+	test_end_check();
+}
+
+static void high_class_event_handle(const struct high_class_event *event)
+{
+	zassert_equal(event->val, high_cnt, "Incorrect event order in class");
+	high_cnt++;
+
+	test_end_check();
+}
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		cur_test_id = st->test_id;
+
+		switch (st->test_id) {
+		case TEST_DISPATCH_CLASS:
+		{
+			high_cnt = 0;
+			low_cnt = 0;
+
+			/* Lower class events are submitted first. */
+			for (int i = 0; i < TEST_DISPATCH_CLASS_CNT; i++) {
+				submit_low(i);
+			}
+			for (int i = 0; i < TEST_DISPATCH_CLASS_CNT; i++) {
+				submit_high(i);
+			}
+			break;
+		}
+
+		default:
+			/* Ignore other test cases, check if proper test_id. */
+			zassert_true(st->test_id < TEST_CNT,
+				     "test_id out of range");
+			break;
+		}
+
+		return false;
+	}
+
+	if (is_low_class_event(eh)) {
+		if (cur_test_id == TEST_DISPATCH_CLASS) {
+			low_class_event_handle(cast_low_class_event(eh));
+		}
+
+		return false;
+	}
+
+	if (is_high_class_event(eh)) {
+		if (cur_test_id == TEST_DISPATCH_CLASS) {
+			high_class_event_handle(cast_high_class_event(eh));
+		}
+
+		return false;
+	}
+
+	zassert_true(false, "Event unhandled");
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
+EVENT_SUBSCRIBE(MODULE, high_class_event);
+EVENT_SUBSCRIBE(MODULE, low_class_event);
@@ -30,6 +30,11 @@ static bool event_handler(const struct event_header *eh)
 		switch (st->test_id) {
 		case TEST_OOM_RESET:
 		{
+			/* Allocated first, as no memory is left until the
+			 * events below are freed.
+			 */
+			struct test_end_event *et = new_test_end_event();
+
 			/* Sending large number of events in infinite loop to
 			 *  cause out of memory error.
 			 */
@@ -42,17 +47,17 @@ static bool event_handler(const struct event_header *eh)
 					      "No OOM detected,"
 					      "increase TEST_EVENTS_CNT");
 			}
-			/* Freeing memory to enable further testing.
-			 * Two last items in array are NULL.
+			/* Freeing memory to enable further testing. The
+			 * events are submitted, so that the Event Manager
+			 * returns them to their pool or to the heap. Last
+			 * item in array is NULL.
 			 */
-			i -= 2;
+			i--;
 			while (i != 0) {
-				k_free(event_tab[i]);
 				i--;
+				EVENT_SUBMIT(event_tab[i]);
 			}
 
-			struct test_end_event *et = new_test_end_event();
-
 			et->test_id = st->test_id;
 			EVENT_SUBMIT(et);
 			break;
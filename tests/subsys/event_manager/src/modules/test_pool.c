@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <test_events.h>
+#include <pool_event.h>
+
+#include "test_config.h"
+
+#define MODULE test_pool
+
+/* Values of the events submitted after the checked ones. */
+#define POOL_CHECK_VAL	-1
+#define POOL_REUSE_VAL	-2
+
+#define TEST_POOL_EVENT_CNT (POOL_EVENT_POOL_SIZE + TEST_POOL_HEAP_CNT)
+
+static enum test_id cur_test_id;
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOLS
+static atomic_val_t heap_alloc_start;
+
+static bool is_pool_block(const struct k_mem_slab *slab, const void *mem)
+{
+	const char *start = slab->buffer;
+	const char *end = start + slab->num_blocks * slab->block_size;
+
+	return ((const char *)mem >= start) && ((const char *)mem < end);
+}
+
+static void pool_alloc_check(struct event_pool *pool)
+{
+	struct pool_event *events[TEST_POOL_EVENT_CNT];
+
+	heap_alloc_start = atomic_get(&pool->heap_alloc_cnt);
+
+	zassert_equal(pool->slab->num_blocks, POOL_EVENT_POOL_SIZE,
+		      "Pool size not set from the event type definition");
+	zassert_equal(k_mem_slab_num_used_get(pool->slab), 0,
+		      "Pool not empty");
+
+	for (size_t i = 0; i < ARRAY_SIZE(events); i++) {
+		events[i] = new_pool_event();
+		events[i]->val = i;
+
+		/* Heap is used only once the pool is exhausted. */
+		zassert_equal(is_pool_block(pool->slab, events[i]),
+			      i < POOL_EVENT_POOL_SIZE,
+			      "Event %u from the wrong allocator", (u32_t)i);
+	}
+
+	zassert_equal(k_mem_slab_num_used_get(pool->slab),
+		      POOL_EVENT_POOL_SIZE, "Pool not used");
+	zassert_equal(atomic_get(&pool->max_used), POOL_EVENT_POOL_SIZE,
+		      "Wrong pool usage");
+	zassert_equal(atomic_get(&pool->heap_alloc_cnt) - heap_alloc_start,
+		      TEST_POOL_HEAP_CNT, "Wrong number of heap allocations");
+
+	for (size_t i = 0; i < ARRAY_SIZE(events); i++) {
+		EVENT_SUBMIT(events[i]);
+	}
+
+	/* Allocated from the heap, the pool blocks are still in use. */
+	struct pool_event *event = new_pool_event();
+
+	event->val = POOL_CHECK_VAL;
+	EVENT_SUBMIT(event);
+}
+
+static void pool_free_check(struct event_pool *pool)
+{
+	/* The events submitted before were processed and freed. */
+	zassert_equal(k_mem_slab_num_used_get(pool->slab), 0,
+		      "Events not returned to the pool");
+	zassert_equal(atomic_get(&pool->heap_alloc_cnt) - heap_alloc_start,
+		      TEST_POOL_HEAP_CNT + 1,
+		      "Wrong number of heap allocations");
+
+	/* The pool serves new events again. */
+	for (size_t i = 0; i < POOL_EVENT_POOL_SIZE; i++) {
+		struct pool_event *event = new_pool_event();
+
+		zassert_true(is_pool_block(pool->slab, event),
+			     "Event not allocated from the pool");
+
+		event->val = POOL_REUSE_VAL;
+		EVENT_SUBMIT(event);
+	}
+
+	zassert_equal(atomic_get(&pool->heap_alloc_cnt) - heap_alloc_start,
+		      TEST_POOL_HEAP_CNT + 1,
+		      "Heap used with free pool blocks");
+}
+#endif /* CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOLS */
+
+static void test_end(void)
+{
+	struct test_end_event *te = new_test_end_event();
+
+	te->test_id = TEST_EVENT_POOL;
+	EVENT_SUBMIT(te);
+}
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		cur_test_id = st->test_id;
+
+		switch (st->test_id) {
+		case TEST_EVENT_POOL:
+		{
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOLS
+			pool_alloc_check(_EVENT_ID(pool_event)->pool);
+#else
+			test_end();
+#endif
+			break;
+		}
+
+		default:
+			/* Ignore other test cases, check if proper test_id. */
+			zassert_true(st->test_id < TEST_CNT,
+				     "test_id out of range");
+			break;
+		}
+
+		return false;
+	}
+
+	if (is_pool_event(eh)) {
+		if (cur_test_id == TEST_EVENT_POOL) {
+			static int i;
+			struct pool_event *event = cast_pool_event(eh);
+
+			if (event->val == POOL_REUSE_VAL) {
+				return false;
+			}
+
+			if (event->val != POOL_CHECK_VAL) {
+				zassert_equal(event->val, i,
+					      "Incorrect event order");
+				i++;
+				return false;
+			}
+
+			zassert_equal(i, TEST_POOL_EVENT_CNT,
+				      "Events not received");
+
+#ifdef CONFIG_DESKTOP_EVENT_MANAGER_EVENT_POOLS
+			pool_free_check(eh->type_id->pool);
+#endif
+			test_end();
+		}
+
+		return false;
+	}
+
+	zassert_true(false, "Event unhandled");
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
+EVENT_SUBSCRIBE(MODULE, pool_event);
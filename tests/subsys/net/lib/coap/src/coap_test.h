@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _COAP_TEST_H_
+#define _COAP_TEST_H_
+
+#include <net/coap_api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Initialize the library with the loopback transport stub. */
+void coap_test_init(void);
+
+/** Let the messages left in the queue time out, and reset the transport. */
+void coap_test_teardown(void);
+
+/** Number of allocations done by the library since the start. */
+size_t coap_test_alloc_count(void);
+
+/** Deliver the queued datagrams and tick the library until the condition
+ *  becomes true, or the number of ticks runs out.
+ *
+ * @return True if the condition became true.
+ */
+bool coap_test_run(const bool *condition, u32_t ticks);
+
+/** Take the oldest datagram written by the library and decode it.
+ *
+ * @param[out] message Decoded message.
+ * @param[out] raw     Buffer of TRANSPORT_STUB_MAX_DATAGRAM_SIZE bytes,
+ *                     which the message points into.
+ *
+ * @return True if a datagram was queued and decoded.
+ */
+bool coap_test_message_take(coap_message_t *message, u8_t *raw);
+
+/** Encode a message created for the test and pass it to the library as
+ *  if it was received. The message is deleted.
+ */
+void coap_test_message_receive(coap_message_t *message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _COAP_TEST_H_ */
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <net/coap_api.h>
+#include <net/coap_message.h>
+
+#include "coap_test.h"
+#include "transport_stub.h"
+
+/* test_block.c */
+void test_block_setup(void);
+void test_block2_sequencing(void);
+void test_block1_sequencing(void);
+void test_block2_size_renegotiation(void);
+void test_block1_size_renegotiation(void);
+void test_block1_out_of_order(void);
+void test_block1_duplicate(void);
+void test_block1_last_block(void);
+void test_block2_last_block(void);
+void test_block_lossy_link(void);
+
+/* test_queue.c */
+void test_queue_setup(void);
+void test_queue_add_remove(void);
+void test_queue_remove_by_mid(void);
+void test_queue_remove_by_token(void);
+void test_queue_expiry_order(void);
+void test_queue_next_deadline(void);
+void test_queue_library_deadline(void);
+void test_queue_tick_wraparound(void);
+void test_queue_full(void);
+
+/* test_message.c */
+void test_message_setup(void);
+void test_message_decode_view(void);
+void test_message_decode_reuse(void);
+void test_message_decode_malformed(void);
+void test_message_decode_option_overflow(void);
+void test_message_encode(void);
+void test_message_receive_no_allocation(void);
+
+/* test_observe.c */
+void test_observe_setup(void);
+void test_observe_notify_fanout(void);
+void test_observe_notify_errors(void);
+void test_observe_con_pacing(void);
+void test_observe_con_pending(void);
+void test_observe_con_reset(void);
+void test_observe_reregister_con_pending(void);
+void test_observe_unregister_during_walk(void);
+
+/* test_resource.c */
+void test_resource_setup(void);
+void test_resource_lookup(void);
+void test_resource_lookup_after_add(void);
+void test_resource_index_overflow(void);
+void test_resource_request_dispatch(void);
+void test_resource_well_known(void);
+void test_resource_well_known_cache(void);
+void test_resource_well_known_root_only(void);
+
+/* test_mem.c */
+void test_mem_stats(void);
+void test_mem_best_fit(void);
+void test_mem_fallback(void);
+void test_mem_exhausted(void);
+void test_mem_oversize(void);
+void test_mem_max_used(void);
+void test_mem_free_foreign(void);
+void test_mem_library(void);
+
+static size_t alloc_count;
+
+static void *test_alloc(size_t size)
+{
+	alloc_count++;
+
+	return k_malloc(size);
+}
+
+static void test_free(void *memory)
+{
+	k_free(memory);
+}
+
+void coap_test_init(void)
+{
+	coap_transport_init_t transport_params = { 0 };
+
+	zassert_equal(coap_init(17, &transport_params, test_alloc, test_free),
+		      0, "CoAP init failed");
+}
+
+void coap_test_teardown(void)
+{
+	u32_t ticks;
+
+	/* Let the messages left in the queue time out, to free them. */
+	while (coap_next_deadline(&ticks) == 0) {
+		(void)coap_time_tick();
+	}
+
+	transport_stub_reset();
+}
+
+size_t coap_test_alloc_count(void)
+{
+	return alloc_count;
+}
+
+bool coap_test_run(const bool *condition, u32_t ticks)
+{
+	while (!*condition && (ticks-- > 0)) {
+		(void)transport_stub_deliver();
+		if (!*condition) {
+			(void)coap_time_tick();
+		}
+	}
+
+	return *condition;
+}
+
+bool coap_test_message_take(coap_message_t *message, u8_t *raw)
+{
+	u16_t len = transport_stub_take(raw, TRANSPORT_STUB_MAX_DATAGRAM_SIZE);
+
+	if (len == 0) {
+		return false;
+	}
+
+	return coap_message_decode(message, raw, len) == 0;
+}
+
+void coap_test_message_receive(coap_message_t *message)
+{
+	static u8_t raw[TRANSPORT_STUB_MAX_DATAGRAM_SIZE];
+	u16_t len = sizeof(raw);
+
+	zassert_equal(coap_message_encode(message, raw, &len), 0,
+		      "Encode failed");
+	zassert_equal(coap_message_delete(message), 0, "Delete failed");
+	zassert_equal(coap_transport_read(0, transport_stub_remote(), NULL, 0,
+					  raw, len), 0, "Read failed");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(coap_tests,
+		ztest_unit_test_setup_teardown(test_block2_sequencing,
+				test_block_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_block1_sequencing,
+				test_block_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_block2_size_renegotiation,
+				test_block_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_block1_size_renegotiation,
+				test_block_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_block1_out_of_order,
+				test_block_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_block1_duplicate,
+				test_block_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_block1_last_block,
+				test_block_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_block2_last_block,
+				test_block_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_block_lossy_link,
+				test_block_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_queue_add_remove,
+				test_queue_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_queue_remove_by_mid,
+				test_queue_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_queue_remove_by_token,
+				test_queue_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_queue_expiry_order,
+				test_queue_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_queue_next_deadline,
+				test_queue_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_queue_library_deadline,
+				test_queue_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_queue_tick_wraparound,
+				test_queue_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_queue_full,
+				test_queue_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_message_decode_view,
+				test_message_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_message_decode_reuse,
+				test_message_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_message_decode_malformed,
+				test_message_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(
+				test_message_decode_option_overflow,
+				test_message_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_message_encode,
+				test_message_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(
+				test_message_receive_no_allocation,
+				test_message_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_observe_notify_fanout,
+				test_observe_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_observe_notify_errors,
+				test_observe_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_observe_con_pacing,
+				test_observe_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_observe_con_pending,
+				test_observe_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_observe_con_reset,
+				test_observe_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(
+				test_observe_reregister_con_pending,
+				test_observe_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(
+				test_observe_unregister_during_walk,
+				test_observe_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_resource_lookup,
+				test_resource_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_resource_lookup_after_add,
+				test_resource_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_resource_index_overflow,
+				test_resource_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_resource_request_dispatch,
+				test_resource_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_resource_well_known,
+				test_resource_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(test_resource_well_known_cache,
+				test_resource_setup, coap_test_teardown),
+		ztest_unit_test_setup_teardown(
+				test_resource_well_known_root_only,
+				test_resource_setup, coap_test_teardown),
+		ztest_unit_test(test_mem_stats),
+		ztest_unit_test(test_mem_best_fit),
+		ztest_unit_test(test_mem_fallback),
+		ztest_unit_test(test_mem_exhausted),
+		ztest_unit_test(test_mem_oversize),
+		ztest_unit_test(test_mem_max_used),
+		ztest_unit_test(test_mem_free_foreign),
+		ztest_unit_test(test_mem_library)
+	);
+
+	ztest_run_test_suite(coap_tests);
+}
@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <net/coap_api.h>
+#include <net/coap_block.h>
+#include <net/coap_option.h>
+
+#include "coap_test.h"
+#include "transport_stub.h"
+
+#define BODY_MAX_SIZE	1000
+#define RUN_TICKS	200
+
+/* Body served and uploaded by the transfers, and the body received. */
+static u8_t body[BODY_MAX_SIZE];
+static u32_t body_len;
+static u8_t received[BODY_MAX_SIZE];
+static u32_t received_len;
+static u32_t write_count;
+static bool write_last;
+
+static coap_block_xfer_t server;
+static coap_block_xfer_t client;
+static bool done;
+static u32_t done_status;
+static u8_t done_code;
+
+static u32_t body_read(coap_block_xfer_t *xfer, u32_t offset, u8_t *data,
+		       u16_t *len, bool *last)
+{
+	u32_t remaining = (offset < body_len) ? (body_len - offset) : 0;
+
+	*len = MIN(*len, remaining);
+	*last = (offset + *len >= body_len);
+	if (*len > 0) {
+		memcpy(data, &body[offset], *len);
+	}
+
+	return 0;
+}
+
+static u32_t body_write(coap_block_xfer_t *xfer, u32_t offset,
+			const u8_t *data, u16_t len, bool last)
+{
+	zassert_equal(offset, received_len, "Block written out of order");
+	zassert_true(offset + len <= sizeof(received), "Body too large");
+
+	if (len > 0) {
+		memcpy(&received[offset], data, len);
+	}
+	received_len += len;
+	write_count++;
+	write_last = last;
+
+	return 0;
+}
+
+static void transfer_done(coap_block_xfer_t *xfer, u32_t status,
+			  coap_message_t *response)
+{
+	done = true;
+	done_status = status;
+	done_code = (response != NULL) ? response->header.code : 0;
+}
+
+static u32_t request_handle(coap_message_t *request)
+{
+	if (request->header.code == COAP_CODE_GET) {
+		return coap_block_server_get_handle(&server, request);
+	}
+
+	return coap_block_server_put_handle(&server, request,
+					    COAP_CODE_204_CHANGED);
+}
+
+void test_block_setup(void)
+{
+	coap_test_init();
+	(void)coap_request_handler_register(request_handle);
+
+	for (size_t i = 0; i < sizeof(body); i++) {
+		body[i] = (u8_t)(i * 7 + 3);
+	}
+
+	memset(&server, 0, sizeof(server));
+	server.read = body_read;
+	server.write = body_write;
+
+	memset(&client, 0, sizeof(client));
+	client.done = transfer_done;
+
+	memset(received, 0, sizeof(received));
+	received_len = 0;
+	write_count = 0;
+	write_last = false;
+	done = false;
+	done_status = 0;
+	done_code = 0;
+}
+
+static void transfer_run(coap_msg_code_t code, u16_t client_size,
+			 u16_t server_size, u32_t len)
+{
+	coap_message_conf_t config = {
+		.type = COAP_TYPE_CON,
+		.code = code,
+		.token = { 0x12, 0x34 },
+		.token_len = 2,
+	};
+
+	body_len = len;
+	server.block_size = server_size;
+	client.block_size = client_size;
+
+	if (code == COAP_CODE_GET) {
+		client.write = body_write;
+	} else {
+		client.read = body_read;
+	}
+
+	zassert_equal(coap_block_client_start(&client, &config,
+					      transport_stub_remote()),
+		      0, "Transfer start failed");
+	zassert_true(coap_test_run(&done, RUN_TICKS), "Transfer not done");
+	zassert_equal(done_status, 0, "Transfer failed");
+	zassert_equal(received_len, len, "Body length differs");
+	zassert_true(memcmp(received, body, len) == 0, "Body differs");
+	zassert_true(write_last, "Last block not flagged");
+}
+
+/* Build a PUT request carrying one Block1 block of the body. */
+static void block1_receive(u32_t number, bool more, u16_t size, u16_t len)
+{
+	coap_message_conf_t config = {
+		.type = COAP_TYPE_CON,
+		.code = COAP_CODE_PUT,
+		.token = { 0x56, 0x78 },
+		.token_len = 2,
+		.id = 100 + number,
+	};
+	coap_block_opt_block1_t opt = {
+		.more = more ? COAP_BLOCK_OPT_BLOCK_MORE_BIT_SET :
+			       COAP_BLOCK_OPT_BLOCK_MORE_BIT_UNSET,
+		.size = size,
+		.number = number,
+	};
+	coap_message_t *request;
+	u32_t encoded;
+
+	zassert_equal(coap_message_new(&request, &config), 0,
+		      "Request not created");
+	zassert_equal(coap_message_remote_addr_set(request,
+						   transport_stub_remote()),
+		      0, "Remote not set");
+	zassert_equal(coap_block_opt_block1_encode(&encoded, &opt), 0,
+		      "Block1 not encoded");
+	zassert_equal(coap_message_opt_uint_add(request, COAP_OPT_BLOCK1,
+						encoded), 0, "Block1 not added");
+	zassert_equal(coap_message_payload_set(request,
+					       &body[number * size], len),
+		      0, "Payload not set");
+
+	coap_test_message_receive(request);
+}
+
+/* Take the response to a request and decode its Block1 option. */
+static u8_t block1_response_take(coap_block_opt_block1_t *opt)
+{
+	static u8_t raw[TRANSPORT_STUB_MAX_DATAGRAM_SIZE];
+	coap_message_t response;
+	u32_t encoded;
+	u8_t index;
+
+	zassert_true(coap_test_message_take(&response, raw), "No response");
+	zassert_equal(transport_stub_pending(), 0, "Unexpected datagram");
+
+	memset(opt, 0, sizeof(*opt));
+	if (coap_message_opt_index_get(&index, &response,
+				       COAP_OPT_BLOCK1) == 0) {
+		zassert_equal(coap_opt_uint_decode(
+				&encoded, response.options[index].length,
+				response.options[index].data),
+			      0, "Block1 not decoded");
+		zassert_equal(coap_block_opt_block1_decode(opt, encoded), 0,
+			      "Block1 not valid");
+	}
+
+	return response.header.code;
+}
+
+void test_block2_sequencing(void)
+{
+	transfer_run(COAP_CODE_GET, 64, 64, BODY_MAX_SIZE);
+
+	zassert_equal(done_code, COAP_CODE_205_CONTENT, "Wrong final code");
+	zassert_equal(write_count, ceiling_fraction(BODY_MAX_SIZE, 64),
+		      "Wrong number of blocks");
+	/* One request and one response per block. */
+	zassert_equal(transport_stub_write_count(), 2 * write_count,
+		      "Blocks were retransmitted");
+}
+
+void test_block1_sequencing(void)
+{
+	transfer_run(COAP_CODE_PUT, 64, 64, BODY_MAX_SIZE);
+
+	zassert_equal(done_code, COAP_CODE_204_CHANGED, "Wrong final code");
+	zassert_equal(write_count, ceiling_fraction(BODY_MAX_SIZE, 64),
+		      "Wrong number of blocks");
+	zassert_equal(transport_stub_write_count(), 2 * write_count,
+		      "Blocks were retransmitted");
+}
+
+void test_block2_size_renegotiation(void)
+{
+	/* The first block is received at the client size, the server then
+	 * continues with its smaller size.
+	 */
+	transfer_run(COAP_CODE_GET, 128, 32, BODY_MAX_SIZE);
+
+	zassert_equal(write_count, ceiling_fraction(BODY_MAX_SIZE, 32),
+		      "Smaller block size not used");
+}
+
+void test_block1_size_renegotiation(void)
+{
+	coap_block_opt_block1_t opt;
+
+	/* The server acknowledges the first 128 byte block proposing 32
+	 * bytes, so the next block is number 4 of 32 bytes.
+	 */
+	server.block_size = 32;
+
+	block1_receive(0, true, 128, 128);
+	zassert_equal(block1_response_take(&opt), COAP_CODE_231_CONTINUE,
+		      "First block not continued");
+	zassert_equal(opt.size, 32, "Smaller block size not proposed");
+	zassert_equal(opt.number, 0, "Wrong block acknowledged");
+
+	block1_receive(4, false, 32, 10);
+	zassert_equal(block1_response_take(&opt), COAP_CODE_204_CHANGED,
+		      "Renegotiated block not accepted");
+	zassert_equal(received_len, 138, "Body length differs");
+
+	/* Whole transfer with the client adapting to the server. */
+	test_block_setup();
+	transfer_run(COAP_CODE_PUT, 128, 32, BODY_MAX_SIZE);
+	zassert_equal(write_count, 1 + ceiling_fraction(BODY_MAX_SIZE - 128, 32),
+		      "Smaller block size not used");
+}
+
+void test_block1_out_of_order(void)
+{
+	coap_block_opt_block1_t opt;
+
+	server.block_size = 64;
+
+	block1_receive(0, true, 64, 64);
+	zassert_equal(block1_response_take(&opt), COAP_CODE_231_CONTINUE,
+		      "First block not continued");
+
+	/* Block 1 is skipped. */
+	block1_receive(2, true, 64, 64);
+	zassert_equal(block1_response_take(&opt),
+		      COAP_CODE_408_REQUEST_ENTITY_INCOMPLETE,
+		      "Missing block not detected");
+	zassert_equal(write_count, 1, "Out of order block written");
+	zassert_equal(received_len, 64, "Out of order block written");
+}
+
+void test_block1_duplicate(void)
+{
+	coap_block_opt_block1_t opt;
+
+	server.block_size = 64;
+
+	block1_receive(0, true, 64, 64);
+	zassert_equal(block1_response_take(&opt), COAP_CODE_231_CONTINUE,
+		      "First block not continued");
+	block1_receive(1, true, 64, 64);
+	zassert_equal(block1_response_take(&opt), COAP_CODE_231_CONTINUE,
+		      "Second block not continued");
+
+	/* The acknowledgment of block 1 was lost and the client resends. */
+	block1_receive(1, true, 64, 64);
+	zassert_equal(block1_response_take(&opt), COAP_CODE_231_CONTINUE,
+		      "Duplicate block not acknowledged");
+	zassert_equal(opt.number, 1, "Wrong block acknowledged");
+	zassert_equal(opt.more, COAP_BLOCK_OPT_BLOCK_MORE_BIT_SET,
+		      "Wrong more flag acknowledged");
+	zassert_equal(write_count, 2, "Duplicate block written");
+
+	block1_receive(2, true, 64, 64);
+	zassert_equal(block1_response_take(&opt), COAP_CODE_231_CONTINUE,
+		      "Transfer not continued after duplicate");
+	zassert_equal(received_len, 192, "Body length differs");
+	zassert_true(memcmp(received, body, received_len) == 0,
+		     "Body differs");
+}
+
+void test_block1_last_block(void)
+{
+	coap_block_opt_block1_t opt;
+
+	server.block_size = 64;
+
+	block1_receive(0, true, 64, 64);
+	zassert_equal(block1_response_take(&opt), COAP_CODE_231_CONTINUE,
+		      "First block not continued");
+	zassert_false(write_last, "First block flagged last");
+
+	block1_receive(1, false, 64, 20);
+	zassert_equal(block1_response_take(&opt), COAP_CODE_204_CHANGED,
+		      "Last block not responded with the final code");
+	zassert_equal(opt.number, 1, "Wrong block acknowledged");
+	zassert_equal(opt.more, COAP_BLOCK_OPT_BLOCK_MORE_BIT_UNSET,
+		      "Last block acknowledged with more flag");
+	zassert_true(write_last, "Last block not flagged");
+	zassert_equal(received_len, 84, "Body length differs");
+}
+
+void test_block2_last_block(void)
+{
+	/* Body ending on a block boundary, and an empty body, both end with
+	 * a block without the more flag.
+	 */
+	transfer_run(COAP_CODE_GET, 64, 64, 128);
+	zassert_equal(write_count, 2, "Wrong number of blocks");
+
+	test_block_setup();
+	transfer_run(COAP_CODE_GET, 64, 64, 0);
+	zassert_equal(write_count, 1, "Wrong number of blocks");
+}
+
+void test_block_lossy_link(void)
+{
+	transport_stub_drop_set(5);
+	transport_stub_duplicate_set(true);
+	transfer_run(COAP_CODE_GET, 64, 32, BODY_MAX_SIZE);
+
+	test_block_setup();
+	transport_stub_drop_set(4);
+	transport_stub_duplicate_set(true);
+	transfer_run(COAP_CODE_PUT, 64, 32, BODY_MAX_SIZE);
+}
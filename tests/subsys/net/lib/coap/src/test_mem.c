@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <net/coap_api.h>
+
+#include "coap_test.h"
+#include "transport_stub.h"
+
+/* More than the blocks of any pool in the test configuration. */
+#define MAX_BLOCKS	16
+
+static coap_mem_stats_t stats_get(coap_mem_pool_t pool)
+{
+	coap_mem_stats_t stats;
+
+	zassert_equal(coap_mem_stats_get(pool, &stats), 0, "No stats");
+
+	return stats;
+}
+
+static u16_t used_get(coap_mem_pool_t pool)
+{
+	return stats_get(pool).used;
+}
+
+/* Take every block of the pool, the blocks are returned in the array. */
+static void pool_exhaust(coap_mem_pool_t pool, void **blocks)
+{
+	coap_mem_stats_t stats = stats_get(pool);
+
+	zassert_true(stats.block_count <= MAX_BLOCKS, "Pool too large");
+
+	for (int i = 0; i < stats.block_count; i++) {
+		blocks[i] = coap_mem_alloc(stats.block_size);
+		zassert_not_null(blocks[i], "Block not allocated");
+	}
+
+	zassert_equal(used_get(pool), stats.block_count, "Pool not full");
+}
+
+static void pool_release(coap_mem_pool_t pool, void **blocks)
+{
+	for (int i = 0; i < stats_get(pool).block_count; i++) {
+		coap_mem_free(blocks[i]);
+	}
+
+	zassert_equal(used_get(pool), 0, "Pool not released");
+}
+
+void test_mem_stats(void)
+{
+	coap_mem_stats_t stats;
+
+	zassert_equal(coap_mem_stats_get(COAP_MEM_POOL_BUFFER, NULL), EINVAL,
+		      "NULL not rejected");
+	zassert_equal(coap_mem_stats_get(COAP_MEM_POOL_COUNT, &stats),
+		      EINVAL, "Invalid pool not rejected");
+
+	stats = stats_get(COAP_MEM_POOL_SMALL);
+	zassert_equal(stats.block_count, CONFIG_NRF_COAP_MEM_SMALL_BUFFER_COUNT,
+		      "Wrong small block count");
+	zassert_true(stats.block_size >= CONFIG_NRF_COAP_MEM_SMALL_BUFFER_SIZE,
+		     "Small blocks too small");
+
+	stats = stats_get(COAP_MEM_POOL_MESSAGE);
+	zassert_equal(stats.block_count, CONFIG_NRF_COAP_MEM_MESSAGE_COUNT,
+		      "Wrong message block count");
+	zassert_true(stats.block_size >= sizeof(coap_message_t),
+		     "Message blocks too small");
+
+	stats = stats_get(COAP_MEM_POOL_BUFFER);
+	zassert_equal(stats.block_count, CONFIG_NRF_COAP_MEM_BUFFER_COUNT,
+		      "Wrong buffer block count");
+	zassert_true(stats.block_size >= COAP_MESSAGE_DATA_MAX_SIZE,
+		     "Buffer blocks too small");
+
+	for (int i = 0; i < COAP_MEM_POOL_COUNT; i++) {
+		zassert_equal(used_get(i), 0, "Pool %d in use", i);
+	}
+}
+
+void test_mem_best_fit(void)
+{
+	void *block;
+
+	for (int i = 0; i < COAP_MEM_POOL_COUNT; i++) {
+		coap_mem_stats_t stats = stats_get(i);
+
+		/* A request of exactly the block size fits no smaller pool. */
+		block = coap_mem_alloc(stats.block_size);
+		zassert_not_null(block, "Block not allocated");
+		zassert_equal(used_get(i), 1, "Pool %d not used", i);
+
+		coap_mem_free(block);
+		zassert_equal(used_get(i), 0, "Pool %d block not freed", i);
+	}
+
+	/* The smallest request is served from the smallest blocks. */
+	block = coap_mem_alloc(1);
+	zassert_not_null(block, "Block not allocated");
+	zassert_equal(used_get(COAP_MEM_POOL_SMALL), 1, "Small pool not used");
+
+	coap_mem_free(block);
+}
+
+void test_mem_fallback(void)
+{
+	coap_mem_stats_t small = stats_get(COAP_MEM_POOL_SMALL);
+	coap_mem_stats_t larger = stats_get(COAP_MEM_POOL_MESSAGE);
+	void *blocks[MAX_BLOCKS];
+	void *block;
+
+	pool_exhaust(COAP_MEM_POOL_SMALL, blocks);
+
+	/* An empty best fit pool falls back to the next larger blocks, and
+	 * records the miss on the best fit pool.
+	 */
+	block = coap_mem_alloc(1);
+	zassert_not_null(block, "No fallback block");
+	zassert_equal(used_get(COAP_MEM_POOL_MESSAGE), larger.used + 1,
+		      "Fallback pool not used");
+	zassert_equal(stats_get(COAP_MEM_POOL_SMALL).failures,
+		      small.failures + 1, "Miss not counted");
+	zassert_equal(stats_get(COAP_MEM_POOL_MESSAGE).failures,
+		      larger.failures, "Miss counted on fallback pool");
+
+	coap_mem_free(block);
+	pool_release(COAP_MEM_POOL_SMALL, blocks);
+}
+
+void test_mem_exhausted(void)
+{
+	coap_mem_stats_t stats = stats_get(COAP_MEM_POOL_BUFFER);
+	void *blocks[MAX_BLOCKS];
+
+	pool_exhaust(COAP_MEM_POOL_BUFFER, blocks);
+
+	/* There are no larger blocks to fall back to. */
+	zassert_is_null(coap_mem_alloc(stats.block_size), "Block allocated");
+	zassert_equal(stats_get(COAP_MEM_POOL_BUFFER).failures,
+		      stats.failures + 1, "Failure not counted");
+
+	pool_release(COAP_MEM_POOL_BUFFER, blocks);
+}
+
+void test_mem_oversize(void)
+{
+	coap_mem_stats_t before[COAP_MEM_POOL_COUNT];
+	u16_t largest = 0;
+
+	for (int i = 0; i < COAP_MEM_POOL_COUNT; i++) {
+		before[i] = stats_get(i);
+		largest = MAX(largest, before[i].block_size);
+	}
+
+	zassert_is_null(coap_mem_alloc(largest + 1), "Oversize allocated");
+
+	/* No pool fits, so no pool is charged with the failure. */
+	for (int i = 0; i < COAP_MEM_POOL_COUNT; i++) {
+		zassert_equal(used_get(i), before[i].used, "Pool %d used", i);
+		zassert_equal(stats_get(i).failures, before[i].failures,
+			      "Failure counted on pool %d", i);
+	}
+}
+
+void test_mem_max_used(void)
+{
+	coap_mem_stats_t stats = stats_get(COAP_MEM_POOL_BUFFER);
+	void *blocks[MAX_BLOCKS];
+
+	pool_exhaust(COAP_MEM_POOL_BUFFER, blocks);
+	pool_release(COAP_MEM_POOL_BUFFER, blocks);
+
+	/* The high-water mark stays after the blocks are freed. */
+	stats = stats_get(COAP_MEM_POOL_BUFFER);
+	zassert_equal(stats.used, 0, "Blocks in use");
+	zassert_equal(stats.max_used, stats.block_count,
+		      "High-water mark not kept");
+}
+
+void test_mem_free_foreign(void)
+{
+	coap_mem_stats_t before[COAP_MEM_POOL_COUNT];
+	u32_t foreign;
+
+	for (int i = 0; i < COAP_MEM_POOL_COUNT; i++) {
+		before[i] = stats_get(i);
+	}
+
+	coap_mem_free(NULL);
+	coap_mem_free(&foreign);
+
+	for (int i = 0; i < COAP_MEM_POOL_COUNT; i++) {
+		zassert_equal(used_get(i), before[i].used,
+			      "Pool %d changed", i);
+	}
+}
+
+void test_mem_library(void)
+{
+	coap_transport_init_t transport_params = { 0 };
+	coap_message_conf_t config = {
+		.type = COAP_TYPE_CON,
+		.code = COAP_CODE_GET,
+	};
+	coap_message_t *request;
+	u32_t handle;
+	u32_t ticks;
+
+	zassert_equal(coap_init(17, &transport_params, coap_mem_alloc,
+				coap_mem_free), 0, "CoAP init failed");
+	transport_stub_tx_buffer_set(false);
+
+	zassert_equal(coap_message_new(&request, &config), 0,
+		      "Request not created");
+	zassert_equal(used_get(COAP_MEM_POOL_MESSAGE), 1,
+		      "Message not from the pool");
+	zassert_equal(coap_message_remote_addr_set(request,
+						   transport_stub_remote()),
+		      0, "Remote not set");
+	zassert_equal(coap_message_send(&handle, request), 0,
+		      "Request not sent");
+	zassert_equal(coap_message_delete(request), 0, "Request not deleted");
+
+	/* The encoded CON request is kept for retransmission. */
+	zassert_equal(used_get(COAP_MEM_POOL_MESSAGE), 0, "Message leaked");
+	zassert_equal(used_get(COAP_MEM_POOL_SMALL) +
+		      used_get(COAP_MEM_POOL_BUFFER), 1,
+		      "Request not kept in a pool");
+
+	while (coap_next_deadline(&ticks) == 0) {
+		(void)coap_time_tick();
+	}
+
+	for (int i = 0; i < COAP_MEM_POOL_COUNT; i++) {
+		zassert_equal(used_get(i), 0, "Pool %d leaked", i);
+	}
+
+	transport_stub_reset();
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <net/coap_api.h>
+#include <net/coap_message.h>
+
+#include "coap_test.h"
+#include "transport_stub.h"
+
+/* CON GET, token 0xAB 0xCD, Uri-Path "temp", Uri-Query "u=c" and a payload. */
+static const u8_t request[] = {
+	0x42, 0x01, 0x12, 0x34, 0xAB, 0xCD,
+	0xB4, 't', 'e', 'm', 'p',
+	0x43, 'u', '=', 'c',
+	0xFF, '2', '1', '.', '5',
+};
+
+void test_message_setup(void)
+{
+	coap_test_init();
+	(void)coap_request_handler_register(NULL);
+	transport_stub_tx_buffer_set(true);
+}
+
+void test_message_decode_view(void)
+{
+	coap_message_t message;
+
+	zassert_equal(coap_message_decode(&message, request, sizeof(request)),
+		      0, "Decode failed");
+
+	zassert_equal(message.header.type, COAP_TYPE_CON, "Wrong type");
+	zassert_equal(message.header.code, COAP_CODE_GET, "Wrong code");
+	zassert_equal(message.header.id, 0x1234, "Wrong message ID");
+	zassert_equal(message.header.token_len, 2, "Wrong token length");
+	zassert_equal(message.token[1], 0xCD, "Wrong token");
+	zassert_equal(message.options_count, 2, "Wrong option count");
+
+	/* Option values and the payload are not copied. */
+	zassert_equal(message.options[0].number, COAP_OPT_URI_PATH,
+		      "Wrong option");
+	zassert_equal(message.options[0].length, 4, "Wrong option length");
+	zassert_equal(message.options[0].data, &request[7],
+		      "Option value copied");
+	zassert_equal(message.options[1].number, COAP_OPT_URI_QUERY,
+		      "Wrong option");
+	zassert_equal(message.options[1].data, &request[12],
+		      "Option value copied");
+	zassert_equal(message.payload, &request[16], "Payload copied");
+	zassert_equal(message.payload_len, 4, "Wrong payload length");
+}
+
+void test_message_decode_reuse(void)
+{
+	coap_message_t message;
+
+	zassert_equal(coap_message_decode(&message, request, sizeof(request)),
+		      0, "Decode failed");
+
+	/* The views of a previous decode do not leak into the next one. */
+	zassert_equal(coap_message_decode(&message, request, 6), 0,
+		      "Decode failed");
+	zassert_equal(message.options_count, 0, "Options kept");
+	zassert_equal(message.payload, NULL, "Payload kept");
+	zassert_equal(message.payload_len, 0, "Payload kept");
+}
+
+void test_message_decode_malformed(void)
+{
+	coap_message_t message;
+	u8_t raw[sizeof(request)];
+
+	zassert_equal(coap_message_decode(&message, request, 3), EMSGSIZE,
+		      "Short header accepted");
+	zassert_equal(coap_message_decode(&message, request, 5), EMSGSIZE,
+		      "Truncated token accepted");
+
+	/* Option value running past the end of the datagram. */
+	zassert_equal(coap_message_decode(&message, request, 9), EINVAL,
+		      "Truncated option accepted");
+
+	/* Reserved token length. */
+	memcpy(raw, request, sizeof(raw));
+	raw[0] = 0x49;
+	zassert_equal(coap_message_decode(&message, raw, sizeof(raw)), EINVAL,
+		      "Reserved token length accepted");
+
+	/* Reserved option delta and length nibbles. */
+	memcpy(raw, request, sizeof(raw));
+	raw[6] = 0xF4;
+	zassert_equal(coap_message_decode(&message, raw, sizeof(raw)), EINVAL,
+		      "Reserved option delta accepted");
+	raw[6] = 0xBF;
+	zassert_equal(coap_message_decode(&message, raw, sizeof(raw)), EINVAL,
+		      "Reserved option length accepted");
+}
+
+void test_message_decode_option_overflow(void)
+{
+	coap_message_t message;
+	u8_t raw[4 + CONFIG_NRF_COAP_MAX_NUMBER_OF_OPTIONS + 1];
+
+	/* Empty If-Match options, one more than fit the option table. */
+	memcpy(raw, request, 4);
+	raw[0] = 0x40;
+	memset(&raw[4], 0x00, sizeof(raw) - 4);
+	raw[4] = 0x10;
+
+	zassert_equal(coap_message_decode(&message, raw, sizeof(raw) - 1), 0,
+		      "Full option table rejected");
+	zassert_equal(message.options_count,
+		      CONFIG_NRF_COAP_MAX_NUMBER_OF_OPTIONS,
+		      "Wrong option count");
+	zassert_equal(coap_message_decode(&message, raw, sizeof(raw)), ENOMEM,
+		      "Option table overflowed");
+}
+
+void test_message_encode(void)
+{
+	static u8_t raw[sizeof(request)];
+	coap_message_conf_t config = {
+		.type = COAP_TYPE_CON,
+		.code = COAP_CODE_GET,
+		.id = 0x1234,
+		.token = { 0xAB, 0xCD },
+		.token_len = 2,
+	};
+	coap_message_t *message;
+	u16_t len = 0;
+
+	zassert_equal(coap_message_new(&message, &config), 0,
+		      "Message not created");
+	zassert_equal(coap_message_opt_str_add(message, COAP_OPT_URI_PATH,
+					       (u8_t *)"temp", 4),
+		      0, "Option not added");
+	zassert_equal(coap_message_opt_str_add(message, COAP_OPT_URI_QUERY,
+					       (u8_t *)"u=c", 3),
+		      0, "Option not added");
+	zassert_equal(coap_message_payload_set(message, "21.5", 4), 0,
+		      "Payload not set");
+
+	/* Length only, then the message. */
+	zassert_equal(coap_message_encode(message, NULL, &len), 0,
+		      "Length not calculated");
+	zassert_equal(len, sizeof(request), "Wrong length");
+	zassert_equal(coap_message_encode(message, raw, &len), 0,
+		      "Encode failed");
+	zassert_true(memcmp(raw, request, sizeof(request)) == 0,
+		     "Encoded message differs");
+
+	len = sizeof(request) - 1;
+	zassert_equal(coap_message_encode(message, raw, &len), EMSGSIZE,
+		      "Too small buffer accepted");
+
+	zassert_equal(coap_message_delete(message), 0, "Message not deleted");
+}
+
+static void error_response_check(size_t expected_allocations)
+{
+	static u8_t raw[TRANSPORT_STUB_MAX_DATAGRAM_SIZE];
+	coap_message_t response;
+	size_t allocations = coap_test_alloc_count();
+
+	/* No resource is registered, so the request is responded with
+	 * 4.04 Not Found.
+	 */
+	zassert_equal(coap_transport_read(0, transport_stub_remote(), NULL, 0,
+					  request, sizeof(request)),
+		      0, "Request not handled");
+
+	zassert_equal(coap_test_alloc_count() - allocations,
+		      expected_allocations, "Wrong number of allocations");
+	zassert_true(coap_test_message_take(&response, raw), "No response");
+	zassert_equal(response.header.type, COAP_TYPE_ACK, "Wrong type");
+	zassert_equal(response.header.code, COAP_CODE_404_NOT_FOUND,
+		      "Wrong code");
+	zassert_equal(response.header.id, 0x1234, "Wrong message ID");
+	zassert_equal(response.header.token_len, 2, "Wrong token length");
+	zassert_true(memcmp(response.token, &request[4], 2) == 0,
+		     "Wrong token");
+}
+
+void test_message_receive_no_allocation(void)
+{
+	/* Decoded on the stack, responded from the transport TX buffer. */
+	error_response_check(0);
+
+	/* The response buffer is allocated if the transport has none. */
+	transport_stub_tx_buffer_set(false);
+	error_response_check(1);
+}
@@ -0,0 +1,414 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <net/coap_api.h>
+#include <net/coap_observe_api.h>
+#include <net/coap_option.h>
+
+#include "coap_test.h"
+#include "transport_stub.h"
+
+#define OBSERVER_COUNT	CONFIG_NRF_COAP_OBSERVE_MAX_NUM_OBSERVERS
+#define CON_INTERVAL	CONFIG_NRF_COAP_OBSERVE_CON_INTERVAL
+
+static coap_resource_t resource;
+static coap_resource_t other_resource;
+static struct sockaddr_in6 remotes[OBSERVER_COUNT];
+static u32_t handles[OBSERVER_COUNT];
+
+static const u8_t payload[] = "21.5";
+
+/* Notification taken from the transport. */
+struct notification {
+	u8_t type;
+	u16_t id;
+	u8_t token_len;
+	u8_t token[8];
+	u32_t observe;
+	u32_t ct;
+};
+
+static u32_t observer_add(size_t index, coap_resource_t *of_interest,
+			  coap_content_type_t ct)
+{
+	coap_observer_t observer = {
+		.remote = (struct sockaddr *)&remotes[index],
+		.resource_of_interest = of_interest,
+		.ct = ct,
+		/* Tokens of different lengths, 1 to 8 bytes. */
+		.token_len = 1 + (index % 8),
+	};
+
+	memset(observer.token, 0x10 + index, sizeof(observer.token));
+
+	return coap_observe_server_register(&handles[index], &observer);
+}
+
+static u32_t option_uint_get(coap_message_t *message, u16_t option)
+{
+	u32_t value = 0;
+	u8_t index;
+
+	zassert_equal(coap_message_opt_index_get(&index, message, option), 0,
+		      "Option missing");
+	zassert_equal(coap_opt_uint_decode(&value,
+					   message->options[index].length,
+					   message->options[index].data),
+		      0, "Option not decoded");
+
+	return value;
+}
+
+static bool notification_take(struct notification *notification)
+{
+	static u8_t raw[TRANSPORT_STUB_MAX_DATAGRAM_SIZE];
+	coap_message_t message;
+
+	if (!coap_test_message_take(&message, raw)) {
+		return false;
+	}
+
+	zassert_equal(message.header.code, COAP_CODE_205_CONTENT,
+		      "Wrong code");
+	zassert_equal(message.payload_len, sizeof(payload), "Wrong payload");
+	zassert_true(memcmp(message.payload, payload, sizeof(payload)) == 0,
+		     "Wrong payload");
+	zassert_equal(option_uint_get(&message, COAP_OPT_MAX_AGE),
+		      resource.max_age, "Wrong Max-Age");
+
+	notification->type = message.header.type;
+	notification->id = message.header.id;
+	notification->token_len = message.header.token_len;
+	memcpy(notification->token, message.token, message.header.token_len);
+	notification->observe = option_uint_get(&message, COAP_OPT_OBSERVE);
+	notification->ct = option_uint_get(&message,
+					   COAP_OPT_CONTENT_FORMAT);
+
+	return true;
+}
+
+/* Index of the observer the notification was sent to. */
+static size_t notification_observer(const struct notification *notification)
+{
+	size_t index = notification->token[0] - 0x10;
+
+	zassert_true(index < OBSERVER_COUNT, "Unknown token");
+	zassert_equal(notification->token_len, 1 + (index % 8),
+		      "Wrong token length");
+
+	return index;
+}
+
+/* Respond to a CON notification with an empty ACK or RST. */
+static void notification_respond(const struct notification *notification,
+				 coap_msg_type_t type)
+{
+	u8_t raw[4] = {
+		(1 << 6) | (type << 4),
+		COAP_CODE_EMPTY_MESSAGE,
+		(u8_t)(notification->id >> 8),
+		(u8_t)notification->id,
+	};
+
+	(void)coap_transport_read(0, transport_stub_remote(), NULL, 0, raw,
+				  sizeof(raw));
+}
+
+void test_observe_setup(void)
+{
+	coap_test_init();
+
+	memset(&resource, 0, sizeof(resource));
+	resource.max_age = 60;
+	memset(&other_resource, 0, sizeof(other_resource));
+
+	for (size_t i = 0; i < OBSERVER_COUNT; i++) {
+		remotes[i].sin6_family = AF_INET6;
+		remotes[i].sin6_port = htons(5683 + i);
+	}
+}
+
+void test_observe_notify_fanout(void)
+{
+	struct notification notification;
+	u32_t observe = 0;
+	u16_t ids = 0;
+
+	for (size_t i = 0; i < OBSERVER_COUNT - 2; i++) {
+		zassert_equal(observer_add(i, &resource,
+					   COAP_CT_APP_JSON), 0,
+			      "Observer not registered");
+	}
+
+	/* Observers of another resource and of another content format are
+	 * not notified.
+	 */
+	zassert_equal(observer_add(OBSERVER_COUNT - 2, &other_resource,
+				   COAP_CT_APP_JSON), 0,
+		      "Observer not registered");
+	zassert_equal(observer_add(OBSERVER_COUNT - 1, &resource,
+				   COAP_CT_PLAIN_TEXT), 0,
+		      "Observer not registered");
+
+	zassert_equal(coap_observe_notify(&resource, COAP_TYPE_NON,
+					  COAP_CT_APP_JSON, payload,
+					  sizeof(payload)),
+		      0, "Notify failed");
+
+	for (size_t i = 0; i < OBSERVER_COUNT - 2; i++) {
+		zassert_true(notification_take(&notification),
+			     "Observer not notified");
+		zassert_true(notification_observer(&notification) <
+			     OBSERVER_COUNT - 2, "Wrong observer notified");
+		zassert_equal(notification.ct, COAP_CT_APP_JSON,
+			      "Wrong Content-Format");
+
+		/* One Observe value per notification, and a message ID per
+		 * observer.
+		 */
+		if (i == 0) {
+			observe = notification.observe;
+		}
+		zassert_equal(notification.observe, observe,
+			      "Observe value differs");
+		zassert_false(ids & BIT(notification.id % 16),
+			      "Message ID reused");
+		ids |= BIT(notification.id % 16);
+	}
+
+	zassert_equal(transport_stub_pending(), 0, "Unexpected notification");
+
+	/* The Observe value increases with every notification. */
+	zassert_equal(coap_observe_notify(&resource, COAP_TYPE_NON,
+					  COAP_CT_PLAIN_TEXT, payload,
+					  sizeof(payload)),
+		      0, "Notify failed");
+	zassert_true(notification_take(&notification),
+		     "Observer not notified");
+	zassert_equal(notification_observer(&notification),
+		      OBSERVER_COUNT - 1, "Wrong observer notified");
+	zassert_true(notification.observe > observe,
+		     "Observe value not increased");
+}
+
+void test_observe_notify_errors(void)
+{
+	static u8_t large[CONFIG_NRF_COAP_MESSAGE_DATA_MAX_SIZE];
+
+	zassert_equal(coap_observe_notify(&resource, COAP_TYPE_NON,
+					  COAP_CT_APP_JSON, payload,
+					  sizeof(payload)),
+		      ENOENT, "Notified without observers");
+
+	zassert_equal(observer_add(0, &resource, COAP_CT_APP_JSON), 0,
+		      "Observer not registered");
+
+	zassert_equal(coap_observe_notify(NULL, COAP_TYPE_NON,
+					  COAP_CT_APP_JSON, payload,
+					  sizeof(payload)),
+		      EINVAL, "NULL resource accepted");
+	zassert_equal(coap_observe_notify(&resource, COAP_TYPE_NON,
+					  COAP_CT_APP_JSON, NULL, 1),
+		      EINVAL, "NULL payload accepted");
+	zassert_equal(coap_observe_notify(&resource, COAP_TYPE_NON,
+					  COAP_CT_APP_JSON, large,
+					  sizeof(large)),
+		      EMSGSIZE, "Oversized notification accepted");
+	zassert_equal(transport_stub_pending(), 0, "Unexpected notification");
+}
+
+void test_observe_con_pacing(void)
+{
+	struct notification notification;
+	u32_t con_count[OBSERVER_COUNT] = { 0 };
+
+	for (size_t i = 0; i < OBSERVER_COUNT; i++) {
+		zassert_equal(observer_add(i, &resource, COAP_CT_APP_JSON), 0,
+			      "Observer not registered");
+	}
+
+	/* Every observer gets one CON notification per interval, and the
+	 * CON notifications are spread over the interval.
+	 */
+	for (size_t n = 0; n < 2 * CON_INTERVAL; n++) {
+		size_t cons = 0;
+
+		zassert_equal(coap_observe_notify(&resource, COAP_TYPE_NON,
+						  COAP_CT_APP_JSON, payload,
+						  sizeof(payload)),
+			      0, "Notify failed");
+
+		while (notification_take(&notification)) {
+			if (notification.type == COAP_TYPE_CON) {
+				con_count[notification_observer(
+						&notification)]++;
+				notification_respond(&notification,
+						     COAP_TYPE_ACK);
+				cons++;
+			}
+		}
+
+		zassert_true(cons <= ceiling_fraction(OBSERVER_COUNT, CON_INTERVAL),
+			     "CON notifications not spread");
+	}
+
+	for (size_t i = 0; i < OBSERVER_COUNT; i++) {
+		zassert_equal(con_count[i], 2, "Wrong number of CONs");
+	}
+}
+
+void test_observe_con_pending(void)
+{
+	struct notification notification;
+	coap_observer_t *observer;
+	u32_t ticks;
+
+	zassert_equal(observer_add(0, &resource, COAP_CT_APP_JSON), 0,
+		      "Observer not registered");
+
+	zassert_equal(coap_observe_notify(&resource, COAP_TYPE_CON,
+					  COAP_CT_APP_JSON, payload,
+					  sizeof(payload)),
+		      0, "Notify failed");
+	zassert_true(notification_take(&notification), "Not notified");
+	zassert_equal(notification.type, COAP_TYPE_CON, "CON not sent");
+
+	/* No second CON while the first one is not acknowledged. */
+	zassert_equal(coap_observe_notify(&resource, COAP_TYPE_CON,
+					  COAP_CT_APP_JSON, payload,
+					  sizeof(payload)),
+		      0, "Notify failed");
+	zassert_true(notification_take(&notification), "Not notified");
+	zassert_equal(notification.type, COAP_TYPE_NON,
+		      "Second CON sent while one is pending");
+
+	/* The observer is dropped when the CON notification times out. */
+	while (coap_next_deadline(&ticks) == 0) {
+		(void)coap_time_tick();
+	}
+
+	zassert_equal(coap_observe_server_get(handles[0], &observer), ENOENT,
+		      "Observer kept after timeout");
+}
+
+void test_observe_con_reset(void)
+{
+	struct notification notification;
+	coap_observer_t *observer;
+
+	zassert_equal(observer_add(0, &resource, COAP_CT_APP_JSON), 0,
+		      "Observer not registered");
+	zassert_equal(observer_add(1, &resource, COAP_CT_APP_JSON), 0,
+		      "Observer not registered");
+
+	zassert_equal(coap_observe_notify(&resource, COAP_TYPE_CON,
+					  COAP_CT_APP_JSON, payload,
+					  sizeof(payload)),
+		      0, "Notify failed");
+
+	/* One observer rejects the notification, the other acknowledges. */
+	while (notification_take(&notification)) {
+		zassert_equal(notification.type, COAP_TYPE_CON,
+			      "CON not sent");
+		notification_respond(&notification,
+				     (notification_observer(&notification) ==
+				      0) ? COAP_TYPE_RST : COAP_TYPE_ACK);
+	}
+
+	zassert_equal(coap_observe_server_get(handles[0], &observer), ENOENT,
+		      "Observer kept after reset");
+	zassert_equal(coap_observe_server_get(handles[1], &observer), 0,
+		      "Acknowledging observer dropped");
+}
+
+/* Send a CON notification to the only observer and take it. */
+static void con_notify(struct notification *notification, size_t index)
+{
+	zassert_equal(coap_observe_notify(&resource, COAP_TYPE_CON,
+					  COAP_CT_APP_JSON, payload,
+					  sizeof(payload)),
+		      0, "Notify failed");
+	zassert_true(notification_take(notification), "Not notified");
+	zassert_equal(notification->type, COAP_TYPE_CON, "CON not sent");
+	zassert_equal(notification_observer(notification), index,
+		      "Wrong observer notified");
+}
+
+void test_observe_reregister_con_pending(void)
+{
+	struct notification old;
+	struct notification pending;
+	struct notification notification;
+	coap_observer_t *observer;
+
+	zassert_equal(observer_add(0, &resource, COAP_CT_APP_JSON), 0,
+		      "Observer not registered");
+	con_notify(&old, 0);
+
+	/* A new observer takes the slot while the CON is not acknowledged. */
+	zassert_equal(coap_observe_server_unregister(handles[0]), 0,
+		      "Observer not unregistered");
+	zassert_equal(observer_add(1, &resource, COAP_CT_APP_JSON), 0,
+		      "Observer not registered");
+	zassert_equal(handles[1], handles[0], "Slot not reused");
+	con_notify(&pending, 1);
+
+	/* The acknowledgment of the old CON leaves the new one pending. */
+	notification_respond(&old, COAP_TYPE_ACK);
+	zassert_equal(coap_observe_notify(&resource, COAP_TYPE_CON,
+					  COAP_CT_APP_JSON, payload,
+					  sizeof(payload)),
+		      0, "Notify failed");
+	zassert_true(notification_take(&notification), "Not notified");
+	zassert_equal(notification.type, COAP_TYPE_NON,
+		      "Second CON sent while one is pending");
+
+	/* A reset of the old CON does not drop the new observer. */
+	zassert_equal(coap_observe_server_unregister(handles[1]), 0,
+		      "Observer not unregistered");
+	zassert_equal(observer_add(2, &resource, COAP_CT_APP_JSON), 0,
+		      "Observer not registered");
+	zassert_equal(handles[2], handles[0], "Slot not reused");
+
+	notification_respond(&pending, COAP_TYPE_RST);
+	zassert_equal(coap_observe_server_get(handles[2], &observer), 0,
+		      "Observer dropped by a stale reset");
+	zassert_equal(observer->remote->sa_family, AF_INET6, "Wrong remote");
+	zassert_equal(((struct sockaddr_in6 *)observer->remote)->sin6_port,
+		      remotes[2].sin6_port, "Wrong observer in the slot");
+}
+
+void test_observe_unregister_during_walk(void)
+{
+	coap_observer_t *observer = NULL;
+	size_t visited = 0;
+	u32_t handle;
+
+	for (size_t i = 0; i < OBSERVER_COUNT; i++) {
+		zassert_equal(observer_add(i, &resource, COAP_CT_APP_JSON), 0,
+			      "Observer not registered");
+	}
+
+	/* Observers can be unregistered while they are iterated. */
+	while (coap_observe_server_next_get(&observer, observer,
+					    &resource) == 0) {
+		zassert_equal(coap_observe_server_search(&handle,
+							 observer->remote,
+							 &resource),
+			      0, "Observer not found");
+		zassert_equal(coap_observe_server_unregister(handle), 0,
+			      "Observer not unregistered");
+		visited++;
+	}
+
+	zassert_equal(visited, OBSERVER_COUNT, "Observers skipped");
+	zassert_equal(coap_observe_notify(&resource, COAP_TYPE_NON,
+					  COAP_CT_APP_JSON, payload,
+					  sizeof(payload)),
+		      ENOENT, "Unregistered observers notified");
+}
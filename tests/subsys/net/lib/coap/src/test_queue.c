@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <net/coap_api.h>
+
+#include "coap_queue.h"
+#include "coap_test.h"
+#include "transport_stub.h"
+
+#define QUEUE_SIZE	CONFIG_NRF_COAP_MESSAGE_QUEUE_SIZE
+
+/* The queue tick counter wraps this many ticks after the initialization. */
+#define TICKS_TO_WRAP	300
+
+static u8_t buffer[QUEUE_SIZE];
+
+static coap_queue_item_t *item_add(u16_t mid, u8_t token_len, u8_t token,
+				   u16_t timeout)
+{
+	coap_queue_item_t item;
+	coap_queue_item_t *added;
+
+	memset(&item, 0, sizeof(item));
+	item.mid = mid;
+	item.token_len = token_len;
+	memset(item.token, token, token_len);
+	item.timeout = timeout;
+	/* Used items are marked by the buffer. */
+	item.buffer = &buffer[mid % QUEUE_SIZE];
+
+	zassert_equal(coap_queue_add(&item), 0, "Item not added");
+	zassert_equal(coap_queue_item_by_mid_get(&added, mid), 0,
+		      "Added item not found");
+	zassert_equal(added->handle, item.handle, "Wrong handle");
+
+	return added;
+}
+
+static void ticks_run(u32_t ticks)
+{
+	while (ticks-- > 0) {
+		coap_queue_time_tick();
+	}
+}
+
+/* Remove the expired items, checking that they expire in the given order. */
+static void expired_check(const u16_t *mids, size_t count)
+{
+	coap_queue_item_t *item;
+
+	for (size_t i = 0; i < count; i++) {
+		zassert_equal(coap_queue_item_expired_get(&item), 0,
+			      "Item not expired");
+		zassert_equal(item->mid, mids[i], "Wrong expiry order");
+		zassert_equal(coap_queue_remove(item), 0, "Item not removed");
+	}
+
+	zassert_equal(coap_queue_item_expired_get(&item), ENOENT,
+		      "Unexpected expired item");
+}
+
+void test_queue_setup(void)
+{
+	zassert_equal(coap_queue_init(), 0, "Queue init failed");
+}
+
+void test_queue_add_remove(void)
+{
+	coap_queue_item_t *item;
+
+	item = item_add(1, 0, 0, 10);
+	zassert_equal(coap_queue_remove(item), 0, "Item not removed");
+	zassert_equal(coap_queue_remove(item), ENOENT, "Item removed twice");
+	zassert_equal(coap_queue_item_by_mid_get(&item, 1), ENOENT,
+		      "Removed item found");
+	zassert_equal(coap_queue_remove(NULL), EINVAL, "NULL not rejected");
+	zassert_equal(coap_queue_add(NULL), EINVAL, "NULL not rejected");
+}
+
+void test_queue_remove_by_mid(void)
+{
+	coap_queue_item_t *item;
+
+	/* Message IDs sharing a hash bucket. */
+	(void)item_add(3, 0, 0, 10);
+	(void)item_add(3 + QUEUE_SIZE, 0, 0, 10);
+	(void)item_add(3 + 2 * QUEUE_SIZE, 0, 0, 10);
+
+	zassert_equal(coap_queue_item_by_mid_get(&item, 3 + QUEUE_SIZE), 0,
+		      "Item not found");
+	zassert_equal(coap_queue_remove(item), 0, "Item not removed");
+
+	zassert_equal(coap_queue_item_by_mid_get(&item, 3 + QUEUE_SIZE),
+		      ENOENT, "Removed item found");
+	zassert_equal(coap_queue_item_by_mid_get(&item, 3), 0,
+		      "Item lost from the bucket");
+	zassert_equal(item->mid, 3, "Wrong item found");
+	zassert_equal(coap_queue_item_by_mid_get(&item, 3 + 2 * QUEUE_SIZE),
+		      0, "Item lost from the bucket");
+	zassert_equal(item->mid, 3 + 2 * QUEUE_SIZE, "Wrong item found");
+	zassert_equal(coap_queue_item_by_mid_get(&item, 4), ENOENT,
+		      "Unknown message ID found");
+}
+
+void test_queue_remove_by_token(void)
+{
+	coap_queue_item_t *item;
+	u8_t token[8];
+
+	(void)item_add(1, 2, 0xAA, 10);
+	(void)item_add(2, 4, 0xAA, 10);
+	(void)item_add(3, 0, 0, 10);
+
+	/* Same bytes, different length. */
+	memset(token, 0xAA, sizeof(token));
+	zassert_equal(coap_queue_item_by_token_get(&item, token, 4), 0,
+		      "Item not found");
+	zassert_equal(item->mid, 2, "Wrong item found");
+	zassert_equal(coap_queue_remove(item), 0, "Item not removed");
+
+	zassert_equal(coap_queue_item_by_token_get(&item, token, 4), ENOENT,
+		      "Removed item found");
+	zassert_equal(coap_queue_item_by_token_get(&item, token, 2), 0,
+		      "Item not found");
+	zassert_equal(item->mid, 1, "Wrong item found");
+	zassert_equal(coap_queue_item_by_token_get(&item, token, 8), ENOENT,
+		      "Unknown token found");
+
+	/* Items without a token are not matched by an empty token. */
+	zassert_equal(coap_queue_item_by_token_get(&item, token, 0), ENOENT,
+		      "Empty token matched");
+}
+
+void test_queue_expiry_order(void)
+{
+	static const u16_t first[] = { 2, 4 };
+	static const u16_t second[] = { 1, 5 };
+	static const u16_t third[] = { 3 };
+	coap_queue_item_t *item;
+
+	(void)item_add(1, 0, 0, 5);
+	(void)item_add(3, 0, 0, 8);
+	(void)item_add(4, 0, 0, 2);
+	(void)item_add(2, 0, 0, 1);
+
+	/* An item expires on the tick after its timeout ran out. */
+	ticks_run(1);
+	zassert_equal(coap_queue_item_expired_get(&item), ENOENT,
+		      "Item expired early");
+
+	ticks_run(2);
+	expired_check(first, ARRAY_SIZE(first));
+
+	/* Restarted timeout moves the item before and after the others. */
+	zassert_equal(coap_queue_item_by_mid_get(&item, 3), 0,
+		      "Item not found");
+	item->timeout = 1;
+	zassert_equal(coap_queue_item_timeout_restart(item), 0,
+		      "Timeout not restarted");
+	ticks_run(2);
+	zassert_equal(coap_queue_item_expired_get(&item), 0,
+		      "Restarted item not expired");
+	zassert_equal(item->mid, 3, "Wrong expiry order");
+	item->timeout = 10;
+	zassert_equal(coap_queue_item_timeout_restart(item), 0,
+		      "Timeout not restarted");
+
+	ticks_run(1);
+	(void)item_add(5, 0, 0, 0);
+	ticks_run(1);
+	expired_check(second, ARRAY_SIZE(second));
+
+	ticks_run(10);
+	expired_check(third, ARRAY_SIZE(third));
+}
+
+void test_queue_next_deadline(void)
+{
+	coap_queue_item_t *item;
+	u32_t ticks;
+
+	zassert_equal(coap_queue_next_deadline_get(&ticks), ENOENT,
+		      "Empty queue has a deadline");
+
+	(void)item_add(1, 0, 0, 6);
+	zassert_equal(coap_queue_next_deadline_get(&ticks), 0,
+		      "No deadline");
+	zassert_equal(ticks, 7, "Wrong deadline");
+
+	item = item_add(2, 0, 0, 2);
+	zassert_equal(coap_queue_next_deadline_get(&ticks), 0,
+		      "No deadline");
+	zassert_equal(ticks, 3, "Earliest deadline not used");
+
+	ticks_run(5);
+	zassert_equal(coap_queue_next_deadline_get(&ticks), 0,
+		      "No deadline");
+	zassert_equal(ticks, 0, "Expired item not due");
+
+	zassert_equal(coap_queue_remove(item), 0, "Item not removed");
+	zassert_equal(coap_queue_next_deadline_get(&ticks), 0,
+		      "No deadline");
+	zassert_equal(ticks, 2, "Wrong deadline after removal");
+}
+
+void test_queue_library_deadline(void)
+{
+	coap_message_conf_t config = {
+		.type = COAP_TYPE_CON,
+		.code = COAP_CODE_GET,
+	};
+	coap_message_t *request;
+	u32_t handle;
+	u32_t ticks;
+
+	coap_test_init();
+
+	zassert_equal(coap_next_deadline(&ticks), ENOENT,
+		      "Empty queue has a deadline");
+	zassert_equal(coap_next_deadline(NULL), EINVAL, "NULL not rejected");
+
+	zassert_equal(coap_message_new(&request, &config), 0,
+		      "Request not created");
+	zassert_equal(coap_message_remote_addr_set(request,
+						   transport_stub_remote()),
+		      0, "Remote not set");
+	zassert_equal(coap_message_send(&handle, request), 0,
+		      "Request not sent");
+	zassert_equal(coap_message_delete(request), 0, "Request not deleted");
+
+	/* The first retransmission is on the tick after the ACK timeout. */
+	zassert_equal(coap_next_deadline(&ticks), 0, "No deadline");
+	zassert_equal(ticks, CONFIG_NRF_COAP_ACK_TIMEOUT *
+			     CONFIG_NRF_COAP_ACK_RANDOM_FACTOR + 1,
+		      "Wrong deadline");
+
+	while (ticks-- > 1) {
+		(void)coap_time_tick();
+	}
+	zassert_equal(transport_stub_write_count(), 1, "Early retransmit");
+	(void)coap_time_tick();
+	zassert_equal(transport_stub_write_count(), 2, "No retransmit");
+
+	/* The request is dropped from the queue after the last attempt. */
+	while (coap_next_deadline(&ticks) == 0) {
+		(void)coap_time_tick();
+	}
+	zassert_equal(transport_stub_write_count(),
+		      1 + CONFIG_NRF_COAP_MAX_RETRANSMIT_COUNT,
+		      "Wrong number of retransmits");
+}
+
+void test_queue_tick_wraparound(void)
+{
+	static const u16_t order[] = { 1, 2, 3 };
+	u32_t ticks;
+
+	ticks_run(TICKS_TO_WRAP - 10);
+
+	/* Deadline before the wrap, one after it, and one far after it. */
+	(void)item_add(3, 0, 0, 60);
+	(void)item_add(2, 0, 0, 20);
+	(void)item_add(1, 0, 0, 5);
+
+	zassert_equal(coap_queue_next_deadline_get(&ticks), 0,
+		      "No deadline");
+	zassert_equal(ticks, 6, "Wrong deadline before the wrap");
+
+	ticks_run(6);
+	expired_check(order, 1);
+
+	zassert_equal(coap_queue_next_deadline_get(&ticks), 0,
+		      "No deadline");
+	zassert_equal(ticks, 15, "Wrong deadline across the wrap");
+
+	ticks_run(14);
+	expired_check(order, 0);
+	ticks_run(1);
+	expired_check(&order[1], 1);
+
+	zassert_equal(coap_queue_next_deadline_get(&ticks), 0,
+		      "No deadline");
+	zassert_equal(ticks, 40, "Wrong deadline after the wrap");
+	ticks_run(40);
+	expired_check(&order[2], 1);
+}
+
+void test_queue_full(void)
+{
+	coap_queue_item_t item;
+	coap_queue_item_t *found;
+
+	for (u16_t mid = 0; mid < QUEUE_SIZE; mid++) {
+		(void)item_add(mid, 1, (u8_t)mid, 10);
+	}
+
+	memset(&item, 0, sizeof(item));
+	item.mid = QUEUE_SIZE;
+	item.buffer = buffer;
+	zassert_equal(coap_queue_add(&item), ENOMEM, "Full queue extended");
+
+	/* A freed slot is reused, and the other items are kept. */
+	zassert_equal(coap_queue_item_by_mid_get(&found, 1), 0,
+		      "Item not found");
+	zassert_equal(coap_queue_remove(found), 0, "Item not removed");
+	zassert_equal(coap_queue_add(&item), 0, "Freed slot not reused");
+
+	for (u16_t mid = 0; mid <= QUEUE_SIZE; mid++) {
+		zassert_equal(coap_queue_item_by_mid_get(&found, mid),
+			      (mid == 1) ? ENOENT : 0, "Wrong item set");
+	}
+}
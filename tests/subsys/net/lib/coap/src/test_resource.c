@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <stdio.h>
+#include <string.h>
+#include <net/coap_api.h>
+
+#include "coap_resource.h"
+#include "coap_test.h"
+#include "transport_stub.h"
+
+#define INDEX_SIZE	CONFIG_NRF_COAP_RESOURCE_INDEX_SIZE
+#define MAX_DEPTH	CONFIG_NRF_COAP_RESOURCE_MAX_DEPTH
+
+static coap_resource_t root;
+static coap_resource_t temp;
+static coap_resource_t t;
+static coap_resource_t sensors;
+static coap_resource_t humidity;
+static coap_resource_t sensors_temp;
+
+/* Resources to fill the tree past the index size. */
+static coap_resource_t extra[INDEX_SIZE];
+static char extra_names[INDEX_SIZE][4];
+
+static coap_resource_t *callback_resource;
+
+static void resource_callback(coap_resource_t *resource,
+			      coap_message_t *request)
+{
+	callback_resource = resource;
+}
+
+static void resource_add(coap_resource_t *parent, coap_resource_t *child,
+			 const char *name)
+{
+	memset(child, 0, sizeof(*child));
+	zassert_equal(coap_resource_create(child, name), 0,
+		      "Resource not created");
+	zassert_equal(coap_resource_child_add(parent, child), 0,
+		      "Resource not added");
+}
+
+/* Look up a path given as a string of segments separated by '/'. */
+static coap_resource_t *resource_lookup(const char *path)
+{
+	u8_t *segments[MAX_DEPTH];
+	u16_t lengths[MAX_DEPTH];
+	u8_t count = 0;
+	coap_resource_t *found;
+
+	while (*path != '\0') {
+		const char *end = strchr(path, '/');
+		u16_t len = (end != NULL) ? (end - path) : strlen(path);
+
+		zassert_true(count < MAX_DEPTH, "Path too deep");
+		segments[count] = (u8_t *)path;
+		lengths[count++] = len;
+		path += len + ((end != NULL) ? 1 : 0);
+	}
+
+	if (coap_resource_get(&found, segments, lengths, count) != 0) {
+		zassert_equal(found, NULL, "Resource set on failure");
+		return NULL;
+	}
+
+	return found;
+}
+
+void test_resource_setup(void)
+{
+	coap_test_init();
+
+	memset(&root, 0, sizeof(root));
+	zassert_equal(coap_resource_create(&root, "root"), 0,
+		      "Root not created");
+
+	resource_add(&root, &temp, "temp");
+	resource_add(&root, &t, "t");
+	resource_add(&root, &sensors, "sensors");
+	resource_add(&sensors, &humidity, "humidity");
+	resource_add(&sensors, &sensors_temp, "temp");
+
+	t.permission = COAP_PERM_OBSERVE;
+	callback_resource = NULL;
+}
+
+void test_resource_lookup(void)
+{
+	zassert_equal(resource_lookup(""), &root, "Root not found");
+	zassert_equal(resource_lookup("temp"), &temp, "Resource not found");
+	zassert_equal(resource_lookup("sensors/humidity"), &humidity,
+		      "Resource not found");
+	zassert_equal(resource_lookup("sensors/temp"), &sensors_temp,
+		      "Resource not found");
+
+	/* Names are compared exactly, not by prefix. */
+	zassert_equal(resource_lookup("t"), &t, "Resource not found");
+	zassert_equal(resource_lookup("te"), NULL, "Prefix matched");
+	zassert_equal(resource_lookup("sensors/hum"), NULL, "Prefix matched");
+	zassert_equal(resource_lookup("temperature"), NULL, "Prefix matched");
+
+	/* Segments are not merged. */
+	zassert_equal(resource_lookup("sensorst/emp"), NULL,
+		      "Merged segments matched");
+	zassert_equal(resource_lookup("humidity"), NULL,
+		      "Resource found outside of its parent");
+	zassert_equal(resource_lookup("sensors/temp/x"), NULL,
+		      "Missing child found");
+}
+
+void test_resource_lookup_after_add(void)
+{
+	static coap_resource_t pressure;
+
+	zassert_equal(resource_lookup("sensors/pressure"), NULL,
+		      "Resource found before it was added");
+
+	resource_add(&sensors, &pressure, "pressure");
+
+	zassert_equal(resource_lookup("sensors/pressure"), &pressure,
+		      "Added resource not found");
+	zassert_equal(resource_lookup("sensors/humidity"), &humidity,
+		      "Resource lost after add");
+}
+
+void test_resource_index_overflow(void)
+{
+	/* Trees larger than the index are still searched. */
+	for (size_t i = 0; i < INDEX_SIZE; i++) {
+		snprintf(extra_names[i], sizeof(extra_names[i]), "x%u",
+			 (unsigned int)i);
+		resource_add(&sensors, &extra[i], extra_names[i]);
+	}
+
+	zassert_equal(resource_lookup("sensors/x0"), &extra[0],
+		      "Resource not found");
+	zassert_equal(resource_lookup(extra_names[INDEX_SIZE - 1]), NULL,
+		      "Resource found outside of its parent");
+	zassert_equal(resource_lookup("sensors/temp"), &sensors_temp,
+		      "Resource not found");
+	zassert_equal(resource_lookup("t"), &t, "Resource not found");
+	zassert_equal(resource_lookup("te"), NULL, "Prefix matched");
+}
+
+static void request_receive(const char * const *segments, size_t count)
+{
+	coap_message_conf_t config = {
+		.type = COAP_TYPE_CON,
+		.code = COAP_CODE_GET,
+		.token = { 0x01 },
+		.token_len = 1,
+	};
+	coap_message_t *request;
+
+	zassert_equal(coap_message_new(&request, &config), 0,
+		      "Request not created");
+	zassert_equal(coap_message_remote_addr_set(request,
+						   transport_stub_remote()),
+		      0, "Remote not set");
+
+	for (size_t i = 0; i < count; i++) {
+		zassert_equal(coap_message_opt_str_add(
+					request, COAP_OPT_URI_PATH,
+					(u8_t *)segments[i],
+					strlen(segments[i])),
+			      0, "Option not added");
+	}
+
+	coap_test_message_receive(request);
+}
+
+static u8_t response_code_take(void)
+{
+	static u8_t raw[TRANSPORT_STUB_MAX_DATAGRAM_SIZE];
+	coap_message_t response;
+
+	zassert_true(coap_test_message_take(&response, raw), "No response");
+
+	return response.header.code;
+}
+
+void test_resource_request_dispatch(void)
+{
+	static const char * const path[] = { "sensors", "temp" };
+	static const char * const deep[MAX_DEPTH + 1] = {
+		"sensors", "temp", "a", "b", "c", "d"
+	};
+
+	(void)coap_request_handler_register(NULL);
+	sensors_temp.callback = resource_callback;
+	sensors_temp.permission = COAP_PERM_GET;
+
+	request_receive(path, ARRAY_SIZE(path));
+	zassert_equal(callback_resource, &sensors_temp,
+		      "Request not dispatched");
+
+	/* Paths deeper than the tree can be are not found. */
+	request_receive(deep, ARRAY_SIZE(deep));
+	zassert_equal(response_code_take(), COAP_CODE_404_NOT_FOUND,
+		      "Too deep path not rejected");
+
+	request_receive(path, 1);
+	zassert_equal(response_code_take(), COAP_CODE_405_METHOD_NOT_ALLOWED,
+		      "Resource without callback not rejected");
+}
+
+void test_resource_well_known(void)
+{
+	static const char expected[] = "</temp>,</t>;obs,</sensors/humidity>,"
+				       "</sensors/temp>,</sensors>";
+	u8_t string[sizeof(expected) + 8];
+	u16_t length = sizeof(string);
+
+	zassert_equal(coap_resource_well_known_generate(string, &length), 0,
+		      "Generate failed");
+	zassert_true(strcmp((char *)string, expected) == 0,
+		     "Wrong link format");
+	zassert_equal(length, sizeof(string) - sizeof(expected),
+		      "Wrong remaining length");
+
+	/* Too small buffer, generated and from the cache. */
+	coap_resource_init();
+	zassert_equal(coap_resource_well_known_generate(string, &length),
+		      ENOENT, "Empty tree generated");
+	test_resource_setup();
+
+	length = sizeof(expected) - 1;
+	zassert_equal(coap_resource_well_known_generate(string, &length),
+		      ENOMEM, "Too small buffer accepted");
+
+	length = sizeof(string);
+	zassert_equal(coap_resource_well_known_generate(string, &length), 0,
+		      "Generate failed");
+
+	length = sizeof(expected) - 1;
+	zassert_equal(coap_resource_well_known_generate(string, &length),
+		      ENOMEM, "Too small buffer accepted from the cache");
+}
+
+void test_resource_well_known_cache(void)
+{
+	static coap_resource_t pressure;
+	u8_t first[96];
+	u8_t second[96];
+	u16_t first_length = sizeof(first);
+	u16_t second_length = sizeof(second);
+
+	zassert_equal(coap_resource_well_known_generate(first, &first_length),
+		      0, "Generate failed");
+
+	/* The cached string is identical, and not regenerated until the
+	 * tree changes.
+	 */
+	root.front->permission = COAP_PERM_OBSERVE;
+	zassert_equal(coap_resource_well_known_generate(second,
+							&second_length),
+		      0, "Generate failed");
+	zassert_true(strcmp((char *)first, (char *)second) == 0,
+		     "Cached string differs");
+	zassert_equal(first_length, second_length, "Wrong remaining length");
+
+	resource_add(&sensors, &pressure, "pressure");
+
+	second_length = sizeof(second);
+	zassert_equal(coap_resource_well_known_generate(second,
+							&second_length),
+		      0, "Generate failed");
+	zassert_not_null(strstr((char *)second, "</sensors/pressure>"),
+			 "Added resource missing");
+	zassert_not_null(strstr((char *)second, "</temp>;obs"),
+			 "String not regenerated");
+}
+
+void test_resource_well_known_root_only(void)
+{
+	u8_t string[8];
+	u16_t length = sizeof(string);
+
+	coap_resource_init();
+	memset(&root, 0, sizeof(root));
+	zassert_equal(coap_resource_create(&root, "root"), 0,
+		      "Root not created");
+
+	memset(string, 0xFF, sizeof(string));
+	zassert_equal(coap_resource_well_known_generate(string, &length), 0,
+		      "Generate failed");
+	zassert_equal(string[0], '\0', "Root listed");
+	zassert_equal(length, sizeof(string), "Bytes used");
+}
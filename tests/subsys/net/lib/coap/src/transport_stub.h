@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _TRANSPORT_STUB_H_
+#define _TRANSPORT_STUB_H_
+
+/**
+ * @brief Loopback stand-in used instead of the CoAP socket transport.
+ *
+ * Datagrams written by the library are queued by the stub, and passed back
+ * to the library on delivery, so one CoAP instance is both the client and
+ * the server.
+ */
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <net/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRANSPORT_STUB_MAX_DATAGRAMS 16
+#define TRANSPORT_STUB_MAX_DATAGRAM_SIZE 512
+
+/** Forget the queued datagrams and reset the loss settings. */
+void transport_stub_reset(void);
+
+/** Drop every nth datagram written, 0 to drop none. */
+void transport_stub_drop_set(u32_t every);
+
+/** Deliver every datagram twice, as if the network duplicated it. */
+void transport_stub_duplicate_set(bool enable);
+
+/** Provide a TX buffer to the library, or let it allocate the buffers. */
+void transport_stub_tx_buffer_set(bool enable);
+
+/** Number of transport writes done since the last reset. */
+size_t transport_stub_write_count(void);
+
+/** Number of datagrams queued and not delivered yet. */
+size_t transport_stub_pending(void);
+
+/** Remove the oldest queued datagram without delivering it.
+ *
+ * @return Length of the datagram, 0 if none is queued.
+ */
+u16_t transport_stub_take(u8_t *data, u16_t len);
+
+/** Deliver the queued datagrams to the library, including the ones written
+ *  while delivering.
+ *
+ * @return Number of datagrams delivered.
+ */
+size_t transport_stub_deliver(void);
+
+/** Remote of all the datagrams. */
+struct sockaddr *transport_stub_remote(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TRANSPORT_STUB_H_ */
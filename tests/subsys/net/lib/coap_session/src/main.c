@@ -0,0 +1,408 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <net/coap_api.h>
+
+#include "socket_stub.h"
+
+#define SESSION_COUNT	CONFIG_NRF_COAP_SESSION_COUNT
+
+static struct sockaddr_in port_addr;
+static struct sockaddr_in session_addr;
+static struct sockaddr_in remotes[SESSION_COUNT + 1];
+
+static sec_tag_t sec_tag_list[] = { 1 };
+static coap_sec_config_t sec_config = {
+	.sec_tag_count = ARRAY_SIZE(sec_tag_list),
+	.sec_tag_list = sec_tag_list,
+};
+
+static coap_local_t session_local = {
+	.addr = (struct sockaddr *)&session_addr,
+	.protocol = IPPROTO_DTLS_1_2,
+	.setting = &sec_config,
+};
+
+/* Same security tag as sec_config, until changed by a test. */
+static sec_tag_t other_sec_tag_list[] = { 1 };
+static coap_sec_config_t other_sec_config = {
+	.sec_tag_count = ARRAY_SIZE(other_sec_tag_list),
+	.sec_tag_list = other_sec_tag_list,
+};
+
+static coap_local_t other_session_local = {
+	.addr = (struct sockaddr *)&session_addr,
+	.protocol = IPPROTO_DTLS_1_2,
+	.setting = &other_sec_config,
+};
+
+static coap_local_t port_table[COAP_PORT_COUNT];
+
+static bool responded;
+static u32_t response_status;
+
+static void addr_set(struct sockaddr_in *addr, u32_t host, u16_t port)
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->sin_family = AF_INET;
+	addr->sin_port = htons(port);
+	addr->sin_addr.s_addr = htonl(host);
+}
+
+static void response_handle(u32_t status, void *arg, coap_message_t *message)
+{
+	responded = true;
+	response_status = status;
+}
+
+static coap_transport_handle_t session_setup(int remote)
+{
+	zassert_equal(coap_security_setup(&session_local,
+				(struct sockaddr *)&remotes[remote]), 0,
+		      "Session %d not set up", remote);
+
+	return session_local.transport;
+}
+
+static void request_send(coap_transport_handle_t transport, int remote)
+{
+	coap_message_conf_t config = {
+		.type = COAP_TYPE_CON,
+		.code = COAP_CODE_GET,
+		.response_callback = response_handle,
+		.transport = transport,
+	};
+	coap_message_t *request;
+	u32_t handle;
+
+	zassert_equal(coap_message_new(&request, &config), 0,
+		      "Request not created");
+	zassert_equal(coap_message_remote_addr_set(request,
+				(struct sockaddr *)&remotes[remote]), 0,
+		      "Remote not set");
+	zassert_equal(coap_message_send(&handle, request), 0,
+		      "Request not sent");
+	zassert_equal(coap_message_delete(request), 0, "Request not deleted");
+	zassert_equal(socket_stub_write_count(transport), 1,
+		      "Request not written");
+}
+
+/* Tick until no confirmable message is left waiting for a response. */
+static void queue_drain(void)
+{
+	u32_t ticks;
+
+	while (coap_next_deadline(&ticks) == 0) {
+		(void)coap_time_tick();
+	}
+}
+
+static void test_session_setup(void)
+{
+	coap_transport_init_t transport_params = {
+		.port_table = port_table,
+	};
+
+	socket_stub_reset();
+
+	addr_set(&port_addr, INADDR_ANY, 5683);
+	addr_set(&session_addr, INADDR_ANY, 5684);
+	for (int i = 0; i < ARRAY_SIZE(remotes); i++) {
+		addr_set(&remotes[i], 0x0A000001, 5684 + i);
+	}
+
+	memset(port_table, 0, sizeof(port_table));
+	port_table[0].addr = (struct sockaddr *)&port_addr;
+
+	other_sec_tag_list[0] = sec_tag_list[0];
+	other_sec_config.role = sec_config.role;
+	other_sec_config.hostname = NULL;
+
+	responded = false;
+	response_status = 0;
+
+	zassert_equal(coap_init(17, &transport_params, k_malloc, k_free), 0,
+		      "CoAP init failed");
+}
+
+static void test_session_teardown(void)
+{
+	queue_drain();
+}
+
+static void test_session_reuse_active(void)
+{
+	coap_transport_handle_t transport = session_setup(0);
+	size_t opened = socket_stub_open_count();
+
+	/* Only one session is kept between the same endpoints. */
+	zassert_equal(session_setup(0), transport, "Session not reused");
+	zassert_equal(socket_stub_open_count(), opened, "Socket opened");
+}
+
+static void test_session_full(void)
+{
+	for (int i = 0; i < SESSION_COUNT; i++) {
+		(void)session_setup(i);
+	}
+
+	/* Sessions in use by the application are never closed. */
+	zassert_equal(coap_security_setup(&session_local,
+				(struct sockaddr *)&remotes[SESSION_COUNT]),
+		      ENOMEM, "Active session evicted");
+}
+
+static void test_session_resume(void)
+{
+	coap_transport_handle_t transport = session_setup(0);
+	size_t opened = socket_stub_open_count();
+
+	zassert_equal(coap_security_release(transport), 0,
+		      "Session not released");
+
+	zassert_equal(session_setup(0), transport, "Session not resumed");
+	zassert_true(socket_stub_is_open(transport), "Session closed");
+	zassert_equal(socket_stub_open_count(), opened, "Socket opened");
+}
+
+static void test_session_resume_other_security(void)
+{
+	coap_transport_handle_t transport = session_setup(0);
+	size_t opened = socket_stub_open_count();
+
+	request_send(transport, 0);
+	zassert_equal(coap_security_release(transport), 0,
+		      "Session not released");
+
+	/* Equal settings given in another structure resume the session. */
+	zassert_equal(coap_security_setup(&other_session_local,
+				(struct sockaddr *)&remotes[0]), 0,
+		      "Session not set up");
+	zassert_equal(other_session_local.transport, transport,
+		      "Session not resumed");
+	zassert_false(responded, "Pending request failed");
+	zassert_equal(coap_security_release(transport), 0,
+		      "Session not released");
+
+	/* Another security tag needs a new session. */
+	other_sec_tag_list[0] = 2;
+	zassert_equal(coap_security_setup(&other_session_local,
+				(struct sockaddr *)&remotes[0]), 0,
+		      "Session not set up");
+	zassert_equal(socket_stub_open_count(), opened + 1,
+		      "Session with other security tag resumed");
+
+	zassert_true(responded, "Pending request not failed");
+	zassert_equal(response_status, ECONNABORTED, "Wrong status");
+
+	/* So does another hostname. */
+	zassert_equal(coap_security_release(other_session_local.transport), 0,
+		      "Session not released");
+	other_sec_config.hostname = "coap.example.com";
+	zassert_equal(coap_security_setup(&other_session_local,
+				(struct sockaddr *)&remotes[0]), 0,
+		      "Session not set up");
+	zassert_equal(socket_stub_open_count(), opened + 2,
+		      "Session with other hostname resumed");
+}
+
+static void test_session_active_other_security(void)
+{
+	coap_transport_handle_t transport = session_setup(0);
+
+	other_sec_config.role = 1;
+
+	/* A session in use is not replaced. */
+	zassert_equal(coap_security_setup(&other_session_local,
+				(struct sockaddr *)&remotes[0]), EBUSY,
+		      "Session in use shared with other settings");
+	zassert_true(socket_stub_is_open(transport), "Session closed");
+}
+
+static void test_session_evict_lru(void)
+{
+	coap_transport_handle_t transports[SESSION_COUNT];
+
+	for (int i = 0; i < SESSION_COUNT; i++) {
+		transports[i] = session_setup(i);
+	}
+
+	for (int i = 0; i < SESSION_COUNT; i++) {
+		zassert_equal(coap_security_release(transports[i]), 0,
+			      "Session not released");
+		k_sleep(10);
+	}
+
+	/* The least recently released session makes room. */
+	(void)session_setup(SESSION_COUNT);
+	zassert_equal(socket_stub_open_count(), COAP_PORT_COUNT +
+						SESSION_COUNT + 1,
+		      "No socket opened");
+
+	for (int i = 1; i < SESSION_COUNT; i++) {
+		zassert_equal(session_setup(i), transports[i],
+			      "Session %d not kept", i);
+	}
+}
+
+static void test_session_evict_pending(void)
+{
+	coap_transport_handle_t transports[SESSION_COUNT];
+	coap_transport_handle_t transport;
+	u32_t ticks;
+
+	for (int i = 0; i < SESSION_COUNT; i++) {
+		transports[i] = session_setup(i);
+	}
+
+	request_send(transports[0], 0);
+
+	for (int i = 0; i < SESSION_COUNT; i++) {
+		zassert_equal(coap_security_release(transports[i]), 0,
+			      "Session not released");
+		k_sleep(10);
+	}
+
+	/* The new session gets the descriptor of the evicted one. */
+	transport = session_setup(SESSION_COUNT);
+	zassert_equal(transport, transports[0], "Descriptor not reused");
+
+	zassert_true(responded, "Pending request not failed");
+	zassert_equal(response_status, ECONNABORTED, "Wrong status");
+	zassert_equal(coap_next_deadline(&ticks), ENOENT,
+		      "Request still queued");
+
+	/* The request is not retransmitted to the new remote. */
+	for (int i = 0; i < CONFIG_NRF_COAP_MAX_TRANSMISSION_SPAN; i++) {
+		(void)coap_time_tick();
+	}
+	zassert_equal(socket_stub_write_count(transport), 0,
+		      "Request sent on the new session");
+}
+
+static void test_session_expired(void)
+{
+	coap_transport_handle_t transport = session_setup(0);
+
+	zassert_equal(coap_security_release(transport), 0,
+		      "Session not released");
+	k_sleep(K_SECONDS(CONFIG_NRF_COAP_SESSION_CACHE_TIMEOUT) + 100);
+
+	/* The peer has likely dropped the session, a new one is made. */
+	(void)session_setup(0);
+	zassert_equal(socket_stub_open_count(), COAP_PORT_COUNT + 2,
+		      "Expired session resumed");
+}
+
+static void test_session_destroy_pending(void)
+{
+	coap_transport_handle_t transport = session_setup(0);
+	u32_t ticks;
+
+	request_send(transport, 0);
+
+	zassert_equal(coap_security_destroy(transport), 0,
+		      "Session not destroyed");
+	zassert_false(socket_stub_is_open(transport), "Session not closed");
+
+	zassert_true(responded, "Pending request not failed");
+	zassert_equal(response_status, ECONNABORTED, "Wrong status");
+	zassert_equal(coap_next_deadline(&ticks), ENOENT,
+		      "Request still queued");
+}
+
+static void test_session_errors(void)
+{
+	zassert_equal(coap_security_release(port_table[0].transport), ENOENT,
+		      "Port released");
+	zassert_equal(coap_security_destroy(port_table[0].transport), ENOENT,
+		      "Port destroyed");
+	zassert_equal(coap_security_release(SOCKET_STUB_MAX_SOCKETS + 1),
+		      EBADF, "Unknown handle released");
+	zassert_equal(coap_security_destroy(-1), EBADF,
+		      "Unknown handle destroyed");
+}
+
+static void test_port_error_reopen(void)
+{
+	coap_transport_handle_t transport = port_table[0].transport;
+	size_t opened = socket_stub_open_count();
+
+	request_send(transport, 0);
+	socket_stub_poll_error_set(transport);
+
+	zassert_equal(coap_transport_poll(0), 0, "Poll failed");
+
+	/* Requests sent on the closed socket are failed. */
+	zassert_true(responded, "Pending request not failed");
+	zassert_equal(response_status, EIO, "Wrong status");
+
+	/* The port is opened again, with the descriptor it had. */
+	zassert_equal(socket_stub_open_count(), opened + 1,
+		      "Port not opened again");
+	zassert_true(socket_stub_is_open(transport), "Port closed");
+	request_send(transport, 0);
+}
+
+static void test_port_error_retry(void)
+{
+	coap_transport_handle_t transport = port_table[0].transport;
+	size_t opened = socket_stub_open_count();
+
+	socket_stub_socket_fail_set(true);
+	socket_stub_poll_error_set(transport);
+
+	zassert_equal(coap_transport_poll(0), 0, "Poll failed");
+	zassert_false(socket_stub_is_open(transport), "Port not closed");
+
+	/* The port is out of the poll set until it can be opened again. */
+	zassert_equal(coap_transport_poll(0), ENOTCONN, "Port polled");
+	zassert_equal(socket_stub_open_count(), opened, "Socket opened");
+
+	socket_stub_socket_fail_set(false);
+	zassert_equal(coap_transport_poll(0), 0, "Poll failed");
+	zassert_equal(socket_stub_open_count(), opened + 1,
+		      "Port not opened again");
+	zassert_true(socket_stub_is_open(transport), "Port closed");
+}
+
+void test_main(void)
+{
+	socket_stub_register();
+
+	ztest_test_suite(coap_session_tests,
+		ztest_unit_test_setup_teardown(test_session_reuse_active,
+				test_session_setup, test_session_teardown),
+		ztest_unit_test_setup_teardown(test_session_full,
+				test_session_setup, test_session_teardown),
+		ztest_unit_test_setup_teardown(test_session_resume,
+				test_session_setup, test_session_teardown),
+		ztest_unit_test_setup_teardown(
+				test_session_resume_other_security,
+				test_session_setup, test_session_teardown),
+		ztest_unit_test_setup_teardown(
+				test_session_active_other_security,
+				test_session_setup, test_session_teardown),
+		ztest_unit_test_setup_teardown(test_session_evict_lru,
+				test_session_setup, test_session_teardown),
+		ztest_unit_test_setup_teardown(test_session_evict_pending,
+				test_session_setup, test_session_teardown),
+		ztest_unit_test_setup_teardown(test_session_expired,
+				test_session_setup, test_session_teardown),
+		ztest_unit_test_setup_teardown(test_session_destroy_pending,
+				test_session_setup, test_session_teardown),
+		ztest_unit_test_setup_teardown(test_session_errors,
+				test_session_setup, test_session_teardown),
+		ztest_unit_test_setup_teardown(test_port_error_reopen,
+				test_session_setup, test_session_teardown),
+		ztest_unit_test_setup_teardown(test_port_error_retry,
+				test_session_setup, test_session_teardown)
+	);
+
+	ztest_run_test_suite(coap_session_tests);
+}
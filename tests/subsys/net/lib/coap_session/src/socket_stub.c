@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <errno.h>
+#include <string.h>
+#include <net/socket_offload.h>
+
+#include "socket_stub.h"
+
+/* Descriptors start above 0, so that a zeroed handle is not a socket. */
+#define SD_FIRST 1
+
+static struct {
+	bool open;
+	size_t writes;
+	short revents;
+} sockets[SOCKET_STUB_MAX_SOCKETS];
+
+static size_t open_count;
+static bool socket_fail;
+
+static bool sd_valid(int sd)
+{
+	return (sd >= SD_FIRST) && (sd < SD_FIRST + SOCKET_STUB_MAX_SOCKETS) &&
+	       sockets[sd - SD_FIRST].open;
+}
+
+static int stub_socket(int family, int type, int proto)
+{
+	if (socket_fail) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	/* Like a real socket layer, the lowest free descriptor is reused. */
+	for (int i = 0; i < SOCKET_STUB_MAX_SOCKETS; i++) {
+		if (!sockets[i].open) {
+			memset(&sockets[i], 0, sizeof(sockets[i]));
+			sockets[i].open = true;
+			open_count++;
+			return SD_FIRST + i;
+		}
+	}
+
+	errno = ENFILE;
+	return -1;
+}
+
+static int stub_close(int sd)
+{
+	if (!sd_valid(sd)) {
+		errno = EBADF;
+		return -1;
+	}
+
+	sockets[sd - SD_FIRST].open = false;
+	return 0;
+}
+
+static int stub_bind(int sd, const struct sockaddr *addr, socklen_t addrlen)
+{
+	return sd_valid(sd) ? 0 : -1;
+}
+
+static int stub_connect(int sd, const struct sockaddr *addr,
+			socklen_t addrlen)
+{
+	return sd_valid(sd) ? 0 : -1;
+}
+
+static int stub_setsockopt(int sd, int level, int optname,
+			   const void *optval, socklen_t optlen)
+{
+	return sd_valid(sd) ? 0 : -1;
+}
+
+static ssize_t stub_send(int sd, const void *buf, size_t len, int flags)
+{
+	if (!sd_valid(sd)) {
+		errno = EBADF;
+		return -1;
+	}
+
+	sockets[sd - SD_FIRST].writes++;
+	return len;
+}
+
+static ssize_t stub_sendto(int sd, const void *buf, size_t len, int flags,
+			   const struct sockaddr *to, socklen_t tolen)
+{
+	return stub_send(sd, buf, len, flags);
+}
+
+static ssize_t stub_recvfrom(int sd, void *buf, short int len,
+			     short int flags, struct sockaddr *from,
+			     socklen_t *fromlen)
+{
+	errno = EAGAIN;
+	return -1;
+}
+
+static int stub_poll(struct pollfd *fds, int nfds, int timeout)
+{
+	int ready = 0;
+
+	for (int i = 0; i < nfds; i++) {
+		fds[i].revents = 0;
+
+		if (sd_valid(fds[i].fd)) {
+			/* Pending events are reported once. */
+			fds[i].revents = sockets[fds[i].fd - SD_FIRST].revents;
+			sockets[fds[i].fd - SD_FIRST].revents = 0;
+		}
+
+		if (fds[i].revents != 0) {
+			ready++;
+		}
+	}
+
+	return ready;
+}
+
+static const struct socket_offload stub_ops = {
+	.socket = stub_socket,
+	.close = stub_close,
+	.bind = stub_bind,
+	.connect = stub_connect,
+	.setsockopt = stub_setsockopt,
+	.recvfrom = stub_recvfrom,
+	.send = stub_send,
+	.sendto = stub_sendto,
+	.poll = stub_poll,
+};
+
+void socket_stub_register(void)
+{
+	socket_offload_register(&stub_ops);
+}
+
+void socket_stub_reset(void)
+{
+	memset(sockets, 0, sizeof(sockets));
+	open_count = 0;
+	socket_fail = false;
+}
+
+void socket_stub_socket_fail_set(bool fail)
+{
+	socket_fail = fail;
+}
+
+void socket_stub_poll_error_set(int sd)
+{
+	if (sd_valid(sd)) {
+		sockets[sd - SD_FIRST].revents = POLLERR;
+	}
+}
+
+size_t socket_stub_open_count(void)
+{
+	return open_count;
+}
+
+bool socket_stub_is_open(int sd)
+{
+	return sd_valid(sd);
+}
+
+size_t socket_stub_write_count(int sd)
+{
+	if ((sd < SD_FIRST) || (sd >= SD_FIRST + SOCKET_STUB_MAX_SOCKETS)) {
+		return 0;
+	}
+
+	return sockets[sd - SD_FIRST].writes;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _SOCKET_STUB_H_
+#define _SOCKET_STUB_H_
+
+/**
+ * @brief Socket offload stand-in used below the CoAP socket transport.
+ *
+ * Sockets are only bookkeeping: every call succeeds unless socket creation
+ * is set to fail, datagrams written are counted and dropped, and no datagram
+ * is ever received. Only the errors set on a socket are reported by poll().
+ */
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SOCKET_STUB_MAX_SOCKETS 16
+
+/** Register the stub as the socket offload. */
+void socket_stub_register(void);
+
+/** Forget all sockets, open or closed. */
+void socket_stub_reset(void);
+
+/** Make the creation of new sockets fail, or succeed again. */
+void socket_stub_socket_fail_set(bool fail);
+
+/** Report an error on a socket on the next poll. */
+void socket_stub_poll_error_set(int sd);
+
+/** Number of sockets opened since the reset. */
+size_t socket_stub_open_count(void);
+
+/** Check if a socket is open. */
+bool socket_stub_is_open(int sd);
+
+/** Number of datagrams written on a socket. */
+size_t socket_stub_write_count(int sd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SOCKET_STUB_H_ */
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <net/mqtt_socket.h>
+
+#define ROUTE_CNT 8
+
+MQTT_ROUTER_DEFINE(router, 16);
+
+static u32_t hits[ROUTE_CNT];
+
+static const char * const filters[ROUTE_CNT] = {
+	"sport/tennis/player1",
+	"sport/tennis/+",
+	"sport/#",
+	"+/+",
+	"#",
+	"/finance",
+	"+/tennis/#",
+	"$SYS/#",
+};
+
+static struct mqtt_utf8 utf8(const char *str)
+{
+	struct mqtt_utf8 ret = {
+		.utf8 = (u8_t *)str,
+		.size = strlen(str)
+	};
+
+	return ret;
+}
+
+static void handler(struct mqtt_client *client,
+		    const struct mqtt_publish_param *param, void *user_data)
+{
+	hits[(size_t)user_data]++;
+}
+
+/* Dispatch the topic and return bit mask of the routes that matched. */
+static u32_t dispatch(const char *topic)
+{
+	struct mqtt_publish_param param = {
+		.message.topic.topic = utf8(topic),
+	};
+	u32_t mask = 0;
+	int count;
+
+	memset(hits, 0, sizeof(hits));
+
+	count = mqtt_router_dispatch(&router, NULL, &param);
+
+	for (size_t i = 0; i < ROUTE_CNT; i++) {
+		zassert_true(hits[i] <= 1, "Handler called twice");
+		mask |= hits[i] ? BIT(i) : 0;
+	}
+
+	zassert_equal(count, __builtin_popcount(mask),
+		      "Invalid number of handlers");
+
+	return mask;
+}
+
+static void test_add(void)
+{
+	for (size_t i = 0; i < ROUTE_CNT; i++) {
+		struct mqtt_utf8 filter = utf8(filters[i]);
+
+		zassert_equal(mqtt_router_add(&router, &filter, handler,
+					      (void *)i), 0,
+			      "Cannot add route");
+	}
+}
+
+static void test_match(void)
+{
+	zassert_equal(dispatch("sport/tennis/player1"),
+		      BIT(0) | BIT(1) | BIT(2) | BIT(4) | BIT(6), NULL);
+	zassert_equal(dispatch("sport/tennis/player2"),
+		      BIT(1) | BIT(2) | BIT(4) | BIT(6), NULL);
+	zassert_equal(dispatch("sport/tennis/player1/ranking"),
+		      BIT(2) | BIT(4) | BIT(6), NULL);
+	zassert_equal(dispatch("sport"), BIT(2) | BIT(4), NULL);
+	zassert_equal(dispatch("sport/"), BIT(2) | BIT(3) | BIT(4), NULL);
+	zassert_equal(dispatch("sport/tennis"),
+		      BIT(2) | BIT(3) | BIT(4) | BIT(6), NULL);
+	zassert_equal(dispatch("/finance"), BIT(3) | BIT(4) | BIT(5), NULL);
+	zassert_equal(dispatch("finance"), BIT(4), NULL);
+}
+
+static void test_dollar_topics(void)
+{
+	/* Wildcards on the first level do not match '$' topics. */
+	zassert_equal(dispatch("$SYS/broker/load"), BIT(7), NULL);
+	zassert_equal(dispatch("$SYS"), BIT(7), NULL);
+	zassert_equal(dispatch("$other/tennis"), 0, NULL);
+}
+
+static void test_invalid_filters(void)
+{
+	const char * const invalid[] = {
+		"sport/tennis#", "sport/#/ranking", "sport+", "+sport/x", "",
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(invalid); i++) {
+		struct mqtt_utf8 filter = utf8(invalid[i]);
+
+		zassert_equal(mqtt_router_add(&router, &filter, handler, NULL),
+			      -EINVAL, "Invalid filter accepted");
+	}
+}
+
+static void test_duplicate(void)
+{
+	struct mqtt_utf8 filter = utf8(filters[1]);
+
+	zassert_equal(mqtt_router_add(&router, &filter, handler, NULL),
+		      -EEXIST, "Duplicate route added");
+}
+
+static void test_remove(void)
+{
+	struct mqtt_utf8 filter = utf8(filters[2]);
+
+	zassert_equal(mqtt_router_remove(&router, &filter), 0,
+		      "Cannot remove route");
+	zassert_equal(mqtt_router_remove(&router, &filter), -ENOENT,
+		      "Route removed twice");
+
+	zassert_equal(dispatch("sport"), BIT(4), NULL);
+	zassert_equal(dispatch("sport/tennis/player1"),
+		      BIT(0) | BIT(1) | BIT(4) | BIT(6), NULL);
+
+	/* Level shared with other routes is not removed. */
+	filter = utf8(filters[0]);
+	zassert_equal(mqtt_router_remove(&router, &filter), 0,
+		      "Cannot remove route");
+	zassert_equal(dispatch("sport/tennis/player1"),
+		      BIT(1) | BIT(4) | BIT(6), NULL);
+}
+
+static void test_out_of_nodes(void)
+{
+	static const char * const deep = "a/b/c/d/e/f/g/h/i/j/k/l/m/n/o/p";
+	struct mqtt_utf8 filter = utf8(deep);
+	struct mqtt_utf8 short_filter = utf8("a/b");
+
+	zassert_equal(mqtt_router_add(&router, &filter, handler, NULL),
+		      -ENOMEM, "Route added without free nodes");
+
+	/* Nodes of the failed route are released. */
+	zassert_equal(mqtt_router_add(&router, &short_filter, handler,
+				      (void *)0), 0, "Cannot add route");
+	zassert_equal(dispatch("a/b"), BIT(0) | BIT(3) | BIT(4), NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(mqtt_router_tests,
+			 ztest_unit_test(test_add),
+			 ztest_unit_test(test_match),
+			 ztest_unit_test(test_dollar_topics),
+			 ztest_unit_test(test_invalid_filters),
+			 ztest_unit_test(test_duplicate),
+			 ztest_unit_test(test_remove),
+			 ztest_unit_test(test_out_of_nodes)
+			 );
+
+	ztest_run_test_suite(mqtt_router_tests);
+}
@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <errno.h>
+
+#include "mqtt_transport.h"
+#include "mqtt_internal.h"
+#include "broker_stub.h"
+
+#define STUB_BUF_SIZE 1024
+
+static u8_t tx_buf[STUB_BUF_SIZE];
+static size_t tx_len;
+static u8_t rx_buf[STUB_BUF_SIZE];
+static size_t rx_len;
+
+static struct broker_stub_record records[BROKER_STUB_MAX_RECORDS];
+static size_t record_cnt;
+static size_t write_cnt;
+static size_t write_msg_cnt;
+
+static bool ack_enabled = true;
+static bool link_up = true;
+static bool session_stored;
+static u8_t protocol_version;
+static u16_t receive_max;
+static u16_t topic_alias_max;
+static u32_t read_limit;
+static bool read_blocking;
+
+
+static void response_add(u8_t type, u16_t message_id, size_t len)
+{
+	u8_t *p = &rx_buf[rx_len];
+
+	__ASSERT_NO_MSG(rx_len + 4 <= sizeof(rx_buf));
+
+	p[0] = type;
+	p[1] = len;
+	if (len == 2) {
+		p[2] = message_id >> 8;
+		p[3] = message_id & 0xFF;
+	}
+	rx_len += 2 + len;
+}
+
+static void record_add(u8_t type, bool dup, u16_t message_id,
+		       u16_t topic_len, u16_t topic_alias)
+{
+	if (record_cnt < ARRAY_SIZE(records)) {
+		records[record_cnt].type = type;
+		records[record_cnt].dup = dup;
+		records[record_cnt].message_id = message_id;
+		records[record_cnt].topic_len = topic_len;
+		records[record_cnt].topic_alias = topic_alias;
+		record_cnt++;
+	}
+}
+
+static void connack_add(bool session_present)
+{
+	bool v5 = (protocol_version == MQTT_VERSION_5_0);
+
+	rx_buf[rx_len++] = MQTT_PKT_TYPE_CONNACK;
+	rx_buf[rx_len++] = v5 ? 9 : 2;
+	rx_buf[rx_len++] = session_present ? 1 : 0;
+	rx_buf[rx_len++] = 0;
+
+	if (v5) {
+		rx_buf[rx_len++] = 6;
+		rx_buf[rx_len++] = MQTT_PROP_RECEIVE_MAXIMUM;
+		rx_buf[rx_len++] = receive_max >> 8;
+		rx_buf[rx_len++] = receive_max & 0xFF;
+		rx_buf[rx_len++] = MQTT_PROP_TOPIC_ALIAS_MAXIMUM;
+		rx_buf[rx_len++] = topic_alias_max >> 8;
+		rx_buf[rx_len++] = topic_alias_max & 0xFF;
+	}
+}
+
+static void packet_handle(const u8_t *data, u32_t hdr_len)
+{
+	u8_t type = data[0] & 0xF0;
+	u16_t message_id = 0;
+	u16_t topic_len = 0;
+	u16_t topic_alias = 0;
+
+	switch (type) {
+	case MQTT_PKT_TYPE_CONNECT: {
+		/* Connect flags follow protocol name and level. */
+		u32_t name_len = (data[hdr_len] << 8) | data[hdr_len + 1];
+		bool clean = data[hdr_len + 2 + name_len + 1] &
+			     MQTT_CONNECT_FLAG_CLEAN_SESSION;
+
+		protocol_version = data[hdr_len + 2 + name_len];
+		connack_add(!clean && session_stored);
+		session_stored = !clean;
+		break;
+	}
+	case MQTT_PKT_TYPE_PUBLISH: {
+		u8_t qos = (data[0] & MQTT_HEADER_QOS_MASK) >> 1;
+		u32_t offset;
+
+		topic_len = (data[hdr_len] << 8) | data[hdr_len + 1];
+		offset = hdr_len + 2 + topic_len;
+
+		if (qos > 0) {
+			message_id = (data[offset] << 8) | data[offset + 1];
+			offset += 2;
+		}
+
+		/* Topic Alias is the only property sent by the client. */
+		if ((protocol_version == MQTT_VERSION_5_0) &&
+		    (data[offset] == 3) &&
+		    (data[offset + 1] == MQTT_PROP_TOPIC_ALIAS)) {
+			topic_alias = (data[offset + 2] << 8) |
+				      data[offset + 3];
+		}
+
+		if (ack_enabled && (qos == 1)) {
+			response_add(MQTT_PKT_TYPE_PUBACK, message_id, 2);
+		} else if (ack_enabled && (qos == 2)) {
+			response_add(MQTT_PKT_TYPE_PUBREC, message_id, 2);
+		}
+		break;
+	}
+	case MQTT_PKT_TYPE_PUBREL:
+		message_id = (data[hdr_len] << 8) | data[hdr_len + 1];
+		if (ack_enabled) {
+			response_add(MQTT_PKT_TYPE_PUBCOMP, message_id, 2);
+		}
+		break;
+
+	case MQTT_PKT_TYPE_PINGREQ:
+		response_add(MQTT_PKT_TYPE_PINGRSP, 0, 0);
+		break;
+
+	default:
+		break;
+	}
+
+	record_add(type, data[0] & MQTT_HEADER_DUP_MASK, message_id,
+		   topic_len, topic_alias);
+}
+
+static void tx_process(void)
+{
+	while (tx_len >= MQTT_FIXED_HEADER_SIZE) {
+		u32_t remaining_length;
+		u32_t offset = 1;
+
+		if (packet_length_decode(tx_buf, tx_len, &remaining_length,
+					 &offset) != 0) {
+			return;
+		}
+
+		u32_t packet_len = offset + remaining_length;
+
+		if (packet_len > tx_len) {
+			return;
+		}
+
+		packet_handle(tx_buf, offset);
+
+		tx_len -= packet_len;
+		memmove(tx_buf, tx_buf + packet_len, tx_len);
+	}
+}
+
+static int tx_add(const u8_t *data, u32_t datalen)
+{
+	if (!link_up) {
+		return -ENOTCONN;
+	}
+
+	__ASSERT_NO_MSG(tx_len + datalen <= sizeof(tx_buf));
+
+	memcpy(tx_buf + tx_len, data, datalen);
+	tx_len += datalen;
+
+	return 0;
+}
+
+int mqtt_transport_connect(struct mqtt_client *client)
+{
+	tx_len = 0;
+	rx_len = 0;
+
+	return link_up ? 0 : -ECONNREFUSED;
+}
+
+int mqtt_transport_write(struct mqtt_client *client, const u8_t *data,
+			 u32_t datalen)
+{
+	int err = tx_add(data, datalen);
+
+	if (err == 0) {
+		write_cnt++;
+	}
+
+	tx_process();
+
+	return err;
+}
+
+int mqtt_transport_write_msg(struct mqtt_client *client, const u8_t *header,
+			     u32_t header_len, const u8_t *payload,
+			     u32_t payload_len)
+{
+	int err = tx_add(header, header_len);
+
+	if (err == 0) {
+		err = tx_add(payload, payload_len);
+	}
+
+	if (err == 0) {
+		write_cnt++;
+		write_msg_cnt++;
+	}
+
+	tx_process();
+
+	return err;
+}
+
+int mqtt_transport_read(struct mqtt_client *client, u8_t *data, u32_t *datalen,
+			bool shall_block)
+{
+	u32_t len = MIN(*datalen, rx_len);
+
+	read_blocking = shall_block;
+
+	if (read_limit > 0) {
+		len = MIN(len, read_limit);
+	}
+
+	if (len == 0) {
+		return -EAGAIN;
+	}
+
+	memcpy(data, rx_buf, len);
+	rx_len -= len;
+	memmove(rx_buf, rx_buf + len, rx_len);
+	*datalen = len;
+
+	return 0;
+}
+
+int mqtt_transport_disconnect(struct mqtt_client *client)
+{
+	tx_len = 0;
+	rx_len = 0;
+
+	return 0;
+}
+
+int mqtt_transport_sock_get(const struct mqtt_client *client)
+{
+	/* No socket to poll, data is only read by mqtt_input. */
+	return -1;
+}
+
+void broker_stub_reset(void)
+{
+	tx_len = 0;
+	rx_len = 0;
+	record_cnt = 0;
+	write_cnt = 0;
+	write_msg_cnt = 0;
+	ack_enabled = true;
+	link_up = true;
+	session_stored = false;
+	receive_max = MQTT_RECEIVE_MAXIMUM_DEFAULT;
+	topic_alias_max = 0;
+	read_limit = 0;
+	read_blocking = false;
+}
+
+void broker_stub_limits_set(u16_t receive_max_value,
+			    u16_t topic_alias_max_value)
+{
+	receive_max = receive_max_value;
+	topic_alias_max = topic_alias_max_value;
+}
+
+void broker_stub_ack_set(bool enable)
+{
+	ack_enabled = enable;
+}
+
+void broker_stub_link_set(bool up)
+{
+	link_up = up;
+}
+
+size_t broker_stub_record_count(void)
+{
+	return record_cnt;
+}
+
+const struct broker_stub_record *broker_stub_record_get(size_t idx)
+{
+	return (idx < record_cnt) ? &records[idx] : NULL;
+}
+
+void broker_stub_record_clear(void)
+{
+	record_cnt = 0;
+	write_cnt = 0;
+	write_msg_cnt = 0;
+}
+
+size_t broker_stub_write_count(void)
+{
+	return write_cnt;
+}
+
+size_t broker_stub_write_msg_count(void)
+{
+	return write_msg_cnt;
+}
+
+void broker_stub_publish_inject(const char *topic, const u8_t *data,
+				u32_t len)
+{
+	u32_t topic_len = strlen(topic);
+	u32_t remaining_length = 2 + topic_len + len;
+	u8_t *p;
+
+	__ASSERT_NO_MSG(rx_len + MQTT_FIXED_HEADER_EXTENDED_SIZE +
+			remaining_length <= sizeof(rx_buf));
+
+	rx_buf[rx_len++] = MQTT_PKT_TYPE_PUBLISH;
+
+	/* Variable length encoding of the remaining length. */
+	do {
+		rx_buf[rx_len] = remaining_length & 0x7F;
+		remaining_length >>= 7;
+		if (remaining_length > 0) {
+			rx_buf[rx_len] |= 0x80;
+		}
+		rx_len++;
+	} while (remaining_length > 0);
+
+	p = &rx_buf[rx_len];
+	p[0] = topic_len >> 8;
+	p[1] = topic_len & 0xFF;
+	memcpy(&p[2], topic, topic_len);
+	memcpy(&p[2 + topic_len], data, len);
+	rx_len += 2 + topic_len + len;
+}
+
+void broker_stub_puback_inject(u16_t message_id)
+{
+	response_add(MQTT_PKT_TYPE_PUBACK, message_id, 2);
+}
+
+void broker_stub_read_limit_set(u32_t limit)
+{
+	read_limit = limit;
+}
+
+bool broker_stub_read_blocking(void)
+{
+	return read_blocking;
+}
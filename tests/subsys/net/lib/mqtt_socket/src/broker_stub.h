@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _BROKER_STUB_H_
+#define _BROKER_STUB_H_
+
+/**
+ * @brief Broker stand-in used instead of the MQTT socket transport.
+ *
+ * Packets written by the client are decoded by the stub and the broker
+ * responses are returned by the transport read.
+ */
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BROKER_STUB_MAX_RECORDS 32
+
+/** Packet received by the broker stand-in. */
+struct broker_stub_record {
+	u8_t type;
+	bool dup;
+	u16_t message_id;
+	/** Topic length and MQTT 5.0 topic alias of a PUBLISH packet. */
+	u16_t topic_len;
+	u16_t topic_alias;
+};
+
+/** Reset the broker state, including the session. */
+void broker_stub_reset(void);
+
+/** Enable or disable acknowledging of PUBLISH and PUBREL packets. */
+void broker_stub_ack_set(bool enable);
+
+/** Make transport writes fail, as if the connection was lost. */
+void broker_stub_link_set(bool up);
+
+/** Set the Receive Maximum and Topic Alias Maximum sent in the CONNACK to
+ *  MQTT 5.0 clients.
+ */
+void broker_stub_limits_set(u16_t receive_max, u16_t topic_alias_max);
+
+/** Queue a QoS 0 PUBLISH message to be read by the client. */
+void broker_stub_publish_inject(const char *topic, const u8_t *data,
+				u32_t len);
+
+/** Queue a PUBACK to be read by the client, whether or not the message was
+ *  sent.
+ */
+void broker_stub_puback_inject(u16_t message_id);
+
+/** Return at most limit bytes from each transport read, as if the data
+ *  arrived in pieces. 0 to return all the data queued.
+ */
+void broker_stub_read_limit_set(u32_t limit);
+
+/** Whether the last transport read was a blocking one. */
+bool broker_stub_read_blocking(void);
+
+/** Number of packets received by the broker since the last reset. */
+size_t broker_stub_record_count(void);
+
+/** Packet received by the broker. */
+const struct broker_stub_record *broker_stub_record_get(size_t idx);
+
+/** Forget the packets received and writes done so far. */
+void broker_stub_record_clear(void);
+
+/** Number of transport writes done since the last clear. */
+size_t broker_stub_write_count(void);
+
+/** Number of those writes done with a separate header and payload. */
+size_t broker_stub_write_msg_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BROKER_STUB_H_ */
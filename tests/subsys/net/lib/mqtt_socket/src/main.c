@@ -0,0 +1,854 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <net/mqtt_socket.h>
+
+#include "mqtt_internal.h"
+#include "broker_stub.h"
+
+#define TEST_TOPIC		"sensors/temp"
+#define TEST_CLIENT_ID		"inflight_test"
+#define RETRY_TIMEOUT_MS	(CONFIG_MQTT_INFLIGHT_RETRY_TIMEOUT * 1000)
+
+#define STORAGE_SLOTS		CONFIG_MQTT_INFLIGHT_MAX_MESSAGES
+
+static struct mqtt_client client;
+static u8_t payload[64] = "21.5";
+static u32_t pubrec_cnt;
+static u32_t disconnect_cnt;
+
+/* Payload larger than the client RX buffer, streamed to the application. */
+#define LARGE_PAYLOAD_LEN	300
+#define READ_CHUNK_LEN		50
+
+static u8_t large_payload[LARGE_PAYLOAD_LEN];
+static u8_t rx_payload[LARGE_PAYLOAD_LEN];
+static u32_t publish_cnt;
+static u32_t publish_len;
+static bool publish_streamed;
+/* Bytes of a streamed payload to read from the event handler. */
+static u32_t publish_handler_read_len;
+
+/* RAM backed stand-in of a persistent storage. */
+static struct {
+	bool used;
+	u16_t message_id;
+	u32_t len;
+	u8_t data[CONFIG_MQTT_INFLIGHT_MAX_MESSAGE_LENGTH];
+} storage_slots[STORAGE_SLOTS];
+
+
+static int storage_store(const struct mqtt_utf8 *client_id, u16_t message_id,
+			 const u8_t *data, u32_t len)
+{
+	size_t free_slot = STORAGE_SLOTS;
+
+	for (size_t i = 0; i < STORAGE_SLOTS; i++) {
+		if (storage_slots[i].used &&
+		    (storage_slots[i].message_id == message_id)) {
+			free_slot = i;
+			break;
+		} else if (!storage_slots[i].used &&
+			   (free_slot == STORAGE_SLOTS)) {
+			free_slot = i;
+		}
+	}
+
+	if (free_slot == STORAGE_SLOTS) {
+		return -ENOMEM;
+	}
+
+	storage_slots[free_slot].used = true;
+	storage_slots[free_slot].message_id = message_id;
+	storage_slots[free_slot].len = len;
+	memcpy(storage_slots[free_slot].data, data, len);
+
+	return 0;
+}
+
+static void storage_remove(const struct mqtt_utf8 *client_id,
+			   u16_t message_id)
+{
+	for (size_t i = 0; i < STORAGE_SLOTS; i++) {
+		if (storage_slots[i].used &&
+		    (storage_slots[i].message_id == message_id)) {
+			storage_slots[i].used = false;
+		}
+	}
+}
+
+static void storage_load(struct mqtt_client *c)
+{
+	for (size_t i = 0; i < STORAGE_SLOTS; i++) {
+		if (storage_slots[i].used) {
+			zassert_equal(mqtt_inflight_restore(c,
+						storage_slots[i].message_id,
+						storage_slots[i].data,
+						storage_slots[i].len),
+				      0, "Cannot restore message");
+		}
+	}
+}
+
+static const struct mqtt_inflight_storage storage = {
+	.store = storage_store,
+	.remove = storage_remove,
+	.load = storage_load,
+};
+
+static size_t storage_count(void)
+{
+	size_t cnt = 0;
+
+	for (size_t i = 0; i < STORAGE_SLOTS; i++) {
+		cnt += storage_slots[i].used ? 1 : 0;
+	}
+
+	return cnt;
+}
+
+static void evt_handler(struct mqtt_client *c, const struct mqtt_evt *evt)
+{
+	if (evt->type == MQTT_EVT_PUBREC) {
+		const struct mqtt_pubrel_param param = {
+			.message_id = evt->param.pubrec.message_id
+		};
+
+		pubrec_cnt++;
+		zassert_equal(mqtt_publish_qos2_release(c, &param), 0,
+			      "Cannot send PUBREL");
+	} else if (evt->type == MQTT_EVT_DISCONNECT) {
+		disconnect_cnt++;
+	} else if (evt->type == MQTT_EVT_PUBLISH) {
+		const struct mqtt_binstr *payload =
+					&evt->param.publish.message.payload;
+
+		publish_cnt++;
+		publish_len = payload->len;
+		publish_streamed = (payload->data == NULL);
+
+		if (!publish_streamed) {
+			memcpy(rx_payload, payload->data, payload->len);
+		} else if (publish_handler_read_len > 0) {
+			zassert_equal(mqtt_readall_publish_payload(c,
+						rx_payload,
+						publish_handler_read_len),
+				      0, "Cannot read payload in handler");
+		}
+	}
+}
+
+static void client_connect_version(bool clean_session, u8_t version)
+{
+	mqtt_client_init(&client);
+
+	client.protocol_version = version;
+	client.client_id.utf8 = (u8_t *)TEST_CLIENT_ID;
+	client.client_id.size = strlen(TEST_CLIENT_ID);
+	client.clean_session = clean_session;
+	client.evt_cb = evt_handler;
+
+	zassert_equal(mqtt_connect(&client), 0, "Cannot connect");
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive CONNACK");
+	zassert_true(client.state & MQTT_STATE_CONNECTED, "Not connected");
+}
+
+static void client_connect(bool clean_session)
+{
+	client_connect_version(clean_session, MQTT_VERSION_3_1_1);
+}
+
+static void publish_param_init(struct mqtt_publish_param *param,
+			       u16_t message_id, u8_t qos, u32_t payload_len)
+{
+	memset(param, 0, sizeof(*param));
+
+	param->message.topic.topic.utf8 = (u8_t *)TEST_TOPIC;
+	param->message.topic.topic.size = strlen(TEST_TOPIC);
+	param->message.topic.qos = qos;
+	param->message.payload.data = payload;
+	param->message.payload.len = payload_len;
+	param->message_id = message_id;
+}
+
+static int publish(u16_t message_id, u8_t qos, u32_t payload_len)
+{
+	struct mqtt_publish_param param;
+
+	publish_param_init(&param, message_id, qos, payload_len);
+
+	return mqtt_publish(&client, &param);
+}
+
+static int publish_batch(u16_t message_id, u8_t qos, u32_t payload_len)
+{
+	struct mqtt_publish_param param;
+
+	publish_param_init(&param, message_id, qos, payload_len);
+
+	return mqtt_publish_batch(&client, &param);
+}
+
+static void check_record(size_t idx, u8_t type, bool dup, u16_t message_id)
+{
+	const struct broker_stub_record *rec = broker_stub_record_get(idx);
+
+	zassert_not_null(rec, "Packet %u not received", idx);
+	zassert_equal(rec->type, type, "Invalid packet type");
+	zassert_equal(rec->dup, dup, "Invalid DUP flag");
+	zassert_equal(rec->message_id, message_id, "Invalid message id");
+}
+
+static void test_setup(void)
+{
+	broker_stub_reset();
+	mqtt_inflight_storage_set(NULL);
+	memset(storage_slots, 0, sizeof(storage_slots));
+	pubrec_cnt = 0;
+	disconnect_cnt = 0;
+	publish_cnt = 0;
+	publish_len = 0;
+	publish_streamed = false;
+	publish_handler_read_len = 0;
+	memset(rx_payload, 0, sizeof(rx_payload));
+
+	client_connect(true);
+	broker_stub_record_clear();
+}
+
+static void test_teardown(void)
+{
+	broker_stub_link_set(true);
+	(void)mqtt_abort(&client);
+}
+
+static void test_init(void)
+{
+	zassert_equal(mqtt_init(), 0, "Cannot initialize MQTT");
+}
+
+static void test_qos0_not_stored(void)
+{
+	zassert_equal(publish(0, MQTT_QOS_0_AT_MOST_ONCE, 4), 0,
+		      "Cannot publish");
+	zassert_equal(mqtt_inflight_count(&client), 0,
+		      "QoS 0 message stored");
+}
+
+static void test_publish_single_write(void)
+{
+	struct mqtt_publish_param param;
+
+	/* Payload fitting in the TX buffer is sent with the header. */
+	zassert_equal(publish(0, MQTT_QOS_0_AT_MOST_ONCE, sizeof(payload)), 0,
+		      "Cannot publish");
+	zassert_equal(broker_stub_write_count(), 1, "Message not sent at once");
+	zassert_equal(broker_stub_write_msg_count(), 0, "Payload not copied");
+
+	/* Longer payload is sent from the application buffer. */
+	publish_param_init(&param, 0, MQTT_QOS_0_AT_MOST_ONCE,
+			   sizeof(large_payload));
+	param.message.payload.data = large_payload;
+
+	zassert_equal(mqtt_publish(&client, &param), 0, "Cannot publish");
+	zassert_equal(broker_stub_write_count(), 2, "Message not sent");
+	zassert_equal(broker_stub_write_msg_count(), 1, "Payload copied");
+	zassert_equal(broker_stub_record_count(), 2, "Messages not received");
+	check_record(1, MQTT_PKT_TYPE_PUBLISH, false, 0);
+}
+
+static void test_qos1_acknowledged(void)
+{
+	zassert_equal(publish(1, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+	zassert_equal(mqtt_inflight_count(&client), 1, "Message not stored");
+
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBACK");
+	zassert_equal(mqtt_inflight_count(&client), 0,
+		      "Acknowledged message not removed");
+}
+
+static void test_qos1_resend(void)
+{
+	broker_stub_ack_set(false);
+
+	zassert_equal(publish(2, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+
+	/* Nothing is sent again before the timeout. */
+	zassert_equal(mqtt_live(), 0, "Keep alive failed");
+	zassert_equal(broker_stub_record_count(), 1, "Sent again too early");
+
+	k_sleep(RETRY_TIMEOUT_MS + 100);
+	broker_stub_ack_set(true);
+
+	zassert_equal(mqtt_live(), 0, "Keep alive failed");
+	zassert_equal(broker_stub_record_count(), 2, "Message not sent again");
+	check_record(0, MQTT_PKT_TYPE_PUBLISH, false, 2);
+	check_record(1, MQTT_PKT_TYPE_PUBLISH, true, 2);
+
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBACK");
+	zassert_equal(mqtt_inflight_count(&client), 0,
+		      "Acknowledged message not removed");
+}
+
+static void test_process_resend(void)
+{
+	broker_stub_ack_set(false);
+
+	zassert_equal(publish(9, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+
+	zassert_equal(mqtt_process(K_NO_WAIT), 0, "Processing failed");
+	zassert_equal(broker_stub_record_count(), 1, "Sent again too early");
+
+	k_sleep(RETRY_TIMEOUT_MS + 100);
+	broker_stub_ack_set(true);
+
+	zassert_equal(mqtt_process(K_NO_WAIT), 0, "Processing failed");
+	check_record(1, MQTT_PKT_TYPE_PUBLISH, true, 9);
+
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBACK");
+	zassert_equal(mqtt_inflight_count(&client), 0,
+		      "Acknowledged message not removed");
+}
+
+static void test_qos2_flow(void)
+{
+	zassert_equal(publish(3, MQTT_QOS_2_EXACTLY_ONCE, 4), 0,
+		      "Cannot publish");
+
+	/* PUBREC is handled by sending PUBREL, PUBCOMP is not sent. */
+	broker_stub_ack_set(false);
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBREC");
+	zassert_equal(pubrec_cnt, 1, "PUBREC not received");
+	zassert_equal(mqtt_inflight_count(&client), 1,
+		      "PUBREL not stored");
+
+	k_sleep(RETRY_TIMEOUT_MS + 100);
+	broker_stub_ack_set(true);
+
+	zassert_equal(mqtt_live(), 0, "Keep alive failed");
+	check_record(0, MQTT_PKT_TYPE_PUBLISH, false, 3);
+	check_record(1, MQTT_PKT_TYPE_PUBREL, false, 3);
+	check_record(2, MQTT_PKT_TYPE_PUBREL, false, 3);
+
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBCOMP");
+	zassert_equal(mqtt_inflight_count(&client), 0,
+		      "Completed message not removed");
+}
+
+static void test_replay_on_reconnect(void)
+{
+	zassert_equal(mqtt_abort(&client), 0, "Cannot abort");
+	client_connect(false);
+	broker_stub_record_clear();
+	disconnect_cnt = 0;
+
+	broker_stub_link_set(false);
+
+	/* Messages are stored even if the connection is lost, so the failed
+	 * write is reported only by the disconnect event.
+	 */
+	zassert_equal(publish(4, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Stored message failed");
+	zassert_equal(mqtt_inflight_count(&client), 1, "Message not stored");
+	zassert_equal(disconnect_cnt, 1, "Connection loss not reported");
+
+	broker_stub_link_set(true);
+	client_connect(false);
+	zassert_equal(publish(5, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+
+	/* Stored message is sent again right after CONNACK. */
+	check_record(0, MQTT_PKT_TYPE_CONNECT, false, 0);
+	check_record(1, MQTT_PKT_TYPE_PUBLISH, true, 4);
+	check_record(2, MQTT_PKT_TYPE_PUBLISH, false, 5);
+
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBACK");
+	zassert_equal(mqtt_inflight_count(&client), 0,
+		      "Acknowledged messages not removed");
+}
+
+static void test_clean_session_write_failure(void)
+{
+	broker_stub_link_set(false);
+
+	/* The stored message is dropped when reconnecting with a clean
+	 * session, so the failed write is reported.
+	 */
+	zassert_equal(publish(4, MQTT_QOS_1_AT_LEAST_ONCE, 4), -EIO,
+		      "Write failure not reported");
+	zassert_equal(disconnect_cnt, 1, "Connection loss not reported");
+
+	broker_stub_link_set(true);
+	client_connect(true);
+
+	zassert_equal(mqtt_inflight_count(&client), 0,
+		      "Messages kept with clean session");
+	zassert_equal(broker_stub_record_count(), 1, "Message sent again");
+	check_record(0, MQTT_PKT_TYPE_CONNECT, false, 0);
+}
+
+static void test_clean_session(void)
+{
+	broker_stub_ack_set(false);
+	zassert_equal(publish(6, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+	zassert_equal(mqtt_abort(&client), 0, "Cannot abort");
+
+	client_connect(true);
+	zassert_equal(mqtt_inflight_count(&client), 0,
+		      "Messages kept with clean session");
+}
+
+static void test_limits(void)
+{
+	broker_stub_ack_set(false);
+
+	for (u16_t i = 0; i < CONFIG_MQTT_INFLIGHT_MAX_MESSAGES; i++) {
+		zassert_equal(publish(10 + i, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+			      "Cannot publish");
+	}
+
+	zassert_equal(publish(100, MQTT_QOS_1_AT_LEAST_ONCE, 4), -ENOMEM,
+		      "Store is not bounded");
+
+	/* Message with the same id replaces the stored one. */
+	zassert_equal(publish(10, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish again");
+
+	mqtt_inflight_clear(&client);
+
+	zassert_equal(publish(101, MQTT_QOS_1_AT_LEAST_ONCE,
+			      CONFIG_MQTT_INFLIGHT_MAX_MESSAGE_LENGTH),
+		      -EMSGSIZE, "Too long message stored");
+}
+
+static void test_persistent_storage(void)
+{
+	mqtt_inflight_storage_set(&storage);
+	broker_stub_ack_set(false);
+
+	zassert_equal(publish(7, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+	zassert_equal(publish(8, MQTT_QOS_2_EXACTLY_ONCE, 4), 0,
+		      "Cannot publish");
+	zassert_equal(storage_count(), 2, "Messages not stored");
+
+	/* Drop messages kept in RAM, as after a reset. */
+	mqtt_inflight_storage_set(NULL);
+	mqtt_inflight_clear(&client);
+	mqtt_inflight_storage_set(&storage);
+	zassert_equal(mqtt_abort(&client), 0, "Cannot abort");
+
+	broker_stub_ack_set(true);
+	broker_stub_record_clear();
+
+	client_connect(false);
+	zassert_equal(mqtt_inflight_count(&client), 2,
+		      "Messages not restored");
+	check_record(1, MQTT_PKT_TYPE_PUBLISH, true, 7);
+	check_record(2, MQTT_PKT_TYPE_PUBLISH, true, 8);
+
+	/* PUBACK, then PUBREC followed by PUBREL and PUBCOMP. */
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive acks");
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBCOMP");
+	zassert_equal(mqtt_inflight_count(&client), 0,
+		      "Acknowledged messages not removed");
+	zassert_equal(storage_count(), 0, "Stored messages not removed");
+}
+
+static void test_batch_flush(void)
+{
+	for (u16_t i = 0; i < 3; i++) {
+		zassert_equal(publish_batch(0, MQTT_QOS_0_AT_MOST_ONCE, 4), 0,
+			      "Cannot publish");
+	}
+
+	zassert_equal(broker_stub_write_count(), 0, "Batch sent too early");
+
+	zassert_equal(mqtt_publish_batch_flush(&client), 0, "Cannot flush");
+	zassert_equal(broker_stub_write_count(), 1, "Batch not sent at once");
+	zassert_equal(broker_stub_record_count(), 3, "Messages not sent");
+
+	/* Nothing left to send. */
+	zassert_equal(mqtt_publish_batch_flush(&client), 0, "Cannot flush");
+	zassert_equal(broker_stub_write_count(), 1, "Empty batch sent");
+}
+
+static void test_batch_full(void)
+{
+	/* Each message takes 20 bytes, three of them fit in the buffer. */
+	for (u16_t i = 0; i < 4; i++) {
+		zassert_equal(publish_batch(0, MQTT_QOS_0_AT_MOST_ONCE, 4), 0,
+			      "Cannot publish");
+	}
+
+	zassert_equal(broker_stub_write_count(), 1, "Full batch not sent");
+	zassert_equal(broker_stub_record_count(), 3, "Invalid batch length");
+
+	/* Message longer than the buffer is sent with the batch before it. */
+	zassert_equal(publish_batch(0, MQTT_QOS_0_AT_MOST_ONCE,
+				    sizeof(payload)), 0, "Cannot publish");
+	zassert_equal(broker_stub_write_count(), 3, "Long message batched");
+	zassert_equal(broker_stub_record_count(), 5, "Messages not sent");
+}
+
+static void test_batch_timeout(void)
+{
+	zassert_equal(publish_batch(0, MQTT_QOS_0_AT_MOST_ONCE, 4), 0,
+		      "Cannot publish");
+
+	zassert_equal(mqtt_live(), 0, "Keep alive failed");
+	zassert_equal(broker_stub_write_count(), 0, "Batch sent too early");
+
+	k_sleep(CONFIG_MQTT_PUBLISH_BATCH_TIMEOUT);
+
+	zassert_equal(mqtt_process(K_NO_WAIT), 0, "Processing failed");
+	zassert_equal(broker_stub_write_count(), 1, "Batch not sent");
+}
+
+static void test_batch_order(void)
+{
+	zassert_equal(publish_batch(20, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+	zassert_equal(mqtt_inflight_count(&client), 1, "Message not stored");
+
+	zassert_equal(publish(21, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+
+	check_record(0, MQTT_PKT_TYPE_PUBLISH, false, 20);
+	check_record(1, MQTT_PKT_TYPE_PUBLISH, false, 21);
+
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBACK");
+	zassert_equal(mqtt_inflight_count(&client), 0,
+		      "Acknowledged messages not removed");
+}
+
+static void check_topic(size_t idx, u16_t topic_len, u16_t topic_alias)
+{
+	const struct broker_stub_record *rec = broker_stub_record_get(idx);
+
+	zassert_not_null(rec, "Packet %u not received", idx);
+	zassert_equal(rec->topic_len, topic_len, "Invalid topic length");
+	zassert_equal(rec->topic_alias, topic_alias, "Invalid topic alias");
+}
+
+static void test_v5_topic_alias(void)
+{
+	struct mqtt_publish_param param;
+
+	(void)mqtt_abort(&client);
+	broker_stub_limits_set(10, 1);
+	client_connect_version(true, MQTT_VERSION_5_0);
+	broker_stub_record_clear();
+
+	zassert_equal(publish(0, MQTT_QOS_0_AT_MOST_ONCE, 4), 0,
+		      "Cannot publish");
+	zassert_equal(publish(0, MQTT_QOS_0_AT_MOST_ONCE, 4), 0,
+		      "Cannot publish");
+
+	/* Topic is only sent along with the alias the first time. */
+	check_topic(0, strlen(TEST_TOPIC), 1);
+	check_topic(1, 0, 1);
+
+	/* Only as many aliases as the server accepts are used. */
+	publish_param_init(&param, 0, MQTT_QOS_0_AT_MOST_ONCE, 4);
+	param.message.topic.topic.size--;
+	zassert_equal(mqtt_publish(&client, &param), 0, "Cannot publish");
+	check_topic(2, strlen(TEST_TOPIC) - 1, 0);
+
+	/* Stored messages keep the topic to be valid on a new connection. */
+	zassert_equal(publish(1, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+	check_topic(3, strlen(TEST_TOPIC), 0);
+
+	/* Aliases are forgotten on reconnect. */
+	(void)mqtt_abort(&client);
+	client_connect_version(true, MQTT_VERSION_5_0);
+	broker_stub_record_clear();
+
+	zassert_equal(publish(0, MQTT_QOS_0_AT_MOST_ONCE, 4), 0,
+		      "Cannot publish");
+	check_topic(0, strlen(TEST_TOPIC), 1);
+}
+
+static void test_v5_receive_max(void)
+{
+	(void)mqtt_abort(&client);
+	broker_stub_limits_set(2, 0);
+	client_connect_version(true, MQTT_VERSION_5_0);
+	broker_stub_record_clear();
+
+	zassert_equal(publish(1, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+	zassert_equal(publish(2, MQTT_QOS_2_EXACTLY_ONCE, 4), 0,
+		      "Cannot publish");
+	zassert_equal(publish(3, MQTT_QOS_1_AT_LEAST_ONCE, 4), -EAGAIN,
+		      "Receive Maximum exceeded");
+
+	/* QoS 0 messages are not limited. */
+	zassert_equal(publish(0, MQTT_QOS_0_AT_MOST_ONCE, 4), 0,
+		      "Cannot publish");
+
+	/* PUBACK returns a slot. PUBREC does not, until PUBCOMP. */
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBACK");
+	zassert_equal(publish(3, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+	zassert_equal(publish(4, MQTT_QOS_1_AT_LEAST_ONCE, 4), -EAGAIN,
+		      "Receive Maximum exceeded");
+
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBCOMP");
+	zassert_equal(pubrec_cnt, 1, "PUBREC not received");
+	zassert_equal(mqtt_inflight_count(&client), 0,
+		      "Acknowledged messages not removed");
+	zassert_equal(publish(4, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+}
+
+static void test_v5_receive_max_duplicate_ack(void)
+{
+	(void)mqtt_abort(&client);
+	broker_stub_limits_set(2, 0);
+	client_connect_version(true, MQTT_VERSION_5_0);
+
+	zassert_equal(publish(1, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBACK");
+
+	/* A second PUBACK for the message does not return another slot. */
+	broker_stub_puback_inject(1);
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBACK");
+
+	broker_stub_ack_set(false);
+	zassert_equal(publish(2, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+	zassert_equal(publish(3, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+	zassert_equal(publish(4, MQTT_QOS_1_AT_LEAST_ONCE, 4), -EAGAIN,
+		      "Receive Maximum exceeded");
+}
+
+static void test_v5_replay_receive_max(void)
+{
+	(void)mqtt_abort(&client);
+	broker_stub_limits_set(4, 0);
+	client_connect_version(false, MQTT_VERSION_5_0);
+
+	broker_stub_ack_set(false);
+	for (u16_t i = 1; i <= 3; i++) {
+		zassert_equal(publish(i, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+			      "Cannot publish");
+	}
+
+	/* The server accepts fewer messages on the new connection. */
+	zassert_equal(mqtt_abort(&client), 0, "Cannot abort");
+	broker_stub_limits_set(2, 0);
+	broker_stub_ack_set(true);
+	broker_stub_record_clear();
+	client_connect_version(false, MQTT_VERSION_5_0);
+
+	check_record(0, MQTT_PKT_TYPE_CONNECT, false, 0);
+	check_record(1, MQTT_PKT_TYPE_PUBLISH, true, 1);
+	check_record(2, MQTT_PKT_TYPE_PUBLISH, true, 2);
+	zassert_equal(broker_stub_record_count(), 3,
+		      "Receive Maximum exceeded by the replay");
+	zassert_equal(publish(4, MQTT_QOS_1_AT_LEAST_ONCE, 4), -EAGAIN,
+		      "Receive Maximum exceeded");
+
+	/* The returned slot is taken by the queued message. */
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBACK");
+	check_record(3, MQTT_PKT_TYPE_PUBLISH, true, 3);
+	zassert_equal(broker_stub_record_count(), 4, "Too many messages sent");
+
+	for (int i = 0; i < 2; i++) {
+		zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBACK");
+	}
+
+	zassert_equal(mqtt_inflight_count(&client), 0,
+		      "Acknowledged messages not removed");
+	zassert_equal(publish(4, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+	zassert_equal(publish(5, MQTT_QOS_1_AT_LEAST_ONCE, 4), 0,
+		      "Cannot publish");
+}
+
+static void large_publish_receive(void)
+{
+	for (size_t i = 0; i < sizeof(large_payload); i++) {
+		large_payload[i] = i;
+	}
+
+	broker_stub_publish_inject(TEST_TOPIC, large_payload,
+				   sizeof(large_payload));
+
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBLISH");
+	zassert_equal(publish_cnt, 1, "PUBLISH not notified");
+	zassert_true(publish_streamed, "Payload not streamed");
+	zassert_equal(publish_len, sizeof(large_payload),
+		      "Invalid payload length");
+}
+
+static void test_publish_stream_read(void)
+{
+	u32_t total = 0;
+	int ret;
+
+	/* Payload arrives in pieces smaller than the reads. */
+	broker_stub_read_limit_set(READ_CHUNK_LEN - 10);
+	large_publish_receive();
+
+	do {
+		ret = mqtt_read_publish_payload(&client, rx_payload + total,
+						MIN(READ_CHUNK_LEN,
+						    sizeof(rx_payload) - total));
+		zassert_true(ret >= 0, "Cannot read payload");
+		zassert_true(ret <= READ_CHUNK_LEN, "Read too much");
+		total += ret;
+	} while (ret > 0);
+
+	zassert_equal(total, sizeof(large_payload), "Payload truncated");
+	zassert_mem_equal(rx_payload, large_payload, sizeof(large_payload),
+			  "Invalid payload");
+	zassert_equal(mqtt_read_publish_payload(&client, rx_payload,
+						READ_CHUNK_LEN), 0,
+		      "Read past the payload");
+}
+
+static void test_publish_stream_readall(void)
+{
+	broker_stub_read_limit_set(READ_CHUNK_LEN);
+	large_publish_receive();
+
+	zassert_equal(mqtt_readall_publish_payload(&client, rx_payload,
+						   sizeof(rx_payload)), 0,
+		      "Cannot read payload");
+	zassert_mem_equal(rx_payload, large_payload, sizeof(large_payload),
+			  "Invalid payload");
+	zassert_true(broker_stub_read_blocking(), "Read not blocking");
+
+	/* The payload is shorter than requested. */
+	zassert_equal(mqtt_readall_publish_payload(&client, rx_payload, 1),
+		      -EIO, "Read past the payload");
+}
+
+static void test_publish_stream_handler(void)
+{
+	publish_handler_read_len = sizeof(large_payload);
+	large_publish_receive();
+
+	zassert_mem_equal(rx_payload, large_payload, sizeof(large_payload),
+			  "Invalid payload");
+	zassert_equal(mqtt_read_publish_payload(&client, rx_payload,
+						READ_CHUNK_LEN), 0,
+		      "Payload left after handler");
+}
+
+static void test_publish_stream_discard(void)
+{
+	large_publish_receive();
+
+	/* Only a part of the payload is read by the application. */
+	zassert_equal(mqtt_readall_publish_payload(&client, rx_payload,
+						   READ_CHUNK_LEN), 0,
+		      "Cannot read payload");
+
+	broker_stub_publish_inject(TEST_TOPIC, payload, 4);
+
+	/* The rest is dropped, and the next packet is handled. */
+	zassert_equal(mqtt_input(&client), 0, "Cannot receive PUBLISH");
+	zassert_equal(publish_cnt, 2, "Next PUBLISH not notified");
+	zassert_false(publish_streamed, "Small payload streamed");
+	zassert_equal(publish_len, 4, "Invalid payload length");
+	zassert_mem_equal(rx_payload, payload, 4, "Invalid payload");
+	zassert_true(client.state & MQTT_STATE_CONNECTED, "Disconnected");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(mqtt_socket_tests,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test_setup_teardown(test_qos0_not_stored,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_publish_single_write,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_qos1_acknowledged,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_qos1_resend,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_process_resend,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_qos2_flow,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_replay_on_reconnect,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(
+						test_clean_session_write_failure,
+						test_setup,
+						test_teardown),
+			 ztest_unit_test_setup_teardown(test_clean_session,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_limits,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_persistent_storage,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_batch_flush,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_batch_full,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_batch_timeout,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_batch_order,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_v5_topic_alias,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_v5_receive_max,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(
+						test_v5_receive_max_duplicate_ack,
+						test_setup,
+						test_teardown),
+			 ztest_unit_test_setup_teardown(test_v5_replay_receive_max,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(test_publish_stream_read,
+							test_setup,
+							test_teardown),
+			 ztest_unit_test_setup_teardown(
+						test_publish_stream_readall,
+						test_setup,
+						test_teardown),
+			 ztest_unit_test_setup_teardown(
+						test_publish_stream_handler,
+						test_setup,
+						test_teardown),
+			 ztest_unit_test_setup_teardown(
+						test_publish_stream_discard,
+						test_setup,
+						test_teardown)
+			 );
+
+	ztest_run_test_suite(mqtt_socket_tests);
+}